@@ -0,0 +1,202 @@
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include "BenchCommon.h"
+#include "MemoryStats.h"
+#include "ResourceManager.h"
+
+namespace bench {
+
+	namespace {
+
+		const size_t BATCH_SIZE = 256;
+		const size_t CHURN_SLOTS = 4096;
+		// One in LONG_LIVED_INTERVAL churn allocations survives until the end of the phase
+		const size_t LONG_LIVED_INTERVAL = 64;
+		const size_t ALIGNMENT = 8;
+
+		// Fragmentation is MemoryStats' 1 - largest free block / free bytes everywhere, so it's
+		// only reported by allocators that can say what their largest free block is.
+		// Every case constructs its own allocator so earlier cases don't leave it fragmented
+		struct MallocAllocator
+		{
+			explicit MallocAllocator(size_t) {}
+
+			const char* name() const { return "malloc"; }
+			void* alloc(size_t, size_t size) { return std::malloc(size); }
+			void free(size_t, void* p, size_t) { std::free(p); }
+
+			// The C heap doesn't expose its largest free chunk, and can't be reset either
+			double fragmentation() const { return -1.0; }
+		};
+
+		struct TlsfAllocator
+		{
+			explicit TlsfAllocator(size_t) { hvk::ResourceManager::reset(); }
+
+			const char* name() const { return "ResourceManager"; }
+			void* alloc(size_t, size_t size) { return hvk::ResourceManager::alloc(size, ALIGNMENT); }
+			void free(size_t, void* p, size_t size) { hvk::ResourceManager::free(p, size); }
+
+			double fragmentation() const { return hvk::memory::getResourceManagerStats().fragmentation; }
+		};
+
+		// Pools hand out fixed size blocks per size class and don't expose their free lists
+		struct PmrSynchronizedAllocator
+		{
+			std::pmr::synchronized_pool_resource pool;
+
+			explicit PmrSynchronizedAllocator(size_t) : pool() {}
+
+			const char* name() const { return "pmr::synchronized_pool"; }
+			void* alloc(size_t, size_t size) { return pool.allocate(size, ALIGNMENT); }
+			void free(size_t, void* p, size_t size) { pool.deallocate(p, size, ALIGNMENT); }
+
+			double fragmentation() const { return -1.0; }
+		};
+
+		// One unsynchronized pool per thread, the usual way to avoid the lock
+		struct PmrUnsynchronizedAllocator
+		{
+			std::vector<std::unique_ptr<std::pmr::unsynchronized_pool_resource>> pools;
+
+			explicit PmrUnsynchronizedAllocator(size_t threadCount) : pools()
+			{
+				for (size_t i = 0; i < threadCount; ++i) {
+					pools.push_back(std::make_unique<std::pmr::unsynchronized_pool_resource>());
+				}
+			}
+
+			const char* name() const { return "pmr::unsync_pool/thread"; }
+			void* alloc(size_t thread, size_t size) { return pools[thread]->allocate(size, ALIGNMENT); }
+			void free(size_t thread, void* p, size_t size) { pools[thread]->deallocate(p, size, ALIGNMENT); }
+
+			double fragmentation() const { return -1.0; }
+		};
+
+		struct Allocation
+		{
+			void* p;
+			size_t size;
+		};
+
+		// Allocate a batch then free it in allocation order, over and over
+		template <typename AllocatorType>
+		Result runBatch(AllocatorType& allocator, SizeDistribution distribution, size_t threadCount, size_t ops)
+		{
+			std::vector<std::vector<size_t>> sizes;
+			for (size_t t = 0; t < threadCount; ++t) {
+				sizes.push_back(generateSizes(distribution, BATCH_SIZE * 16, t + 1));
+			}
+
+			const size_t batches = std::max<size_t>(1, ops / (BATCH_SIZE * 2));
+			const Timing timing = runThreads(threadCount, [&](size_t t) {
+				const std::vector<size_t>& threadSizes = sizes[t];
+				std::vector<Allocation> live(BATCH_SIZE);
+				size_t cursor = 0;
+				for (size_t b = 0; b < batches; ++b) {
+					for (size_t i = 0; i < BATCH_SIZE; ++i) {
+						const size_t size = threadSizes[cursor++ % threadSizes.size()];
+						live[i] = { allocator.alloc(t, size), size };
+					}
+					for (size_t i = 0; i < BATCH_SIZE; ++i) {
+						allocator.free(t, live[i].p, live[i].size);
+					}
+				}
+			});
+
+			Result result;
+			result.suite = "alloc";
+			result.allocator = allocator.name();
+			result.workload = std::string(getDistributionName(distribution)) + " batch";
+			result.threads = threadCount;
+			result.opsTotal = static_cast<double>(threadCount * batches * BATCH_SIZE * 2);
+			result.seconds = timing.seconds;
+			result.rssGrowthBytes = timing.rssGrowthBytes;
+			result.fragmentation = -1.0;
+			return result;
+		}
+
+		// Random replacement in a table of live allocations gives short and medium
+		// lifetimes; every LONG_LIVED_INTERVAL'th allocation is kept to the end.
+		// Fragmentation is measured once only the long lived allocations remain.
+		template <typename AllocatorType>
+		Result runChurn(AllocatorType& allocator, size_t threadCount, size_t ops)
+		{
+			std::vector<std::vector<size_t>> sizes;
+			for (size_t t = 0; t < threadCount; ++t) {
+				sizes.push_back(generateSizes(SizeDistribution::Mixed, CHURN_SLOTS * 4, t + 101));
+			}
+			std::vector<std::vector<Allocation>> survivors(threadCount);
+
+			const size_t steps = std::max<size_t>(1, ops / 2);
+			const Timing timing = runThreads(threadCount, [&](size_t t) {
+				const std::vector<size_t>& threadSizes = sizes[t];
+				std::vector<Allocation> slots(CHURN_SLOTS, Allocation{ nullptr, 0 });
+				std::vector<Allocation>& kept = survivors[t];
+				Rng rng(t + 7);
+				for (size_t i = 0; i < steps; ++i) {
+					const size_t size = threadSizes[i % threadSizes.size()];
+					void* p = allocator.alloc(t, size);
+					if (i % LONG_LIVED_INTERVAL == 0) {
+						kept.push_back({ p, size });
+						continue;
+					}
+
+					Allocation& slot = slots[rng.nextBelow(CHURN_SLOTS)];
+					if (slot.p != nullptr) {
+						allocator.free(t, slot.p, slot.size);
+					}
+					slot = { p, size };
+				}
+				for (auto& slot : slots) {
+					if (slot.p != nullptr) {
+						allocator.free(t, slot.p, slot.size);
+					}
+				}
+			});
+
+			Result result;
+			result.suite = "alloc";
+			result.allocator = allocator.name();
+			result.workload = "mixed-lifetime churn";
+			result.threads = threadCount;
+			result.opsTotal = static_cast<double>(threadCount * steps * 2);
+			result.seconds = timing.seconds;
+			result.rssGrowthBytes = timing.rssGrowthBytes;
+			result.fragmentation = allocator.fragmentation();
+
+			for (size_t t = 0; t < threadCount; ++t) {
+				for (const auto& allocation : survivors[t]) {
+					allocator.free(t, allocation.p, allocation.size);
+				}
+			}
+			return result;
+		}
+
+		template <typename AllocatorType>
+		void runAll(const Options& options, size_t threadCount)
+		{
+			{
+				AllocatorType allocator(threadCount);
+				printResult(options, runChurn(allocator, threadCount, options.ops));
+			}
+			for (SizeDistribution distribution : { SizeDistribution::Fixed, SizeDistribution::PowerLaw, SizeDistribution::Mixed }) {
+				AllocatorType allocator(threadCount);
+				printResult(options, runBatch(allocator, distribution, threadCount, options.ops));
+			}
+		}
+	}
+
+	void runAllocatorSuite(const Options& options)
+	{
+		for (size_t threads = 1; threads <= options.maxThreads; threads *= 2) {
+			runAll<MallocAllocator>(options, threads);
+			runAll<TlsfAllocator>(options, threads);
+			runAll<PmrSynchronizedAllocator>(options, threads);
+			runAll<PmrUnsynchronizedAllocator>(options, threads);
+		}
+	}
+}
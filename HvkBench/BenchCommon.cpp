@@ -0,0 +1,201 @@
+#include "BenchCommon.h"
+
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <cstdlib>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <cstdio>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+	const char* getDistributionName(SizeDistribution distribution)
+	{
+		switch (distribution) {
+		case SizeDistribution::Fixed:
+			return "fixed";
+		case SizeDistribution::PowerLaw:
+			return "power-law";
+		case SizeDistribution::Mixed:
+			return "mixed";
+		}
+		return "unknown";
+	}
+
+	std::vector<size_t> generateSizes(SizeDistribution distribution, size_t count, uint64_t seed)
+	{
+		const double minLog = std::log(16.0);
+		const double maxLog = std::log(64.0 * 1024.0);
+
+		Rng rng(seed);
+		std::vector<size_t> sizes;
+		sizes.reserve(count);
+		for (size_t i = 0; i < count; ++i) {
+			switch (distribution) {
+			case SizeDistribution::Fixed:
+				sizes.push_back(64);
+				break;
+			case SizeDistribution::PowerLaw:
+				// log-uniform sampling gives a 1/size density
+				sizes.push_back(static_cast<size_t>(std::exp(minLog + rng.nextDouble() * (maxLog - minLog))));
+				break;
+			case SizeDistribution::Mixed:
+				if (rng.nextBelow(100) < 95) {
+					sizes.push_back(static_cast<size_t>(std::exp(minLog + rng.nextDouble() * (std::log(1024.0) - minLog))));
+				} else {
+					sizes.push_back(static_cast<size_t>(std::exp(std::log(4096.0) + rng.nextDouble() * (maxLog - std::log(4096.0)))));
+				}
+				break;
+			}
+		}
+		return sizes;
+	}
+
+	size_t getCurrentRssBytes()
+	{
+#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS counters = {};
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+			return counters.WorkingSetSize;
+		}
+		return 0;
+#elif defined(__APPLE__)
+		mach_task_basic_info_data_t info = {};
+		mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+		if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS) {
+			return static_cast<size_t>(info.resident_size);
+		}
+		return 0;
+#else
+		// Second field of statm is the resident page count
+		FILE* statm = fopen("/proc/self/statm", "r");
+		if (statm == nullptr) {
+			return 0;
+		}
+		unsigned long pages = 0;
+		unsigned long residentPages = 0;
+		const int fields = fscanf(statm, "%lu %lu", &pages, &residentPages);
+		fclose(statm);
+		if (fields != 2) {
+			return 0;
+		}
+		return static_cast<size_t>(residentPages) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+	}
+
+	Timing runThreads(size_t threadCount, const std::function<void(size_t)>& body)
+	{
+		std::atomic<size_t> ready(0);
+		std::atomic<bool> go(false);
+		std::vector<std::thread> threads;
+		std::vector<double> seconds(threadCount, 0.0);
+
+		// Sampled from a thread of its own, since the peak may come and go before the case ends
+		const size_t baselineRss = getCurrentRssBytes();
+		std::atomic<bool> done(false);
+		size_t peakRss = baselineRss;
+		std::thread sampler([&]() {
+			while (!done.load()) {
+				peakRss = std::max(peakRss, getCurrentRssBytes());
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			peakRss = std::max(peakRss, getCurrentRssBytes());
+		});
+
+		for (size_t t = 0; t < threadCount; ++t) {
+			threads.emplace_back([&, t]() {
+				ready.fetch_add(1);
+				while (!go.load()) {
+					std::this_thread::yield();
+				}
+
+				auto start = std::chrono::high_resolution_clock::now();
+				body(t);
+				auto end = std::chrono::high_resolution_clock::now();
+				seconds[t] = std::chrono::duration<double>(end - start).count();
+			});
+		}
+
+		while (ready.load() < threadCount) {
+			std::this_thread::yield();
+		}
+		go.store(true);
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		done.store(true);
+		sampler.join();
+
+		Timing timing;
+		timing.seconds = *std::max_element(seconds.begin(), seconds.end());
+		timing.rssGrowthBytes = peakRss - baselineRss;
+		return timing;
+	}
+
+	void printHeader(const Options& options)
+	{
+		if (options.csv) {
+			std::cout << "suite,allocator,workload,threads,ns_per_op,mops_per_s,rss_growth_mb,fragmentation" << std::endl;
+			return;
+		}
+
+		std::cout << std::left
+			<< std::setw(11) << "suite"
+			<< std::setw(26) << "allocator"
+			<< std::setw(20) << "workload"
+			<< std::right
+			<< std::setw(8) << "threads"
+			<< std::setw(12) << "ns/op"
+			<< std::setw(12) << "Mops/s"
+			<< std::setw(14) << "RSS growth MB"
+			<< std::setw(8) << "frag" << std::endl;
+	}
+
+	void printResult(const Options& options, const Result& result)
+	{
+		// ns/op is per thread, so it stays comparable as the thread count grows
+		const double nsPerOp = result.seconds * 1e9 * result.threads / result.opsTotal;
+		const double mops = result.opsTotal / result.seconds / 1e6;
+		const double rssMb = static_cast<double>(result.rssGrowthBytes) / (1024.0 * 1024.0);
+
+		if (options.csv) {
+			std::cout << result.suite << ','
+				<< result.allocator << ','
+				<< result.workload << ','
+				<< result.threads << ','
+				<< std::fixed << std::setprecision(2) << nsPerOp << ','
+				<< mops << ','
+				<< rssMb << ',';
+			if (result.fragmentation >= 0.0) {
+				std::cout << std::setprecision(3) << result.fragmentation;
+			}
+			std::cout << std::endl;
+			return;
+		}
+
+		std::cout << std::left
+			<< std::setw(11) << result.suite
+			<< std::setw(26) << result.allocator
+			<< std::setw(20) << result.workload
+			<< std::right
+			<< std::setw(8) << result.threads
+			<< std::setw(12) << std::fixed << std::setprecision(2) << nsPerOp
+			<< std::setw(12) << mops
+			<< std::setw(14) << rssMb;
+		if (result.fragmentation >= 0.0) {
+			std::cout << std::setw(8) << std::setprecision(3) << result.fragmentation;
+		} else {
+			std::cout << std::setw(8) << "-";
+		}
+		std::cout << std::endl;
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <memory_resource>
+
+namespace bench {
+
+	struct Options
+	{
+		size_t maxThreads;
+		size_t ops;
+		bool csv;
+	};
+
+	struct Result
+	{
+		std::string suite;
+		std::string allocator;
+		std::string workload;
+		size_t threads;
+		double opsTotal;
+		double seconds;
+		// How far resident memory rose above where it was when the case started
+		size_t rssGrowthBytes;
+		// Fraction of the allocator's footprint not holding live data after churn, < 0 when unknown
+		double fragmentation;
+	};
+
+	enum class SizeDistribution
+	{
+		Fixed,
+		PowerLaw,
+		Mixed
+	};
+
+	const char* getDistributionName(SizeDistribution distribution);
+
+	// xorshift64*, deterministic per seed so every allocator sees the same sequence
+	class Rng
+	{
+	private:
+		uint64_t mState;
+
+	public:
+		explicit Rng(uint64_t seed) : mState(seed * 0x9E3779B97F4A7C15ull + 1) {}
+
+		uint64_t next()
+		{
+			mState ^= mState >> 12;
+			mState ^= mState << 25;
+			mState ^= mState >> 27;
+			return mState * 0x2545F4914F6CDD1Dull;
+		}
+
+		double nextDouble() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+		size_t nextBelow(size_t bound) { return static_cast<size_t>(next() % bound); }
+	};
+
+	// Fixed: 64 bytes. PowerLaw: 16B..64KB with P(size) ~ 1/size.
+	// Mixed: mostly small power law requests with occasional large ones
+	std::vector<size_t> generateSizes(SizeDistribution distribution, size_t count, uint64_t seed);
+
+	// Bytes the process has resident right now, 0 when the platform can't tell us
+	size_t getCurrentRssBytes();
+
+	struct Timing
+	{
+		double seconds;
+		size_t rssGrowthBytes;
+	};
+
+	// Starts threadCount threads together and returns the slowest thread's wall time.
+	// The process' peak RSS is a high-water mark over every earlier case, so RSS growth
+	// is the highest current RSS seen while the threads run, over the RSS just before
+	Timing runThreads(size_t threadCount, const std::function<void(size_t)>& body);
+
+	void printHeader(const Options& options);
+	void printResult(const Options& options, const Result& result);
+}
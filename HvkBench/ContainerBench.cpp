@@ -0,0 +1,101 @@
+#include <list>
+#include <memory_resource>
+#include <vector>
+
+#include "BenchCommon.h"
+#include "ResourceManager.h"
+
+namespace bench {
+
+	namespace {
+
+		const size_t VECTOR_LENGTH = 4096;
+		const size_t LIST_LENGTH = 1024;
+
+		struct Payload
+		{
+			uint64_t values[4];
+		};
+
+		Result makeResult(const char* allocator, const char* workload, size_t threadCount, double opsPerThread, const Timing& timing)
+		{
+			Result result;
+			result.suite = "container";
+			result.allocator = allocator;
+			result.workload = workload;
+			result.threads = threadCount;
+			result.opsTotal = opsPerThread * threadCount;
+			result.seconds = timing.seconds;
+			result.rssGrowthBytes = timing.rssGrowthBytes;
+			result.fragmentation = -1.0;
+			return result;
+		}
+
+		// Grows a vector from empty so every reallocation goes through the allocator.
+		// An op is one push_back
+		template <typename VectorType, typename MakeVector>
+		Result runVector(const char* name, size_t threadCount, size_t ops, MakeVector makeVector)
+		{
+			const size_t rounds = std::max<size_t>(1, ops / VECTOR_LENGTH);
+			const Timing timing = runThreads(threadCount, [&](size_t) {
+				for (size_t r = 0; r < rounds; ++r) {
+					VectorType values = makeVector();
+					for (size_t i = 0; i < VECTOR_LENGTH; ++i) {
+						values.push_back(Payload{ { i, r, i ^ r, 0 } });
+					}
+				}
+			});
+			return makeResult(name, "vector push_back", threadCount, static_cast<double>(rounds * VECTOR_LENGTH), timing);
+		}
+
+		// Keeps a list at LIST_LENGTH nodes while cycling nodes through it.
+		// An op is one node allocation or free
+		template <typename ListType, typename MakeList>
+		Result runList(const char* name, size_t threadCount, size_t ops, MakeList makeList)
+		{
+			const size_t steps = std::max<size_t>(1, ops / 2);
+			const Timing timing = runThreads(threadCount, [&](size_t) {
+				ListType values = makeList();
+				for (size_t i = 0; i < LIST_LENGTH; ++i) {
+					values.push_back(Payload{ { i, 0, 0, 0 } });
+				}
+				for (size_t i = 0; i < steps; ++i) {
+					values.pop_front();
+					values.push_back(Payload{ { i, 1, 0, 0 } });
+				}
+			});
+			return makeResult(name, "list cycle", threadCount, static_cast<double>(steps * 2), timing);
+		}
+	}
+
+	void runContainerSuite(const Options& options)
+	{
+		using HVector = std::vector<Payload, hvk::Hallocator<Payload>>;
+		using HList = std::list<Payload, hvk::Hallocator<Payload>>;
+
+		for (size_t threads = 1; threads <= options.maxThreads; threads *= 2) {
+			printResult(options, runVector<std::vector<Payload>>("std::allocator", threads, options.ops, []() {
+				return std::vector<Payload>();
+			}));
+			printResult(options, runVector<HVector>("Hallocator", threads, options.ops, []() {
+				return HVector();
+			}));
+			// Each thread's container gets its own unsynchronized pool
+			printResult(options, runVector<std::pmr::vector<Payload>>("pmr::unsync_pool", threads, options.ops, []() {
+				thread_local std::pmr::unsynchronized_pool_resource pool;
+				return std::pmr::vector<Payload>(&pool);
+			}));
+
+			printResult(options, runList<std::list<Payload>>("std::allocator", threads, options.ops, []() {
+				return std::list<Payload>();
+			}));
+			printResult(options, runList<HList>("Hallocator", threads, options.ops, []() {
+				return HList();
+			}));
+			printResult(options, runList<std::pmr::list<Payload>>("pmr::unsync_pool", threads, options.ops, []() {
+				thread_local std::pmr::unsynchronized_pool_resource pool;
+				return std::pmr::list<Payload>(&pool);
+			}));
+		}
+	}
+}
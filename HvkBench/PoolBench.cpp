@@ -0,0 +1,104 @@
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include "BenchCommon.h"
+#include "ResourceManager.h"
+
+namespace bench {
+
+	namespace {
+
+		struct Particle
+		{
+			float position[3];
+			float velocity[3];
+			uint32_t id;
+			uint32_t flags;
+
+			Particle(uint32_t _id) : position{}, velocity{}, id(_id), flags(0) {}
+		};
+
+		using PoolHandle = std::unique_ptr<Particle, void(*)(Particle*)>;
+
+		const size_t LIVE_OBJECTS = 256;
+
+		Result makeResult(const char* allocator, size_t threadCount, size_t iterations, const Timing& timing)
+		{
+			Result result;
+			result.suite = "pool";
+			result.allocator = allocator;
+			result.workload = "fixed batch";
+			result.threads = threadCount;
+			result.opsTotal = static_cast<double>(threadCount * iterations * LIVE_OBJECTS * 2);
+			result.seconds = timing.seconds;
+			result.rssGrowthBytes = timing.rssGrowthBytes;
+			result.fragmentation = -1.0;
+			return result;
+		}
+
+		// Each thread repeatedly allocates a working set of objects then releases it
+		Result runPool(size_t threadCount, size_t iterations)
+		{
+			const Timing timing = runThreads(threadCount, [&](size_t) {
+				std::vector<PoolHandle> live;
+				live.reserve(LIVE_OBJECTS);
+				for (size_t i = 0; i < iterations; ++i) {
+					for (size_t j = 0; j < LIVE_OBJECTS; ++j) {
+						live.push_back(hvk::Pool<Particle>::alloc(static_cast<uint32_t>(j)));
+					}
+					live.clear();
+				}
+			});
+			return makeResult("Pool<T>", threadCount, iterations, timing);
+		}
+
+		Result runNewDelete(size_t threadCount, size_t iterations)
+		{
+			const Timing timing = runThreads(threadCount, [&](size_t) {
+				std::vector<std::unique_ptr<Particle>> live;
+				live.reserve(LIVE_OBJECTS);
+				for (size_t i = 0; i < iterations; ++i) {
+					for (size_t j = 0; j < LIVE_OBJECTS; ++j) {
+						live.push_back(std::make_unique<Particle>(static_cast<uint32_t>(j)));
+					}
+					live.clear();
+				}
+			});
+			return makeResult("new/delete", threadCount, iterations, timing);
+		}
+
+		Result runPmr(size_t threadCount, size_t iterations)
+		{
+			const Timing timing = runThreads(threadCount, [&](size_t) {
+				std::pmr::unsynchronized_pool_resource pool;
+				std::pmr::polymorphic_allocator<Particle> allocator(&pool);
+				std::vector<Particle*> live;
+				live.reserve(LIVE_OBJECTS);
+				for (size_t i = 0; i < iterations; ++i) {
+					for (size_t j = 0; j < LIVE_OBJECTS; ++j) {
+						Particle* particle = allocator.allocate(1);
+						allocator.construct(particle, static_cast<uint32_t>(j));
+						live.push_back(particle);
+					}
+					for (Particle* particle : live) {
+						particle->~Particle();
+						allocator.deallocate(particle, 1);
+					}
+					live.clear();
+				}
+			});
+			return makeResult("pmr::unsync_pool/thread", threadCount, iterations, timing);
+		}
+	}
+
+	void runPoolSuite(const Options& options)
+	{
+		const size_t iterations = std::max<size_t>(1, options.ops / (LIVE_OBJECTS * 2));
+		for (size_t threads = 1; threads <= options.maxThreads; threads *= 2) {
+			printResult(options, runPool(threads, iterations));
+			printResult(options, runNewDelete(threads, iterations));
+			printResult(options, runPmr(threads, iterations));
+		}
+	}
+}
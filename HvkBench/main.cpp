@@ -0,0 +1,71 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <thread>
+#include <algorithm>
+
+#include "BenchCommon.h"
+
+namespace bench {
+	void runAllocatorSuite(const Options& options);
+	void runPoolSuite(const Options& options);
+	void runContainerSuite(const Options& options);
+}
+
+namespace {
+
+	void printUsage()
+	{
+		std::cout << "usage: HvkBench [all|alloc|pool|container] [--threads N] [--ops N] [--csv]" << std::endl
+			<< "  --threads N  run 1, 2, 4 ... up to N threads (default: hardware concurrency)" << std::endl
+			<< "  --ops N      allocator operations per thread per case (default: 1000000)" << std::endl
+			<< "  --csv        machine readable output for gating allocator changes" << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bench::Options options;
+	options.maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	options.ops = 1000000;
+	options.csv = false;
+	std::string suite = "all";
+
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			options.maxThreads = std::max<size_t>(1, std::stoul(argv[++i]));
+		} else if (std::strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+			options.ops = std::max<size_t>(1, std::stoul(argv[++i]));
+		} else if (std::strcmp(argv[i], "--csv") == 0) {
+			options.csv = true;
+		} else if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0) {
+			printUsage();
+			return 0;
+		} else if (argv[i][0] != '-') {
+			suite = argv[i];
+		} else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (suite != "all" && suite != "alloc" && suite != "pool" && suite != "container") {
+		printUsage();
+		return 1;
+	}
+
+	bench::printHeader(options);
+	// The allocator suite resets ResourceManager before each case, which needs it empty,
+	// so run it before Pool<T> keeps arenas alive in it
+	if (suite == "all" || suite == "alloc") {
+		bench::runAllocatorSuite(options);
+	}
+	if (suite == "all" || suite == "pool") {
+		bench::runPoolSuite(options);
+	}
+	if (suite == "all" || suite == "container") {
+		bench::runContainerSuite(options);
+	}
+
+	return 0;
+}
@@ -0,0 +1,97 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "TextureCooker.h"
+
+namespace {
+
+	void printUsage()
+	{
+		std::cout << "usage: HvkCook <image> [--usage albedo|normal|mr|mask|hdr] [--compact] [--uncompressed] [-o out.ktx2]" << std::endl
+			<< "  --usage         what the texture is sampled as (default: hdr for .hdr files, otherwise albedo)" << std::endl
+			<< "  --compact       BC1/BC3 instead of BC7 for colour textures" << std::endl
+			<< "  --uncompressed  RGBA8/RGBA32F for devices without BC support" << std::endl
+			<< "  -o              output path (default: <image>.ktx2)" << std::endl;
+	}
+
+	bool parseUsage(const char* name, hvk::TextureUsage& outUsage)
+	{
+		const struct { const char* name; hvk::TextureUsage usage; } usages[] = {
+			{ "albedo", hvk::TextureUsage::Albedo },
+			{ "normal", hvk::TextureUsage::Normal },
+			{ "mr", hvk::TextureUsage::MetallicRoughness },
+			{ "mask", hvk::TextureUsage::Mask },
+			{ "hdr", hvk::TextureUsage::Hdr } };
+		for (const auto& usage : usages) {
+			if (std::strcmp(name, usage.name) == 0) {
+				outUsage = usage.usage;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool hasExtension(const std::string& path, const std::string& extension)
+	{
+		return path.size() >= extension.size() &&
+			path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string sourcePath;
+	std::string cookedPath;
+	hvk::TextureCookSettings settings;
+	bool usageSet = false;
+	hvk::TextureUsage usage = hvk::TextureUsage::Albedo;
+
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--usage") == 0 && i + 1 < argc) {
+			if (!parseUsage(argv[++i], usage)) {
+				printUsage();
+				return 1;
+			}
+			usageSet = true;
+		} else if (std::strcmp(argv[i], "--compact") == 0) {
+			settings.compact = true;
+		} else if (std::strcmp(argv[i], "--uncompressed") == 0) {
+			settings.compress = false;
+		} else if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			cookedPath = argv[++i];
+		} else if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0) {
+			printUsage();
+			return 0;
+		} else if (argv[i][0] != '-' && sourcePath.empty()) {
+			sourcePath = argv[i];
+		} else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (sourcePath.empty()) {
+		printUsage();
+		return 1;
+	}
+	if (!usageSet && hasExtension(sourcePath, ".hdr")) {
+		usage = hvk::TextureUsage::Hdr;
+	}
+	if (cookedPath.empty()) {
+		cookedPath = hvk::getCookedTexturePath(sourcePath);
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	if (!hvk::cookTextureFile(sourcePath, cookedPath, usage, settings)) {
+		std::cerr << "failed to cook " << sourcePath << std::endl;
+		return 1;
+	}
+	const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << sourcePath << " -> " << cookedPath << " (" << ms << " ms)" << std::endl;
+	return 0;
+}
@@ -0,0 +1,735 @@
+#include "pch.h"
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "WorkerPool.h"
+
+namespace hvk {
+
+	namespace bc {
+
+		namespace {
+
+			// 4 bit interpolation weights shared by BC6H and BC7, out of 64
+			const int WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+			// Largest finite half below infinity, the top of BC6H_UFLOAT's range
+			const int MAX_HALF = 0x7bff;
+
+			using BlockTexels = float[16][4];
+
+			// Writes fields LSB first into a zeroed 128 bit block
+			class BitWriter
+			{
+			private:
+				uint8_t* mOut;
+				uint32_t mBit;
+
+			public:
+				BitWriter(uint8_t* out) :
+					mOut(out),
+					mBit(0)
+				{
+					memset(mOut, 0, 16);
+				}
+
+				void write(uint32_t value, uint32_t bitCount)
+				{
+					for (uint32_t i = 0; i < bitCount; ++i, ++mBit)
+					{
+						if ((value >> i) & 1)
+						{
+							mOut[mBit >> 3] |= static_cast<uint8_t>(1 << (mBit & 7));
+						}
+					}
+				}
+			};
+
+			int clampInt(int value, int low, int high)
+			{
+				return std::min(std::max(value, low), high);
+			}
+
+			// Endpoints spanning the points' projection onto their principal axis
+			void fitLine(const BlockTexels& points, int dims, float e0[4], float e1[4])
+			{
+				float mean[4] = {};
+				for (int i = 0; i < 16; ++i)
+				{
+					for (int c = 0; c < dims; ++c)
+					{
+						mean[c] += points[i][c] / 16.f;
+					}
+				}
+
+				float covariance[4][4] = {};
+				for (int i = 0; i < 16; ++i)
+				{
+					for (int a = 0; a < dims; ++a)
+					{
+						for (int b = 0; b < dims; ++b)
+						{
+							covariance[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+						}
+					}
+				}
+
+				// Power iteration from the row with the most variance
+				int start = 0;
+				for (int c = 1; c < dims; ++c)
+				{
+					if (covariance[c][c] > covariance[start][start])
+					{
+						start = c;
+					}
+				}
+				float axis[4] = {};
+				for (int c = 0; c < dims; ++c)
+				{
+					axis[c] = covariance[start][c];
+				}
+				float length = 0.f;
+				for (int iteration = 0; iteration < 8; ++iteration)
+				{
+					float next[4] = {};
+					for (int a = 0; a < dims; ++a)
+					{
+						for (int b = 0; b < dims; ++b)
+						{
+							next[a] += covariance[a][b] * axis[b];
+						}
+					}
+					length = 0.f;
+					for (int c = 0; c < dims; ++c)
+					{
+						length += next[c] * next[c];
+					}
+					length = std::sqrt(length);
+					if (length < 1e-12f)
+					{
+						break;
+					}
+					for (int c = 0; c < dims; ++c)
+					{
+						axis[c] = next[c] / length;
+					}
+				}
+
+				float tMin = 0.f;
+				float tMax = 0.f;
+				if (length >= 1e-12f)
+				{
+					for (int i = 0; i < 16; ++i)
+					{
+						float t = 0.f;
+						for (int c = 0; c < dims; ++c)
+						{
+							t += (points[i][c] - mean[c]) * axis[c];
+						}
+						tMin = std::min(tMin, t);
+						tMax = std::max(tMax, t);
+					}
+				}
+				for (int c = 0; c < dims; ++c)
+				{
+					e0[c] = mean[c] + axis[c] * tMin;
+					e1[c] = mean[c] + axis[c] * tMax;
+				}
+			}
+
+			// Least squares endpoints for texels fixed at weights between e0 (0) and e1 (1)
+			bool refineLine(const BlockTexels& points, int dims, const float weights[16], float e0[4], float e1[4])
+			{
+				float a = 0.f, b = 0.f, c = 0.f;
+				float x0[4] = {}, x1[4] = {};
+				for (int i = 0; i < 16; ++i)
+				{
+					const float w = weights[i];
+					a += (1.f - w) * (1.f - w);
+					b += (1.f - w) * w;
+					c += w * w;
+					for (int ch = 0; ch < dims; ++ch)
+					{
+						x0[ch] += (1.f - w) * points[i][ch];
+						x1[ch] += w * points[i][ch];
+					}
+				}
+				const float determinant = a * c - b * b;
+				if (std::fabs(determinant) < 1e-6f)
+				{
+					return false;
+				}
+				for (int ch = 0; ch < dims; ++ch)
+				{
+					e0[ch] = (c * x0[ch] - b * x1[ch]) / determinant;
+					e1[ch] = (a * x1[ch] - b * x0[ch]) / determinant;
+				}
+				return true;
+			}
+
+			void fetchBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t bx, uint32_t by, BlockTexels& out)
+			{
+				for (uint32_t y = 0; y < 4; ++y)
+				{
+					const uint32_t sy = std::min(by * 4 + y, height - 1);
+					for (uint32_t x = 0; x < 4; ++x)
+					{
+						const uint32_t sx = std::min(bx * 4 + x, width - 1);
+						const uint8_t* texel = rgba + (static_cast<size_t>(sy) * width + sx) * 4;
+						for (int c = 0; c < 4; ++c)
+						{
+							out[y * 4 + x][c] = texel[c];
+						}
+					}
+				}
+			}
+
+			uint16_t floatToHalf(float value)
+			{
+				if (!(value > 0.f))
+				{
+					return 0;
+				}
+				uint32_t bits;
+				memcpy(&bits, &value, sizeof(bits));
+				const int exponent = static_cast<int>((bits >> 23) & 0xff) - 127 + 15;
+				uint32_t mantissa = bits & 0x7fffff;
+				if (exponent >= 31)
+				{
+					return MAX_HALF;
+				}
+				if (exponent <= 0)
+				{
+					if (exponent < -10)
+					{
+						return 0;
+					}
+					mantissa |= 0x800000;
+					const uint32_t shift = static_cast<uint32_t>(14 - exponent);
+					return static_cast<uint16_t>((mantissa >> shift) + ((mantissa >> (shift - 1)) & 1));
+				}
+				uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+				half += (mantissa >> 12) & 1;
+				return static_cast<uint16_t>(std::min<uint32_t>(half, MAX_HALF));
+			}
+
+			void fetchBlock(const float* rgba, uint32_t width, uint32_t height, uint32_t bx, uint32_t by, BlockTexels& out)
+			{
+				// BC6H interpolates the half bit patterns, so that's the space endpoints are fit in
+				for (uint32_t y = 0; y < 4; ++y)
+				{
+					const uint32_t sy = std::min(by * 4 + y, height - 1);
+					for (uint32_t x = 0; x < 4; ++x)
+					{
+						const uint32_t sx = std::min(bx * 4 + x, width - 1);
+						const float* texel = rgba + (static_cast<size_t>(sy) * width + sx) * 4;
+						for (int c = 0; c < 3; ++c)
+						{
+							out[y * 4 + x][c] = floatToHalf(texel[c]);
+						}
+						out[y * 4 + x][3] = 0.f;
+					}
+				}
+			}
+
+			// BC1
+
+			uint16_t packRgb565(const float color[4])
+			{
+				const int r = clampInt(static_cast<int>(std::lround(color[0] * 31.f / 255.f)), 0, 31);
+				const int g = clampInt(static_cast<int>(std::lround(color[1] * 63.f / 255.f)), 0, 63);
+				const int b = clampInt(static_cast<int>(std::lround(color[2] * 31.f / 255.f)), 0, 31);
+				return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+			}
+
+			void unpackRgb565(uint16_t packed, int out[3])
+			{
+				const int r = (packed >> 11) & 31;
+				const int g = (packed >> 5) & 63;
+				const int b = packed & 31;
+				out[0] = (r << 3) | (r >> 2);
+				out[1] = (g << 2) | (g >> 4);
+				out[2] = (b << 3) | (b >> 2);
+			}
+
+			// Four colour mode needs c0 > c1; equal endpoints leave every index on c0
+			float evaluateBC1(const BlockTexels& texels, uint16_t& c0, uint16_t& c1, uint32_t& outIndices)
+			{
+				if (c0 < c1)
+				{
+					std::swap(c0, c1);
+				}
+				int palette[4][3];
+				unpackRgb565(c0, palette[0]);
+				unpackRgb565(c1, palette[1]);
+				for (int c = 0; c < 3; ++c)
+				{
+					palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+					palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+				}
+				const int paletteSize = c0 == c1 ? 1 : 4;
+
+				float error = 0.f;
+				outIndices = 0;
+				for (int i = 0; i < 16; ++i)
+				{
+					float best = 1e30f;
+					uint32_t bestIndex = 0;
+					for (int p = 0; p < paletteSize; ++p)
+					{
+						float distance = 0.f;
+						for (int c = 0; c < 3; ++c)
+						{
+							const float d = texels[i][c] - palette[p][c];
+							distance += d * d;
+						}
+						if (distance < best)
+						{
+							best = distance;
+							bestIndex = static_cast<uint32_t>(p);
+						}
+					}
+					error += best;
+					outIndices |= bestIndex << (2 * i);
+				}
+				return error;
+			}
+
+			void encodeBC1(const BlockTexels& texels, uint8_t* out)
+			{
+				float e0[4], e1[4];
+				fitLine(texels, 3, e0, e1);
+				uint16_t c0 = packRgb565(e1);
+				uint16_t c1 = packRgb565(e0);
+				uint32_t indices;
+				float error = evaluateBC1(texels, c0, c1, indices);
+
+				static const float INDEX_WEIGHTS[4] = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+				float weights[16];
+				for (int i = 0; i < 16; ++i)
+				{
+					weights[i] = INDEX_WEIGHTS[(indices >> (2 * i)) & 3];
+				}
+				if (refineLine(texels, 3, weights, e0, e1))
+				{
+					uint16_t r0 = packRgb565(e0);
+					uint16_t r1 = packRgb565(e1);
+					uint32_t refinedIndices;
+					if (evaluateBC1(texels, r0, r1, refinedIndices) < error)
+					{
+						c0 = r0;
+						c1 = r1;
+						indices = refinedIndices;
+					}
+				}
+
+				memcpy(out, &c0, sizeof(c0));
+				memcpy(out + 2, &c1, sizeof(c1));
+				memcpy(out + 4, &indices, sizeof(indices));
+			}
+
+			// BC4, also the alpha half of BC3 and both halves of BC5
+
+			void encodeBC4(const BlockTexels& texels, int channel, uint8_t* out)
+			{
+				int low = 255;
+				int high = 0;
+				for (int i = 0; i < 16; ++i)
+				{
+					const int value = static_cast<int>(texels[i][channel]);
+					low = std::min(low, value);
+					high = std::max(high, value);
+				}
+
+				// a0 > a1 selects the eight value palette; a flat block uses index 0 (a0) either way
+				int palette[8] = { high, low };
+				for (int k = 1; k <= 6; ++k)
+				{
+					palette[k + 1] = ((7 - k) * high + k * low) / 7;
+				}
+
+				uint64_t indices = 0;
+				if (high != low)
+				{
+					for (int i = 0; i < 16; ++i)
+					{
+						const int value = static_cast<int>(texels[i][channel]);
+						int best = 0;
+						for (int p = 1; p < 8; ++p)
+						{
+							if (std::abs(palette[p] - value) < std::abs(palette[best] - value))
+							{
+								best = p;
+							}
+						}
+						indices |= static_cast<uint64_t>(best) << (3 * i);
+					}
+				}
+
+				out[0] = static_cast<uint8_t>(high);
+				out[1] = static_cast<uint8_t>(low);
+				for (int i = 0; i < 6; ++i)
+				{
+					out[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+				}
+			}
+
+			// BC7 mode 6: one subset, 7 bit RGBA endpoints with a p-bit each, 4 bit indices
+
+			struct Bc7Endpoint
+			{
+				int quantized[4];
+				int pBit;
+				int value[4];
+			};
+
+			Bc7Endpoint quantizeBC7(const float endpoint[4])
+			{
+				Bc7Endpoint best = {};
+				float bestError = 1e30f;
+				for (int p = 0; p < 2; ++p)
+				{
+					Bc7Endpoint candidate;
+					candidate.pBit = p;
+					float error = 0.f;
+					for (int c = 0; c < 4; ++c)
+					{
+						candidate.quantized[c] = clampInt(static_cast<int>(std::lround((endpoint[c] - p) / 2.f)), 0, 127);
+						candidate.value[c] = (candidate.quantized[c] << 1) | p;
+						const float d = candidate.value[c] - endpoint[c];
+						error += d * d;
+					}
+					if (error < bestError)
+					{
+						bestError = error;
+						best = candidate;
+					}
+				}
+				return best;
+			}
+
+			float evaluateWeighted(
+				const BlockTexels& texels,
+				int dims,
+				const int palette[16][4],
+				uint8_t outIndices[16])
+			{
+				float error = 0.f;
+				for (int i = 0; i < 16; ++i)
+				{
+					float best = 1e30f;
+					for (int p = 0; p < 16; ++p)
+					{
+						float distance = 0.f;
+						for (int c = 0; c < dims; ++c)
+						{
+							const float d = texels[i][c] - palette[p][c];
+							distance += d * d;
+						}
+						if (distance < best)
+						{
+							best = distance;
+							outIndices[i] = static_cast<uint8_t>(p);
+						}
+					}
+					error += best;
+				}
+				return error;
+			}
+
+			float evaluateBC7(const BlockTexels& texels, const Bc7Endpoint& e0, const Bc7Endpoint& e1, uint8_t outIndices[16])
+			{
+				int palette[16][4];
+				for (int p = 0; p < 16; ++p)
+				{
+					for (int c = 0; c < 4; ++c)
+					{
+						palette[p][c] = ((64 - WEIGHTS4[p]) * e0.value[c] + WEIGHTS4[p] * e1.value[c] + 32) >> 6;
+					}
+				}
+				return evaluateWeighted(texels, 4, palette, outIndices);
+			}
+
+			void encodeBC7(const BlockTexels& texels, uint8_t* out)
+			{
+				float f0[4], f1[4];
+				fitLine(texels, 4, f0, f1);
+				Bc7Endpoint e0 = quantizeBC7(f0);
+				Bc7Endpoint e1 = quantizeBC7(f1);
+				uint8_t indices[16];
+				float error = evaluateBC7(texels, e0, e1, indices);
+
+				float weights[16];
+				for (int i = 0; i < 16; ++i)
+				{
+					weights[i] = WEIGHTS4[indices[i]] / 64.f;
+				}
+				if (refineLine(texels, 4, weights, f0, f1))
+				{
+					Bc7Endpoint r0 = quantizeBC7(f0);
+					Bc7Endpoint r1 = quantizeBC7(f1);
+					uint8_t refinedIndices[16];
+					if (evaluateBC7(texels, r0, r1, refinedIndices) < error)
+					{
+						e0 = r0;
+						e1 = r1;
+						memcpy(indices, refinedIndices, sizeof(indices));
+					}
+				}
+
+				// The first index drops its top bit, so it has to be in the lower half
+				if (indices[0] & 8)
+				{
+					std::swap(e0, e1);
+					for (int i = 0; i < 16; ++i)
+					{
+						indices[i] = static_cast<uint8_t>(15 - indices[i]);
+					}
+				}
+
+				BitWriter writer(out);
+				writer.write(1 << 6, 7);
+				for (int c = 0; c < 4; ++c)
+				{
+					writer.write(static_cast<uint32_t>(e0.quantized[c]), 7);
+					writer.write(static_cast<uint32_t>(e1.quantized[c]), 7);
+				}
+				writer.write(static_cast<uint32_t>(e0.pBit), 1);
+				writer.write(static_cast<uint32_t>(e1.pBit), 1);
+				writer.write(indices[0], 3);
+				for (int i = 1; i < 16; ++i)
+				{
+					writer.write(indices[i], 4);
+				}
+			}
+
+			// BC6H mode 11: one region, 10 bit unsigned endpoints, 4 bit indices
+
+			int unquantizeBC6H(int quantized)
+			{
+				if (quantized == 0)
+				{
+					return 0;
+				}
+				if (quantized == 1023)
+				{
+					return 0xffff;
+				}
+				return ((quantized << 16) + 0x8000) >> 10;
+			}
+
+			// Interpolated values are scaled by 31/64 into half bits
+			int finishBC6H(int unquantized)
+			{
+				return (unquantized * 31) >> 6;
+			}
+
+			int quantizeBC6H(float half)
+			{
+				const int guess = clampInt(static_cast<int>(std::lround(half / 31.f)), 0, 1023);
+				int best = guess;
+				for (int q = std::max(guess - 1, 0); q <= std::min(guess + 1, 1023); ++q)
+				{
+					if (std::fabs(finishBC6H(unquantizeBC6H(q)) - half) < std::fabs(finishBC6H(unquantizeBC6H(best)) - half))
+					{
+						best = q;
+					}
+				}
+				return best;
+			}
+
+			float evaluateBC6H(const BlockTexels& texels, const int q0[3], const int q1[3], uint8_t outIndices[16])
+			{
+				int palette[16][4] = {};
+				for (int p = 0; p < 16; ++p)
+				{
+					for (int c = 0; c < 3; ++c)
+					{
+						const int u0 = unquantizeBC6H(q0[c]);
+						const int u1 = unquantizeBC6H(q1[c]);
+						palette[p][c] = finishBC6H(((64 - WEIGHTS4[p]) * u0 + WEIGHTS4[p] * u1 + 32) >> 6);
+					}
+				}
+				return evaluateWeighted(texels, 3, palette, outIndices);
+			}
+
+			void encodeBC6H(const BlockTexels& texels, uint8_t* out)
+			{
+				float f0[4], f1[4];
+				fitLine(texels, 3, f0, f1);
+				int q0[3], q1[3];
+				for (int c = 0; c < 3; ++c)
+				{
+					q0[c] = quantizeBC6H(std::min(std::max(f0[c], 0.f), float(MAX_HALF)));
+					q1[c] = quantizeBC6H(std::min(std::max(f1[c], 0.f), float(MAX_HALF)));
+				}
+				uint8_t indices[16];
+				float error = evaluateBC6H(texels, q0, q1, indices);
+
+				float weights[16];
+				for (int i = 0; i < 16; ++i)
+				{
+					weights[i] = WEIGHTS4[indices[i]] / 64.f;
+				}
+				if (refineLine(texels, 3, weights, f0, f1))
+				{
+					int r0[3], r1[3];
+					for (int c = 0; c < 3; ++c)
+					{
+						r0[c] = quantizeBC6H(std::min(std::max(f0[c], 0.f), float(MAX_HALF)));
+						r1[c] = quantizeBC6H(std::min(std::max(f1[c], 0.f), float(MAX_HALF)));
+					}
+					uint8_t refinedIndices[16];
+					if (evaluateBC6H(texels, r0, r1, refinedIndices) < error)
+					{
+						memcpy(q0, r0, sizeof(q0));
+						memcpy(q1, r1, sizeof(q1));
+						memcpy(indices, refinedIndices, sizeof(indices));
+					}
+				}
+
+				if (indices[0] & 8)
+				{
+					for (int c = 0; c < 3; ++c)
+					{
+						std::swap(q0[c], q1[c]);
+					}
+					for (int i = 0; i < 16; ++i)
+					{
+						indices[i] = static_cast<uint8_t>(15 - indices[i]);
+					}
+				}
+
+				BitWriter writer(out);
+				writer.write(0x03, 5);
+				for (int c = 0; c < 3; ++c)
+				{
+					writer.write(static_cast<uint32_t>(q0[c]), 10);
+				}
+				for (int c = 0; c < 3; ++c)
+				{
+					writer.write(static_cast<uint32_t>(q1[c]), 10);
+				}
+				writer.write(indices[0], 3);
+				for (int i = 1; i < 16; ++i)
+				{
+					writer.write(indices[i], 4);
+				}
+			}
+
+			template <typename Texel, typename Encode>
+			void compressBlocks(
+				const Texel* texels,
+				uint32_t width,
+				uint32_t height,
+				uint32_t blockSize,
+				uint8_t* outBlocks,
+				Encode encode)
+			{
+				const uint32_t blocksX = (width + 3) / 4;
+				const uint32_t blocksY = (height + 3) / 4;
+				// A row of blocks per task
+				WorkerPool::parallelFor(blocksY, [&](size_t row) {
+					const uint32_t by = static_cast<uint32_t>(row);
+					BlockTexels block;
+					uint8_t* out = outBlocks + static_cast<size_t>(by) * blocksX * blockSize;
+					for (uint32_t bx = 0; bx < blocksX; ++bx, out += blockSize)
+					{
+						fetchBlock(texels, width, height, bx, by, block);
+						encode(block, out);
+					}
+				});
+			}
+		}
+
+		uint32_t getBlockSize(VkFormat format)
+		{
+			switch (format)
+			{
+			case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+			case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			case VK_FORMAT_BC4_UNORM_BLOCK:
+				return 8;
+			case VK_FORMAT_BC3_UNORM_BLOCK:
+			case VK_FORMAT_BC3_SRGB_BLOCK:
+			case VK_FORMAT_BC5_UNORM_BLOCK:
+			case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+			case VK_FORMAT_BC7_UNORM_BLOCK:
+			case VK_FORMAT_BC7_SRGB_BLOCK:
+				return 16;
+			default:
+				return 0;
+			}
+		}
+
+		size_t getLevelSize(VkFormat format, uint32_t width, uint32_t height)
+		{
+			return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * getBlockSize(format);
+		}
+
+		bool compressImage(
+			VkFormat format,
+			const uint8_t* rgba,
+			uint32_t width,
+			uint32_t height,
+			uint8_t* outBlocks)
+		{
+			const uint32_t blockSize = getBlockSize(format);
+			switch (format)
+			{
+			case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+			case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+				compressBlocks(rgba, width, height, blockSize, outBlocks, [](const BlockTexels& block, uint8_t* out) {
+					encodeBC1(block, out);
+				});
+				return true;
+			case VK_FORMAT_BC3_UNORM_BLOCK:
+			case VK_FORMAT_BC3_SRGB_BLOCK:
+				compressBlocks(rgba, width, height, blockSize, outBlocks, [](const BlockTexels& block, uint8_t* out) {
+					encodeBC4(block, 3, out);
+					encodeBC1(block, out + 8);
+				});
+				return true;
+			case VK_FORMAT_BC4_UNORM_BLOCK:
+				compressBlocks(rgba, width, height, blockSize, outBlocks, [](const BlockTexels& block, uint8_t* out) {
+					encodeBC4(block, 0, out);
+				});
+				return true;
+			case VK_FORMAT_BC5_UNORM_BLOCK:
+				compressBlocks(rgba, width, height, blockSize, outBlocks, [](const BlockTexels& block, uint8_t* out) {
+					encodeBC4(block, 0, out);
+					encodeBC4(block, 1, out + 8);
+				});
+				return true;
+			case VK_FORMAT_BC7_UNORM_BLOCK:
+			case VK_FORMAT_BC7_SRGB_BLOCK:
+				compressBlocks(rgba, width, height, blockSize, outBlocks, [](const BlockTexels& block, uint8_t* out) {
+					encodeBC7(block, out);
+				});
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		bool compressImage(
+			VkFormat format,
+			const float* rgba,
+			uint32_t width,
+			uint32_t height,
+			uint8_t* outBlocks)
+		{
+			if (format != VK_FORMAT_BC6H_UFLOAT_BLOCK)
+			{
+				return false;
+			}
+			compressBlocks(rgba, width, height, getBlockSize(format), outBlocks, [](const BlockTexels& block, uint8_t* out) {
+				encodeBC6H(block, out);
+			});
+			return true;
+		}
+	}
+}
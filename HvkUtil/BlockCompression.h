@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+namespace hvk {
+
+	// CPU encoders for the block compressed formats textures are cooked to. They need
+	// no GPU, so cooking runs headless. Each encoder fits one endpoint pair along the
+	// block's principal axis: BC7 only writes mode 6 and BC6H only mode 11
+	namespace bc {
+
+		// Bytes per 4x4 block of a format the encoders write, 0 for anything else
+		uint32_t getBlockSize(VkFormat format);
+		size_t getLevelSize(VkFormat format, uint32_t width, uint32_t height);
+
+		// Encodes RGBA8 texels to BC1 (opaque), BC3, BC4 (red), BC5 (red, green) or BC7.
+		// Blocks overhanging the edge repeat the last row and column. Block rows are
+		// split across a thread per core
+		bool compressImage(
+			VkFormat format,
+			const uint8_t* rgba,
+			uint32_t width,
+			uint32_t height,
+			uint8_t* outBlocks);
+
+		// Encodes RGBA float texels to BC6H_UFLOAT; alpha is dropped and negatives clamp to 0
+		bool compressImage(
+			VkFormat format,
+			const float* rgba,
+			uint32_t width,
+			uint32_t height,
+			uint8_t* outBlocks);
+	}
+}
@@ -36,7 +36,7 @@ namespace hvk {
 	{
 	}
 
-	void CameraController::update(double d, std::vector<Command>& commands) {
+	void CameraController::update(double d, HVK_pmr_vector<Command>& commands) {
 		MouseState mouse = InputManager::currentMouseState;
 		MouseState prevMouse = InputManager::previousMouseState;
 
@@ -20,7 +20,7 @@ namespace hvk {
 	public:
 		CameraController(HVK_shared<Camera> camera, float movementSpeed=1.f);
 		~CameraController();
-		void update(double d, std::vector<Command>& commands);
+		void update(double d, HVK_pmr_vector<Command>& commands);
         void setCamera(HVK_shared<Camera> camera)
         {
             mCamera = camera;
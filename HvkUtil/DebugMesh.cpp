@@ -8,6 +8,7 @@ namespace hvk
 		mVertices(vertices),
 		mIndices(indices)
 	{
+		assert(getNarrowestIndexType(mVertices->size()) == VK_INDEX_TYPE_UINT16);
 	}
 
 
@@ -0,0 +1,118 @@
+#include "pch.h"
+#include "FrameAllocator.h"
+
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <new>
+
+namespace hvk {
+
+	std::array<FrameAllocator::FrameResource, FRAMES_IN_FLIGHT> FrameAllocator::sFrames;
+	uint32_t FrameAllocator::sFrameIndex = 0;
+	bool FrameAllocator::sInitialized = false;
+
+	FrameAllocator::FrameResource::FrameResource() :
+		mStorage(nullptr),
+		mSize(0),
+		mOffset(0),
+		mPeak(0),
+		mOverflowCount(0),
+		mOverflow(nullptr)
+	{
+	}
+
+	FrameAllocator::FrameResource::~FrameResource()
+	{
+		reset();
+		std::free(mStorage);
+	}
+
+	void FrameAllocator::FrameResource::init(size_t size)
+	{
+		reset();
+		std::free(mStorage);
+		mStorage = static_cast<char*>(std::malloc(size));
+		mSize = mStorage ? size : 0;
+		mPeak = 0;
+	}
+
+	void FrameAllocator::FrameResource::reset()
+	{
+		while (mOverflow) {
+			Overflow* next = mOverflow->next;
+			std::free(mOverflow);
+			mOverflow = next;
+		}
+		mOffset = 0;
+		mOverflowCount = 0;
+	}
+
+	void* FrameAllocator::FrameResource::do_allocate(size_t bytes, size_t alignment)
+	{
+		const uintptr_t base = reinterpret_cast<uintptr_t>(mStorage);
+		const uintptr_t aligned = (base + mOffset + (alignment - 1)) & ~(uintptr_t(alignment) - 1);
+		const size_t end = static_cast<size_t>(aligned - base) + bytes;
+		if (mStorage && end <= mSize) {
+			mOffset = end;
+			mPeak = std::max(mPeak, mOffset);
+			return reinterpret_cast<void*>(aligned);
+		}
+
+		// Out of frame memory, fall back to the heap until the next reset
+		const size_t headerSize = std::max(sizeof(Overflow), alignment);
+		char* mem = static_cast<char*>(std::malloc(headerSize + bytes + alignment));
+		if (mem == nullptr) {
+			throw std::bad_alloc();
+		}
+		Overflow* overflow = reinterpret_cast<Overflow*>(mem);
+		overflow->next = mOverflow;
+		mOverflow = overflow;
+		++mOverflowCount;
+
+		const uintptr_t data = (reinterpret_cast<uintptr_t>(mem) + headerSize + (alignment - 1)) & ~(uintptr_t(alignment) - 1);
+		return reinterpret_cast<void*>(data);
+	}
+
+	void FrameAllocator::FrameResource::do_deallocate(void*, size_t, size_t)
+	{
+		// Memory is reclaimed all at once when the frame is reset
+	}
+
+	bool FrameAllocator::FrameResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+	{
+		return this == &other;
+	}
+
+	void FrameAllocator::initialize(size_t bytesPerFrame)
+	{
+		for (auto& frame : sFrames) {
+			frame.init(bytesPerFrame);
+		}
+		sFrameIndex = 0;
+		sInitialized = true;
+	}
+
+	void FrameAllocator::nextFrame()
+	{
+		sFrameIndex = (sFrameIndex + 1) % FRAMES_IN_FLIGHT;
+		sFrames[sFrameIndex].reset();
+	}
+
+	std::pmr::memory_resource* FrameAllocator::getResource()
+	{
+		if (!sInitialized) {
+			initialize(DEFAULT_FRAME_SIZE);
+		}
+		return &sFrames[sFrameIndex];
+	}
+
+	size_t FrameAllocator::getPeakBytesUsed()
+	{
+		size_t peak = 0;
+		for (const auto& frame : sFrames) {
+			peak = std::max(peak, frame.getPeak());
+		}
+		return peak;
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <memory_resource>
+
+#define FRAMES_IN_FLIGHT 2
+
+namespace hvk {
+
+	// Linear scratch memory for data that only needs to live for a frame.
+	// Each frame in flight gets its own buffer; nextFrame() (called from
+	// VulkanApp::renderFinish) moves to the next buffer and resets it, so
+	// anything allocated during a frame stays valid until the same buffer
+	// comes around again. Main thread only.
+	class FrameAllocator
+	{
+	public:
+		static constexpr size_t DEFAULT_FRAME_SIZE = 256 * 1024;
+
+	private:
+		class FrameResource : public std::pmr::memory_resource
+		{
+		private:
+			// Allocations that don't fit in the frame buffer are chained here
+			struct Overflow
+			{
+				Overflow* next;
+			};
+
+			char* mStorage;
+			size_t mSize;
+			size_t mOffset;
+			size_t mPeak;
+			size_t mOverflowCount;
+			Overflow* mOverflow;
+
+		protected:
+			void* do_allocate(size_t bytes, size_t alignment) override;
+			void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+			bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+		public:
+			FrameResource();
+			~FrameResource();
+
+			void init(size_t size);
+			void reset();
+
+			size_t getUsed() const { return mOffset; }
+			size_t getPeak() const { return mPeak; }
+			size_t getSize() const { return mSize; }
+			size_t getOverflowCount() const { return mOverflowCount; }
+		};
+
+		static std::array<FrameResource, FRAMES_IN_FLIGHT> sFrames;
+		static uint32_t sFrameIndex;
+		static bool sInitialized;
+
+	public:
+		static void initialize(size_t bytesPerFrame);
+		static void nextFrame();
+		static std::pmr::memory_resource* getResource();
+
+		static size_t getBytesUsed() { return sFrames[sFrameIndex].getUsed(); }
+		static size_t getPeakBytesUsed();
+		static size_t getFrameSize() { return sFrames[sFrameIndex].getSize(); }
+		static size_t getOverflowCount() { return sFrames[sFrameIndex].getOverflowCount(); }
+	};
+}
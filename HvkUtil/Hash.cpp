@@ -0,0 +1,66 @@
+#include "pch.h"
+#include "Hash.h"
+
+#include <cstring>
+
+#include "MappedFile.h"
+
+namespace hvk {
+
+	namespace hash {
+
+		namespace {
+
+			const uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+			const uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+			uint64_t finalize(uint64_t h)
+			{
+				h ^= h >> 33;
+				h *= 0xff51afd7ed558ccdULL;
+				h ^= h >> 33;
+				h *= 0xc4ceb9fe1a85ec53ULL;
+				h ^= h >> 33;
+				return h;
+			}
+		}
+
+		// FNV-1a over 8 byte words rather than bytes, with a final avalanche
+		// so the low bits are usable for bucketing
+		uint64_t hashBytes(const void* data, size_t size, uint64_t seed)
+		{
+			const auto* bytes = static_cast<const uint8_t*>(data);
+			uint64_t h = (FNV_OFFSET ^ seed) * FNV_PRIME;
+
+			size_t i = 0;
+			for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+			{
+				uint64_t word;
+				memcpy(&word, bytes + i, sizeof(word));
+				h = (h ^ word) * FNV_PRIME;
+			}
+			for (; i < size; ++i)
+			{
+				h = (h ^ bytes[i]) * FNV_PRIME;
+			}
+
+			return finalize(h ^ size);
+		}
+
+		uint64_t combine(uint64_t a, uint64_t b)
+		{
+			return finalize(a ^ (b + 0x9e3779b97f4a7c15ULL + (a << 6) + (a >> 2)));
+		}
+
+		bool hashFile(const std::string& path, uint64_t& outHash)
+		{
+			MappedFile file;
+			if (!file.open(path))
+			{
+				return false;
+			}
+			outHash = hashBytes(file.getData(), file.getSize());
+			return true;
+		}
+	}
+}
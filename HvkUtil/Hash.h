@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace hvk {
+
+	namespace hash {
+
+		// 64 bit non-cryptographic content hash for cache keys. Stable across runs and platforms
+		uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0);
+		// Folds b into a so hashes of several inputs can be chained
+		uint64_t combine(uint64_t a, uint64_t b);
+		// Hashes a whole file through a read-only mapping; false if it can't be opened
+		bool hashFile(const std::string& path, uint64_t& outHash);
+	}
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <memory>
 #include <vector>
+#include <memory_resource>
 #include <variant>
 
 #include <vulkan/vulkan.h>
@@ -16,14 +17,25 @@ namespace hvk
 	#define COMP2_ALIGN(t) alignas(2*sizeof(t))
 	#define COMP1_ALIGN(t) alignas(sizeof(t))
 
+	// Indices of the generated debug and environment cubes and other shapes. Those never
+	// reach getNarrowestIndexType's 32 bit threshold, so they're fixed at 16 bits and drawn
+	// with VK_INDEX_TYPE_UINT16; DebugMesh and CubeMesh assert that their vertices fit.
+	// Loaded models pick their width per mesh through StaticMesh instead
 	using VertIndex = uint16_t;
 
+	// 16 bit indices whenever every vertex is addressable by them
+	inline VkIndexType getNarrowestIndexType(size_t vertexCount) {
+		return vertexCount <= static_cast<size_t>(UINT16_MAX) + 1 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+	}
+
 	const VkFormat VertexPositionFormat = VK_FORMAT_R32G32B32_SFLOAT;
 	const VkFormat VertexColorFormat = VK_FORMAT_R32G32B32_SFLOAT;
 	const VkFormat VertexUVFormat = VK_FORMAT_R32G32_SFLOAT;
 	const VkFormat VertexNormalFormat = VK_FORMAT_R32G32B32_SFLOAT;
     const VkFormat VertexTangentFormat = VK_FORMAT_R32G32B32A32_SFLOAT;
     const VkFormat VertexUVWFormat = VK_FORMAT_R32G32B32_SFLOAT;
+	const VkFormat PackedNormalTangentFormat = VK_FORMAT_R16G16B16A16_SNORM;
+	const VkFormat PackedUVFormat = VK_FORMAT_R16G16_SFLOAT;
 
 	template <typename T>
 	using HVK_shared = std::shared_ptr<T>;
@@ -41,6 +53,10 @@ namespace hvk
 	using HVK_vector = std::vector<T>;
 	//using HVK_vector = std::vector<T, Hallocator<T>>;
 
+	// Vector drawing from a std::pmr resource, typically FrameAllocator::getResource()
+	template <typename T>
+	using HVK_pmr_vector = std::pmr::vector<T>;
+
 
 	struct MaterialProperty {
 		HVK_shared<tinygltf::Image> texture;
@@ -97,6 +113,105 @@ namespace hvk
 		}
 	};
 
+	// Meshes are drawn from two vertex streams: positions in binding 0, so depth only passes
+	// fetch 12 bytes a vertex, and the rest in binding 1 at either precision (see VertexEncoding.h)
+	struct PositionVertex {
+		glm::vec3 pos;
+
+		static VkVertexInputBindingDescription getBindingDescription() {
+			VkVertexInputBindingDescription bindingDescription = {};
+			bindingDescription.binding = 0;
+			bindingDescription.stride = sizeof(PositionVertex);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+			return bindingDescription;
+		}
+
+		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions() {
+			std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+			attributeDescriptions.resize(1);
+
+			attributeDescriptions[0].binding = 0;
+			attributeDescriptions[0].location = 0;
+			attributeDescriptions[0].format = VertexPositionFormat;
+			attributeDescriptions[0].offset = offsetof(PositionVertex, pos);
+
+			return attributeDescriptions;
+		}
+	};
+
+	// Everything in Vertex but its position, at full precision
+	struct VertexAttributes {
+		glm::vec3 normal;
+		glm::vec2 texCoord;
+		glm::vec4 tangent;
+
+		static VkVertexInputBindingDescription getBindingDescription() {
+			VkVertexInputBindingDescription bindingDescription = {};
+			bindingDescription.binding = 1;
+			bindingDescription.stride = sizeof(VertexAttributes);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+			return bindingDescription;
+		}
+
+		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions() {
+			std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+			attributeDescriptions.resize(3);
+
+			attributeDescriptions[0].binding = 1;
+			attributeDescriptions[0].location = 1;
+			attributeDescriptions[0].format = VertexNormalFormat;
+			attributeDescriptions[0].offset = offsetof(VertexAttributes, normal);
+
+			attributeDescriptions[1].binding = 1;
+			attributeDescriptions[1].location = 2;
+			attributeDescriptions[1].format = VertexUVFormat;
+			attributeDescriptions[1].offset = offsetof(VertexAttributes, texCoord);
+
+			attributeDescriptions[2].binding = 1;
+			attributeDescriptions[2].location = 3;
+			attributeDescriptions[2].format = VertexTangentFormat;
+			attributeDescriptions[2].offset = offsetof(VertexAttributes, tangent);
+
+			return attributeDescriptions;
+		}
+	};
+
+	// The same attributes in 12 bytes: octahedral normal and tangent as snorm16 pairs, read
+	// together as one vec4, and half float UVs. The tangent's handedness is the lowest bit
+	// of its second component
+	struct PackedVertexAttributes {
+		int16_t normalTangent[4];
+		uint16_t texCoord[2];
+
+		static VkVertexInputBindingDescription getBindingDescription() {
+			VkVertexInputBindingDescription bindingDescription = {};
+			bindingDescription.binding = 1;
+			bindingDescription.stride = sizeof(PackedVertexAttributes);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+			return bindingDescription;
+		}
+
+		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions() {
+			std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+			attributeDescriptions.resize(2);
+
+			attributeDescriptions[0].binding = 1;
+			attributeDescriptions[0].location = 1;
+			attributeDescriptions[0].format = PackedNormalTangentFormat;
+			attributeDescriptions[0].offset = offsetof(PackedVertexAttributes, normalTangent);
+
+			attributeDescriptions[1].binding = 1;
+			attributeDescriptions[1].location = 2;
+			attributeDescriptions[1].format = PackedUVFormat;
+			attributeDescriptions[1].offset = offsetof(PackedVertexAttributes, texCoord);
+
+			return attributeDescriptions;
+		}
+	};
+
 	struct ColorVertex {
 		glm::vec3 pos;
 		glm::vec3 color;
@@ -161,7 +276,7 @@ namespace hvk
 
 	struct Command {
 		uint16_t id;
-		std::string name;
+		const char* name;
 		std::variant<uint32_t, float, bool> payload;
 	};
 }
@@ -0,0 +1,354 @@
+#include "pch.h"
+#include "Ktx2.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "BlockCompression.h"
+#include "MipChain.h"
+
+namespace hvk {
+
+	namespace {
+
+		const uint8_t KTX2_IDENTIFIER[12] = { 0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n' };
+		const char SOURCE_KEY_NAME[] = "HvkSourceKey";
+		// Satisfies every level's lcm(texel block size, 4) for the formats written here
+		const uint64_t LEVEL_ALIGNMENT = 16;
+
+		struct Header
+		{
+			uint8_t identifier[12];
+			uint32_t vkFormat;
+			uint32_t typeSize;
+			uint32_t pixelWidth;
+			uint32_t pixelHeight;
+			uint32_t pixelDepth;
+			uint32_t layerCount;
+			uint32_t faceCount;
+			uint32_t levelCount;
+			uint32_t supercompressionScheme;
+			uint32_t dfdByteOffset;
+			uint32_t dfdByteLength;
+			uint32_t kvdByteOffset;
+			uint32_t kvdByteLength;
+			uint64_t sgdByteOffset;
+			uint64_t sgdByteLength;
+		};
+
+		struct LevelIndex
+		{
+			uint64_t byteOffset;
+			uint64_t byteLength;
+			uint64_t uncompressedByteLength;
+		};
+
+		static_assert(sizeof(Header) == 80, "KTX2 header is read and written as-is");
+		static_assert(sizeof(LevelIndex) == 24, "KTX2 level index is read and written as-is");
+
+		// Khronos data format descriptor values
+		const uint32_t MODEL_RGBSDA = 1;
+		const uint32_t MODEL_BC1A = 128;
+		const uint32_t MODEL_BC3 = 130;
+		const uint32_t MODEL_BC4 = 131;
+		const uint32_t MODEL_BC5 = 132;
+		const uint32_t MODEL_BC6H = 133;
+		const uint32_t MODEL_BC7 = 134;
+		const uint32_t PRIMARIES_BT709 = 1;
+		const uint32_t TRANSFER_LINEAR = 1;
+		const uint32_t TRANSFER_SRGB = 2;
+		const uint32_t CHANNEL_ALPHA = 15;
+		const uint32_t QUALIFIER_FLOAT = 0x80;
+		const uint32_t QUALIFIER_SIGNED = 0x40;
+		const uint32_t FLOAT_ONE = 0x3f800000;
+		const uint32_t FLOAT_MINUS_ONE = 0xbf800000;
+
+		struct Sample
+		{
+			uint32_t bitOffset;
+			uint32_t bitLength;
+			uint32_t channel;
+			uint32_t lower;
+			uint32_t upper;
+		};
+
+		uint64_t alignOffset(uint64_t offset, uint64_t alignment)
+		{
+			return (offset + alignment - 1) & ~(alignment - 1);
+		}
+
+		// Bytes per texel of the uncompressed formats, 0 for anything else
+		uint32_t getTexelSize(VkFormat format)
+		{
+			switch (format)
+			{
+			case VK_FORMAT_R8G8B8A8_UNORM:
+			case VK_FORMAT_R8G8B8A8_SRGB:
+				return 4;
+			case VK_FORMAT_R16G16B16A16_SFLOAT:
+				return 8;
+			case VK_FORMAT_R32G32B32A32_SFLOAT:
+				return 16;
+			default:
+				return 0;
+			}
+		}
+
+		uint64_t getLevelSize(VkFormat format, uint32_t width, uint32_t height)
+		{
+			const uint32_t texelSize = getTexelSize(format);
+			if (texelSize != 0)
+			{
+				return static_cast<uint64_t>(width) * height * texelSize;
+			}
+			return bc::getLevelSize(format, width, height);
+		}
+
+		bool writeDataFormatDescriptor(VkFormat format, std::vector<uint32_t>& outWords)
+		{
+			uint32_t model = 0;
+			uint32_t transfer = TRANSFER_LINEAR;
+			uint32_t blockDimensions = 0;
+			uint32_t bytesPlane0 = 0;
+			// Every format has one to four samples, so they're kept in place rather than on the heap
+			std::array<Sample, 4> samples = {};
+			uint32_t sampleCount = 0;
+			switch (format)
+			{
+			case VK_FORMAT_R8G8B8A8_SRGB:
+				transfer = TRANSFER_SRGB;
+				// fallthrough
+			case VK_FORMAT_R8G8B8A8_UNORM:
+				model = MODEL_RGBSDA;
+				bytesPlane0 = 4;
+				samples = { { { 0, 8, 0, 0, 255 }, { 8, 8, 1, 0, 255 }, { 16, 8, 2, 0, 255 }, { 24, 8, CHANNEL_ALPHA, 0, 255 } } };
+				sampleCount = 4;
+				break;
+			case VK_FORMAT_R16G16B16A16_SFLOAT:
+			case VK_FORMAT_R32G32B32A32_SFLOAT:
+			{
+				// Float sample bounds are given as 32 bit floats whatever the channel width
+				const uint32_t bits = format == VK_FORMAT_R16G16B16A16_SFLOAT ? 16 : 32;
+				model = MODEL_RGBSDA;
+				bytesPlane0 = bits / 2;
+				const uint32_t qualifiers = QUALIFIER_FLOAT | QUALIFIER_SIGNED;
+				samples = { {
+					{ 0, bits, qualifiers | 0, FLOAT_MINUS_ONE, FLOAT_ONE },
+					{ bits, bits, qualifiers | 1, FLOAT_MINUS_ONE, FLOAT_ONE },
+					{ bits * 2, bits, qualifiers | 2, FLOAT_MINUS_ONE, FLOAT_ONE },
+					{ bits * 3, bits, qualifiers | CHANNEL_ALPHA, FLOAT_MINUS_ONE, FLOAT_ONE } } };
+				sampleCount = 4;
+				break;
+			}
+			case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+				transfer = TRANSFER_SRGB;
+				// fallthrough
+			case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+				model = MODEL_BC1A;
+				samples = { { { 0, 64, 0, 0, UINT32_MAX } } };
+				sampleCount = 1;
+				break;
+			case VK_FORMAT_BC3_SRGB_BLOCK:
+				transfer = TRANSFER_SRGB;
+				// fallthrough
+			case VK_FORMAT_BC3_UNORM_BLOCK:
+				model = MODEL_BC3;
+				samples = { { { 0, 64, CHANNEL_ALPHA, 0, UINT32_MAX }, { 64, 64, 0, 0, UINT32_MAX } } };
+				sampleCount = 2;
+				break;
+			case VK_FORMAT_BC4_UNORM_BLOCK:
+				model = MODEL_BC4;
+				samples = { { { 0, 64, 0, 0, UINT32_MAX } } };
+				sampleCount = 1;
+				break;
+			case VK_FORMAT_BC5_UNORM_BLOCK:
+				model = MODEL_BC5;
+				samples = { { { 0, 64, 0, 0, UINT32_MAX }, { 64, 64, 1, 0, UINT32_MAX } } };
+				sampleCount = 2;
+				break;
+			case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+				model = MODEL_BC6H;
+				samples = { { { 0, 128, QUALIFIER_FLOAT, 0, FLOAT_ONE } } };
+				sampleCount = 1;
+				break;
+			case VK_FORMAT_BC7_SRGB_BLOCK:
+				transfer = TRANSFER_SRGB;
+				// fallthrough
+			case VK_FORMAT_BC7_UNORM_BLOCK:
+				model = MODEL_BC7;
+				samples = { { { 0, 128, 0, 0, UINT32_MAX } } };
+				sampleCount = 1;
+				break;
+			default:
+				return false;
+			}
+			if (model != MODEL_RGBSDA)
+			{
+				blockDimensions = 3 | (3 << 8);
+				bytesPlane0 = bc::getBlockSize(format);
+			}
+
+			const uint32_t blockSize = 24 + 16 * sampleCount;
+			outWords.clear();
+			outWords.push_back(4 + blockSize);
+			outWords.push_back(0);
+			outWords.push_back(2 | (blockSize << 16));
+			outWords.push_back(model | (PRIMARIES_BT709 << 8) | (transfer << 16));
+			outWords.push_back(blockDimensions);
+			outWords.push_back(bytesPlane0);
+			outWords.push_back(0);
+			for (uint32_t i = 0; i < sampleCount; ++i)
+			{
+				const Sample& sample = samples[i];
+				outWords.push_back(sample.bitOffset | ((sample.bitLength - 1) << 16) | (sample.channel << 24));
+				outWords.push_back(0);
+				outWords.push_back(sample.lower);
+				outWords.push_back(sample.upper);
+			}
+			return true;
+		}
+	}
+
+	bool parseKtx2(const uint8_t* data, size_t size, Ktx2Texture& outTexture)
+	{
+		Header header;
+		if (size < sizeof(header))
+		{
+			return false;
+		}
+		memcpy(&header, data, sizeof(header));
+
+		const VkFormat format = static_cast<VkFormat>(header.vkFormat);
+		const bool headerValid =
+			memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0 &&
+			getLevelSize(format, 1, 1) != 0 &&
+			header.pixelWidth != 0 &&
+			header.pixelHeight != 0 &&
+			header.pixelDepth == 0 &&
+			header.layerCount == 0 &&
+			(header.faceCount == 1 || (header.faceCount == 6 && header.pixelWidth == header.pixelHeight)) &&
+			header.supercompressionScheme == 0 &&
+			header.levelCount <= getMipLevelCount(header.pixelWidth, header.pixelHeight);
+		const uint32_t levelCount = std::max(header.levelCount, 1u);
+		if (!headerValid || size - sizeof(header) < levelCount * sizeof(LevelIndex))
+		{
+			return false;
+		}
+
+		outTexture.format = format;
+		outTexture.width = header.pixelWidth;
+		outTexture.height = header.pixelHeight;
+		outTexture.faceCount = header.faceCount;
+		outTexture.generateMips = header.levelCount == 0;
+		outTexture.levels.clear();
+		outTexture.sourceKey = 0;
+		for (uint32_t level = 0; level < levelCount; ++level)
+		{
+			LevelIndex index;
+			memcpy(&index, data + sizeof(header) + level * sizeof(LevelIndex), sizeof(index));
+			const uint64_t expectedSize = getLevelSize(
+				format,
+				std::max(header.pixelWidth >> level, 1u),
+				std::max(header.pixelHeight >> level, 1u)) * header.faceCount;
+			if (index.byteLength != expectedSize || index.byteOffset > size || index.byteLength > size - index.byteOffset)
+			{
+				return false;
+			}
+			outTexture.levels.push_back({ data + index.byteOffset, index.byteLength });
+		}
+
+		// Key/value entries are a length, a null terminated key, then the value, padded to 4 bytes
+		if (header.kvdByteOffset <= size && header.kvdByteLength <= size - header.kvdByteOffset)
+		{
+			const uint8_t* entry = data + header.kvdByteOffset;
+			const uint8_t* end = entry + header.kvdByteLength;
+			while (end - entry >= 4)
+			{
+				uint32_t entryLength;
+				memcpy(&entryLength, entry, sizeof(entryLength));
+				const uint8_t* key = entry + 4;
+				if (entryLength > static_cast<size_t>(end - key))
+				{
+					break;
+				}
+				const size_t keyLength = sizeof(SOURCE_KEY_NAME);
+				if (entryLength == keyLength + sizeof(uint64_t) && memcmp(key, SOURCE_KEY_NAME, keyLength) == 0)
+				{
+					memcpy(&outTexture.sourceKey, key + keyLength, sizeof(uint64_t));
+				}
+				entry = key + alignOffset(entryLength, 4);
+			}
+		}
+
+		return true;
+	}
+
+	bool writeKtx2(
+		VkFormat format,
+		uint32_t width,
+		uint32_t height,
+		uint32_t faceCount,
+		const std::vector<std::vector<uint8_t>>& levels,
+		bool generateMips,
+		uint64_t sourceKey,
+		std::vector<uint8_t>& outFile)
+	{
+		std::vector<uint32_t> dfd;
+		const bool facesValid = faceCount == 1 || (faceCount == 6 && width == height);
+		if (levels.empty() || !facesValid || (generateMips && levels.size() != 1) || !writeDataFormatDescriptor(format, dfd))
+		{
+			return false;
+		}
+		for (size_t level = 0; level < levels.size(); ++level)
+		{
+			const uint32_t levelWidth = std::max(width >> level, 1u);
+			const uint32_t levelHeight = std::max(height >> level, 1u);
+			if (levels[level].size() != getLevelSize(format, levelWidth, levelHeight) * faceCount)
+			{
+				return false;
+			}
+		}
+
+		std::vector<uint8_t> kvd(4 + sizeof(SOURCE_KEY_NAME) + sizeof(uint64_t));
+		const uint32_t entryLength = static_cast<uint32_t>(kvd.size() - 4);
+		memcpy(kvd.data(), &entryLength, sizeof(entryLength));
+		memcpy(kvd.data() + 4, SOURCE_KEY_NAME, sizeof(SOURCE_KEY_NAME));
+		memcpy(kvd.data() + 4 + sizeof(SOURCE_KEY_NAME), &sourceKey, sizeof(sourceKey));
+		kvd.resize(alignOffset(kvd.size(), 4));
+
+		Header header = {};
+		memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+		header.vkFormat = static_cast<uint32_t>(format);
+		header.typeSize = std::max(getTexelSize(format) / 4, 1u);
+		header.pixelWidth = width;
+		header.pixelHeight = height;
+		header.faceCount = faceCount;
+		header.levelCount = generateMips ? 0 : static_cast<uint32_t>(levels.size());
+		header.dfdByteOffset = static_cast<uint32_t>(sizeof(Header) + levels.size() * sizeof(LevelIndex));
+		header.dfdByteLength = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+		header.kvdByteOffset = header.dfdByteOffset + header.dfdByteLength;
+		header.kvdByteLength = static_cast<uint32_t>(kvd.size());
+
+		// Level data is stored smallest first so a streaming reader sees the tail of the chain early
+		std::vector<LevelIndex> index(levels.size());
+		uint64_t cursor = header.kvdByteOffset + header.kvdByteLength;
+		for (size_t level = levels.size(); level-- > 0;)
+		{
+			cursor = alignOffset(cursor, LEVEL_ALIGNMENT);
+			index[level] = { cursor, levels[level].size(), levels[level].size() };
+			cursor += levels[level].size();
+		}
+
+		outFile.assign(cursor, 0);
+		memcpy(outFile.data(), &header, sizeof(header));
+		memcpy(outFile.data() + sizeof(header), index.data(), index.size() * sizeof(LevelIndex));
+		memcpy(outFile.data() + header.dfdByteOffset, dfd.data(), header.dfdByteLength);
+		memcpy(outFile.data() + header.kvdByteOffset, kvd.data(), kvd.size());
+		for (size_t level = 0; level < levels.size(); ++level)
+		{
+			memcpy(outFile.data() + index[level].byteOffset, levels[level].data(), levels[level].size());
+		}
+		return true;
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace hvk {
+
+	struct Ktx2Level
+	{
+		const uint8_t* data;
+		uint64_t size;
+	};
+
+	// Non-owning view of a 2D or cubemap KTX2 texture without supercompression. levels are largest
+	// first, each holding all of its faces in order; a file whose levelCount is 0 has only its base
+	// level and asks for the rest to be generated
+	struct Ktx2Texture
+	{
+		VkFormat format;
+		uint32_t width;
+		uint32_t height;
+		// 1, or 6 for a cubemap
+		uint32_t faceCount;
+		bool generateMips;
+		std::vector<Ktx2Level> levels;
+		// Hash of the image the texture was cooked from (the HvkSourceKey entry), 0 if absent
+		uint64_t sourceKey;
+	};
+
+	// Validates the header and level index against the data's size and the format's
+	// level sizes. Only RGBA8, RGBA16F, RGBA32F and the BC formats the cooker writes are accepted
+	bool parseKtx2(const uint8_t* data, size_t size, Ktx2Texture& outTexture);
+
+	// Serializes levels (largest first, or just the base with generateMips, each with its
+	// faces packed in order) with a data format descriptor and the source key. A cubemap
+	// has 6 faces and is square
+	bool writeKtx2(
+		VkFormat format,
+		uint32_t width,
+		uint32_t height,
+		uint32_t faceCount,
+		const std::vector<std::vector<uint8_t>>& levels,
+		bool generateMips,
+		uint64_t sourceKey,
+		std::vector<uint8_t>& outFile);
+}
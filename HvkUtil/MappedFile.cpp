@@ -0,0 +1,149 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace hvk {
+
+	MappedFile::MappedFile() :
+		mData(nullptr),
+		mSize(0)
+#ifdef _WIN32
+		, mFile(INVALID_HANDLE_VALUE),
+		mMapping(nullptr)
+#endif
+	{
+	}
+
+	MappedFile::MappedFile(MappedFile&& rhs) noexcept :
+		MappedFile()
+	{
+		*this = std::move(rhs);
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& rhs) noexcept
+	{
+		if (this != &rhs)
+		{
+			close();
+			std::swap(mData, rhs.mData);
+			std::swap(mSize, rhs.mSize);
+#ifdef _WIN32
+			std::swap(mFile, rhs.mFile);
+			std::swap(mMapping, rhs.mMapping);
+#endif
+		}
+		return *this;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	bool MappedFile::open(const std::string& path)
+	{
+		close();
+
+#ifdef _WIN32
+		mFile = CreateFileA(
+			path.c_str(),
+			GENERIC_READ,
+			FILE_SHARE_READ,
+			nullptr,
+			OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+			nullptr);
+		if (mFile == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(mFile, &fileSize) || fileSize.QuadPart == 0)
+		{
+			close();
+			return false;
+		}
+
+		mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mMapping == nullptr)
+		{
+			close();
+			return false;
+		}
+
+		mData = static_cast<const uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+		if (mData == nullptr)
+		{
+			close();
+			return false;
+		}
+		mSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+		const int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return false;
+		}
+
+		struct stat fileStat;
+		if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+		{
+			::close(fd);
+			return false;
+		}
+
+		// The mapping keeps its own reference to the file
+		void* mapped = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (mapped == MAP_FAILED)
+		{
+			return false;
+		}
+		mData = static_cast<const uint8_t*>(mapped);
+		mSize = static_cast<size_t>(fileStat.st_size);
+#endif
+
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+#ifdef _WIN32
+		if (mData != nullptr)
+		{
+			UnmapViewOfFile(mData);
+		}
+		if (mMapping != nullptr)
+		{
+			CloseHandle(mMapping);
+		}
+		if (mFile != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(mFile);
+		}
+		mMapping = nullptr;
+		mFile = INVALID_HANDLE_VALUE;
+#else
+		if (mData != nullptr)
+		{
+			munmap(const_cast<uint8_t*>(mData), mSize);
+		}
+#endif
+		mData = nullptr;
+		mSize = 0;
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace hvk {
+
+	// Read-only memory mapping of a whole file. The view stays valid until
+	// close() or destruction; move-only so the mapping has a single owner
+	class MappedFile
+	{
+	private:
+		const uint8_t* mData;
+		size_t mSize;
+#ifdef _WIN32
+		void* mFile;
+		void* mMapping;
+#endif
+
+	public:
+		MappedFile();
+		MappedFile(MappedFile&& rhs) noexcept;
+		MappedFile& operator=(MappedFile&& rhs) noexcept;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		~MappedFile();
+
+		bool open(const std::string& path);
+		void close();
+
+		bool isOpen() const { return mData != nullptr; }
+		const uint8_t* getData() const { return mData; }
+		size_t getSize() const { return mSize; }
+	};
+}
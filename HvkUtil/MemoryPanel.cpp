@@ -0,0 +1,63 @@
+#include "pch.h"
+#include "MemoryPanel.h"
+#include "MemoryStats.h"
+
+#include "imgui/imgui.h"
+
+namespace hvk {
+
+	namespace memory {
+
+		void drawMemoryPanel(bool* open)
+		{
+			ImGui::Begin("Memory", open);
+
+#if HVK_MEMORY_STATS
+			const HeapStats heap = getResourceManagerStats();
+			ImGui::Text("ResourceManager: %zu / %zu bytes free in %zu regions",
+				heap.freeBytes,
+				heap.capacity,
+				heap.regionCount);
+			ImGui::Text("Largest free block: %zu bytes", heap.largestFreeBlock);
+			ImGui::Text("Fragmentation: %.1f%%", heap.fragmentation * 100.f);
+			ImGui::Text("Heap allocations last frame: %zu", getFrameHeapAllocations());
+
+			for (size_t s = 0; s < static_cast<size_t>(MemorySource::Count); ++s) {
+				const MemorySource source = static_cast<MemorySource>(s);
+				if (!ImGui::CollapsingHeader(getSourceName(source), ImGuiTreeNodeFlags_DefaultOpen)) {
+					continue;
+				}
+
+				const SourceStats stats = getSourceStats(source);
+				ImGui::Columns(5, getSourceName(source));
+				ImGui::Text("Tag"); ImGui::NextColumn();
+				ImGui::Text("Live"); ImGui::NextColumn();
+				ImGui::Text("Peak"); ImGui::NextColumn();
+				ImGui::Text("Allocs"); ImGui::NextColumn();
+				ImGui::Text("Allocs/frame"); ImGui::NextColumn();
+				ImGui::Separator();
+				for (size_t t = 0; t < stats.size(); ++t) {
+					ImGui::Text("%s", getTagName(static_cast<MemoryTag>(t))); ImGui::NextColumn();
+					ImGui::Text("%zu", stats[t].liveBytes); ImGui::NextColumn();
+					ImGui::Text("%zu", stats[t].peakBytes); ImGui::NextColumn();
+					ImGui::Text("%zu", stats[t].liveAllocations); ImGui::NextColumn();
+					ImGui::Text("%zu", stats[t].frameAllocations); ImGui::NextColumn();
+				}
+				ImGui::Columns(1);
+			}
+
+			if (ImGui::Button("Dump JSON")) {
+				writeReport("memory_report.json");
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Dump CSV")) {
+				writeReport("memory_report.csv");
+			}
+#else
+			ImGui::Text("Allocation tracking is compiled out of this build");
+#endif
+
+			ImGui::End();
+		}
+	}
+}
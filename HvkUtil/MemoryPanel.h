@@ -0,0 +1,11 @@
+#pragma once
+
+namespace hvk {
+
+	namespace memory {
+
+		// ImGui window showing per-tag allocation stats with buttons to dump them to disk.
+		// Kept out of MemoryStats so tools that don't link ImGui can still use the stats
+		void drawMemoryPanel(bool* open = nullptr);
+	}
+}
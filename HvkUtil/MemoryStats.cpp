@@ -0,0 +1,284 @@
+#include "pch.h"
+#include "MemoryStats.h"
+#include "ResourceManager.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+namespace {
+	const size_t TAG_COUNT = static_cast<size_t>(hvk::MemoryTag::Count);
+	const size_t SOURCE_COUNT = static_cast<size_t>(hvk::MemorySource::Count);
+
+	const char* TAG_NAMES[TAG_COUNT] = {
+		"General",
+		"Assets",
+		"Scene",
+		"Render",
+		"UI"
+	};
+
+	const char* SOURCE_NAMES[SOURCE_COUNT] = {
+		"ResourceManager",
+		"Pool",
+		"Heap"
+	};
+
+	std::atomic<size_t> sHeapAllocations(0);
+	size_t sFrameStart = 0;
+	size_t sLastFrameAllocations = 0;
+}
+
+#if HVK_MEMORY_STATS
+
+namespace {
+	struct Counters
+	{
+		std::atomic<size_t> liveBytes;
+		std::atomic<size_t> peakBytes;
+		std::atomic<size_t> liveAllocations;
+		std::atomic<size_t> totalAllocations;
+		std::atomic<size_t> frameAllocations;
+		std::atomic<size_t> lastFrameAllocations;
+	};
+
+	// Zero initialized before any dynamic initialization, so safe to use from operator new
+	Counters sCounters[SOURCE_COUNT][TAG_COUNT];
+	thread_local hvk::MemoryTag sCurrentTag = hvk::MemoryTag::General;
+
+	// Keeps heap allocations aligned for max_align_t
+	struct alignas(16) HeapHeader
+	{
+		size_t size;
+		hvk::MemoryTag tag;
+	};
+
+	void* countedAlloc(size_t size)
+	{
+		sHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+		char* mem = static_cast<char*>(std::malloc(sizeof(HeapHeader) + size));
+		if (mem == nullptr) {
+			throw std::bad_alloc();
+		}
+		HeapHeader* header = reinterpret_cast<HeapHeader*>(mem);
+		header->size = size;
+		header->tag = sCurrentTag;
+		hvk::memory::recordAlloc(hvk::MemorySource::Heap, header->tag, size);
+		return mem + sizeof(HeapHeader);
+	}
+
+	void countedFree(void* p)
+	{
+		if (p != nullptr) {
+			HeapHeader* header = reinterpret_cast<HeapHeader*>(p) - 1;
+			hvk::memory::recordFree(hvk::MemorySource::Heap, header->tag, header->size);
+			std::free(header);
+		}
+	}
+}
+
+void* operator new(size_t size)
+{
+	return countedAlloc(size);
+}
+
+void* operator new[](size_t size)
+{
+	return countedAlloc(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	countedFree(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	countedFree(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	countedFree(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	countedFree(p);
+}
+
+#endif
+
+namespace hvk {
+
+	namespace memory {
+
+		const char* getTagName(MemoryTag tag)
+		{
+			return TAG_NAMES[static_cast<size_t>(tag)];
+		}
+
+		const char* getSourceName(MemorySource source)
+		{
+			return SOURCE_NAMES[static_cast<size_t>(source)];
+		}
+
+#if HVK_MEMORY_STATS
+		MemoryTag getCurrentTag()
+		{
+			return sCurrentTag;
+		}
+
+		void setCurrentTag(MemoryTag tag)
+		{
+			sCurrentTag = tag;
+		}
+
+		void recordAlloc(MemorySource source, MemoryTag tag, size_t bytes)
+		{
+			Counters& counters = sCounters[static_cast<size_t>(source)][static_cast<size_t>(tag)];
+			const size_t live = counters.liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+			size_t peak = counters.peakBytes.load(std::memory_order_relaxed);
+			while (live > peak && !counters.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+			}
+			counters.liveAllocations.fetch_add(1, std::memory_order_relaxed);
+			counters.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+			counters.frameAllocations.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void recordFree(MemorySource source, MemoryTag tag, size_t bytes)
+		{
+			Counters& counters = sCounters[static_cast<size_t>(source)][static_cast<size_t>(tag)];
+			counters.liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+			counters.liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+		}
+#endif
+
+		void endFrame()
+		{
+			const size_t total = sHeapAllocations.load(std::memory_order_relaxed);
+			sLastFrameAllocations = total - sFrameStart;
+			sFrameStart = total;
+
+#if HVK_MEMORY_STATS
+			for (auto& source : sCounters) {
+				for (auto& counters : source) {
+					counters.lastFrameAllocations.store(
+						counters.frameAllocations.exchange(0, std::memory_order_relaxed),
+						std::memory_order_relaxed);
+				}
+			}
+#endif
+		}
+
+		size_t getFrameHeapAllocations()
+		{
+			return sLastFrameAllocations;
+		}
+
+		size_t getTotalHeapAllocations()
+		{
+			return sHeapAllocations.load(std::memory_order_relaxed);
+		}
+
+#if HVK_MEMORY_STATS
+		SourceStats getSourceStats(MemorySource source)
+		{
+			SourceStats stats = {};
+			for (size_t i = 0; i < TAG_COUNT; ++i) {
+				const Counters& counters = sCounters[static_cast<size_t>(source)][i];
+				stats[i].liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+				stats[i].peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+				stats[i].liveAllocations = counters.liveAllocations.load(std::memory_order_relaxed);
+				stats[i].totalAllocations = counters.totalAllocations.load(std::memory_order_relaxed);
+				stats[i].frameAllocations = counters.lastFrameAllocations.load(std::memory_order_relaxed);
+			}
+			return stats;
+		}
+#endif
+
+		HeapStats getResourceManagerStats()
+		{
+			HeapStats stats = {};
+			stats.capacity = ResourceManager::getCapacity();
+			stats.freeBytes = ResourceManager::getRemaining();
+			stats.largestFreeBlock = ResourceManager::getLargestFreeBlock();
+			stats.regionCount = ResourceManager::getRegionCount();
+			if (stats.freeBytes > 0) {
+				stats.fragmentation = 1.f - static_cast<float>(stats.largestFreeBlock) / static_cast<float>(stats.freeBytes);
+			}
+			return stats;
+		}
+
+		bool writeReport(const char* filename)
+		{
+			FILE* file = fopen(filename, "w");
+			if (file == nullptr) {
+				return false;
+			}
+
+			const HeapStats heap = getResourceManagerStats();
+			const size_t nameLength = strlen(filename);
+			const bool csv = nameLength >= 4 && strcmp(filename + nameLength - 4, ".csv") == 0;
+
+			if (csv) {
+				fprintf(file, "source,tag,liveBytes,peakBytes,liveAllocations,totalAllocations,frameAllocations\n");
+				for (size_t s = 0; s < SOURCE_COUNT; ++s) {
+					const SourceStats stats = getSourceStats(static_cast<MemorySource>(s));
+					for (size_t t = 0; t < TAG_COUNT; ++t) {
+						fprintf(file, "%s,%s,%zu,%zu,%zu,%zu,%zu\n",
+							SOURCE_NAMES[s],
+							TAG_NAMES[t],
+							stats[t].liveBytes,
+							stats[t].peakBytes,
+							stats[t].liveAllocations,
+							stats[t].totalAllocations,
+							stats[t].frameAllocations);
+					}
+				}
+				fprintf(file, "\ncapacity,freeBytes,largestFreeBlock,regionCount,fragmentation,frameHeapAllocations\n");
+				fprintf(file, "%zu,%zu,%zu,%zu,%.4f,%zu\n",
+					heap.capacity,
+					heap.freeBytes,
+					heap.largestFreeBlock,
+					heap.regionCount,
+					heap.fragmentation,
+					getFrameHeapAllocations());
+			}
+			else {
+				fprintf(file, "{\n");
+				fprintf(file, "  \"frameHeapAllocations\": %zu,\n", getFrameHeapAllocations());
+				fprintf(file, "  \"resourceManager\": {\n");
+				fprintf(file, "    \"capacity\": %zu,\n", heap.capacity);
+				fprintf(file, "    \"freeBytes\": %zu,\n", heap.freeBytes);
+				fprintf(file, "    \"largestFreeBlock\": %zu,\n", heap.largestFreeBlock);
+				fprintf(file, "    \"regionCount\": %zu,\n", heap.regionCount);
+				fprintf(file, "    \"fragmentation\": %.4f\n", heap.fragmentation);
+				fprintf(file, "  },\n");
+				fprintf(file, "  \"sources\": {\n");
+				for (size_t s = 0; s < SOURCE_COUNT; ++s) {
+					const SourceStats stats = getSourceStats(static_cast<MemorySource>(s));
+					fprintf(file, "    \"%s\": {\n", SOURCE_NAMES[s]);
+					for (size_t t = 0; t < TAG_COUNT; ++t) {
+						fprintf(file, "      \"%s\": { \"liveBytes\": %zu, \"peakBytes\": %zu, \"liveAllocations\": %zu, \"totalAllocations\": %zu, \"frameAllocations\": %zu }%s\n",
+							TAG_NAMES[t],
+							stats[t].liveBytes,
+							stats[t].peakBytes,
+							stats[t].liveAllocations,
+							stats[t].totalAllocations,
+							stats[t].frameAllocations,
+							t + 1 < TAG_COUNT ? "," : "");
+					}
+					fprintf(file, "    }%s\n", s + 1 < SOURCE_COUNT ? "," : "");
+				}
+				fprintf(file, "  }\n");
+				fprintf(file, "}\n");
+			}
+
+			fclose(file);
+			return true;
+		}
+	}
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+
+// Allocation tracking replaces the global operator new and adds a header to
+// every tracked allocation, so it is only compiled into debug builds.
+// _DEBUG rather than NDEBUG since the x64 release configurations don't define NDEBUG
+#if defined(_DEBUG) && !defined(HVK_MEMORY_STATS)
+#define HVK_MEMORY_STATS 1
+#endif
+
+namespace hvk {
+
+	enum class MemoryTag : uint8_t
+	{
+		General,
+		Assets,
+		Scene,
+		Render,
+		UI,
+		Count
+	};
+
+	enum class MemorySource : uint8_t
+	{
+		ResourceManager,
+		Pool,
+		Heap,
+		Count
+	};
+
+	// Tag used for Pool<T> allocations, specialize to attribute a type to a subsystem
+	template <typename T>
+	struct MemoryTagOf
+	{
+		static constexpr MemoryTag value = MemoryTag::General;
+	};
+
+	namespace memory {
+
+		struct TagStats
+		{
+			size_t liveBytes;
+			size_t peakBytes;
+			size_t liveAllocations;
+			size_t totalAllocations;
+			size_t frameAllocations;
+		};
+
+		struct HeapStats
+		{
+			size_t capacity;
+			size_t freeBytes;
+			size_t largestFreeBlock;
+			size_t regionCount;
+			// 1 - largest free block / total free, 0 when all free space is contiguous
+			float fragmentation;
+		};
+
+		using SourceStats = std::array<TagStats, static_cast<size_t>(MemoryTag::Count)>;
+
+		const char* getTagName(MemoryTag tag);
+		const char* getSourceName(MemorySource source);
+
+		// Tag applied to ResourceManager and heap allocations made on this thread.
+		// Without tracking these are empty inlines so callers compile down to nothing
+#if HVK_MEMORY_STATS
+		MemoryTag getCurrentTag();
+		void setCurrentTag(MemoryTag tag);
+
+		void recordAlloc(MemorySource source, MemoryTag tag, size_t bytes);
+		void recordFree(MemorySource source, MemoryTag tag, size_t bytes);
+#else
+		inline MemoryTag getCurrentTag() { return MemoryTag::General; }
+		inline void setCurrentTag(MemoryTag) {}
+
+		inline void recordAlloc(MemorySource, MemoryTag, size_t) {}
+		inline void recordFree(MemorySource, MemoryTag, size_t) {}
+#endif
+
+		// Mark a frame boundary; call once per frame
+		void endFrame();
+
+		// Number of global operator new calls made during the last completed frame
+		size_t getFrameHeapAllocations();
+
+		// Number of global operator new calls made since startup
+		size_t getTotalHeapAllocations();
+
+#if HVK_MEMORY_STATS
+		inline bool isHeapCountingEnabled() { return true; }
+		// Per-tag stats for a source, frameAllocations is for the last completed frame
+		SourceStats getSourceStats(MemorySource source);
+#else
+		inline bool isHeapCountingEnabled() { return false; }
+		inline SourceStats getSourceStats(MemorySource) { return {}; }
+#endif
+		HeapStats getResourceManagerStats();
+
+		// Write all stats to a file, as CSV if the filename ends in .csv and JSON otherwise
+		bool writeReport(const char* filename);
+	}
+
+	// Scoped override of the current thread's memory tag
+	class MemoryTagScope
+	{
+	private:
+		MemoryTag mPrevious;
+	public:
+		MemoryTagScope(MemoryTag tag) :
+			mPrevious(memory::getCurrentTag())
+		{
+			memory::setCurrentTag(tag);
+		}
+
+		~MemoryTagScope()
+		{
+			memory::setCurrentTag(mPrevious);
+		}
+
+		MemoryTagScope(const MemoryTagScope&) = delete;
+		MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+	};
+}
@@ -0,0 +1,758 @@
+#include "pch.h"
+#include "MeshCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+
+#include "gltf.h"
+#include "Hash.h"
+#include "MemoryStats.h"
+
+namespace hvk
+{
+	namespace
+	{
+		const char COOKED_MAGIC[4] = { 'H', 'V', 'K', 'M' };
+		const char* COOKED_EXTENSION = ".hvkmesh";
+		// Payloads start on this boundary so vertices can be streamed with aligned loads
+		const uint64_t PAYLOAD_ALIGNMENT = 16;
+
+		struct FileHeader
+		{
+			char magic[4];
+			uint32_t version;
+			uint64_t sourceKey;
+			uint32_t vertexEncoding;
+			uint32_t attributeStride;
+			uint32_t dependencyCount;
+			uint32_t meshCount;
+			uint32_t imageCount;
+			uint32_t padding;
+			uint64_t dependencyOffset;
+			uint64_t meshOffset;
+			uint64_t imageOffset;
+		};
+
+		struct DependencyRecord
+		{
+			uint64_t pathOffset;
+			uint32_t pathLength;
+			uint32_t padding;
+		};
+
+		struct MeshRecord
+		{
+			uint32_t vertexCount;
+			uint32_t indexCount;
+			uint32_t submeshCount;
+			uint32_t materialCount;
+			uint32_t indexType;
+			float boundsMin[3];
+			float boundsMax[3];
+			uint32_t lodCount;
+			uint32_t meshletCount;
+			uint32_t padding;
+			uint64_t positionOffset;
+			uint64_t attributeOffset;
+			uint64_t indexOffset;
+			uint64_t submeshOffset;
+			uint64_t lodErrorOffset;
+			uint64_t meshletRangeOffset;
+			uint64_t meshletOffset;
+			uint64_t materialOffset;
+		};
+
+		// A whole KTX2 file
+		struct ImageRecord
+		{
+			uint64_t offset;
+			uint64_t size;
+		};
+
+		static_assert(sizeof(Submesh) == 5 * sizeof(uint32_t), "Submesh is written to cooked models as-is");
+		static_assert(sizeof(CookedMaterial) == 3 * sizeof(int32_t), "CookedMaterial is written to cooked models as-is");
+		static_assert(sizeof(MeshletRange) == 2 * sizeof(uint32_t), "MeshletRange is written to cooked models as-is");
+		static_assert(sizeof(Meshlet) == 14 * sizeof(uint32_t), "Meshlet is written to cooked models as-is");
+
+		uint64_t alignOffset(uint64_t offset, uint64_t alignment)
+		{
+			return (offset + alignment - 1) & ~(alignment - 1);
+		}
+
+		bool inFile(uint64_t offset, uint64_t size, size_t fileSize)
+		{
+			return offset <= fileSize && size <= fileSize - offset;
+		}
+
+		std::string getDirectory(const std::string& path)
+		{
+			const size_t slash = path.find_last_of("/\\");
+			return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+		}
+
+		bool isExternalUri(const std::string& uri)
+		{
+			return !uri.empty() && uri.compare(0, 5, "data:") != 0;
+		}
+
+		// Cooked images and vertices are only valid for the settings they were cooked with
+		bool computeCookKey(
+			const std::string& sourcePath,
+			const std::vector<std::string>& dependencies,
+			const TextureCookSettings& settings,
+			const MeshCookSettings& meshSettings,
+			uint64_t& outKey)
+		{
+			uint64_t sourceKey;
+			if (!computeSourceKey(sourcePath, dependencies, sourceKey))
+			{
+				return false;
+			}
+			outKey = hash::combine(sourceKey, getTextureCookSettingsKey(settings));
+			outKey = hash::combine(outKey, static_cast<uint64_t>(meshSettings.vertexEncoding));
+			outKey = hash::combine(outKey,
+				(meshSettings.optimize.enabled ? 1ULL : 0ULL) |
+				(meshSettings.optimize.optimizeOverdraw ? 2ULL : 0ULL) |
+				(meshSettings.lods.enabled ? 4ULL : 0ULL));
+			const std::vector<float>& targetErrors = meshSettings.lods.targetErrors;
+			outKey = hash::combine(outKey, hash::hashBytes(targetErrors.data(), targetErrors.size() * sizeof(float)));
+			outKey = hash::combine(outKey, hash::hashBytes(&meshSettings.lods.maxTriangleRatio, sizeof(float)));
+			outKey = hash::combine(outKey,
+				(meshSettings.meshlets.enabled ? 1ULL : 0ULL) |
+				(static_cast<uint64_t>(meshSettings.meshlets.maxVertices) << 8) |
+				(static_cast<uint64_t>(meshSettings.meshlets.maxTriangles) << 32));
+			return true;
+		}
+
+		// The cooker takes 8 bit RGBA; greyscale and 16 bit images are expanded the way stb_image would
+		std::vector<uint8_t> convertToRgba8(const tinygltf::Image& image)
+		{
+			const size_t texelCount = static_cast<size_t>(image.width) * image.height;
+			const int components = image.component;
+			const int bytesPerChannel = image.bits / 8;
+			std::vector<uint8_t> rgba(texelCount * 4);
+			for (size_t i = 0; i < texelCount; ++i)
+			{
+				uint8_t channels[4] = { 0, 0, 0, 255 };
+				for (int c = 0; c < components; ++c)
+				{
+					// The high byte of a little endian 16 bit channel
+					channels[c] = image.image[(i * components + c) * bytesPerChannel + bytesPerChannel - 1];
+				}
+				uint8_t* texel = rgba.data() + i * 4;
+				if (components <= 2)
+				{
+					texel[0] = texel[1] = texel[2] = channels[0];
+					texel[3] = components == 2 ? channels[1] : 255;
+				}
+				else
+				{
+					memcpy(texel, channels, sizeof(channels));
+				}
+			}
+			return rgba;
+		}
+
+		// Everything tinygltf read besides the source file itself
+		std::vector<std::string> gatherDependencies(const tinygltf::Model& model)
+		{
+			std::vector<std::string> dependencies;
+			for (const auto& buffer : model.buffers)
+			{
+				if (isExternalUri(buffer.uri))
+				{
+					dependencies.push_back(buffer.uri);
+				}
+			}
+			for (const auto& image : model.images)
+			{
+				if (isExternalUri(image.uri))
+				{
+					dependencies.push_back(image.uri);
+				}
+			}
+			std::sort(dependencies.begin(), dependencies.end());
+			dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+			return dependencies;
+		}
+
+		// Writes sections in offset order, padding the gaps left for alignment
+		class CookedWriter
+		{
+		private:
+			std::ofstream mStream;
+			uint64_t mOffset;
+
+		public:
+			CookedWriter(const std::string& path) :
+				mStream(path, std::ios::binary | std::ios::trunc),
+				mOffset(0)
+			{
+			}
+
+			bool isGood() const { return mStream.good(); }
+
+			void write(uint64_t offset, const void* data, size_t size)
+			{
+				assert(offset >= mOffset);
+				static const char zeroes[PAYLOAD_ALIGNMENT] = {};
+				while (mOffset < offset)
+				{
+					const size_t padding = static_cast<size_t>(std::min<uint64_t>(offset - mOffset, sizeof(zeroes)));
+					mStream.write(zeroes, padding);
+					mOffset += padding;
+				}
+				mStream.write(static_cast<const char*>(data), size);
+				mOffset += size;
+			}
+		};
+	}
+
+	CookedModel::CookedModel() :
+		mFile(),
+		mSourceKey(0),
+		mVertexEncoding(VertexEncoding::Full),
+		mDependencies(),
+		mMeshes(),
+		mImages()
+	{
+	}
+
+	bool CookedModel::open(const std::string& cachePath)
+	{
+		close();
+		if (!mFile.open(cachePath))
+		{
+			return false;
+		}
+
+		const uint8_t* data = mFile.getData();
+		const size_t size = mFile.getSize();
+
+		FileHeader header;
+		if (size < sizeof(header))
+		{
+			close();
+			return false;
+		}
+		memcpy(&header, data, sizeof(header));
+		const VertexEncoding vertexEncoding = static_cast<VertexEncoding>(header.vertexEncoding);
+		const bool headerValid =
+			memcmp(header.magic, COOKED_MAGIC, sizeof(COOKED_MAGIC)) == 0 &&
+			header.version == COOKED_MODEL_VERSION &&
+			(vertexEncoding == VertexEncoding::Full || vertexEncoding == VertexEncoding::Packed) &&
+			header.attributeStride == getVertexAttributeStride(vertexEncoding) &&
+			inFile(header.dependencyOffset, static_cast<uint64_t>(header.dependencyCount) * sizeof(DependencyRecord), size) &&
+			inFile(header.meshOffset, static_cast<uint64_t>(header.meshCount) * sizeof(MeshRecord), size) &&
+			inFile(header.imageOffset, static_cast<uint64_t>(header.imageCount) * sizeof(ImageRecord), size);
+		if (!headerValid)
+		{
+			close();
+			return false;
+		}
+		mSourceKey = header.sourceKey;
+		mVertexEncoding = vertexEncoding;
+
+		mDependencies.reserve(header.dependencyCount);
+		for (uint32_t i = 0; i < header.dependencyCount; ++i)
+		{
+			DependencyRecord record;
+			memcpy(&record, data + header.dependencyOffset + i * sizeof(DependencyRecord), sizeof(record));
+			if (!inFile(record.pathOffset, record.pathLength, size))
+			{
+				close();
+				return false;
+			}
+			mDependencies.emplace_back(reinterpret_cast<const char*>(data + record.pathOffset), record.pathLength);
+		}
+
+		mImages.reserve(header.imageCount);
+		for (uint32_t i = 0; i < header.imageCount; ++i)
+		{
+			ImageRecord record;
+			memcpy(&record, data + header.imageOffset + i * sizeof(ImageRecord), sizeof(record));
+			Ktx2Texture image;
+			if (!inFile(record.offset, record.size, size) ||
+				!parseKtx2(data + record.offset, static_cast<size_t>(record.size), image))
+			{
+				close();
+				return false;
+			}
+			mImages.push_back(std::move(image));
+		}
+
+		mMeshes.reserve(header.meshCount);
+		for (uint32_t i = 0; i < header.meshCount; ++i)
+		{
+			MeshRecord record;
+			memcpy(&record, data + header.meshOffset + i * sizeof(MeshRecord), sizeof(record));
+			const VkIndexType indexType = static_cast<VkIndexType>(record.indexType);
+			const uint64_t indexSize = indexType == VK_INDEX_TYPE_UINT32 ? sizeof(uint32_t) : sizeof(uint16_t);
+			const bool recordValid =
+				(indexType == VK_INDEX_TYPE_UINT16 || indexType == VK_INDEX_TYPE_UINT32) &&
+				record.lodCount > 0 &&
+				record.positionOffset % PAYLOAD_ALIGNMENT == 0 &&
+				record.attributeOffset % PAYLOAD_ALIGNMENT == 0 &&
+				record.indexOffset % sizeof(uint32_t) == 0 &&
+				record.submeshOffset % sizeof(uint32_t) == 0 &&
+				record.lodErrorOffset % sizeof(float) == 0 &&
+				record.meshletRangeOffset % sizeof(uint32_t) == 0 &&
+				record.meshletOffset % sizeof(float) == 0 &&
+				record.materialOffset % sizeof(int32_t) == 0 &&
+				inFile(record.positionOffset, static_cast<uint64_t>(record.vertexCount) * sizeof(PositionVertex), size) &&
+				inFile(record.attributeOffset, static_cast<uint64_t>(record.vertexCount) * header.attributeStride, size) &&
+				inFile(record.indexOffset, record.indexCount * indexSize, size) &&
+				inFile(record.submeshOffset, static_cast<uint64_t>(record.lodCount) * record.submeshCount * sizeof(Submesh), size) &&
+				inFile(record.lodErrorOffset, static_cast<uint64_t>(record.lodCount) * sizeof(float), size) &&
+				inFile(record.meshletRangeOffset, static_cast<uint64_t>(record.lodCount) * record.submeshCount * sizeof(MeshletRange), size) &&
+				inFile(record.meshletOffset, static_cast<uint64_t>(record.meshletCount) * sizeof(Meshlet), size) &&
+				inFile(record.materialOffset, static_cast<uint64_t>(record.materialCount) * sizeof(CookedMaterial), size);
+			if (!recordValid)
+			{
+				close();
+				return false;
+			}
+
+			CookedMesh mesh;
+			mesh.positions = reinterpret_cast<const PositionVertex*>(data + record.positionOffset);
+			mesh.attributes = data + record.attributeOffset;
+			mesh.vertexCount = record.vertexCount;
+			mesh.indices = data + record.indexOffset;
+			mesh.indexCount = record.indexCount;
+			mesh.indexType = indexType;
+			mesh.submeshes = reinterpret_cast<const Submesh*>(data + record.submeshOffset);
+			mesh.submeshCount = record.submeshCount;
+			mesh.lodErrors = reinterpret_cast<const float*>(data + record.lodErrorOffset);
+			mesh.lodCount = record.lodCount;
+			mesh.meshletRanges = reinterpret_cast<const MeshletRange*>(data + record.meshletRangeOffset);
+			mesh.meshlets = reinterpret_cast<const Meshlet*>(data + record.meshletOffset);
+			mesh.meshletCount = record.meshletCount;
+			mesh.materials = reinterpret_cast<const CookedMaterial*>(data + record.materialOffset);
+			mesh.materialCount = record.materialCount;
+			mesh.boundsMin = glm::vec3(record.boundsMin[0], record.boundsMin[1], record.boundsMin[2]);
+			mesh.boundsMax = glm::vec3(record.boundsMax[0], record.boundsMax[1], record.boundsMax[2]);
+
+			// Submeshes must draw from inside the mesh's buffers and meshlet ranges stay inside the table
+			for (uint32_t s = 0; s < mesh.lodCount * mesh.submeshCount; ++s)
+			{
+				const Submesh& submesh = mesh.submeshes[s];
+				const MeshletRange& range = mesh.meshletRanges[s];
+				if (static_cast<uint64_t>(submesh.firstIndex) + submesh.indexCount > mesh.indexCount ||
+					static_cast<uint64_t>(submesh.vertexOffset) + submesh.vertexCount > mesh.vertexCount ||
+					range.firstMeshlet > mesh.meshletCount ||
+					range.meshletCount > mesh.meshletCount - range.firstMeshlet)
+				{
+					close();
+					return false;
+				}
+			}
+
+			// Meshlets must also stay inside the index buffer
+			for (uint32_t m = 0; m < mesh.meshletCount; ++m)
+			{
+				const Meshlet& meshlet = mesh.meshlets[m];
+				if (static_cast<uint64_t>(meshlet.firstIndex) + meshlet.indexCount > mesh.indexCount)
+				{
+					close();
+					return false;
+				}
+			}
+
+			// Materials must only reference images that exist
+			for (uint32_t m = 0; m < mesh.materialCount; ++m)
+			{
+				const CookedMaterial& material = mesh.materials[m];
+				for (int32_t image : { material.albedo, material.metallicRoughness, material.normal })
+				{
+					if (image >= static_cast<int32_t>(header.imageCount))
+					{
+						close();
+						return false;
+					}
+				}
+			}
+			mMeshes.push_back(mesh);
+		}
+
+		return true;
+	}
+
+	void CookedModel::close()
+	{
+		mMeshes.clear();
+		mImages.clear();
+		mDependencies.clear();
+		mSourceKey = 0;
+		mVertexEncoding = VertexEncoding::Full;
+		mFile.close();
+	}
+
+	std::string getCookedModelPath(const std::string& sourcePath)
+	{
+		return sourcePath + COOKED_EXTENSION;
+	}
+
+	bool computeSourceKey(
+		const std::string& sourcePath,
+		const std::vector<std::string>& dependencies,
+		uint64_t& outKey)
+	{
+		uint64_t key;
+		if (!hash::hashFile(sourcePath, key))
+		{
+			return false;
+		}
+
+		const std::string directory = getDirectory(sourcePath);
+		for (const auto& dependency : dependencies)
+		{
+			uint64_t dependencyHash;
+			if (!hash::hashFile(directory + dependency, dependencyHash))
+			{
+				return false;
+			}
+			key = hash::combine(key, hash::hashBytes(dependency.data(), dependency.size()));
+			key = hash::combine(key, dependencyHash);
+		}
+
+		outKey = key;
+		return true;
+	}
+
+	bool cookGltfModel(
+		const std::string& sourcePath,
+		const std::string& cachePath,
+		const TextureCookSettings& settings,
+		const MeshCookSettings& meshSettings)
+	{
+		MemoryTagScope tagScope(MemoryTag::Assets);
+
+		const auto parseStart = std::chrono::steady_clock::now();
+		tinygltf::Model model;
+		if (!loadGltfModel(sourcePath, model, true))
+		{
+			return false;
+		}
+		const double parseMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - parseStart).count();
+
+		const std::vector<std::string> dependencies = gatherDependencies(model);
+		uint64_t sourceKey;
+		if (!computeCookKey(sourcePath, dependencies, settings, meshSettings, sourceKey))
+		{
+			return false;
+		}
+
+		GltfImportTimings timings;
+		std::vector<StaticMesh> meshes = createMeshFromGltf(model, &timings);
+		timings.parseMs = parseMs;
+		timings.totalMs += parseMs;
+		printGltfImportTimings(sourcePath, timings);
+
+		if (meshSettings.optimize.enabled)
+		{
+			std::vector<StaticMesh> optimized;
+			optimized.reserve(meshes.size());
+			for (size_t i = 0; i < meshes.size(); ++i)
+			{
+				MeshOptimizeReport report;
+				optimized.push_back(optimizeMesh(meshes[i], meshSettings.optimize, &report));
+				std::cout << "Optimized mesh " << i << " of " << sourcePath
+					<< ": vertices " << report.verticesBefore << " -> " << report.verticesAfter
+					<< ", ACMR " << report.before.acmr << " -> " << report.after.acmr
+					<< ", ATVR " << report.before.atvr << " -> " << report.after.atvr << std::endl;
+			}
+			meshes.swap(optimized);
+		}
+
+		// Coarser levels reuse the optimized vertices, so they're generated after them
+		std::vector<std::vector<MeshLod>> meshLods(meshes.size());
+		if (meshSettings.lods.enabled)
+		{
+			for (size_t i = 0; i < meshes.size(); ++i)
+			{
+				meshLods[i] = generateMeshLods(meshes[i], meshSettings.lods);
+				std::cout << "Generated " << meshLods[i].size() << " LODs for mesh " << i << " of " << sourcePath
+					<< ": triangles " << meshes[i].getIndices().size() / 3;
+				for (const auto& lod : meshLods[i])
+				{
+					std::cout << " -> " << lod.indices.size() / 3 << " (error " << lod.error << ")";
+				}
+				std::cout << std::endl;
+			}
+		}
+
+		// Materials share images by pointer, so each is only cooked and written once
+		std::vector<const tinygltf::Image*> images;
+		std::vector<TextureUsage> imageUsages;
+		std::unordered_map<const tinygltf::Image*, int32_t> imageSlots;
+		auto getImageSlot = [&](const HVK_shared<tinygltf::Image>& image, TextureUsage usage) {
+			if (image == nullptr)
+			{
+				return int32_t(-1);
+			}
+			auto found = imageSlots.find(image.get());
+			if (found == imageSlots.end())
+			{
+				found = imageSlots.insert({ image.get(), static_cast<int32_t>(images.size()) }).first;
+				images.push_back(image.get());
+				imageUsages.push_back(usage);
+			}
+			return found->second;
+		};
+
+		std::vector<std::vector<CookedMaterial>> meshMaterials(meshes.size());
+		std::vector<std::vector<uint8_t>> meshIndices(meshes.size());
+		std::vector<uint32_t> meshIndexCounts(meshes.size());
+		std::vector<std::vector<Submesh>> meshSubmeshes(meshes.size());
+		std::vector<std::vector<float>> meshLodErrors(meshes.size());
+		std::vector<std::vector<MeshletRange>> meshMeshletRanges(meshes.size());
+		std::vector<std::vector<Meshlet>> meshMeshlets(meshes.size());
+		std::vector<std::vector<PositionVertex>> meshPositions(meshes.size());
+		std::vector<std::vector<uint8_t>> meshAttributes(meshes.size());
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			const StaticMesh::Vertices& vertices = meshes[i].getVertices();
+			encodeVertices(vertices.data(), vertices.size(), meshSettings.vertexEncoding, meshPositions[i], meshAttributes[i]);
+
+			for (const auto& material : meshes[i].getMaterials())
+			{
+				meshMaterials[i].push_back({
+					getImageSlot(material.diffuseProp.texture, TextureUsage::Albedo),
+					getImageSlot(material.metallicRoughnessProp.texture, TextureUsage::MetallicRoughness),
+					getImageSlot(material.normalProp.texture, TextureUsage::Normal) });
+			}
+
+			// Each level's indices and submeshes follow lod0's
+			StaticMesh::Indices indices = meshes[i].getIndices();
+			meshSubmeshes[i] = meshes[i].getSubmeshes();
+			meshLodErrors[i].push_back(0.f);
+			for (const MeshLod& lod : meshLods[i])
+			{
+				const uint32_t lodFirstIndex = static_cast<uint32_t>(indices.size());
+				indices.insert(indices.end(), lod.indices.begin(), lod.indices.end());
+				for (Submesh submesh : lod.submeshes)
+				{
+					submesh.firstIndex += lodFirstIndex;
+					meshSubmeshes[i].push_back(submesh);
+				}
+				meshLodErrors[i].push_back(lod.error);
+			}
+			meshIndexCounts[i] = static_cast<uint32_t>(indices.size());
+
+			// Every level's submeshes are split into meshlets, whose triangles are reordered in place
+			const StaticMesh::Vertices& meshVertices = meshes[i].getVertices();
+			std::vector<uint32_t> submeshIndices;
+			for (const Submesh& submesh : meshSubmeshes[i])
+			{
+				MeshletRange range = { static_cast<uint32_t>(meshMeshlets[i].size()), 0 };
+				if (meshSettings.meshlets.enabled)
+				{
+					submeshIndices.assign(
+						indices.begin() + submesh.firstIndex,
+						indices.begin() + submesh.firstIndex + submesh.indexCount);
+					std::vector<Meshlet> meshlets = buildMeshlets(
+						meshVertices.data() + submesh.vertexOffset,
+						submesh.vertexCount,
+						submeshIndices,
+						meshSettings.meshlets);
+					std::copy(submeshIndices.begin(), submeshIndices.end(), indices.begin() + submesh.firstIndex);
+					for (Meshlet& meshlet : meshlets)
+					{
+						meshlet.firstIndex += submesh.firstIndex;
+						meshMeshlets[i].push_back(meshlet);
+					}
+					range.meshletCount = static_cast<uint32_t>(meshlets.size());
+				}
+				meshMeshletRanges[i].push_back(range);
+			}
+
+			// Indices are stored at the width they're drawn with
+			if (meshes[i].getIndexType() == VK_INDEX_TYPE_UINT16)
+			{
+				meshIndices[i].resize(indices.size() * sizeof(uint16_t));
+				auto* narrow = reinterpret_cast<uint16_t*>(meshIndices[i].data());
+				for (size_t j = 0; j < indices.size(); ++j)
+				{
+					assert(indices[j] <= std::numeric_limits<uint16_t>::max());
+					narrow[j] = static_cast<uint16_t>(indices[j]);
+				}
+			}
+			else
+			{
+				meshIndices[i].resize(indices.size() * sizeof(uint32_t));
+				memcpy(meshIndices[i].data(), indices.data(), meshIndices[i].size());
+			}
+		}
+
+		// Lay out the file: header, tables, then aligned payloads
+		FileHeader header = {};
+		memcpy(header.magic, COOKED_MAGIC, sizeof(COOKED_MAGIC));
+		header.version = COOKED_MODEL_VERSION;
+		header.sourceKey = sourceKey;
+		header.vertexEncoding = static_cast<uint32_t>(meshSettings.vertexEncoding);
+		header.attributeStride = getVertexAttributeStride(meshSettings.vertexEncoding);
+		header.dependencyCount = static_cast<uint32_t>(dependencies.size());
+		header.meshCount = static_cast<uint32_t>(meshes.size());
+		header.imageCount = static_cast<uint32_t>(images.size());
+
+		uint64_t cursor = sizeof(FileHeader);
+		header.dependencyOffset = cursor;
+		cursor += dependencies.size() * sizeof(DependencyRecord);
+		header.meshOffset = cursor;
+		cursor += meshes.size() * sizeof(MeshRecord);
+		header.imageOffset = cursor;
+		cursor += images.size() * sizeof(ImageRecord);
+
+		std::vector<DependencyRecord> dependencyRecords(dependencies.size());
+		for (size_t i = 0; i < dependencies.size(); ++i)
+		{
+			dependencyRecords[i] = { cursor, static_cast<uint32_t>(dependencies[i].size()), 0 };
+			cursor += dependencies[i].size();
+		}
+
+		std::vector<MeshRecord> meshRecords(meshes.size());
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			const StaticMesh& mesh = meshes[i];
+			MeshRecord& record = meshRecords[i];
+			record = {};
+			record.vertexCount = static_cast<uint32_t>(mesh.getVertices().size());
+			record.indexCount = meshIndexCounts[i];
+			record.submeshCount = static_cast<uint32_t>(mesh.getSubmeshes().size());
+			record.lodCount = static_cast<uint32_t>(meshLodErrors[i].size());
+			record.meshletCount = static_cast<uint32_t>(meshMeshlets[i].size());
+			record.materialCount = static_cast<uint32_t>(meshMaterials[i].size());
+			record.indexType = static_cast<uint32_t>(mesh.getIndexType());
+
+			glm::vec3 boundsMin(0.f);
+			glm::vec3 boundsMax(0.f);
+			if (!mesh.getVertices().empty())
+			{
+				boundsMin = boundsMax = mesh.getVertices().front().pos;
+				for (const auto& vertex : mesh.getVertices())
+				{
+					boundsMin = glm::min(boundsMin, vertex.pos);
+					boundsMax = glm::max(boundsMax, vertex.pos);
+				}
+			}
+			memcpy(record.boundsMin, &boundsMin, sizeof(record.boundsMin));
+			memcpy(record.boundsMax, &boundsMax, sizeof(record.boundsMax));
+
+			record.positionOffset = alignOffset(cursor, PAYLOAD_ALIGNMENT);
+			cursor = record.positionOffset + meshPositions[i].size() * sizeof(PositionVertex);
+			record.attributeOffset = alignOffset(cursor, PAYLOAD_ALIGNMENT);
+			cursor = record.attributeOffset + meshAttributes[i].size();
+			record.indexOffset = alignOffset(cursor, PAYLOAD_ALIGNMENT);
+			cursor = record.indexOffset + meshIndices[i].size();
+			record.submeshOffset = alignOffset(cursor, PAYLOAD_ALIGNMENT);
+			cursor = record.submeshOffset + meshSubmeshes[i].size() * sizeof(Submesh);
+			record.lodErrorOffset = alignOffset(cursor, PAYLOAD_ALIGNMENT);
+			cursor = record.lodErrorOffset + meshLodErrors[i].size() * sizeof(float);
+			record.meshletRangeOffset = alignOffset(cursor, PAYLOAD_ALIGNMENT);
+			cursor = record.meshletRangeOffset + meshMeshletRanges[i].size() * sizeof(MeshletRange);
+			record.meshletOffset = alignOffset(cursor, PAYLOAD_ALIGNMENT);
+			cursor = record.meshletOffset + meshMeshlets[i].size() * sizeof(Meshlet);
+			record.materialOffset = alignOffset(cursor, PAYLOAD_ALIGNMENT);
+			cursor = record.materialOffset + meshMaterials[i].size() * sizeof(CookedMaterial);
+		}
+
+		const auto textureStart = std::chrono::steady_clock::now();
+		std::vector<std::vector<uint8_t>> cookedImages(images.size());
+		std::vector<ImageRecord> imageRecords(images.size());
+		for (size_t i = 0; i < images.size(); ++i)
+		{
+			const tinygltf::Image& image = *images[i];
+			const std::vector<uint8_t> rgba = convertToRgba8(image);
+			if (!cookTexture(
+				rgba.data(),
+				static_cast<uint32_t>(image.width),
+				static_cast<uint32_t>(image.height),
+				imageUsages[i],
+				settings,
+				sourceKey,
+				cookedImages[i]))
+			{
+				return false;
+			}
+
+			ImageRecord& record = imageRecords[i];
+			record.offset = alignOffset(cursor, PAYLOAD_ALIGNMENT);
+			record.size = cookedImages[i].size();
+			cursor = record.offset + record.size;
+		}
+		const double textureMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - textureStart).count();
+		std::cout << "Cooked " << images.size() << " textures for " << sourcePath << " in " << textureMs << "ms" << std::endl;
+
+		// Write next to the destination and swap it in, so a failed cook never leaves a truncated cache
+		const std::string tempPath = cachePath + ".tmp";
+		{
+			CookedWriter writer(tempPath);
+			if (!writer.isGood())
+			{
+				return false;
+			}
+
+			writer.write(0, &header, sizeof(header));
+			writer.write(header.dependencyOffset, dependencyRecords.data(), dependencyRecords.size() * sizeof(DependencyRecord));
+			writer.write(header.meshOffset, meshRecords.data(), meshRecords.size() * sizeof(MeshRecord));
+			writer.write(header.imageOffset, imageRecords.data(), imageRecords.size() * sizeof(ImageRecord));
+			for (size_t i = 0; i < dependencies.size(); ++i)
+			{
+				writer.write(dependencyRecords[i].pathOffset, dependencies[i].data(), dependencies[i].size());
+			}
+			for (size_t i = 0; i < meshes.size(); ++i)
+			{
+				writer.write(meshRecords[i].positionOffset, meshPositions[i].data(), meshPositions[i].size() * sizeof(PositionVertex));
+				writer.write(meshRecords[i].attributeOffset, meshAttributes[i].data(), meshAttributes[i].size());
+				writer.write(meshRecords[i].indexOffset, meshIndices[i].data(), meshIndices[i].size());
+				writer.write(meshRecords[i].submeshOffset, meshSubmeshes[i].data(), meshSubmeshes[i].size() * sizeof(Submesh));
+				writer.write(meshRecords[i].lodErrorOffset, meshLodErrors[i].data(), meshLodErrors[i].size() * sizeof(float));
+				writer.write(meshRecords[i].meshletRangeOffset, meshMeshletRanges[i].data(), meshMeshletRanges[i].size() * sizeof(MeshletRange));
+				writer.write(meshRecords[i].meshletOffset, meshMeshlets[i].data(), meshMeshlets[i].size() * sizeof(Meshlet));
+				writer.write(meshRecords[i].materialOffset, meshMaterials[i].data(), meshMaterials[i].size() * sizeof(CookedMaterial));
+			}
+			for (size_t i = 0; i < images.size(); ++i)
+			{
+				writer.write(imageRecords[i].offset, cookedImages[i].data(), cookedImages[i].size());
+			}
+
+			if (!writer.isGood())
+			{
+				std::remove(tempPath.c_str());
+				return false;
+			}
+		}
+
+		std::remove(cachePath.c_str());
+		return std::rename(tempPath.c_str(), cachePath.c_str()) == 0;
+	}
+
+	bool loadCookedModel(
+		const std::string& sourcePath,
+		CookedModel& outModel,
+		const TextureCookSettings& settings,
+		const MeshCookSettings& meshSettings)
+	{
+		const std::string cachePath = getCookedModelPath(sourcePath);
+
+		if (outModel.open(cachePath))
+		{
+			uint64_t sourceKey;
+			if (computeCookKey(sourcePath, outModel.getDependencies(), settings, meshSettings, sourceKey) &&
+				sourceKey == outModel.getSourceKey())
+			{
+				return true;
+			}
+			// The mapping has to be released before the file can be replaced
+			outModel.close();
+		}
+
+		return cookGltfModel(sourcePath, cachePath, settings, meshSettings) && outModel.open(cachePath);
+	}
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "HvkUtil.h"
+#include "StaticMesh.h"
+#include "MappedFile.h"
+#include "Ktx2.h"
+#include "TextureCooker.h"
+#include "VertexEncoding.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+
+namespace hvk
+{
+	// Indices into the cooked model's images, -1 where the material has no texture
+	struct CookedMaterial
+	{
+		int32_t albedo;
+		int32_t metallicRoughness;
+		int32_t normal;
+	};
+
+	// Views into a mapped cooked model. Vertices and indices are already in the
+	// layout they're drawn with: a position stream and an attribute stream in the
+	// model's VertexEncoding, and indexType wide indices. Each level of detail draws from the
+	// same vertices; the levels' indices follow each other in the index buffer
+	struct CookedMesh
+	{
+		const PositionVertex* positions;
+		const void* attributes;
+		uint32_t vertexCount;
+		const void* indices;
+		uint32_t indexCount;
+		VkIndexType indexType;
+		// lodCount levels of submeshCount submeshes each, finest first
+		const Submesh* submeshes;
+		uint32_t submeshCount;
+		// How far each level's surface may be from lod0's in object space, so 0 for lod0
+		const float* lodErrors;
+		uint32_t lodCount;
+		// Parallel to submeshes; a submesh without meshlets has a meshletCount of 0
+		const MeshletRange* meshletRanges;
+		const Meshlet* meshlets;
+		uint32_t meshletCount;
+		const CookedMaterial* materials;
+		uint32_t materialCount;
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+	};
+
+	// A cooked model file mapped into memory; every view is valid for the lifetime of the object
+	class CookedModel
+	{
+	private:
+		MappedFile mFile;
+		uint64_t mSourceKey;
+		VertexEncoding mVertexEncoding;
+		std::vector<std::string> mDependencies;
+		std::vector<CookedMesh> mMeshes;
+		std::vector<Ktx2Texture> mImages;
+
+	public:
+		CookedModel();
+
+		// Maps and validates the file's layout; doesn't check whether the source has changed
+		bool open(const std::string& cachePath);
+		void close();
+
+		uint64_t getSourceKey() const { return mSourceKey; }
+		VertexEncoding getVertexEncoding() const { return mVertexEncoding; }
+		// Files the source references, relative to its directory
+		const std::vector<std::string>& getDependencies() const { return mDependencies; }
+		const std::vector<CookedMesh>& getMeshes() const { return mMeshes; }
+		// Cooked textures embedded as KTX2, ready to be copied into a staging buffer
+		const std::vector<Ktx2Texture>& getImages() const { return mImages; }
+	};
+
+	const uint32_t COOKED_MODEL_VERSION = 6;
+
+	struct MeshCookSettings
+	{
+		VertexEncoding vertexEncoding = VertexEncoding::Full;
+		MeshOptimizeSettings optimize;
+		MeshLodSettings lods;
+		MeshletSettings meshlets;
+	};
+
+	std::string getCookedModelPath(const std::string& sourcePath);
+
+	// Hash of the source file and each dependency, which invalidates the cache when any of them change
+	bool computeSourceKey(
+		const std::string& sourcePath,
+		const std::vector<std::string>& dependencies,
+		uint64_t& outKey);
+
+	// Imports a glTF file and writes its meshes, materials and images to cachePath. Each image
+	// is cooked for the first material slot that samples it; each mesh is optimized, given its
+	// coarser levels of detail, split into meshlets and has its vertices stored as meshSettings ask
+	bool cookGltfModel(
+		const std::string& sourcePath,
+		const std::string& cachePath,
+		const TextureCookSettings& settings = TextureCookSettings(),
+		const MeshCookSettings& meshSettings = MeshCookSettings());
+
+	// Maps the cooked model for sourcePath, (re)cooking it first if the cache is missing,
+	// was written by a different version or with other settings, or the source has changed since
+	bool loadCookedModel(
+		const std::string& sourcePath,
+		CookedModel& outModel,
+		const TextureCookSettings& settings = TextureCookSettings(),
+		const MeshCookSettings& meshSettings = MeshCookSettings());
+}
@@ -0,0 +1,437 @@
+#include "pch.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+#include "Hash.h"
+
+namespace hvk {
+
+	namespace {
+
+		const uint32_t INVALID_INDEX = UINT32_MAX;
+
+		// Forsyth's scoring cache is an LRU, larger than the FIFO the result is measured with
+		const int32_t SCORE_CACHE_SIZE = 32;
+		const float CACHE_DECAY_POWER = 1.5f;
+		const float LAST_TRIANGLE_SCORE = 0.75f;
+		const float VALENCE_BOOST_SCALE = 2.f;
+		const float VALENCE_BOOST_POWER = 0.5f;
+
+		// Timestamps stand in for FIFO positions: a vertex is cached if it missed within the last cacheSize misses
+		uint32_t countCacheMisses(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+		{
+			std::vector<uint32_t> timestamps(vertexCount, 0);
+			uint32_t time = cacheSize + 1;
+			uint32_t misses = 0;
+			for (size_t i = 0; i < indexCount; ++i)
+			{
+				const uint32_t index = indices[i];
+				if (time - timestamps[index] > cacheSize)
+				{
+					timestamps[index] = time++;
+					++misses;
+				}
+			}
+			return misses;
+		}
+
+		float scoreVertex(int32_t cachePosition, uint32_t remainingTriangles)
+		{
+			if (remainingTriangles == 0)
+			{
+				return -1.f;
+			}
+
+			float score = 0.f;
+			if (cachePosition >= 0)
+			{
+				// The last triangle's vertices score the same so it isn't simply repeated
+				if (cachePosition < 3)
+				{
+					score = LAST_TRIANGLE_SCORE;
+				}
+				else
+				{
+					const float scale = 1.f / (SCORE_CACHE_SIZE - 3);
+					score = std::pow(1.f - (cachePosition - 3) * scale, CACHE_DECAY_POWER);
+				}
+			}
+
+			// Vertices with few triangles left are worth finishing off
+			score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+			return score;
+		}
+
+		struct VertexKeyHash
+		{
+			size_t operator()(const Vertex& vertex) const
+			{
+				return static_cast<size_t>(hash::hashBytes(&vertex, sizeof(Vertex)));
+			}
+		};
+
+		struct VertexKeyEqual
+		{
+			bool operator()(const Vertex& a, const Vertex& b) const
+			{
+				return memcmp(&a, &b, sizeof(Vertex)) == 0;
+			}
+		};
+
+		static_assert(sizeof(Vertex) == 12 * sizeof(float), "Vertices are welded by their bytes, so they can't have padding");
+
+		// Indices are rewritten to point at the first of each set of identical vertices
+		void weldVertices(const Vertex* vertices, uint32_t vertexCount, std::vector<uint32_t>& indices)
+		{
+			std::unordered_map<Vertex, uint32_t, VertexKeyHash, VertexKeyEqual> firstSeen;
+			firstSeen.reserve(vertexCount);
+			std::vector<uint32_t> remap(vertexCount);
+			for (uint32_t i = 0; i < vertexCount; ++i)
+			{
+				remap[i] = firstSeen.insert({ vertices[i], i }).first->second;
+			}
+			for (auto& index : indices)
+			{
+				index = remap[index];
+			}
+		}
+
+		std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount)
+		{
+			const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+			std::vector<uint32_t> result;
+			result.reserve(indices.size());
+			if (triangleCount == 0)
+			{
+				return result;
+			}
+
+			// Triangles using each vertex; each vertex's first remaining entries are the ones not yet emitted
+			std::vector<uint32_t> remaining(vertexCount, 0);
+			for (uint32_t index : indices)
+			{
+				++remaining[index];
+			}
+			std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+			for (uint32_t v = 0; v < vertexCount; ++v)
+			{
+				adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remaining[v];
+			}
+			std::vector<uint32_t> adjacency(indices.size());
+			{
+				std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+				for (uint32_t t = 0; t < triangleCount; ++t)
+				{
+					for (uint32_t corner = 0; corner < 3; ++corner)
+					{
+						adjacency[cursor[indices[t * 3 + corner]]++] = t;
+					}
+				}
+			}
+
+			std::vector<int32_t> cachePositions(vertexCount, -1);
+			std::vector<float> vertexScores(vertexCount);
+			for (uint32_t v = 0; v < vertexCount; ++v)
+			{
+				vertexScores[v] = scoreVertex(-1, remaining[v]);
+			}
+
+			std::vector<float> triangleScores(triangleCount);
+			std::vector<bool> emitted(triangleCount, false);
+			uint32_t bestTriangle = 0;
+			for (uint32_t t = 0; t < triangleCount; ++t)
+			{
+				triangleScores[t] =
+					vertexScores[indices[t * 3]] +
+					vertexScores[indices[t * 3 + 1]] +
+					vertexScores[indices[t * 3 + 2]];
+				if (triangleScores[t] > triangleScores[bestTriangle])
+				{
+					bestTriangle = t;
+				}
+			}
+
+			std::vector<uint32_t> cache;
+			std::vector<uint32_t> nextCache;
+			cache.reserve(SCORE_CACHE_SIZE + 3);
+			nextCache.reserve(SCORE_CACHE_SIZE + 3);
+			uint32_t unemittedCursor = 0;
+			for (uint32_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+			{
+				// Nothing in the cache has triangles left, so carry on from the first unemitted one
+				if (bestTriangle == INVALID_INDEX)
+				{
+					while (emitted[unemittedCursor])
+					{
+						++unemittedCursor;
+					}
+					bestTriangle = unemittedCursor;
+				}
+
+				const uint32_t* triangle = &indices[bestTriangle * 3];
+				result.insert(result.end(), triangle, triangle + 3);
+				emitted[bestTriangle] = true;
+
+				nextCache.clear();
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					const uint32_t vertex = triangle[corner];
+					uint32_t* begin = &adjacency[adjacencyOffsets[vertex]];
+					uint32_t* end = begin + remaining[vertex];
+					uint32_t* found = std::find(begin, end, bestTriangle);
+					assert(found != end);
+					std::swap(*found, *(end - 1));
+					--remaining[vertex];
+					// Degenerate triangles can name a vertex twice
+					if (std::find(nextCache.begin(), nextCache.end(), vertex) == nextCache.end())
+					{
+						nextCache.push_back(vertex);
+					}
+				}
+				for (uint32_t vertex : cache)
+				{
+					if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+					{
+						nextCache.push_back(vertex);
+					}
+				}
+
+				// Vertices pushed out of the cache lose their cache score
+				for (size_t i = SCORE_CACHE_SIZE; i < nextCache.size(); ++i)
+				{
+					cachePositions[nextCache[i]] = -1;
+				}
+
+				bestTriangle = INVALID_INDEX;
+				float bestScore = -1.f;
+				for (size_t i = 0; i < nextCache.size(); ++i)
+				{
+					const uint32_t vertex = nextCache[i];
+					if (i < SCORE_CACHE_SIZE)
+					{
+						cachePositions[vertex] = static_cast<int32_t>(i);
+					}
+					const float score = scoreVertex(cachePositions[vertex], remaining[vertex]);
+					const float delta = score - vertexScores[vertex];
+					vertexScores[vertex] = score;
+
+					const uint32_t begin = adjacencyOffsets[vertex];
+					for (uint32_t j = begin; j < begin + remaining[vertex]; ++j)
+					{
+						const uint32_t t = adjacency[j];
+						triangleScores[t] += delta;
+						if (triangleScores[t] > bestScore)
+						{
+							bestScore = triangleScores[t];
+							bestTriangle = t;
+						}
+					}
+				}
+
+				nextCache.resize(std::min<size_t>(nextCache.size(), SCORE_CACHE_SIZE));
+				std::swap(cache, nextCache);
+			}
+
+			return result;
+		}
+
+		// Splits the triangles into runs wherever the cache would start cold anyway, then orders the
+		// runs by how far they face away from the mesh's centre, so silhouettes come before interiors
+		std::vector<uint32_t> optimizeOverdraw(
+			const std::vector<uint32_t>& indices,
+			const Vertex* vertices,
+			uint32_t vertexCount,
+			uint32_t cacheSize)
+		{
+			const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+			std::vector<uint32_t> clusterStarts;
+			std::vector<uint32_t> timestamps(vertexCount, 0);
+			uint32_t time = cacheSize + 1;
+			for (uint32_t t = 0; t < triangleCount; ++t)
+			{
+				uint32_t misses = 0;
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					const uint32_t index = indices[t * 3 + corner];
+					if (time - timestamps[index] > cacheSize)
+					{
+						timestamps[index] = time++;
+						++misses;
+					}
+				}
+				if (t == 0 || misses == 3)
+				{
+					clusterStarts.push_back(t);
+				}
+			}
+			clusterStarts.push_back(triangleCount);
+
+			const size_t clusterCount = clusterStarts.size() - 1;
+			std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3(0.f));
+			std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.f));
+			std::vector<float> clusterAreas(clusterCount, 0.f);
+			glm::vec3 meshCentroid(0.f);
+			float meshArea = 0.f;
+			for (size_t c = 0; c < clusterCount; ++c)
+			{
+				for (uint32_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t)
+				{
+					const glm::vec3& a = vertices[indices[t * 3]].pos;
+					const glm::vec3& b = vertices[indices[t * 3 + 1]].pos;
+					const glm::vec3& p = vertices[indices[t * 3 + 2]].pos;
+					const glm::vec3 normal = glm::cross(b - a, p - a);
+					const float area = glm::length(normal);
+					clusterCentroids[c] += (a + b + p) * (area / 3.f);
+					clusterNormals[c] += normal;
+					clusterAreas[c] += area;
+				}
+				meshCentroid += clusterCentroids[c];
+				meshArea += clusterAreas[c];
+			}
+			if (meshArea > 0.f)
+			{
+				meshCentroid /= meshArea;
+			}
+
+			std::vector<float> sortKeys(clusterCount, 0.f);
+			for (size_t c = 0; c < clusterCount; ++c)
+			{
+				const float normalLength = glm::length(clusterNormals[c]);
+				if (clusterAreas[c] > 0.f && normalLength > 0.f)
+				{
+					const glm::vec3 centroid = clusterCentroids[c] / clusterAreas[c];
+					sortKeys[c] = glm::dot(centroid - meshCentroid, clusterNormals[c] / normalLength);
+				}
+			}
+
+			std::vector<uint32_t> order(clusterCount);
+			for (uint32_t c = 0; c < clusterCount; ++c)
+			{
+				order[c] = c;
+			}
+			std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32_t a, uint32_t b) {
+				return sortKeys[a] > sortKeys[b];
+			});
+
+			std::vector<uint32_t> result;
+			result.reserve(indices.size());
+			for (uint32_t c : order)
+			{
+				result.insert(
+					result.end(),
+					indices.begin() + clusterStarts[c] * 3,
+					indices.begin() + clusterStarts[c + 1] * 3);
+			}
+			return result;
+		}
+	}
+
+	VertexCacheStats analyzeVertexCache(
+		const uint32_t* indices,
+		size_t indexCount,
+		size_t vertexCount,
+		uint32_t cacheSize)
+	{
+		const uint32_t misses = countCacheMisses(indices, indexCount, vertexCount, cacheSize);
+		VertexCacheStats stats = {};
+		stats.acmr = indexCount > 0 ? static_cast<float>(misses) / (indexCount / 3) : 0.f;
+		stats.atvr = vertexCount > 0 ? static_cast<float>(misses) / vertexCount : 0.f;
+		return stats;
+	}
+
+	std::vector<uint32_t> optimizeIndexOrder(const std::vector<uint32_t>& indices, uint32_t vertexCount)
+	{
+		return optimizeVertexCache(indices, vertexCount);
+	}
+
+	StaticMesh optimizeMesh(
+		const StaticMesh& mesh,
+		const MeshOptimizeSettings& settings,
+		MeshOptimizeReport* outReport)
+	{
+		const StaticMesh::Vertices& vertices = mesh.getVertices();
+		const StaticMesh::Indices& indices = mesh.getIndices();
+
+		StaticMesh::Vertices optimizedVertices;
+		StaticMesh::Indices optimizedIndices;
+		StaticMesh::Submeshes optimizedSubmeshes;
+		optimizedVertices.reserve(vertices.size());
+		optimizedIndices.reserve(indices.size());
+		optimizedSubmeshes.reserve(mesh.getSubmeshes().size());
+
+		uint64_t missesBefore = 0;
+		uint64_t missesAfter = 0;
+		uint64_t triangles = 0;
+		for (const Submesh& submesh : mesh.getSubmeshes())
+		{
+			const Vertex* submeshVertices = vertices.data() + submesh.vertexOffset;
+			std::vector<uint32_t> submeshIndices(
+				indices.begin() + submesh.firstIndex,
+				indices.begin() + submesh.firstIndex + submesh.indexCount);
+			missesBefore += countCacheMisses(
+				submeshIndices.data(),
+				submeshIndices.size(),
+				submesh.vertexCount,
+				DEFAULT_VERTEX_CACHE_SIZE);
+			triangles += submeshIndices.size() / 3;
+
+			if (settings.enabled)
+			{
+				weldVertices(submeshVertices, submesh.vertexCount, submeshIndices);
+				submeshIndices = optimizeVertexCache(submeshIndices, submesh.vertexCount);
+				if (settings.optimizeOverdraw)
+				{
+					submeshIndices = optimizeOverdraw(
+						submeshIndices,
+						submeshVertices,
+						submesh.vertexCount,
+						DEFAULT_VERTEX_CACHE_SIZE);
+				}
+			}
+
+			// Vertices are renumbered in the order they're first fetched, dropping any no triangle uses
+			std::vector<uint32_t> remap(submesh.vertexCount, INVALID_INDEX);
+			Submesh optimizedSubmesh = submesh;
+			optimizedSubmesh.firstIndex = static_cast<uint32_t>(optimizedIndices.size());
+			optimizedSubmesh.vertexOffset = static_cast<uint32_t>(optimizedVertices.size());
+			uint32_t fetched = 0;
+			for (uint32_t index : submeshIndices)
+			{
+				if (remap[index] == INVALID_INDEX)
+				{
+					remap[index] = fetched++;
+					optimizedVertices.push_back(submeshVertices[index]);
+				}
+				optimizedIndices.push_back(remap[index]);
+			}
+			optimizedSubmesh.vertexCount = fetched;
+			optimizedSubmeshes.push_back(optimizedSubmesh);
+
+			missesAfter += countCacheMisses(
+				optimizedIndices.data() + optimizedSubmesh.firstIndex,
+				optimizedSubmesh.indexCount,
+				fetched,
+				DEFAULT_VERTEX_CACHE_SIZE);
+		}
+
+		if (outReport != nullptr)
+		{
+			outReport->verticesBefore = static_cast<uint32_t>(vertices.size());
+			outReport->verticesAfter = static_cast<uint32_t>(optimizedVertices.size());
+			outReport->before.acmr = triangles > 0 ? static_cast<float>(missesBefore) / triangles : 0.f;
+			outReport->before.atvr = !vertices.empty() ? static_cast<float>(missesBefore) / vertices.size() : 0.f;
+			outReport->after.acmr = triangles > 0 ? static_cast<float>(missesAfter) / triangles : 0.f;
+			outReport->after.atvr = !optimizedVertices.empty() ? static_cast<float>(missesAfter) / optimizedVertices.size() : 0.f;
+		}
+
+		return StaticMesh(
+			std::move(optimizedVertices),
+			std::move(optimizedIndices),
+			std::move(optimizedSubmeshes),
+			mesh.getMaterials());
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "StaticMesh.h"
+
+namespace hvk {
+
+	// Post-transform cache efficiency of an index buffer, simulated with a FIFO cache.
+	// ACMR is cache misses per triangle (0.5 is ideal for large regular meshes, 3 the worst);
+	// ATVR is misses per vertex (1 is ideal)
+	struct VertexCacheStats
+	{
+		float acmr;
+		float atvr;
+	};
+
+	const uint32_t DEFAULT_VERTEX_CACHE_SIZE = 16;
+
+	VertexCacheStats analyzeVertexCache(
+		const uint32_t* indices,
+		size_t indexCount,
+		size_t vertexCount,
+		uint32_t cacheSize = DEFAULT_VERTEX_CACHE_SIZE);
+
+	struct MeshOptimizeSettings
+	{
+		// Off leaves the mesh exactly as imported
+		bool enabled = true;
+		// Also orders runs of triangles outside in, so near geometry tends to be drawn first,
+		// at the cost of a few extra cache misses where the runs meet
+		bool optimizeOverdraw = true;
+	};
+
+	struct MeshOptimizeReport
+	{
+		uint32_t verticesBefore;
+		uint32_t verticesAfter;
+		VertexCacheStats before;
+		VertexCacheStats after;
+	};
+
+	// Reorders triangles for the post-transform cache and leaves the vertices where they are,
+	// for index buffers that share another buffer's vertices
+	std::vector<uint32_t> optimizeIndexOrder(const std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+	// Welds bitwise identical vertices, reorders triangles for the post-transform cache
+	// (Forsyth's linear-speed optimizer), optionally for overdraw, then lays vertices out in
+	// the order they're first fetched. Each submesh is optimized on its own and materials are
+	// untouched. The result only depends on the input, so cooks are reproducible
+	StaticMesh optimizeMesh(
+		const StaticMesh& mesh,
+		const MeshOptimizeSettings& settings,
+		MeshOptimizeReport* outReport = nullptr);
+}
@@ -0,0 +1,616 @@
+#include "pch.h"
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+#include "Hash.h"
+#include "MeshOptimizer.h"
+
+namespace hvk {
+
+	namespace {
+
+		const uint32_t INVALID_INDEX = UINT32_MAX;
+		// Triangles around a collapse may not turn further than this, which also keeps them from folding over
+		const float MIN_NORMAL_COSINE = 0.25f;
+		// Each pass collapses a set of independent edges; meshes reach their target in far fewer
+		const uint32_t MAX_PASSES = 64;
+
+		// Symmetric 4x4 matrix of summed squared plane distances: A is the 3x3 part, b the
+		// offset column and c the constant. weight is the area (or edge length) the planes
+		// came from, which turns a quadric's value into a mean squared distance
+		struct Quadric
+		{
+			double a00, a01, a02, a11, a12, a22;
+			double b0, b1, b2;
+			double c;
+			double weight;
+		};
+
+		void addPlane(Quadric& q, const glm::dvec3& normal, double distance, double weight)
+		{
+			q.a00 += weight * normal.x * normal.x;
+			q.a01 += weight * normal.x * normal.y;
+			q.a02 += weight * normal.x * normal.z;
+			q.a11 += weight * normal.y * normal.y;
+			q.a12 += weight * normal.y * normal.z;
+			q.a22 += weight * normal.z * normal.z;
+			q.b0 += weight * normal.x * distance;
+			q.b1 += weight * normal.y * distance;
+			q.b2 += weight * normal.z * distance;
+			q.c += weight * distance * distance;
+			q.weight += weight;
+		}
+
+		void addQuadric(Quadric& q, const Quadric& rhs)
+		{
+			q.a00 += rhs.a00;
+			q.a01 += rhs.a01;
+			q.a02 += rhs.a02;
+			q.a11 += rhs.a11;
+			q.a12 += rhs.a12;
+			q.a22 += rhs.a22;
+			q.b0 += rhs.b0;
+			q.b1 += rhs.b1;
+			q.b2 += rhs.b2;
+			q.c += rhs.c;
+			q.weight += rhs.weight;
+		}
+
+		// Root mean squared distance from p to the quadrics' planes
+		double evaluateError(const Quadric& a, const Quadric& b, const glm::vec3& p)
+		{
+			Quadric q = a;
+			addQuadric(q, b);
+			if (q.weight <= 0.0)
+			{
+				return 0.0;
+			}
+			const double x = p.x;
+			const double y = p.y;
+			const double z = p.z;
+			const double error =
+				q.a00 * x * x + q.a11 * y * y + q.a22 * z * z +
+				2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z) +
+				2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) +
+				q.c;
+			return std::sqrt(std::max(error, 0.0) / q.weight);
+		}
+
+		uint64_t makeEdgeKey(uint32_t from, uint32_t to)
+		{
+			return (static_cast<uint64_t>(from) << 32) | to;
+		}
+
+		bool hasEdge(const std::vector<uint64_t>& sortedEdges, uint32_t from, uint32_t to)
+		{
+			return std::binary_search(sortedEdges.begin(), sortedEdges.end(), makeEdgeKey(from, to));
+		}
+
+		// Manifold vertices collapse along any edge. Border vertices sit on an open edge of the
+		// welded surface and seam vertices join exactly two attribute wedges along a closed one;
+		// either only collapses along its open edges so the outline keeps its shape. Anything
+		// else, like corners and non-manifold fans, stays put
+		enum class VertexKind : uint8_t
+		{
+			Manifold,
+			Border,
+			Seam,
+			Locked
+		};
+
+		struct PositionKeyHash
+		{
+			size_t operator()(const glm::vec3& position) const
+			{
+				return static_cast<size_t>(hash::hashBytes(&position, sizeof(glm::vec3)));
+			}
+		};
+
+		struct PositionKeyEqual
+		{
+			bool operator()(const glm::vec3& a, const glm::vec3& b) const
+			{
+				return memcmp(&a, &b, sizeof(glm::vec3)) == 0;
+			}
+		};
+
+		struct Collapse
+		{
+			float error;
+			uint32_t from;
+			uint32_t to;
+		};
+
+		// Indices are into the whole mesh's vertices; a position is named by the first vertex that has it
+		class Simplifier
+		{
+		private:
+			const Vertex* mVertices;
+			std::vector<uint32_t> mPositions;
+			std::vector<Quadric> mQuadrics;
+			// Planes through open edges, perpendicular to the surface. They're kept apart from the
+			// surface's own planes so a large flat area can't average away a border's error
+			std::vector<Quadric> mBorderQuadrics;
+			std::vector<uint32_t> mTriangles;
+			std::vector<uint32_t> mTriangleSubmeshes;
+			float mError;
+
+			void addTriangleQuadrics();
+			bool runPass(float maxError);
+
+		public:
+			Simplifier(const StaticMesh& mesh);
+
+			// Collapses every edge it can without exceeding maxError
+			void simplify(float maxError);
+
+			uint32_t getTriangleCount() const { return static_cast<uint32_t>(mTriangleSubmeshes.size()); }
+			// The largest collapse error so far
+			float getError() const { return mError; }
+			void getLod(const StaticMesh& mesh, MeshLod& outLod) const;
+		};
+
+		Simplifier::Simplifier(const StaticMesh& mesh) :
+			mVertices(mesh.getVertices().data()),
+			mPositions(mesh.getVertices().size()),
+			mQuadrics(mesh.getVertices().size(), Quadric()),
+			mBorderQuadrics(mesh.getVertices().size(), Quadric()),
+			mTriangles(),
+			mTriangleSubmeshes(),
+			mError(0.f)
+		{
+			const StaticMesh::Vertices& vertices = mesh.getVertices();
+			std::unordered_map<glm::vec3, uint32_t, PositionKeyHash, PositionKeyEqual> firstSeen;
+			firstSeen.reserve(vertices.size());
+			for (uint32_t i = 0; i < vertices.size(); ++i)
+			{
+				mPositions[i] = firstSeen.insert({ vertices[i].pos, i }).first->second;
+			}
+
+			// Triangles that are already degenerate have nothing to lose
+			const StaticMesh::Indices& indices = mesh.getIndices();
+			mTriangles.reserve(indices.size());
+			mTriangleSubmeshes.reserve(indices.size() / 3);
+			const StaticMesh::Submeshes& submeshes = mesh.getSubmeshes();
+			for (uint32_t s = 0; s < submeshes.size(); ++s)
+			{
+				const Submesh& submesh = submeshes[s];
+				for (uint32_t i = 0; i + 2 < submesh.indexCount; i += 3)
+				{
+					const uint32_t a = indices[submesh.firstIndex + i] + submesh.vertexOffset;
+					const uint32_t b = indices[submesh.firstIndex + i + 1] + submesh.vertexOffset;
+					const uint32_t c = indices[submesh.firstIndex + i + 2] + submesh.vertexOffset;
+					if (mPositions[a] != mPositions[b] && mPositions[b] != mPositions[c] && mPositions[c] != mPositions[a])
+					{
+						mTriangles.insert(mTriangles.end(), { a, b, c });
+						mTriangleSubmeshes.push_back(s);
+					}
+				}
+			}
+
+			addTriangleQuadrics();
+		}
+
+		void Simplifier::addTriangleQuadrics()
+		{
+			std::vector<uint64_t> edges;
+			edges.reserve(mTriangles.size());
+			for (size_t t = 0; t < mTriangles.size(); t += 3)
+			{
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					edges.push_back(makeEdgeKey(mTriangles[t + corner], mTriangles[t + (corner + 1) % 3]));
+				}
+			}
+			std::sort(edges.begin(), edges.end());
+
+			for (size_t t = 0; t < mTriangles.size(); t += 3)
+			{
+				const glm::dvec3 p0 = mVertices[mTriangles[t]].pos;
+				const glm::dvec3 p1 = mVertices[mTriangles[t + 1]].pos;
+				const glm::dvec3 p2 = mVertices[mTriangles[t + 2]].pos;
+				glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+				const double length = glm::length(normal);
+				if (length <= 0.0)
+				{
+					continue;
+				}
+				normal /= length;
+
+				const double area = length * 0.5;
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					addPlane(mQuadrics[mPositions[mTriangles[t + corner]]], normal, -glm::dot(normal, p0), area);
+				}
+
+				// Attribute edges without a twin are seams, submesh boundaries or borders
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					const uint32_t from = mTriangles[t + corner];
+					const uint32_t to = mTriangles[t + (corner + 1) % 3];
+					if (hasEdge(edges, to, from))
+					{
+						continue;
+					}
+					const glm::dvec3 start = mVertices[from].pos;
+					const glm::dvec3 edge = glm::dvec3(mVertices[to].pos) - start;
+					const glm::dvec3 cross = glm::cross(edge, normal);
+					const double crossLength = glm::length(cross);
+					if (crossLength <= 0.0)
+					{
+						continue;
+					}
+					const glm::dvec3 borderNormal = cross / crossLength;
+					const double weight = glm::length(edge);
+					addPlane(mBorderQuadrics[mPositions[from]], borderNormal, -glm::dot(borderNormal, start), weight);
+					addPlane(mBorderQuadrics[mPositions[to]], borderNormal, -glm::dot(borderNormal, start), weight);
+				}
+			}
+		}
+
+		bool Simplifier::runPass(float maxError)
+		{
+			const uint32_t vertexCount = static_cast<uint32_t>(mPositions.size());
+			const uint32_t triangleCount = getTriangleCount();
+
+			std::vector<uint64_t> edges;
+			std::vector<uint64_t> positionEdges;
+			edges.reserve(mTriangles.size());
+			positionEdges.reserve(mTriangles.size());
+			for (uint32_t t = 0; t < triangleCount; ++t)
+			{
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					const uint32_t from = mTriangles[t * 3 + corner];
+					const uint32_t to = mTriangles[t * 3 + (corner + 1) % 3];
+					edges.push_back(makeEdgeKey(from, to));
+					positionEdges.push_back(makeEdgeKey(mPositions[from], mPositions[to]));
+				}
+			}
+			std::sort(edges.begin(), edges.end());
+			std::sort(positionEdges.begin(), positionEdges.end());
+
+			// Count each position's wedges and open edges to classify it
+			std::vector<uint32_t> wedgeCounts(vertexCount, 0);
+			std::vector<uint32_t> openOut(vertexCount, 0);
+			std::vector<uint32_t> openIn(vertexCount, 0);
+			std::vector<uint32_t> positionOpenOut(vertexCount, 0);
+			std::vector<uint32_t> positionOpenIn(vertexCount, 0);
+			std::vector<bool> nonManifold(vertexCount, false);
+			std::vector<bool> referenced(vertexCount, false);
+			for (uint32_t index : mTriangles)
+			{
+				if (!referenced[index])
+				{
+					referenced[index] = true;
+					++wedgeCounts[mPositions[index]];
+				}
+			}
+			for (size_t i = 0; i < edges.size(); ++i)
+			{
+				const uint32_t from = static_cast<uint32_t>(edges[i] >> 32);
+				const uint32_t to = static_cast<uint32_t>(edges[i]);
+				if (!hasEdge(edges, to, from))
+				{
+					++openOut[from];
+					++openIn[to];
+				}
+			}
+			for (size_t i = 0; i < positionEdges.size(); ++i)
+			{
+				const uint32_t from = static_cast<uint32_t>(positionEdges[i] >> 32);
+				const uint32_t to = static_cast<uint32_t>(positionEdges[i]);
+				// More than one triangle on the same side of an edge
+				if (i > 0 && positionEdges[i] == positionEdges[i - 1])
+				{
+					nonManifold[from] = true;
+					nonManifold[to] = true;
+				}
+				if (!hasEdge(positionEdges, to, from))
+				{
+					++positionOpenOut[from];
+					++positionOpenIn[to];
+				}
+			}
+
+			std::vector<VertexKind> kinds(vertexCount, VertexKind::Locked);
+			std::vector<bool> seamWedgesPaired(vertexCount, true);
+			for (uint32_t v = 0; v < vertexCount; ++v)
+			{
+				if (referenced[v] && (openOut[v] != 1 || openIn[v] != 1))
+				{
+					seamWedgesPaired[mPositions[v]] = false;
+				}
+			}
+			for (uint32_t v = 0; v < vertexCount; ++v)
+			{
+				if (mPositions[v] != v || wedgeCounts[v] == 0 || nonManifold[v])
+				{
+					continue;
+				}
+				if (positionOpenOut[v] == 0 && positionOpenIn[v] == 0)
+				{
+					if (wedgeCounts[v] == 1 && openOut[v] == 0 && openIn[v] == 0)
+					{
+						kinds[v] = VertexKind::Manifold;
+					}
+					else if (wedgeCounts[v] == 2 && seamWedgesPaired[v])
+					{
+						kinds[v] = VertexKind::Seam;
+					}
+				}
+				else if (positionOpenOut[v] == 1 && positionOpenIn[v] == 1 && wedgeCounts[v] == 1)
+				{
+					kinds[v] = VertexKind::Border;
+				}
+			}
+
+			// Triangles around each position
+			std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+			for (uint32_t index : mTriangles)
+			{
+				++adjacencyOffsets[mPositions[index] + 1];
+			}
+			for (uint32_t v = 0; v < vertexCount; ++v)
+			{
+				adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+			}
+			std::vector<uint32_t> adjacency(mTriangles.size());
+			{
+				std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+				for (uint32_t t = 0; t < triangleCount; ++t)
+				{
+					for (uint32_t corner = 0; corner < 3; ++corner)
+					{
+						adjacency[cursor[mPositions[mTriangles[t * 3 + corner]]]++] = t;
+					}
+				}
+			}
+
+			// Each position's cheapest collapse; a vertex moves at most once per pass anyway
+			std::vector<Collapse> best(vertexCount, { 0.f, INVALID_INDEX, INVALID_INDEX });
+			for (uint32_t t = 0; t < triangleCount; ++t)
+			{
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					const uint32_t a = mTriangles[t * 3 + corner];
+					const uint32_t b = mTriangles[t * 3 + (corner + 1) % 3];
+					const bool attributeOpen = !hasEdge(edges, b, a);
+					const bool positionOpen = !hasEdge(positionEdges, mPositions[b], mPositions[a]);
+					for (uint32_t direction = 0; direction < 2; ++direction)
+					{
+						const uint32_t from = mPositions[direction == 0 ? a : b];
+						const uint32_t to = mPositions[direction == 0 ? b : a];
+						const VertexKind kind = kinds[from];
+						const bool allowed =
+							kind == VertexKind::Manifold ||
+							(kind == VertexKind::Border && positionOpen) ||
+							(kind == VertexKind::Seam && attributeOpen);
+						if (!allowed)
+						{
+							continue;
+						}
+						const glm::vec3& target = mVertices[to].pos;
+						const float error = static_cast<float>(std::max(
+							evaluateError(mQuadrics[from], mQuadrics[to], target),
+							evaluateError(mBorderQuadrics[from], mBorderQuadrics[to], target)));
+						Collapse& candidate = best[from];
+						if (error <= maxError && (candidate.from == INVALID_INDEX || error < candidate.error))
+						{
+							candidate = { error, from, to };
+						}
+					}
+				}
+			}
+
+			std::vector<Collapse> collapses;
+			for (const Collapse& candidate : best)
+			{
+				if (candidate.from != INVALID_INDEX)
+				{
+					collapses.push_back(candidate);
+				}
+			}
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs) {
+				return lhs.error < rhs.error || (lhs.error == rhs.error && lhs.from < rhs.from);
+			});
+
+			std::vector<uint32_t> remap(vertexCount, INVALID_INDEX);
+			std::vector<bool> touched(vertexCount, false);
+			std::vector<uint32_t> wedges;
+			std::vector<uint32_t> targets;
+			uint32_t applied = 0;
+			for (const Collapse& collapse : collapses)
+			{
+				if (touched[collapse.from] || touched[collapse.to])
+				{
+					continue;
+				}
+
+				// Each wedge moves onto the wedge it shares a triangle with across the edge
+				wedges.clear();
+				targets.clear();
+				bool valid = true;
+				const glm::vec3& target = mVertices[collapse.to].pos;
+				for (uint32_t j = adjacencyOffsets[collapse.from]; j < adjacencyOffsets[collapse.from + 1] && valid; ++j)
+				{
+					const uint32_t* triangle = &mTriangles[adjacency[j] * 3];
+					uint32_t wedge = INVALID_INDEX;
+					uint32_t other = INVALID_INDEX;
+					for (uint32_t corner = 0; corner < 3; ++corner)
+					{
+						if (mPositions[triangle[corner]] == collapse.from)
+						{
+							wedge = triangle[corner];
+						}
+						else if (mPositions[triangle[corner]] == collapse.to)
+						{
+							other = triangle[corner];
+						}
+					}
+
+					auto found = std::find(wedges.begin(), wedges.end(), wedge);
+					if (found == wedges.end())
+					{
+						wedges.push_back(wedge);
+						targets.push_back(other);
+					}
+					else if (targets[found - wedges.begin()] == INVALID_INDEX)
+					{
+						targets[found - wedges.begin()] = other;
+					}
+
+					// Triangles that stay must keep roughly the way they face
+					if (other == INVALID_INDEX)
+					{
+						glm::vec3 before[3];
+						glm::vec3 after[3];
+						for (uint32_t corner = 0; corner < 3; ++corner)
+						{
+							before[corner] = mVertices[triangle[corner]].pos;
+							after[corner] = triangle[corner] == wedge ? target : before[corner];
+						}
+						const glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+						const glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+						valid = glm::dot(normalBefore, normalAfter) > MIN_NORMAL_COSINE * glm::length(normalBefore) * glm::length(normalAfter);
+					}
+				}
+				valid = valid && std::find(targets.begin(), targets.end(), INVALID_INDEX) == targets.end();
+				if (!valid)
+				{
+					continue;
+				}
+
+				for (size_t w = 0; w < wedges.size(); ++w)
+				{
+					remap[wedges[w]] = targets[w];
+				}
+				// Nothing else may move around this vertex this pass, or the flip test above wouldn't hold
+				for (uint32_t j = adjacencyOffsets[collapse.from]; j < adjacencyOffsets[collapse.from + 1]; ++j)
+				{
+					for (uint32_t corner = 0; corner < 3; ++corner)
+					{
+						touched[mPositions[mTriangles[adjacency[j] * 3 + corner]]] = true;
+					}
+				}
+				addQuadric(mQuadrics[collapse.to], mQuadrics[collapse.from]);
+				addQuadric(mBorderQuadrics[collapse.to], mBorderQuadrics[collapse.from]);
+				mError = std::max(mError, collapse.error);
+				++applied;
+			}
+
+			if (applied == 0)
+			{
+				return false;
+			}
+
+			// Triangles that spanned a collapsed edge are gone
+			uint32_t kept = 0;
+			for (uint32_t t = 0; t < triangleCount; ++t)
+			{
+				uint32_t triangle[3];
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					const uint32_t index = mTriangles[t * 3 + corner];
+					triangle[corner] = remap[index] != INVALID_INDEX ? remap[index] : index;
+				}
+				const uint32_t p0 = mPositions[triangle[0]];
+				const uint32_t p1 = mPositions[triangle[1]];
+				const uint32_t p2 = mPositions[triangle[2]];
+				if (p0 != p1 && p1 != p2 && p2 != p0)
+				{
+					mTriangles[kept * 3] = triangle[0];
+					mTriangles[kept * 3 + 1] = triangle[1];
+					mTriangles[kept * 3 + 2] = triangle[2];
+					mTriangleSubmeshes[kept] = mTriangleSubmeshes[t];
+					++kept;
+				}
+			}
+			mTriangles.resize(kept * 3);
+			mTriangleSubmeshes.resize(kept);
+			return true;
+		}
+
+		void Simplifier::simplify(float maxError)
+		{
+			for (uint32_t pass = 0; pass < MAX_PASSES && runPass(maxError); ++pass)
+			{
+			}
+		}
+
+		void Simplifier::getLod(const StaticMesh& mesh, MeshLod& outLod) const
+		{
+			outLod.error = mError;
+			outLod.indices.clear();
+			outLod.indices.reserve(mTriangles.size());
+			outLod.submeshes = mesh.getSubmeshes();
+
+			std::vector<uint32_t> submeshIndices;
+			for (uint32_t s = 0; s < outLod.submeshes.size(); ++s)
+			{
+				Submesh& submesh = outLod.submeshes[s];
+				submeshIndices.clear();
+				for (uint32_t t = 0; t < getTriangleCount(); ++t)
+				{
+					if (mTriangleSubmeshes[t] != s)
+					{
+						continue;
+					}
+					for (uint32_t corner = 0; corner < 3; ++corner)
+					{
+						const uint32_t index = mTriangles[t * 3 + corner];
+						// Wedges only ever move onto vertices they share a triangle with
+						assert(index >= submesh.vertexOffset && index < submesh.vertexOffset + submesh.vertexCount);
+						submeshIndices.push_back(index - submesh.vertexOffset);
+					}
+				}
+
+				const std::vector<uint32_t> ordered = optimizeIndexOrder(submeshIndices, submesh.vertexCount);
+				submesh.firstIndex = static_cast<uint32_t>(outLod.indices.size());
+				submesh.indexCount = static_cast<uint32_t>(ordered.size());
+				outLod.indices.insert(outLod.indices.end(), ordered.begin(), ordered.end());
+			}
+		}
+	}
+
+	std::vector<MeshLod> generateMeshLods(const StaticMesh& mesh, const MeshLodSettings& settings)
+	{
+		std::vector<MeshLod> lods;
+		const StaticMesh::Vertices& vertices = mesh.getVertices();
+		if (!settings.enabled || vertices.empty() || mesh.getIndices().empty())
+		{
+			return lods;
+		}
+
+		glm::vec3 boundsMin = vertices.front().pos;
+		glm::vec3 boundsMax = vertices.front().pos;
+		for (const auto& vertex : vertices)
+		{
+			boundsMin = glm::min(boundsMin, vertex.pos);
+			boundsMax = glm::max(boundsMax, vertex.pos);
+		}
+		const float extent = glm::length(boundsMax - boundsMin);
+
+		Simplifier simplifier(mesh);
+		uint32_t previousTriangles = simplifier.getTriangleCount();
+		for (float targetError : settings.targetErrors)
+		{
+			simplifier.simplify(targetError * extent);
+			const uint32_t triangles = simplifier.getTriangleCount();
+			if (triangles == 0 || triangles > previousTriangles * settings.maxTriangleRatio)
+			{
+				break;
+			}
+
+			MeshLod lod;
+			simplifier.getLod(mesh, lod);
+			lods.push_back(std::move(lod));
+			previousTriangles = triangles;
+		}
+		return lods;
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "StaticMesh.h"
+
+namespace hvk {
+
+	struct MeshLodSettings
+	{
+		// Off leaves every mesh with lod0 only
+		bool enabled = true;
+		// The error each coarser level may reach, finest first, as a fraction of the mesh's
+		// bounding box diagonal
+		std::vector<float> targetErrors = { 0.002f, 0.008f, 0.025f };
+		// A level that keeps more than this fraction of the previous level's triangles isn't
+		// worth its draw, so it and every coarser level are dropped
+		float maxTriangleRatio = 0.8f;
+	};
+
+	// A coarser level of a StaticMesh. It reuses the mesh's vertices and only has indices of its own
+	struct MeshLod
+	{
+		// How far the surface may have moved from lod0, in the mesh's object space
+		float error;
+		StaticMesh::Indices indices;
+		// The mesh's submeshes in the same order and with the same vertex ranges;
+		// firstIndex and indexCount refer to this level's indices
+		StaticMesh::Submeshes submeshes;
+	};
+
+	// Quadric error metric edge collapse (Garland & Heckbert), collapsing each vertex onto a
+	// neighbour so no new vertices are made. Vertices are welded by position, so UV and normal
+	// seams, submesh boundaries and open borders only ever collapse along themselves and both
+	// sides stay closed. Each level continues from the previous one with the accumulated
+	// quadrics, and has its triangles ordered for the vertex cache
+	std::vector<MeshLod> generateMeshLods(const StaticMesh& mesh, const MeshLodSettings& settings);
+}
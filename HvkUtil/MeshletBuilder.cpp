@@ -0,0 +1,239 @@
+#include "pch.h"
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hvk {
+
+	namespace {
+
+		const uint32_t INVALID_INDEX = UINT32_MAX;
+		// Cones wider than this are facing away from almost nowhere, so they're never tested
+		const float MIN_CONE_DOT = 0.1f;
+
+		void computeMeshletBounds(
+			const Vertex* vertices,
+			const uint32_t* indices,
+			const std::vector<uint32_t>& meshletVertices,
+			Meshlet& outMeshlet)
+		{
+			glm::vec3 boundsMin = vertices[meshletVertices.front()].pos;
+			glm::vec3 boundsMax = boundsMin;
+			for (uint32_t vertex : meshletVertices)
+			{
+				boundsMin = glm::min(boundsMin, vertices[vertex].pos);
+				boundsMax = glm::max(boundsMax, vertices[vertex].pos);
+			}
+			const glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+			float radius = 0.f;
+			for (uint32_t vertex : meshletVertices)
+			{
+				radius = std::max(radius, glm::length(vertices[vertex].pos - center));
+			}
+			outMeshlet.center = center;
+			outMeshlet.radius = radius;
+
+			outMeshlet.coneAxis = glm::vec3(0.f);
+			outMeshlet.coneApex = center;
+			outMeshlet.coneCutoff = 1.f;
+
+			// Degenerate triangles can't be seen from either side, so they're left out of the cone
+			const uint32_t triangleCount = outMeshlet.indexCount / 3;
+			std::vector<glm::vec3> normals(triangleCount, glm::vec3(0.f));
+			glm::vec3 normalSum(0.f);
+			for (uint32_t t = 0; t < triangleCount; ++t)
+			{
+				const glm::vec3& p0 = vertices[indices[t * 3]].pos;
+				const glm::vec3& p1 = vertices[indices[t * 3 + 1]].pos;
+				const glm::vec3& p2 = vertices[indices[t * 3 + 2]].pos;
+				const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				const float length = glm::length(normal);
+				if (length > 0.f)
+				{
+					normals[t] = normal / length;
+					normalSum += normals[t];
+				}
+			}
+			const float sumLength = glm::length(normalSum);
+			if (sumLength <= 0.f)
+			{
+				return;
+			}
+
+			const glm::vec3 axis = normalSum / sumLength;
+			float minDot = 1.f;
+			for (const glm::vec3& normal : normals)
+			{
+				if (normal != glm::vec3(0.f))
+				{
+					minDot = std::min(minDot, glm::dot(axis, normal));
+				}
+			}
+			if (minDot <= MIN_CONE_DOT)
+			{
+				return;
+			}
+
+			// The apex is the first point along -axis from the centre that's behind every triangle's plane
+			float maxT = 0.f;
+			for (uint32_t t = 0; t < triangleCount; ++t)
+			{
+				if (normals[t] != glm::vec3(0.f))
+				{
+					const glm::vec3& p0 = vertices[indices[t * 3]].pos;
+					maxT = std::max(maxT, glm::dot(center - p0, normals[t]) / glm::dot(axis, normals[t]));
+				}
+			}
+
+			outMeshlet.coneAxis = axis;
+			outMeshlet.coneApex = center - axis * maxT;
+			outMeshlet.coneCutoff = std::sqrt(1.f - minDot * minDot);
+		}
+	}
+
+	std::vector<Meshlet> buildMeshlets(
+		const Vertex* vertices,
+		uint32_t vertexCount,
+		std::vector<uint32_t>& indices,
+		const MeshletSettings& settings)
+	{
+		assert(settings.maxVertices >= 3 && settings.maxTriangles >= 1);
+		std::vector<Meshlet> meshlets;
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		if (triangleCount == 0)
+		{
+			return meshlets;
+		}
+
+		// Triangles using each vertex
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (uint32_t index : indices)
+		{
+			++adjacencyOffsets[index + 1];
+		}
+		for (uint32_t v = 0; v < vertexCount; ++v)
+		{
+			adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+		}
+		std::vector<uint32_t> adjacency(indices.size());
+		{
+			std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (uint32_t t = 0; t < triangleCount; ++t)
+			{
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					adjacency[cursor[indices[t * 3 + corner]]++] = t;
+				}
+			}
+		}
+
+		std::vector<bool> used(triangleCount, false);
+		std::vector<bool> inMeshlet(vertexCount, false);
+		std::vector<uint32_t> meshletVertices;
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> ordered;
+		meshletVertices.reserve(settings.maxVertices);
+		ordered.reserve(indices.size());
+
+		uint32_t firstUnused = 0;
+		while (true)
+		{
+			while (firstUnused < triangleCount && used[firstUnused])
+			{
+				++firstUnused;
+			}
+			if (firstUnused == triangleCount)
+			{
+				break;
+			}
+
+			Meshlet meshlet = {};
+			meshlet.firstIndex = static_cast<uint32_t>(ordered.size());
+			meshletVertices.clear();
+			candidates.clear();
+
+			uint32_t next = firstUnused;
+			while (next != INVALID_INDEX)
+			{
+				used[next] = true;
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					const uint32_t vertex = indices[next * 3 + corner];
+					ordered.push_back(vertex);
+					if (!inMeshlet[vertex])
+					{
+						inMeshlet[vertex] = true;
+						meshletVertices.push_back(vertex);
+						candidates.insert(
+							candidates.end(),
+							adjacency.begin() + adjacencyOffsets[vertex],
+							adjacency.begin() + adjacencyOffsets[vertex + 1]);
+					}
+				}
+				meshlet.indexCount += 3;
+				if (meshlet.indexCount / 3 == settings.maxTriangles)
+				{
+					break;
+				}
+
+				// The neighbour adding the fewest vertices keeps the meshlet compact; ties go to the
+				// earliest triangle so the result only depends on the input
+				next = INVALID_INDEX;
+				uint32_t bestNew = 4;
+				for (size_t i = 0; i < candidates.size();)
+				{
+					const uint32_t t = candidates[i];
+					if (used[t])
+					{
+						candidates[i] = candidates.back();
+						candidates.pop_back();
+						continue;
+					}
+					uint32_t newVertices = 0;
+					for (uint32_t corner = 0; corner < 3; ++corner)
+					{
+						newVertices += inMeshlet[indices[t * 3 + corner]] ? 0 : 1;
+					}
+					const bool fits = meshletVertices.size() + newVertices <= settings.maxVertices;
+					if (fits && (newVertices < bestNew || (newVertices == bestNew && t < next)))
+					{
+						bestNew = newVertices;
+						next = t;
+					}
+					++i;
+				}
+
+				// Without a neighbour, like across the split edges of flat shaded geometry, the
+				// next triangle in the input's order is usually still close by
+				while (next == INVALID_INDEX && firstUnused < triangleCount && used[firstUnused])
+				{
+					++firstUnused;
+				}
+				if (next == INVALID_INDEX && firstUnused < triangleCount)
+				{
+					uint32_t newVertices = 0;
+					for (uint32_t corner = 0; corner < 3; ++corner)
+					{
+						newVertices += inMeshlet[indices[firstUnused * 3 + corner]] ? 0 : 1;
+					}
+					if (meshletVertices.size() + newVertices <= settings.maxVertices)
+					{
+						next = firstUnused;
+					}
+				}
+			}
+
+			meshlet.vertexCount = static_cast<uint32_t>(meshletVertices.size());
+			computeMeshletBounds(vertices, ordered.data() + meshlet.firstIndex, meshletVertices, meshlet);
+			meshlets.push_back(meshlet);
+			for (uint32_t vertex : meshletVertices)
+			{
+				inMeshlet[vertex] = false;
+			}
+		}
+
+		indices.swap(ordered);
+		return meshlets;
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "StaticMesh.h"
+
+namespace hvk {
+
+	// Small enough that a meshlet's vertices all stay in the post-transform cache, and matching
+	// the usual mesh shader limits should those ever be used
+	const uint32_t DEFAULT_MESHLET_VERTICES = 64;
+	const uint32_t DEFAULT_MESHLET_TRIANGLES = 124;
+
+	// A cluster of neighbouring triangles, culled as one. Its triangles are contiguous in the
+	// index buffer, so drawing the meshlets that survive is a handful of index ranges
+	struct Meshlet
+	{
+		// Offset in the same index buffer, and relative to the same base vertex, as its submesh's
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		uint32_t vertexCount;
+		float radius;
+		glm::vec3 center;
+		// The meshlet faces away from any viewpoint v where
+		// dot(normalize(coneApex - v), coneAxis) > coneCutoff; a cutoff of 1 means never
+		float coneCutoff;
+		glm::vec3 coneAxis;
+		glm::vec3 coneApex;
+	};
+
+	// A submesh's meshlets in its mesh's meshlet table
+	struct MeshletRange
+	{
+		uint32_t firstMeshlet;
+		uint32_t meshletCount;
+	};
+
+	struct MeshletSettings
+	{
+		// Off leaves submeshes to be drawn whole
+		bool enabled = true;
+		uint32_t maxVertices = DEFAULT_MESHLET_VERTICES;
+		uint32_t maxTriangles = DEFAULT_MESHLET_TRIANGLES;
+	};
+
+	// Splits a submesh's triangles into meshlets, growing each from its first triangle through
+	// the neighbours that add the fewest new vertices (or the next triangle in order when none
+	// are left), and rewrites indices so every meshlet's triangles follow each other. Meshlets
+	// come out in the order of their first triangle, so the input's ordering carries over at a
+	// coarser grain; their firstIndex is relative to the start of indices, which refer to vertices
+	std::vector<Meshlet> buildMeshlets(
+		const Vertex* vertices,
+		uint32_t vertexCount,
+		std::vector<uint32_t>& indices,
+		const MeshletSettings& settings);
+}
@@ -0,0 +1,139 @@
+#include "pch.h"
+#include "MipChain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace hvk {
+
+	namespace {
+
+		size_t getChainSize(uint32_t width, uint32_t height, uint32_t texelSize, uint32_t mipLevels)
+		{
+			size_t chainSize = 0;
+			for (uint32_t level = 0; level < mipLevels; ++level)
+			{
+				chainSize += static_cast<size_t>(std::max(width >> level, 1u)) *
+					std::max(height >> level, 1u) * texelSize;
+			}
+			return chainSize;
+		}
+
+		// Fills each level of chain from the one above it with a 2x2 box. average gets the
+		// four source texels and the destination texel, channelCount elements each
+		template <typename T, typename Average>
+		void filterChain(
+			T* chain,
+			uint32_t width,
+			uint32_t height,
+			uint32_t channelCount,
+			uint32_t mipLevels,
+			Average average)
+		{
+			T* src = chain;
+			uint32_t srcWidth = width;
+			uint32_t srcHeight = height;
+			for (uint32_t level = 1; level < mipLevels; ++level)
+			{
+				T* dst = src + static_cast<size_t>(srcWidth) * srcHeight * channelCount;
+				const uint32_t dstWidth = std::max(srcWidth >> 1, 1u);
+				const uint32_t dstHeight = std::max(srcHeight >> 1, 1u);
+				const size_t srcPitch = static_cast<size_t>(srcWidth) * channelCount;
+
+				for (uint32_t y = 0; y < dstHeight; ++y)
+				{
+					// Edges of odd or 1 texel wide levels reuse their last row or column
+					const T* row0 = src + std::min(2 * y, srcHeight - 1) * srcPitch;
+					const T* row1 = src + std::min(2 * y + 1, srcHeight - 1) * srcPitch;
+					T* out = dst + static_cast<size_t>(y) * dstWidth * channelCount;
+					for (uint32_t x = 0; x < dstWidth; ++x)
+					{
+						const size_t x0 = std::min(2 * x, srcWidth - 1) * channelCount;
+						const size_t x1 = std::min(2 * x + 1, srcWidth - 1) * channelCount;
+						average(row0 + x0, row0 + x1, row1 + x0, row1 + x1, out);
+						out += channelCount;
+					}
+				}
+
+				src = dst;
+				srcWidth = dstWidth;
+				srcHeight = dstHeight;
+			}
+		}
+	}
+
+	uint32_t getMipLevelCount(uint32_t width, uint32_t height)
+	{
+		uint32_t levels = 1;
+		for (uint32_t size = std::max(width, height); size > 1; size >>= 1)
+		{
+			++levels;
+		}
+		return levels;
+	}
+
+	std::vector<uint8_t> generateMipChain(
+		const void* imageData,
+		uint32_t imageWidth,
+		uint32_t imageHeight,
+		uint32_t bytesPerPixel,
+		uint32_t mipLevels,
+		bool sRGB)
+	{
+		// Colour channels of sRGB texels are decoded before averaging, so
+		// minified textures don't darken; alpha is always linear
+		const uint32_t colorChannels = sRGB ? (bytesPerPixel == 4 ? 3 : bytesPerPixel) : 0;
+		float toLinear[256];
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			float c = i / 255.f;
+			toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+		auto toSrgb = [](float c) {
+			c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+			return static_cast<uint8_t>(std::min(std::max(c, 0.f), 1.f) * 255.f + 0.5f);
+		};
+
+		std::vector<uint8_t> chain(getChainSize(imageWidth, imageHeight, bytesPerPixel, mipLevels));
+		memcpy(chain.data(), imageData, static_cast<size_t>(imageWidth) * imageHeight * bytesPerPixel);
+
+		filterChain(chain.data(), imageWidth, imageHeight, bytesPerPixel, mipLevels,
+			[&](const uint8_t* a, const uint8_t* b, const uint8_t* c, const uint8_t* d, uint8_t* out) {
+				for (uint32_t i = 0; i < bytesPerPixel; ++i)
+				{
+					if (i < colorChannels)
+					{
+						out[i] = toSrgb((toLinear[a[i]] + toLinear[b[i]] + toLinear[c[i]] + toLinear[d[i]]) * 0.25f);
+					}
+					else
+					{
+						out[i] = static_cast<uint8_t>((a[i] + b[i] + c[i] + d[i] + 2) >> 2);
+					}
+				}
+			});
+
+		return chain;
+	}
+
+	std::vector<float> generateMipChain(
+		const float* imageData,
+		uint32_t imageWidth,
+		uint32_t imageHeight,
+		uint32_t channelCount,
+		uint32_t mipLevels)
+	{
+		std::vector<float> chain(getChainSize(imageWidth, imageHeight, channelCount, mipLevels));
+		memcpy(chain.data(), imageData, static_cast<size_t>(imageWidth) * imageHeight * channelCount * sizeof(float));
+
+		filterChain(chain.data(), imageWidth, imageHeight, channelCount, mipLevels,
+			[channelCount](const float* a, const float* b, const float* c, const float* d, float* out) {
+				for (uint32_t i = 0; i < channelCount; ++i)
+				{
+					out[i] = (a[i] + b[i] + c[i] + d[i]) * 0.25f;
+				}
+			});
+
+		return chain;
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace hvk {
+
+	// Levels in a full chain down to 1x1
+	uint32_t getMipLevelCount(uint32_t width, uint32_t height);
+
+	// Box filters every level below the base on the CPU. Texels are bytesPerPixel 8 bit
+	// channels; with sRGB the colour channels are averaged in linear space.
+	// Returns the whole chain, base level included, tightly packed level after level
+	std::vector<uint8_t> generateMipChain(
+		const void* imageData,
+		uint32_t imageWidth,
+		uint32_t imageHeight,
+		uint32_t bytesPerPixel,
+		uint32_t mipLevels,
+		bool sRGB);
+
+	// Float texels of channelCount channels, all filtered linearly
+	std::vector<float> generateMipChain(
+		const float* imageData,
+		uint32_t imageWidth,
+		uint32_t imageHeight,
+		uint32_t channelCount,
+		uint32_t mipLevels);
+}
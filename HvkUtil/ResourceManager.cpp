@@ -2,15 +2,145 @@
 #include "ResourceManager.h"
 
 #include <memory>
+#include <cstdlib>
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+#if defined(_MSC_VER)
+	inline int findFirstSet(uint32_t word)
+	{
+		unsigned long index;
+		return _BitScanForward(&index, word) ? static_cast<int>(index) : -1;
+	}
+
+	inline int findLastSet(size_t word)
+	{
+		unsigned long index;
+#if defined(_WIN64)
+		return _BitScanReverse64(&index, word) ? static_cast<int>(index) : -1;
+#else
+		// 32 bit targets only have the 32 bit scan, so check the high half first
+		const uint64_t wide = word;
+		if (_BitScanReverse(&index, static_cast<unsigned long>(wide >> 32))) {
+			return static_cast<int>(index) + 32;
+		}
+		return _BitScanReverse(&index, static_cast<unsigned long>(wide)) ? static_cast<int>(index) : -1;
+#endif
+	}
+#else
+	inline int findFirstSet(uint32_t word)
+	{
+		return word ? __builtin_ctz(word) : -1;
+	}
+
+	inline int findLastSet(size_t word)
+	{
+		return word ? 63 - __builtin_clzll(word) : -1;
+	}
+#endif
+
+	inline size_t alignUp(size_t x, size_t align)
+	{
+		return (x + (align - 1)) & ~(align - 1);
+	}
+
+	inline size_t alignDown(size_t x, size_t align)
+	{
+		return x - (x & (align - 1));
+	}
+
+	inline char* alignPtr(char* p, size_t align)
+	{
+		return reinterpret_cast<char*>(alignUp(reinterpret_cast<uintptr_t>(p), align));
+	}
+
+#if HVK_MEMORY_STATS
+	struct TrackingHeader
+	{
+		size_t size;
+		uint32_t prefix;
+		hvk::MemoryTag tag;
+	};
+#endif
+}
 
 namespace hvk {
 
-	void* ResourceManager::sStorage = nullptr;
-	//void* ResourceManager::sNeedle = nullptr;
+	std::mutex ResourceManager::sLock;
+	ResourceManager::Region* ResourceManager::sRegions = nullptr;
 	size_t ResourceManager::sSize = 0;
 	size_t ResourceManager::sRemaining = 0;
 	bool ResourceManager::sInitialized = false;
-	std::list<ResourceManager::MemoryNode> ResourceManager::sFreeNodes(200);
+	uint32_t ResourceManager::sFlBitmap = 0;
+	std::array<uint32_t, ResourceManager::FL_INDEX_COUNT> ResourceManager::sSlBitmaps{};
+	std::array<std::array<ResourceManager::BlockHeader*, ResourceManager::SL_INDEX_COUNT>, ResourceManager::FL_INDEX_COUNT> ResourceManager::sBlocks{};
+
+	static_assert(ResourceManager::FL_INDEX_COUNT <= 32, "First level bitmap must fit in 32 bits");
+	static_assert(ResourceManager::SL_INDEX_COUNT <= 32, "Second level bitmap must fit in 32 bits");
+
+	/*** block helpers ***/
+
+	namespace {
+		const size_t BLOCK_SIZE_MASK = ~size_t(3);
+
+		template <typename Block>
+		inline size_t blockSize(const Block* block)
+		{
+			return block->size & BLOCK_SIZE_MASK;
+		}
+
+		template <typename Block>
+		inline void setBlockSize(Block* block, size_t size)
+		{
+			block->size = size | (block->size & ~BLOCK_SIZE_MASK);
+		}
+
+		template <typename Block>
+		inline char* blockToPtr(Block* block, size_t startOffset)
+		{
+			return reinterpret_cast<char*>(block) + startOffset;
+		}
+
+		void mapping(size_t size, size_t& fl, size_t& sl)
+		{
+			if (size < ResourceManager::SMALL_BLOCK_SIZE) {
+				fl = 0;
+				sl = size / (ResourceManager::SMALL_BLOCK_SIZE / ResourceManager::SL_INDEX_COUNT);
+			}
+			else {
+				size_t last = static_cast<size_t>(findLastSet(size));
+				sl = (size >> (last - ResourceManager::SL_INDEX_COUNT_LOG2)) ^ (size_t(1) << ResourceManager::SL_INDEX_COUNT_LOG2);
+				fl = last - (ResourceManager::FL_INDEX_SHIFT - 1);
+			}
+		}
+
+		// Round up to the next list so any block found there is large enough
+		void mappingSearch(size_t size, size_t& fl, size_t& sl)
+		{
+			if (size >= ResourceManager::SMALL_BLOCK_SIZE) {
+				size_t round = (size_t(1) << (findLastSet(size) - ResourceManager::SL_INDEX_COUNT_LOG2)) - 1;
+				size += round;
+			}
+			mapping(size, fl, sl);
+		}
+
+		size_t adjustRequestSize(size_t size, size_t align, size_t minSize, size_t maxSize)
+		{
+			size_t adjusted = 0;
+			if (size) {
+				size_t aligned = alignUp(size, align);
+				if (aligned < maxSize) {
+					adjusted = std::max(aligned, minSize);
+				}
+			}
+			return adjusted;
+		}
+	}
 
 	ResourceManager::ResourceManager()
 	{
@@ -23,44 +153,346 @@ namespace hvk {
 
 	void ResourceManager::initialize(size_t startingSize)
 	{
+		std::lock_guard<std::mutex> lock(sLock);
 		if (!sInitialized) {
 			sInitialized = true;
-			sSize = startingSize;
-			sRemaining = startingSize;
-			sStorage = static_cast<char*>(malloc(startingSize));
-			sFreeNodes.insert(sFreeNodes.begin(), MemoryNode{ sStorage, sSize });
+			sSize = 0;
+			sRemaining = 0;
+			addRegion(startingSize);
+		}
+	}
+
+	void ResourceManager::reset()
+	{
+		std::lock_guard<std::mutex> lock(sLock);
+		assert(sRemaining == sSize && "Resetting with live allocations");
+		while (sRegions != nullptr) {
+			Region* next = sRegions->next;
+			std::free(sRegions);
+			sRegions = next;
 		}
+		sSize = 0;
+		sRemaining = 0;
+		sInitialized = false;
+		sFlBitmap = 0;
+		sSlBitmaps.fill(0);
+		for (auto& lists : sBlocks) {
+			lists.fill(nullptr);
+		}
+	}
+
+	void* ResourceManager::alloc(size_t size, size_t alignment, MemoryTag tag)
+	{
+#if HVK_MEMORY_STATS
+		// Tracked allocations carry their tag and size just in front of the returned pointer
+		const size_t prefix = alignUp(sizeof(TrackingHeader), std::max(alignment, ALIGN_SIZE));
+		char* block = static_cast<char*>(allocBlock(size + prefix, alignment));
+		if (block == nullptr) {
+			return nullptr;
+		}
+		char* p = block + prefix;
+		TrackingHeader* header = reinterpret_cast<TrackingHeader*>(p) - 1;
+		header->size = size;
+		header->prefix = static_cast<uint32_t>(prefix);
+		header->tag = tag;
+		memory::recordAlloc(MemorySource::ResourceManager, tag, size);
+		return p;
+#else
+		static_cast<void>(tag);
+		return allocBlock(size, alignment);
+#endif
 	}
 
-	void* ResourceManager::alloc(size_t size, size_t alignment)
+	void* ResourceManager::allocBlock(size_t size, size_t alignment)
 	{
-		void* start = nullptr;
-		if (sInitialized) {
-			start = claimSpace(size, alignment);
+		std::lock_guard<std::mutex> lock(sLock);
+		if (!sInitialized) {
+			sInitialized = true;
+			addRegion(DEFAULT_STORAGE_SIZE);
+		}
+
+		// claimSpace refuses empty requests, which would otherwise chain a new region every call.
+		// Like malloc(0) they get a minimum sized block of their own
+		if (size == 0) {
+			size = 1;
+		}
+
+		void* start = claimSpace(size, alignment);
+		if (start == nullptr) {
+			// Out of space, chain a new region at least as big as everything we own so far
+			size_t required = size + alignment + sizeof(BlockHeader) + sizeof(Region) + 4 * BLOCK_OVERHEAD;
+			required += required >> SL_INDEX_COUNT_LOG2;
+			if (addRegion(std::max(sSize, required))) {
+				start = claimSpace(size, alignment);
+			}
 		}
 		return start;
 	}
 
+	bool ResourceManager::addRegion(size_t size)
+	{
+		const size_t regionOverhead = alignUp(sizeof(Region), ALIGN_SIZE) + ALIGN_SIZE;
+		if (size <= 2 * BLOCK_OVERHEAD + BLOCK_SIZE_MIN) {
+			return false;
+		}
+		const size_t poolBytes = alignDown(size - 2 * BLOCK_OVERHEAD, ALIGN_SIZE);
+		if (poolBytes >= BLOCK_SIZE_MAX) {
+			return false;
+		}
+
+		char* mem = static_cast<char*>(std::malloc(size + regionOverhead));
+		if (mem == nullptr) {
+			return false;
+		}
+
+		Region* region = reinterpret_cast<Region*>(mem);
+		region->next = sRegions;
+		region->size = size;
+		sRegions = region;
+
+		// The first block's prevPhysical field sits in the padding after the region header
+		// and is never read since the block is never marked as having a free predecessor
+		char* poolStart = mem + regionOverhead;
+		BlockHeader* block = reinterpret_cast<BlockHeader*>(poolStart - BLOCK_OVERHEAD);
+		block->size = poolBytes | BLOCK_FREE_BIT;
+		insertBlock(block);
+
+		// Zero-sized sentinel terminates the region so merges never walk past it
+		BlockHeader* sentinel = reinterpret_cast<BlockHeader*>(blockToPtr(block, BLOCK_START_OFFSET) + poolBytes - BLOCK_OVERHEAD);
+		sentinel->prevPhysical = block;
+		sentinel->size = BLOCK_PREV_FREE_BIT;
+
+		sSize += poolBytes;
+		sRemaining += poolBytes;
+		return true;
+	}
+
 	void* ResourceManager::claimSpace(size_t size, size_t alignment)
 	{
-		for (auto it = sFreeNodes.begin(); it != sFreeNodes.end(); ++it)
-		{
-			if (it->size >= size) {
-				void* m = std::align(alignment, size, it->data, it->size);
-				if (m != nullptr) {
-					size_t alignmentOffset = static_cast<char*>(m) - it->data;
-					if (m > it->data) {
-						sFreeNodes.insert(std::prev(it), { it->data, alignmentOffset });
-					}
-					size_t leftOver = (it->size - alignmentOffset) - size;
-					if (leftOver) {
-						sFreeNodes.insert(std::next(it), MemoryNode{ (static_cast<char*>(m) + size), leftOver });
-					}
-					sFreeNodes.erase(it);
-					return m;
+		alignment = std::max(alignment, ALIGN_SIZE);
+		const size_t adjusted = adjustRequestSize(size, ALIGN_SIZE, BLOCK_SIZE_MIN, BLOCK_SIZE_MAX);
+		if (adjusted == 0) {
+			return nullptr;
+		}
+
+		// Over-allocate for larger alignments so a free block can be trimmed off the front
+		const size_t gapMinimum = sizeof(BlockHeader);
+		const size_t searchSize = (alignment > ALIGN_SIZE) ?
+			adjustRequestSize(adjusted + alignment + gapMinimum, alignment, BLOCK_SIZE_MIN, BLOCK_SIZE_MAX) :
+			adjusted;
+
+		BlockHeader* block = findFreeBlock(searchSize);
+		if (block == nullptr) {
+			return nullptr;
+		}
+
+		char* ptr = blockToPtr(block, BLOCK_START_OFFSET);
+		char* aligned = alignPtr(ptr, alignment);
+		size_t gap = static_cast<size_t>(aligned - ptr);
+		if (gap && gap < gapMinimum) {
+			const size_t offset = std::max(gapMinimum - gap, alignment);
+			aligned = alignPtr(aligned + offset, alignment);
+			gap = static_cast<size_t>(aligned - ptr);
+		}
+		if (gap) {
+			block = trimFreeLeading(block, gap);
+		}
+
+		trimFree(block, adjusted);
+		BlockHeader* next = reinterpret_cast<BlockHeader*>(blockToPtr(block, BLOCK_START_OFFSET) + blockSize(block) - BLOCK_OVERHEAD);
+		next->size &= ~BLOCK_PREV_FREE_BIT;
+		block->size &= ~BLOCK_FREE_BIT;
+		sRemaining -= blockSize(block);
+
+		return blockToPtr(block, BLOCK_START_OFFSET);
+	}
+
+	void ResourceManager::releaseSpace(void* p)
+	{
+		if (p == nullptr) {
+			return;
+		}
+
+#if HVK_MEMORY_STATS
+		const TrackingHeader* header = reinterpret_cast<TrackingHeader*>(p) - 1;
+		memory::recordFree(MemorySource::ResourceManager, header->tag, header->size);
+		p = static_cast<char*>(p) - header->prefix;
+#endif
+
+		std::lock_guard<std::mutex> lock(sLock);
+		BlockHeader* block = reinterpret_cast<BlockHeader*>(static_cast<char*>(p) - BLOCK_START_OFFSET);
+		assert(!(block->size & BLOCK_FREE_BIT) && "Block already freed");
+		sRemaining += blockSize(block);
+
+		BlockHeader* next = reinterpret_cast<BlockHeader*>(static_cast<char*>(p) + blockSize(block) - BLOCK_OVERHEAD);
+		next->prevPhysical = block;
+		next->size |= BLOCK_PREV_FREE_BIT;
+		block->size |= BLOCK_FREE_BIT;
+
+		block = mergePrevious(block);
+		block = mergeNext(block);
+		insertBlock(block);
+	}
+
+	/*** free list management ***/
+
+	void ResourceManager::insertBlock(BlockHeader* block)
+	{
+		size_t fl, sl;
+		mapping(blockSize(block), fl, sl);
+
+		BlockHeader* current = sBlocks[fl][sl];
+		block->nextFree = current;
+		block->prevFree = nullptr;
+		if (current) {
+			current->prevFree = block;
+		}
+		sBlocks[fl][sl] = block;
+
+		sFlBitmap |= (1u << fl);
+		sSlBitmaps[fl] |= (1u << sl);
+	}
+
+	void ResourceManager::removeBlock(BlockHeader* block)
+	{
+		size_t fl, sl;
+		mapping(blockSize(block), fl, sl);
+
+		BlockHeader* prev = block->prevFree;
+		BlockHeader* next = block->nextFree;
+		if (next) {
+			next->prevFree = prev;
+		}
+		if (prev) {
+			prev->nextFree = next;
+		}
+
+		if (sBlocks[fl][sl] == block) {
+			sBlocks[fl][sl] = next;
+			if (next == nullptr) {
+				sSlBitmaps[fl] &= ~(1u << sl);
+				if (!sSlBitmaps[fl]) {
+					sFlBitmap &= ~(1u << fl);
 				}
 			}
 		}
-        return nullptr;
+	}
+
+	ResourceManager::BlockHeader* ResourceManager::findFreeBlock(size_t size)
+	{
+		size_t fl, sl;
+		mappingSearch(size, fl, sl);
+		if (fl >= FL_INDEX_COUNT) {
+			return nullptr;
+		}
+
+		uint32_t slMap = sSlBitmaps[fl] & (~0u << sl);
+		if (!slMap) {
+			if (fl + 1 >= FL_INDEX_COUNT) {
+				return nullptr;
+			}
+			const uint32_t flMap = sFlBitmap & (~0u << (fl + 1));
+			if (!flMap) {
+				return nullptr;
+			}
+			fl = static_cast<size_t>(findFirstSet(flMap));
+			slMap = sSlBitmaps[fl];
+		}
+		sl = static_cast<size_t>(findFirstSet(slMap));
+
+		BlockHeader* block = sBlocks[fl][sl];
+		assert(block != nullptr);
+		removeBlock(block);
+		return block;
+	}
+
+	ResourceManager::BlockHeader* ResourceManager::splitBlock(BlockHeader* block, size_t size)
+	{
+		BlockHeader* remaining = reinterpret_cast<BlockHeader*>(blockToPtr(block, BLOCK_START_OFFSET) + size - BLOCK_OVERHEAD);
+		const size_t remainingSize = blockSize(block) - (size + BLOCK_OVERHEAD);
+		remaining->size = remainingSize;
+		setBlockSize(block, size);
+
+		BlockHeader* next = reinterpret_cast<BlockHeader*>(blockToPtr(remaining, BLOCK_START_OFFSET) + remainingSize - BLOCK_OVERHEAD);
+		next->prevPhysical = remaining;
+		next->size |= BLOCK_PREV_FREE_BIT;
+		remaining->size |= BLOCK_FREE_BIT;
+		return remaining;
+	}
+
+	ResourceManager::BlockHeader* ResourceManager::mergePrevious(BlockHeader* block)
+	{
+		if (block->size & BLOCK_PREV_FREE_BIT) {
+			BlockHeader* prev = block->prevPhysical;
+			removeBlock(prev);
+			prev->size += blockSize(block) + BLOCK_OVERHEAD;
+			BlockHeader* next = reinterpret_cast<BlockHeader*>(blockToPtr(prev, BLOCK_START_OFFSET) + blockSize(prev) - BLOCK_OVERHEAD);
+			next->prevPhysical = prev;
+			block = prev;
+		}
+		return block;
+	}
+
+	ResourceManager::BlockHeader* ResourceManager::mergeNext(BlockHeader* block)
+	{
+		BlockHeader* next = reinterpret_cast<BlockHeader*>(blockToPtr(block, BLOCK_START_OFFSET) + blockSize(block) - BLOCK_OVERHEAD);
+		if (next->size & BLOCK_FREE_BIT) {
+			removeBlock(next);
+			block->size += blockSize(next) + BLOCK_OVERHEAD;
+			BlockHeader* after = reinterpret_cast<BlockHeader*>(blockToPtr(block, BLOCK_START_OFFSET) + blockSize(block) - BLOCK_OVERHEAD);
+			after->prevPhysical = block;
+		}
+		return block;
+	}
+
+	// Split the tail of a free block off and return it to the free lists
+	void ResourceManager::trimFree(BlockHeader* block, size_t size)
+	{
+		if (blockSize(block) >= sizeof(BlockHeader) + size) {
+			BlockHeader* remaining = splitBlock(block, size);
+			remaining->prevPhysical = block;
+			remaining->size |= BLOCK_PREV_FREE_BIT;
+			insertBlock(remaining);
+		}
+	}
+
+	// Split the head of a free block off for alignment and return it to the free lists
+	ResourceManager::BlockHeader* ResourceManager::trimFreeLeading(BlockHeader* block, size_t size)
+	{
+		BlockHeader* remaining = block;
+		if (blockSize(block) >= sizeof(BlockHeader) + size) {
+			remaining = splitBlock(block, size - BLOCK_OVERHEAD);
+			remaining->prevPhysical = block;
+			remaining->size |= BLOCK_PREV_FREE_BIT;
+			insertBlock(block);
+		}
+		return remaining;
+	}
+
+	size_t ResourceManager::getLargestFreeBlock()
+	{
+		std::lock_guard<std::mutex> lock(sLock);
+		if (!sFlBitmap) {
+			return 0;
+		}
+
+		// Only the highest occupied list can hold the largest block
+		const size_t fl = static_cast<size_t>(findLastSet(sFlBitmap));
+		const size_t sl = static_cast<size_t>(findLastSet(sSlBitmaps[fl]));
+		size_t largest = 0;
+		for (BlockHeader* block = sBlocks[fl][sl]; block != nullptr; block = block->nextFree) {
+			largest = std::max(largest, blockSize(block));
+		}
+		return largest;
+	}
+
+	size_t ResourceManager::getRegionCount()
+	{
+		std::lock_guard<std::mutex> lock(sLock);
+		size_t count = 0;
+		for (Region* region = sRegions; region != nullptr; region = region->next) {
+			++count;
+		}
+		return count;
 	}
 }
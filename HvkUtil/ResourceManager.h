@@ -4,71 +4,111 @@
 
 #include <memory>
 #include <array>
-#include <list>
 #include <functional>
+#include <cassert>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <atomic>
+#include <type_traits>
+
+#include "MemoryStats.h"
 
 #define ARENA_SIZE 32
+#define POOL_BATCH_SIZE 32
+#define POOL_SHARD_COUNT 8
 
 namespace hvk {
 
 	template <typename T>
 	class Pool;
 	
+	// Two-level segregated fit (TLSF) allocator
+	// Block headers live in-band in the backing storage, so alloc and free
+	// never allocate themselves. When the free lists can't satisfy a request
+	// a new backing region is malloc'd and chained onto the existing ones.
+	// alloc and free are serialized with a single lock.
 	class ResourceManager
 	{
-		struct MemoryNode
+	public:
+		static constexpr size_t ALIGN_SIZE_LOG2 = 3;
+		static constexpr size_t ALIGN_SIZE = 1 << ALIGN_SIZE_LOG2;
+		static constexpr size_t SL_INDEX_COUNT_LOG2 = 5;
+		static constexpr size_t SL_INDEX_COUNT = 1 << SL_INDEX_COUNT_LOG2;
+		static constexpr size_t FL_INDEX_SHIFT = SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2;
+		static constexpr size_t FL_INDEX_MAX = 36;
+		static constexpr size_t FL_INDEX_COUNT = FL_INDEX_MAX - FL_INDEX_SHIFT + 1;
+		static constexpr size_t SMALL_BLOCK_SIZE = 1 << FL_INDEX_SHIFT;
+		static constexpr size_t DEFAULT_STORAGE_SIZE = 1 << 20;
+
+	private:
+		struct BlockHeader
 		{
-			void* data;
+			// only valid when the previous physical block is free
+			BlockHeader* prevPhysical;
+			// low bits hold the free / previous free flags
 			size_t size;
+			// free list links, only valid while the block is free
+			BlockHeader* nextFree;
+			BlockHeader* prevFree;
 		};
-	private:
-		static void* sStorage;
+
+		struct Region
+		{
+			Region* next;
+			size_t size;
+		};
+
+		static constexpr size_t BLOCK_FREE_BIT = 1;
+		static constexpr size_t BLOCK_PREV_FREE_BIT = 2;
+		static constexpr size_t BLOCK_OVERHEAD = sizeof(size_t);
+		static constexpr size_t BLOCK_START_OFFSET = offsetof(BlockHeader, size) + sizeof(size_t);
+		static constexpr size_t BLOCK_SIZE_MIN = sizeof(BlockHeader) - sizeof(BlockHeader*);
+		static constexpr size_t BLOCK_SIZE_MAX = size_t(1) << FL_INDEX_MAX;
+
+		static std::mutex sLock;
+		static Region* sRegions;
 		static size_t sSize;
 		static size_t sRemaining;
 		static bool sInitialized;
-		static std::list<MemoryNode> sFreeNodes;
+		static uint32_t sFlBitmap;
+		static std::array<uint32_t, FL_INDEX_COUNT> sSlBitmaps;
+		static std::array<std::array<BlockHeader*, SL_INDEX_COUNT>, FL_INDEX_COUNT> sBlocks;
 
+		static bool addRegion(size_t size);
+		static void* allocBlock(size_t size, size_t alignment);
 		static void* claimSpace(size_t size, size_t alignment);
+		static void releaseSpace(void* p);
+
+		static void insertBlock(BlockHeader* block);
+		static void removeBlock(BlockHeader* block);
+		static BlockHeader* findFreeBlock(size_t size);
+		static BlockHeader* splitBlock(BlockHeader* block, size_t size);
+		static BlockHeader* mergePrevious(BlockHeader* block);
+		static BlockHeader* mergeNext(BlockHeader* block);
+		static void trimFree(BlockHeader* block, size_t size);
+		static BlockHeader* trimFreeLeading(BlockHeader* block, size_t size);
+
 	public:
 		ResourceManager();
 		~ResourceManager();
 
 		static void initialize(size_t startingSize);
-		static void* alloc(size_t size, size_t alignment);
+		// Hands every region back to the system so the next alloc starts on a fresh heap.
+		// Everything allocated must have been freed
+		static void reset();
+		static void* alloc(size_t size, size_t alignment, MemoryTag tag = memory::getCurrentTag());
 
+		static size_t getCapacity() { return sSize; }
+		static size_t getRemaining() { return sRemaining; }
+		static size_t getLargestFreeBlock();
+		static size_t getRegionCount();
+
+		// Blocks know their own size, so the size is only there to match Hallocator
 		template <typename T>
-		static void free(T* p, size_t size)
+		static void free(T* p, size_t /*size*/)
 		{
-			for (auto it = sFreeNodes.begin(); it->data <= p; ++it)
-			{
-				if (it->data > p) {
-					bool insertNew = true;
-					bool deleteNext = false;
-
-					MemoryNode m{ p, size };
-
-					// if contiguous blocks, merge
-					if (reinterpret_cast<char*>(p) + size == it->data) {
-						m.size += it->size;
-						deleteNext = true;
-					}
-
-					if (it != sFreeNodes.begin()) {
-						auto prev = std::prev(it);
-						if (reinterpret_cast<char*>(prev->data) + prev->size == m.data) {
-							prev->size += m.size;
-							insertNew = false;
-						}
-					}
-
-					if (insertNew) {
-						sFreeNodes.insert(it, m);
-					}
-					if (deleteNext) {
-						sFreeNodes.erase(it);
-					}
-				}
-			}
+			releaseSpace(static_cast<void*>(p));
 		}
 	};
 
@@ -104,62 +144,77 @@ namespace hvk {
 	template <typename T>
 	union PoolItem
 	{
-		//using Storage = char[sizeof(T)];
+		using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
 
 	private:
 		PoolItem<T>* next;
-		T* data;
+		Storage data;
 
 	public:
 		PoolItem<T>* getNext() const { return next; }
 		void setNext(PoolItem<T>* n) { next = n; }
-		T* getData() { return data; }
+		T* getData() { return reinterpret_cast<T*>(&data); }
 	};
 
 
+	template <typename T>
+	class Arena;
+
+	// Arenas are placed in ResourceManager memory, so they're handed back there rather than deleted
+	template <typename T>
+	struct ArenaDeleter
+	{
+		void operator()(Arena<T>* arena) const
+		{
+			arena->~Arena<T>();
+			ResourceManager::free(arena, sizeof(Arena<T>));
+		}
+	};
+
+	template <typename T>
+	using ArenaPtr = std::unique_ptr<Arena<T>, ArenaDeleter<T>>;
+
 	template <typename T>
 	class Arena
 	{
 	private:
-		//std::unique_ptr<std::array<PoolItem<T>, ARENA_SIZE>> mStorage;
-		//std::unique_ptr<PoolItem<T>[]> mStorage;
 		PoolItem<T>* mStorage;
-		std::unique_ptr<Arena<T>> mPreviousArena;
+		ArenaPtr<T> mPreviousArena;
 
 	public:
 		Arena() : 
-			//mStorage(new std::array<PoolItem<T>, ARENA_SIZE>())
-			mStorage(nullptr)
-		{
-			mStorage = reinterpret_cast<PoolItem<T>*>(ResourceManager::alloc(sizeof(PoolItem<T>) * ARENA_SIZE, alignof(PoolItem<T>)));
-			//mStorage = new (mem) PoolItem<T>[ARENA_SIZE]();
-			//mStorage(new PoolItem<T>[ARENA_SIZE])
-			//mStorage = new PoolItem<T>[ARENA_SIZE];
-			//PoolItem<T>* t = (PoolItem<T>*)mem;
+			mStorage(nullptr),
+			mPreviousArena(nullptr)
+		{
+			mStorage = reinterpret_cast<PoolItem<T>*>(ResourceManager::alloc(
+				sizeof(PoolItem<T>) * ARENA_SIZE, 
+				alignof(PoolItem<T>), 
+				MemoryTagOf<T>::value));
 			for (size_t i = 1; i < ARENA_SIZE; ++i) {
 				mStorage[i - 1].setNext(&mStorage[i]);
 			}
-			//PoolItem<T> lastItem = mStorage[ARENA_SIZE - 1];
-			//lastItem.setNext(nullptr);
 			mStorage[ARENA_SIZE - 1].setNext(nullptr);
 		}
 
 		~Arena()
 		{
+			// Unlink the chain one arena at a time so long chains don't recurse through every destructor
+			ArenaPtr<T> previous = std::move(mPreviousArena);
+			while (previous) {
+				ArenaPtr<T> next = std::move(previous->mPreviousArena);
+				previous = std::move(next);
+			}
 			ResourceManager::free(mStorage, sizeof(PoolItem<T>) * ARENA_SIZE);
 		}
 
-		void setPrevious(std::unique_ptr<Arena<T>>&& n)
+		void setPrevious(ArenaPtr<T>&& n)
 		{
 			assert(!mPreviousArena);
-			mPreviousArena.reset(n.release());
+			mPreviousArena = std::move(n);
 		}
 
 		PoolItem<T>* getStorage() const
 		{
-			//return mStorage.get()->at(0);
-			//mStorage
-			//return mStorage.get();
 			return mStorage;
 		}
 	};
@@ -170,50 +225,158 @@ namespace hvk {
 
 	}
 
+	// Each thread allocates from and frees into its own cache of items.
+	// Caches move POOL_BATCH_SIZE items at a time to and from a set of
+	// central shards, so the shared state is only touched once per batch.
 	template <typename T>
 	class Pool
 	{
-
 	private:
-		static PoolItem<T>* sFreeItem;
-		static std::unique_ptr<Arena<T>> sArena;
+		struct Shard
+		{
+			std::mutex lock;
+			PoolItem<T>* head = nullptr;
+			size_t count = 0;
+		};
 
-	public:
-		//Pool(uint32_t size);
-		//~Pool();
+		struct Cache
+		{
+			PoolItem<T>* head = nullptr;
+			size_t count = 0;
+			size_t shard = sNextShard.fetch_add(1, std::memory_order_relaxed) % POOL_SHARD_COUNT;
+
+			~Cache()
+			{
+				if (head != nullptr) {
+					PoolItem<T>* tail = head;
+					while (tail->getNext() != nullptr) {
+						tail = tail->getNext();
+					}
+					pushShard(shard, head, tail, count);
+				}
+			}
+		};
+
+		static std::array<Shard, POOL_SHARD_COUNT> sShards;
+		static std::atomic<size_t> sNextShard;
+		static std::mutex sArenaLock;
+		// Owns every arena through the chain, so they're all freed when the pool is torn down
+		static ArenaPtr<T> sArena;
+		static thread_local Cache sCache;
 
+		static void pushShard(size_t index, PoolItem<T>* head, PoolItem<T>* tail, size_t count)
+		{
+			Shard& shard = sShards[index];
+			std::lock_guard<std::mutex> lock(shard.lock);
+			tail->setNext(shard.head);
+			shard.head = head;
+			shard.count += count;
+		}
+
+		static PoolItem<T>* popShard(size_t index, size_t& count)
+		{
+			Shard& shard = sShards[index];
+			std::lock_guard<std::mutex> lock(shard.lock);
+			PoolItem<T>* head = shard.head;
+			if (head == nullptr) {
+				count = 0;
+				return nullptr;
+			}
+
+			PoolItem<T>* tail = head;
+			count = 1;
+			while (count < POOL_BATCH_SIZE && tail->getNext() != nullptr) {
+				tail = tail->getNext();
+				++count;
+			}
+			shard.head = tail->getNext();
+			shard.count -= count;
+			tail->setNext(nullptr);
+			return head;
+		}
+
+		static PoolItem<T>* newArena()
+		{
+			std::lock_guard<std::mutex> lock(sArenaLock);
+			void* mem = ResourceManager::alloc(sizeof(Arena<T>), alignof(Arena<T>), MemoryTagOf<T>::value);
+			ArenaPtr<T> arena(new (mem) Arena<T>());
+			arena->setPrevious(std::move(sArena));
+			sArena = std::move(arena);
+			return sArena->getStorage();
+		}
+
+		// Slow path: pull a batch from our shard, then any other shard, then carve a new arena
+		static void refill(Cache& cache)
+		{
+			for (size_t i = 0; i < POOL_SHARD_COUNT && cache.head == nullptr; ++i) {
+				cache.head = popShard((cache.shard + i) % POOL_SHARD_COUNT, cache.count);
+			}
+			if (cache.head == nullptr) {
+				cache.head = newArena();
+				cache.count = ARENA_SIZE;
+			}
+		}
+
+		// Slow path: hand a batch back to our shard once the cache holds two batches
+		static void spill(Cache& cache)
+		{
+			PoolItem<T>* head = cache.head;
+			PoolItem<T>* tail = head;
+			for (size_t i = 1; i < POOL_BATCH_SIZE; ++i) {
+				tail = tail->getNext();
+			}
+			cache.head = tail->getNext();
+			cache.count -= POOL_BATCH_SIZE;
+			pushShard(cache.shard, head, tail, POOL_BATCH_SIZE);
+		}
+
+	public:
 		static void free(T* t)
 		{
 			t->T::~T();
-			//PoolItem<T>* item = 
-			//PoolItem<T>* item = std::reinterpret_cast<PoolItem*>(t);
+#if HVK_MEMORY_STATS
+			memory::recordFree(MemorySource::Pool, MemoryTagOf<T>::value, sizeof(T));
+#endif
 			PoolItem<T>* item = reinterpret_cast<PoolItem<T>*>(t);
-			item->setNext(sFreeItem);
-			sFreeItem = item;
+			Cache& cache = sCache;
+			item->setNext(cache.head);
+			cache.head = item;
+			if (++cache.count >= 2 * POOL_BATCH_SIZE) {
+				spill(cache);
+			}
 		}
 
 		template <typename... Args> static std::unique_ptr<T, void(*)(T*) > alloc(Args&& ... args)
 		{
-			if (sFreeItem == nullptr) {
-				void* mem = ResourceManager::alloc(sizeof(Arena<T>) * ARENA_SIZE, alignof(Arena<T>));
-				std::unique_ptr<Arena<T>> newArena(new (mem) Arena<T>());
-				newArena->setPrevious(std::move(sArena));
-				sArena.reset(newArena.release());
-				sFreeItem = sArena->getStorage();
+			Cache& cache = sCache;
+			if (cache.head == nullptr) {
+				refill(cache);
 			}
 
-			PoolItem<T>* item = sFreeItem;
-			sFreeItem = item->getNext();
-			//T* result = item->getData();
-			T* result = reinterpret_cast<T*>(item);
+			PoolItem<T>* item = cache.head;
+			cache.head = item->getNext();
+			--cache.count;
+			T* result = item->getData();
 			new (result) T(std::forward<Args>(args)...);
+#if HVK_MEMORY_STATS
+			memory::recordAlloc(MemorySource::Pool, MemoryTagOf<T>::value, sizeof(T));
+#endif
 			return std::unique_ptr<T, void(*)(T*) >(result, Pool<T>::free);
 		}
 	};
 
 	template <typename T>
-	PoolItem<T>* Pool<T>::sFreeItem = nullptr;
+	std::array<typename Pool<T>::Shard, POOL_SHARD_COUNT> Pool<T>::sShards;
+
+	template <typename T>
+	std::atomic<size_t> Pool<T>::sNextShard(0);
+
+	template <typename T>
+	std::mutex Pool<T>::sArenaLock;
+
+	template <typename T>
+	ArenaPtr<T> Pool<T>::sArena;
 
 	template <typename T>
-	std::unique_ptr<Arena<T>> Pool<T>::sArena = nullptr;
+	thread_local typename Pool<T>::Cache Pool<T>::sCache;
 }
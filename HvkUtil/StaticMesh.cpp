@@ -1,29 +1,67 @@
 #include "pch.h"
 #include "StaticMesh.h"
 
+#include <algorithm>
 
 namespace hvk {
 
+	// Whatever width the source indices had, the mesh is drawn with the narrowest
+	// type that still reaches every vertex of its largest submesh
+	StaticMesh::StaticMesh(Vertices vertices, Indices indices, Submeshes submeshes, Materials materials) :
+		mVertices(std::move(vertices)),
+		mIndices(std::move(indices)),
+		mSubmeshes(std::move(submeshes)),
+		mMaterials(std::move(materials)),
+		mIndexType(VK_INDEX_TYPE_UINT16)
+	{
+		assert(!mMaterials.empty());
+		uint32_t largestSubmesh = 0;
+		for (const auto& submesh : mSubmeshes)
+		{
+			assert(submesh.materialIndex < mMaterials.size());
+			largestSubmesh = std::max(largestSubmesh, submesh.vertexCount);
+		}
+		mIndexType = getNarrowestIndexType(largestSubmesh);
+	}
+
 	StaticMesh::StaticMesh(Vertices vertices, Indices indices, Material material) :
-		mVertices(vertices),
-		mIndices(indices),
-		mMaterial(material)
+		mVertices(std::move(vertices)),
+		mIndices(std::move(indices)),
+		mSubmeshes(),
+		mMaterials({ material }),
+		mIndexType(getNarrowestIndexType(mVertices.size()))
 	{
+		mSubmeshes.push_back({
+			0,
+			static_cast<uint32_t>(mIndices.size()),
+			0,
+			static_cast<uint32_t>(mVertices.size()),
+			0 });
 	}
 
 	StaticMesh::StaticMesh(Vertices vertices, Indices indices) :
-		mVertices(vertices),
-		mIndices(indices),
-		mMaterial()
+		StaticMesh(std::move(vertices), std::move(indices), Material())
 	{
 	}
 
 	StaticMesh::StaticMesh(const StaticMesh& rhs)  :
 		mVertices(rhs.getVertices()),
 		mIndices(rhs.getIndices()),
-		mMaterial(rhs.getMaterial())
+		mSubmeshes(rhs.getSubmeshes()),
+		mMaterials(rhs.getMaterials()),
+		mIndexType(rhs.getIndexType())
 	{
 	}
 
+	StaticMesh::StaticMesh(StaticMesh&& rhs) = default;
+
 	StaticMesh::~StaticMesh() = default;
+
+	void StaticMesh::setUsingSRGMat(bool usingSRGB)
+	{
+		for (auto& material : mMaterials)
+		{
+			material.sRGB = usingSRGB;
+		}
+	}
 }
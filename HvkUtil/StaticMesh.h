@@ -6,21 +6,39 @@
 
 namespace hvk {
 
+	// One glTF primitive's range inside its StaticMesh.
+	// Indices are relative to vertexOffset so each submesh can be drawn with it as the base vertex
+	struct Submesh
+	{
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		uint32_t vertexOffset;
+		uint32_t vertexCount;
+		uint32_t materialIndex;
+	};
+
 	class StaticMesh
 	{
 	public:
 		using Vertices = std::vector<Vertex>;
-		using Indices = std::vector<VertIndex>;
+		// Indices are kept at full width on the CPU; mIndexType is the type they're drawn with
+		using Indices = std::vector<uint32_t>;
+		using Submeshes = std::vector<Submesh>;
+		using Materials = std::vector<Material>;
 
 	private:
 		Vertices mVertices;
 		Indices mIndices;
-		Material mMaterial;
+		Submeshes mSubmeshes;
+		Materials mMaterials;
+		VkIndexType mIndexType;
 
 	public:
+		StaticMesh(Vertices vertices, Indices indices, Submeshes submeshes, Materials materials);
 		StaticMesh(Vertices vertices, Indices indices, Material material);
 		StaticMesh(Vertices vertices, Indices indices);
 		StaticMesh(const StaticMesh& rhs);
+		StaticMesh(StaticMesh&& rhs);
 		~StaticMesh();
 
 		Vertices getVertices() { return mVertices; }
@@ -28,8 +46,10 @@ namespace hvk {
 
 		const Vertices& getVertices() const { return mVertices; }
 		const Indices& getIndices() const { return mIndices; }
-		const Material& getMaterial() const { return mMaterial; }
-		bool isUsingSRGBMat() { return mMaterial.sRGB; }
-		void setUsingSRGMat(bool usingSRGB) { mMaterial.sRGB = usingSRGB; }
+		const Submeshes& getSubmeshes() const { return mSubmeshes; }
+		const Materials& getMaterials() const { return mMaterials; }
+		VkIndexType getIndexType() const { return mIndexType; }
+		bool isUsingSRGBMat() { return mMaterials.front().sRGB; }
+		void setUsingSRGMat(bool usingSRGB);
 	};
 }
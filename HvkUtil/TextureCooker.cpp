@@ -0,0 +1,256 @@
+#include "pch.h"
+#include "TextureCooker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+#include "stb_image.h"
+
+#include "BlockCompression.h"
+#include "Hash.h"
+#include "Ktx2.h"
+#include "MipChain.h"
+
+namespace hvk {
+
+	namespace {
+
+		const char* COOKED_TEXTURE_EXTENSION = ".ktx2";
+		// Bumped whenever the encoders change what they write
+		const uint64_t TEXTURE_COOKER_VERSION = 1;
+
+		bool hasTransparency(const uint8_t* rgba, uint32_t width, uint32_t height)
+		{
+			const size_t texelCount = static_cast<size_t>(width) * height;
+			for (size_t i = 0; i < texelCount; ++i)
+			{
+				if (rgba[i * 4 + 3] != 255)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Box filtered normals shorten, so each texel below the base is put back on the unit sphere
+		void renormalize(uint8_t* rgba, size_t texelCount)
+		{
+			for (size_t i = 0; i < texelCount; ++i)
+			{
+				uint8_t* texel = rgba + i * 4;
+				float x = texel[0] / 127.5f - 1.f;
+				float y = texel[1] / 127.5f - 1.f;
+				float z = texel[2] / 127.5f - 1.f;
+				const float length = std::sqrt(x * x + y * y + z * z);
+				if (length > 0.f)
+				{
+					x /= length;
+					y /= length;
+					z /= length;
+				}
+				texel[0] = static_cast<uint8_t>(std::min(std::max((x + 1.f) * 127.5f + 0.5f, 0.f), 255.f));
+				texel[1] = static_cast<uint8_t>(std::min(std::max((y + 1.f) * 127.5f + 0.5f, 0.f), 255.f));
+				texel[2] = static_cast<uint8_t>(std::min(std::max((z + 1.f) * 127.5f + 0.5f, 0.f), 255.f));
+			}
+		}
+
+		// Compresses every level of a tightly packed chain of channelCount wide texels
+		template <typename T>
+		bool compressChain(
+			VkFormat format,
+			const T* chain,
+			uint32_t width,
+			uint32_t height,
+			uint32_t channelCount,
+			uint32_t mipLevels,
+			std::vector<std::vector<uint8_t>>& outLevels)
+		{
+			outLevels.resize(mipLevels);
+			const T* level = chain;
+			for (uint32_t i = 0; i < mipLevels; ++i)
+			{
+				const uint32_t levelWidth = std::max(width >> i, 1u);
+				const uint32_t levelHeight = std::max(height >> i, 1u);
+				outLevels[i].resize(bc::getLevelSize(format, levelWidth, levelHeight));
+				if (!bc::compressImage(format, level, levelWidth, levelHeight, outLevels[i].data()))
+				{
+					return false;
+				}
+				level += static_cast<size_t>(levelWidth) * levelHeight * channelCount;
+			}
+			return true;
+		}
+	}
+
+	uint64_t getTextureCookSettingsKey(const TextureCookSettings& settings)
+	{
+		const uint64_t flags = (settings.compress ? 1 : 0) | (settings.compact ? 2 : 0);
+		return hash::combine(TEXTURE_COOKER_VERSION, flags);
+	}
+
+	VkFormat getCookedTextureFormat(TextureUsage usage, const TextureCookSettings& settings, bool hasAlpha)
+	{
+		// Albedo is sampled as UNORM and used as stored, so it's cooked to the same formats as the
+		// other colour textures; only its mips are filtered in linear space
+		switch (usage)
+		{
+		case TextureUsage::Albedo:
+		case TextureUsage::MetallicRoughness:
+			if (!settings.compress)
+			{
+				return VK_FORMAT_R8G8B8A8_UNORM;
+			}
+			if (settings.compact)
+			{
+				return hasAlpha ? VK_FORMAT_BC3_UNORM_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+			}
+			return VK_FORMAT_BC7_UNORM_BLOCK;
+		case TextureUsage::Normal:
+			// Two channels keep twice the precision of BC1/BC7; the shader rebuilds z
+			return settings.compress ? VK_FORMAT_BC5_UNORM_BLOCK : VK_FORMAT_R8G8B8A8_UNORM;
+		case TextureUsage::Mask:
+			return settings.compress ? VK_FORMAT_BC4_UNORM_BLOCK : VK_FORMAT_R8G8B8A8_UNORM;
+		case TextureUsage::Hdr:
+			return settings.compress ? VK_FORMAT_BC6H_UFLOAT_BLOCK : VK_FORMAT_R32G32B32A32_SFLOAT;
+		}
+		return VK_FORMAT_UNDEFINED;
+	}
+
+	bool cookTexture(
+		const uint8_t* rgba,
+		uint32_t width,
+		uint32_t height,
+		TextureUsage usage,
+		const TextureCookSettings& settings,
+		uint64_t sourceKey,
+		std::vector<uint8_t>& outFile)
+	{
+		if (usage == TextureUsage::Hdr || width == 0 || height == 0)
+		{
+			return false;
+		}
+
+		const bool hasAlpha = usage != TextureUsage::Normal && hasTransparency(rgba, width, height);
+		const VkFormat format = getCookedTextureFormat(usage, settings, hasAlpha);
+		std::vector<std::vector<uint8_t>> levels;
+		if (!settings.compress)
+		{
+			levels.emplace_back(rgba, rgba + static_cast<size_t>(width) * height * 4);
+			return writeKtx2(format, width, height, 1, levels, true, sourceKey, outFile);
+		}
+
+		const uint32_t mipLevels = getMipLevelCount(width, height);
+		std::vector<uint8_t> chain = generateMipChain(rgba, width, height, 4, mipLevels, usage == TextureUsage::Albedo);
+		if (usage == TextureUsage::Normal)
+		{
+			const size_t baseSize = static_cast<size_t>(width) * height;
+			renormalize(chain.data() + baseSize * 4, chain.size() / 4 - baseSize);
+		}
+
+		return compressChain(format, chain.data(), width, height, 4, mipLevels, levels) &&
+			writeKtx2(format, width, height, 1, levels, false, sourceKey, outFile);
+	}
+
+	bool cookTexture(
+		const float* rgba,
+		uint32_t width,
+		uint32_t height,
+		const TextureCookSettings& settings,
+		uint64_t sourceKey,
+		std::vector<uint8_t>& outFile)
+	{
+		if (width == 0 || height == 0)
+		{
+			return false;
+		}
+
+		const VkFormat format = getCookedTextureFormat(TextureUsage::Hdr, settings, true);
+		std::vector<std::vector<uint8_t>> levels;
+		if (!settings.compress)
+		{
+			const auto* bytes = reinterpret_cast<const uint8_t*>(rgba);
+			levels.emplace_back(bytes, bytes + static_cast<size_t>(width) * height * 4 * sizeof(float));
+			return writeKtx2(format, width, height, 1, levels, true, sourceKey, outFile);
+		}
+
+		const uint32_t mipLevels = getMipLevelCount(width, height);
+		const std::vector<float> chain = generateMipChain(rgba, width, height, 4, mipLevels);
+		return compressChain(format, chain.data(), width, height, 4, mipLevels, levels) &&
+			writeKtx2(format, width, height, 1, levels, false, sourceKey, outFile);
+	}
+
+	bool writeCookedFile(const std::string& path, const std::vector<uint8_t>& contents)
+	{
+		// Written next to the destination and swapped in, so a failed cook never leaves a truncated file
+		const std::string tempPath = path + ".tmp";
+		{
+			std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+			stream.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+			if (!stream.good())
+			{
+				stream.close();
+				std::remove(tempPath.c_str());
+				return false;
+			}
+		}
+		std::remove(path.c_str());
+		return std::rename(tempPath.c_str(), path.c_str()) == 0;
+	}
+
+	std::string getCookedTexturePath(const std::string& sourcePath)
+	{
+		return sourcePath + COOKED_TEXTURE_EXTENSION;
+	}
+
+	bool computeTextureSourceKey(const std::string& sourcePath, const TextureCookSettings& settings, uint64_t& outKey)
+	{
+		uint64_t fileHash;
+		if (!hash::hashFile(sourcePath, fileHash))
+		{
+			return false;
+		}
+		outKey = hash::combine(fileHash, getTextureCookSettingsKey(settings));
+		return true;
+	}
+
+	bool cookTextureFile(
+		const std::string& sourcePath,
+		const std::string& cookedPath,
+		TextureUsage usage,
+		const TextureCookSettings& settings)
+	{
+		uint64_t sourceKey;
+		if (!computeTextureSourceKey(sourcePath, settings, sourceKey))
+		{
+			return false;
+		}
+
+		int width, height, channels;
+		std::vector<uint8_t> file;
+		bool cooked = false;
+		if (usage == TextureUsage::Hdr)
+		{
+			float* pixels = stbi_loadf(sourcePath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+			if (pixels == nullptr)
+			{
+				return false;
+			}
+			cooked = cookTexture(pixels, width, height, settings, sourceKey, file);
+			stbi_image_free(pixels);
+		}
+		else
+		{
+			stbi_uc* pixels = stbi_load(sourcePath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+			if (pixels == nullptr)
+			{
+				return false;
+			}
+			cooked = cookTexture(pixels, width, height, usage, settings, sourceKey, file);
+			stbi_image_free(pixels);
+		}
+
+		return cooked && writeCookedFile(cookedPath, file);
+	}
+}
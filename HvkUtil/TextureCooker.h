@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace hvk {
+
+	// What a texture is sampled as, which decides its cooked format
+	enum class TextureUsage
+	{
+		Albedo,
+		Normal,
+		MetallicRoughness,
+		Mask,
+		Hdr
+	};
+
+	struct TextureCookSettings
+	{
+		// Off writes uncompressed RGBA, for devices without BC support
+		bool compress = true;
+		// Trades quality for size: BC1, or BC3 with alpha, instead of BC7
+		bool compact = false;
+	};
+
+	// Folded into cache keys so changing the settings recooks
+	uint64_t getTextureCookSettingsKey(const TextureCookSettings& settings);
+
+	VkFormat getCookedTextureFormat(TextureUsage usage, const TextureCookSettings& settings, bool hasAlpha);
+
+	// Encodes an RGBA8 image and its full mip chain into a KTX2 file. Uncompressed
+	// textures only store their base level and leave the chain to the GPU
+	bool cookTexture(
+		const uint8_t* rgba,
+		uint32_t width,
+		uint32_t height,
+		TextureUsage usage,
+		const TextureCookSettings& settings,
+		uint64_t sourceKey,
+		std::vector<uint8_t>& outFile);
+
+	// Encodes an RGBA float image as BC6H, or RGBA32F when not compressing
+	bool cookTexture(
+		const float* rgba,
+		uint32_t width,
+		uint32_t height,
+		const TextureCookSettings& settings,
+		uint64_t sourceKey,
+		std::vector<uint8_t>& outFile);
+
+	// Replaces path's contents whole, leaving the old file in place if the write fails
+	bool writeCookedFile(const std::string& path, const std::vector<uint8_t>& contents);
+
+	std::string getCookedTexturePath(const std::string& sourcePath);
+
+	// Hash of the source file and settings, stored in the cooked file so stale textures are detected
+	bool computeTextureSourceKey(const std::string& sourcePath, const TextureCookSettings& settings, uint64_t& outKey);
+
+	// Decodes an image file with stb_image and writes its cooked KTX2 to cookedPath
+	bool cookTextureFile(
+		const std::string& sourcePath,
+		const std::string& cookedPath,
+		TextureUsage usage,
+		const TextureCookSettings& settings);
+}
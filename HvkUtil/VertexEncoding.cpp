@@ -0,0 +1,92 @@
+#include "pch.h"
+#include "VertexEncoding.h"
+
+#include <cmath>
+#include <cstring>
+
+#include <glm/gtc/packing.hpp>
+
+namespace hvk {
+
+	namespace {
+
+		const float SNORM16_MAX = 32767.f;
+
+		int16_t toSnorm16(float value)
+		{
+			return static_cast<int16_t>(std::round(glm::clamp(value, -1.f, 1.f) * SNORM16_MAX));
+		}
+
+		// Projects the unit sphere onto an octahedron and unfolds its lower half over the corners
+		glm::vec2 encodeOctahedral(glm::vec3 direction)
+		{
+			const float length = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+			if (length == 0.f)
+			{
+				return glm::vec2(0.f);
+			}
+			direction /= length;
+
+			glm::vec2 encoded(direction.x, direction.y);
+			if (direction.z < 0.f)
+			{
+				encoded = glm::vec2(
+					(1.f - std::abs(direction.y)) * (direction.x >= 0.f ? 1.f : -1.f),
+					(1.f - std::abs(direction.x)) * (direction.y >= 0.f ? 1.f : -1.f));
+			}
+			return encoded;
+		}
+	}
+
+	uint32_t getVertexAttributeStride(VertexEncoding encoding)
+	{
+		return encoding == VertexEncoding::Packed ? sizeof(PackedVertexAttributes) : sizeof(VertexAttributes);
+	}
+
+	PackedVertexAttributes packVertexAttributes(const Vertex& vertex)
+	{
+		const glm::vec2 normal = encodeOctahedral(vertex.normal);
+		const glm::vec2 tangent = encodeOctahedral(glm::vec3(vertex.tangent));
+
+		PackedVertexAttributes packed;
+		packed.normalTangent[0] = toSnorm16(normal.x);
+		packed.normalTangent[1] = toSnorm16(normal.y);
+		packed.normalTangent[2] = toSnorm16(tangent.x);
+		// Quantized to even values so the lowest bit can carry the handedness; the
+		// result stays inside [-32767, 32767] so the shader never sees the clamped -32768
+		const int evenTangent = 2 * static_cast<int>(std::round(glm::clamp(tangent.y, -1.f, 1.f) * (SNORM16_MAX - 1.f) * 0.5f));
+		packed.normalTangent[3] = static_cast<int16_t>(evenTangent + (vertex.tangent.w < 0.f ? 1 : 0));
+		packed.texCoord[0] = glm::packHalf1x16(vertex.texCoord.x);
+		packed.texCoord[1] = glm::packHalf1x16(vertex.texCoord.y);
+		return packed;
+	}
+
+	void encodeVertices(
+		const Vertex* vertices,
+		size_t vertexCount,
+		VertexEncoding encoding,
+		std::vector<PositionVertex>& outPositions,
+		std::vector<uint8_t>& outAttributes)
+	{
+		const size_t stride = getVertexAttributeStride(encoding);
+		outPositions.resize(vertexCount);
+		outAttributes.resize(vertexCount * stride);
+
+		uint8_t* attributes = outAttributes.data();
+		for (size_t i = 0; i < vertexCount; ++i, attributes += stride)
+		{
+			const Vertex& vertex = vertices[i];
+			outPositions[i].pos = vertex.pos;
+			if (encoding == VertexEncoding::Packed)
+			{
+				const PackedVertexAttributes packed = packVertexAttributes(vertex);
+				memcpy(attributes, &packed, sizeof(packed));
+			}
+			else
+			{
+				const VertexAttributes full = { vertex.normal, vertex.texCoord, vertex.tangent };
+				memcpy(attributes, &full, sizeof(full));
+			}
+		}
+	}
+}
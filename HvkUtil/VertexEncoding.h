@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "HvkUtil.h"
+
+namespace hvk {
+
+	// How a mesh's binding 1 stream is stored. It's picked when the mesh is imported
+	// and decides which vertex shader it's drawn with
+	enum class VertexEncoding : uint32_t
+	{
+		// VertexAttributes; 48 bytes a vertex with the position stream
+		Full,
+		// PackedVertexAttributes; 24 bytes a vertex with the position stream.
+		// UVs keep 11 bits of mantissa, so heavily tiled coordinates lose precision
+		Packed
+	};
+
+	uint32_t getVertexAttributeStride(VertexEncoding encoding);
+
+	PackedVertexAttributes packVertexAttributes(const Vertex& vertex);
+
+	// Splits interleaved vertices into the position stream and encoding's attribute stream
+	void encodeVertices(
+		const Vertex* vertices,
+		size_t vertexCount,
+		VertexEncoding encoding,
+		std::vector<PositionVertex>& outPositions,
+		std::vector<uint8_t>& outAttributes);
+}
@@ -0,0 +1,169 @@
+#include "pch.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hvk {
+
+	namespace
+	{
+		struct Loop
+		{
+			const std::function<void(size_t)>* task;
+			size_t count;
+			std::atomic<size_t> next;
+		};
+
+		void runLoop(Loop& loop)
+		{
+			for (size_t i = loop.next++; i < loop.count; i = loop.next++)
+			{
+				(*loop.task)(i);
+			}
+		}
+
+		// Set on workers and on a caller while it runs its share, so nested loops run inline
+		// instead of waiting on the pool they're part of
+		thread_local bool tInLoop = false;
+
+		class Pool
+		{
+		private:
+			std::vector<std::thread> mThreads;
+			// Held by a caller for the whole loop, so only one is handed out at a time
+			std::mutex mSubmitMutex;
+			std::mutex mMutex;
+			std::condition_variable mWake;
+			std::condition_variable mDone;
+			Loop* mLoop;
+			// Bumped for every loop so a parked worker knows there's something new
+			uint64_t mGeneration;
+			// Workers still allowed to join the current loop, and those that joined and haven't finished
+			size_t mSeats;
+			size_t mBusy;
+			bool mStopping;
+
+			void workerMain()
+			{
+				tInLoop = true;
+				uint64_t seen = 0;
+				std::unique_lock<std::mutex> lock(mMutex);
+				for (;;)
+				{
+					mWake.wait(lock, [&]() { return mStopping || mGeneration != seen; });
+					if (mStopping)
+					{
+						return;
+					}
+					seen = mGeneration;
+					if (mSeats == 0)
+					{
+						continue;
+					}
+					--mSeats;
+					++mBusy;
+					Loop* loop = mLoop;
+
+					lock.unlock();
+					runLoop(*loop);
+					lock.lock();
+
+					if (--mBusy == 0)
+					{
+						mDone.notify_all();
+					}
+				}
+			}
+
+		public:
+			Pool() :
+				mThreads(),
+				mLoop(nullptr),
+				mGeneration(0),
+				mSeats(0),
+				mBusy(0),
+				mStopping(false)
+			{
+				const size_t threadCount = std::max<size_t>(1, std::thread::hardware_concurrency()) - 1;
+				mThreads.reserve(threadCount);
+				for (size_t i = 0; i < threadCount; ++i)
+				{
+					mThreads.emplace_back([this]() { workerMain(); });
+				}
+			}
+
+			~Pool()
+			{
+				{
+					std::lock_guard<std::mutex> lock(mMutex);
+					mStopping = true;
+				}
+				mWake.notify_all();
+				for (auto& thread : mThreads)
+				{
+					thread.join();
+				}
+			}
+
+			size_t getWorkerCount() const { return mThreads.size(); }
+
+			size_t run(size_t count, const std::function<void(size_t)>& task)
+			{
+				Loop loop;
+				loop.task = &task;
+				loop.count = count;
+				loop.next = 0;
+
+				// The caller takes a share too, so a loop of one never wakes anybody
+				const size_t helpers = std::min(mThreads.size(), count > 0 ? count - 1 : 0);
+				if (tInLoop || helpers == 0)
+				{
+					runLoop(loop);
+					return 1;
+				}
+
+				std::lock_guard<std::mutex> submit(mSubmitMutex);
+				{
+					std::lock_guard<std::mutex> lock(mMutex);
+					mLoop = &loop;
+					mSeats = helpers;
+					++mGeneration;
+				}
+				mWake.notify_all();
+
+				tInLoop = true;
+				runLoop(loop);
+				tInLoop = false;
+
+				// Workers that never got to it are turned away before the loop goes out of scope
+				std::unique_lock<std::mutex> lock(mMutex);
+				const size_t joined = helpers - mSeats;
+				mSeats = 0;
+				mDone.wait(lock, [&]() { return mBusy == 0; });
+				mLoop = nullptr;
+				return joined + 1;
+			}
+		};
+
+		Pool& getPool()
+		{
+			static Pool pool;
+			return pool;
+		}
+	}
+
+	size_t WorkerPool::parallelFor(size_t count, const std::function<void(size_t)>& task)
+	{
+		return getPool().run(count, task);
+	}
+
+	size_t WorkerPool::getWorkerCount()
+	{
+		return getPool().getWorkerCount();
+	}
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace hvk {
+
+	// Worker threads shared by every parallel loop, one per core besides the caller's.
+	// They're started on first use and parked between loops, so importing a model or
+	// compressing a texture doesn't pay for creating threads each time.
+	class WorkerPool
+	{
+	public:
+		// Runs task(i) for every i in [0, count) on the pool and the calling thread, returning once
+		// all have finished. Loops from several threads take turns; a loop started from inside a
+		// task runs on the thread that started it alone. Returns how many threads took part
+		static size_t parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+		static size_t getWorkerCount();
+	};
+}
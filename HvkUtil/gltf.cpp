@@ -2,8 +2,25 @@
 #include "framework.h"
 
 #include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <limits>
+#include <cctype>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define HVK_SSE 1
+#include <emmintrin.h>
+#else
+#define HVK_SSE 0
+#endif
 
 #include "gltf.h"
+#include "MemoryStats.h"
+#include "WorkerPool.h"
 #define TINYGLTF_IMPLEMENTATION
 #ifndef STB_IMAGE_IMPLEMENTATION
 #endif
@@ -19,138 +36,753 @@ namespace hvk
 {
 	tinygltf::TinyGLTF ModelLoader = tinygltf::TinyGLTF();
 
-	void processGltfNode(
-		tinygltf::Node& node,
-		tinygltf::Model& model,
-		std::vector<StaticMesh>& outMeshes)
+	namespace
 	{
-		if (node.mesh >= 0) {
-			std::vector<Vertex> vertices;
-			std::vector<VertIndex> indices;
-			Material mat;
+		const uint8_t GLB_MAGIC[4] = { 'g', 'l', 'T', 'F' };
+		// Below this the interleaved vertices are likely to be read again while still in cache
+		const size_t STREAM_THRESHOLD = 1 << 20;
 
-			tinygltf::Mesh mesh = model.meshes[node.mesh];
-			for (size_t j = 0; j < mesh.primitives.size(); ++j) {
-				tinygltf::Primitive prim = mesh.primitives[j];
-				const auto positionAttr = prim.attributes.find("POSITION");
-				const auto uvAttr = prim.attributes.find("TEXCOORD_0");
-				const auto normalAttr = prim.attributes.find("NORMAL");
-                const auto tangentAttr = prim.attributes.find("TANGENT");
-
-				assert(positionAttr != prim.attributes.end());
-				assert(uvAttr != prim.attributes.end());
-				assert(normalAttr != prim.attributes.end());
-
-				// process position data
-				const tinygltf::Accessor positionAccess = model.accessors[positionAttr->second];
-				assert(positionAccess.type == TINYGLTF_TYPE_VEC3);
-				const size_t numPositions = positionAccess.count;
-				const tinygltf::BufferView positionView = model.bufferViews[positionAccess.bufferView];
-				const float* positionData = reinterpret_cast<const float*>(
-					&(model.buffers[positionView.buffer].data[positionView.byteOffset + positionAccess.byteOffset]));
-
-				// process UV data
-				const tinygltf::Accessor uvAccess = model.accessors[uvAttr->second];
-				assert(uvAccess.type == TINYGLTF_TYPE_VEC2);
-				const tinygltf::BufferView uvView = model.bufferViews[uvAccess.bufferView];
-				const float* uvData = reinterpret_cast<const float*>(
-					&(model.buffers[uvView.buffer].data[uvView.byteOffset + uvAccess.byteOffset]));
-
-				// process normal data
-				const tinygltf::Accessor normalAccess = model.accessors[normalAttr->second];
-				assert(normalAccess.type == TINYGLTF_TYPE_VEC3);
-				const tinygltf::BufferView normalView = model.bufferViews[normalAccess.bufferView];
-				const float* normalData = reinterpret_cast<const float*>(
-					&(model.buffers[normalView.buffer].data[normalView.byteOffset + normalAccess.byteOffset]));
-
-                // process tangent data
-                float* tangentData = nullptr;
-                if (tangentAttr != prim.attributes.end())
-                {
-                    const tinygltf::Accessor tangentAccess = model.accessors[tangentAttr->second];
-                    assert(tangentAccess.type == TINYGLTF_TYPE_VEC4);
-                    const tinygltf::BufferView tangentView = model.bufferViews[tangentAccess.bufferView];
-                    tangentData = reinterpret_cast<float*>(&(model.buffers[tangentView.buffer].data[tangentView.byteOffset + tangentAccess.byteOffset]));
-                }
-
-				assert(positionAccess.count == uvAccess.count);
-
-				//RenderObject::allocateVertices(numPositions, vertices);
-				vertices.reserve(numPositions);
-
-				for (size_t k = 0; k < numPositions; ++k) {
-					Vertex v{};
-					v.pos = glm::make_vec3(&positionData[k * 3]);
-					v.normal = glm::make_vec3(&normalData[k * 3]);
-					v.texCoord = glm::make_vec2(&uvData[k * 2]);
-                    if (tangentData != nullptr)
-                    {
-                        v.tangent = glm::make_vec4(&tangentData[k * 4]);
-                    }
-					vertices.push_back(v);
+		bool isBinaryGltf(const std::string& filename)
+		{
+			const size_t dot = filename.find_last_of('.');
+			if (dot != std::string::npos)
+			{
+				std::string extension = filename.substr(dot + 1);
+				std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) {
+					return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+				});
+				if (extension == "glb")
+				{
+					return true;
 				}
+			}
 
-				// process indices
-				const tinygltf::Accessor indexAccess = model.accessors[prim.indices];
-				assert(indexAccess.type == TINYGLTF_TYPE_SCALAR);
-				const size_t numIndices = indexAccess.count;
-				const tinygltf::BufferView indexView = model.bufferViews[indexAccess.bufferView];
-				// TODO: need to handle more than just uint16_t indices (unsigned short)
-				const uint16_t * indexData = reinterpret_cast<const uint16_t*>(
-					&(model.buffers[indexView.buffer].data[indexView.byteOffset + indexAccess.byteOffset]));
+			uint8_t magic[4] = {};
+			std::ifstream file(filename, std::ios::binary);
+			file.read(reinterpret_cast<char*>(magic), sizeof(magic));
+			return file.gcount() == sizeof(magic) && memcmp(magic, GLB_MAGIC, sizeof(magic)) == 0;
+		}
 
-				//RenderObject::allocateIndices(numIndices, indices);
-				indices.reserve(numIndices);
+		// Stands in for tinygltf's decoder during parsing so the encoded bytes can be
+		// decoded on worker threads afterwards. Requested sizes are kept in width/height.
+		// Only the header is read here, so bytes stb_image can't make sense of fail the
+		// parse like they would with tinygltf's own decoder
+		bool deferImageDecode(
+			tinygltf::Image* image,
+			const int imageIndex,
+			std::string* err,
+			std::string*,
+			int reqWidth,
+			int reqHeight,
+			const unsigned char* bytes,
+			int size,
+			void*)
+		{
+			int width, height, components;
+			if (bytes == nullptr || size <= 0 || !stbi_info_from_memory(bytes, size, &width, &height, &components))
+			{
+				if (err)
+				{
+					(*err) += "Unknown image format. STB cannot decode image data for image[" +
+						std::to_string(imageIndex) + "] name = \"" + image->name + "\".\n";
+				}
+				return false;
+			}
+
+			image->image.assign(bytes, bytes + size);
+			image->width = reqWidth;
+			image->height = reqHeight;
+			image->as_is = true;
+			return true;
+		}
 
-				for (size_t k = 0; k < numIndices; ++k) {
-					indices.push_back(indexData[k]);
+		// stb_image keeps no decoder state between calls, only a shared failure-reason
+		// pointer, so images can be decoded on several threads at once
+		bool decodeDeferredImage(tinygltf::Image& image, int imageIndex, std::string& outErr)
+		{
+			std::string warn;
+			tinygltf::Image decoded;
+			decoded.name = image.name;
+			const bool imageDecoded = tinygltf::LoadImageData(
+				&decoded,
+				imageIndex,
+				&outErr,
+				&warn,
+				std::max(image.width, 0),
+				std::max(image.height, 0),
+				image.image.data(),
+				static_cast<int>(image.image.size()),
+				nullptr);
+			if (imageDecoded)
+			{
+				image.width = decoded.width;
+				image.height = decoded.height;
+				image.component = decoded.component;
+				image.bits = decoded.bits;
+				image.pixel_type = decoded.pixel_type;
+				image.image.swap(decoded.image);
+				image.as_is = false;
+			}
+			return imageDecoded;
+		}
+
+		// Bytes of bufferView from offset on, or nullptr if fewer than size remain
+		const uint8_t* getBufferViewBytes(const tinygltf::Model& model, int bufferViewIndex, size_t offset, size_t size)
+		{
+			if (bufferViewIndex < 0 || static_cast<size_t>(bufferViewIndex) >= model.bufferViews.size())
+			{
+				return nullptr;
+			}
+			const tinygltf::BufferView& bufferView = model.bufferViews[bufferViewIndex];
+			if (bufferView.buffer < 0 || static_cast<size_t>(bufferView.buffer) >= model.buffers.size())
+			{
+				return nullptr;
+			}
+			const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+			const size_t start = bufferView.byteOffset + offset;
+			if (offset > bufferView.byteLength || size > bufferView.byteLength - offset || start + size > buffer.data.size())
+			{
+				return nullptr;
+			}
+			return buffer.data.data() + start;
+		}
+
+		// Writes a sparse accessor's base values with its substitutions applied into a buffer
+		// of its own and points the accessor at it, so it reads like any dense accessor.
+		// False if its indices or values don't fit their buffers
+		bool densifySparseAccessor(tinygltf::Model& model, tinygltf::Accessor& accessor)
+		{
+			const int componentSize = tinygltf::GetComponentSizeInBytes(static_cast<uint32_t>(accessor.componentType));
+			const int componentCount = tinygltf::GetTypeSizeInBytes(static_cast<uint32_t>(accessor.type));
+			const int indexSize = tinygltf::GetComponentSizeInBytes(static_cast<uint32_t>(accessor.sparse.indices.componentType));
+			if (componentSize <= 0 || componentCount <= 0 || indexSize <= 0 ||
+				accessor.sparse.count < 0 || accessor.sparse.indices.byteOffset < 0 || accessor.sparse.values.byteOffset < 0)
+			{
+				return false;
+			}
+			const size_t elementSize = static_cast<size_t>(componentSize) * static_cast<size_t>(componentCount);
+
+			// Without a buffer view the base values are all zero
+			std::vector<unsigned char> dense(accessor.count * elementSize, 0);
+			if (accessor.bufferView >= 0 && accessor.count > 0)
+			{
+				const int stride = accessor.ByteStride(model.bufferViews[accessor.bufferView]);
+				if (stride <= 0)
+				{
+					return false;
+				}
+				const uint8_t* base = getBufferViewBytes(
+					model,
+					accessor.bufferView,
+					accessor.byteOffset,
+					(accessor.count - 1) * static_cast<size_t>(stride) + elementSize);
+				if (base == nullptr)
+				{
+					return false;
+				}
+				for (size_t i = 0; i < accessor.count; ++i)
+				{
+					memcpy(dense.data() + i * elementSize, base + i * static_cast<size_t>(stride), elementSize);
 				}
+			}
+
+			const size_t substitutions = static_cast<size_t>(accessor.sparse.count);
+			const uint8_t* indices = getBufferViewBytes(
+				model,
+				accessor.sparse.indices.bufferView,
+				static_cast<size_t>(accessor.sparse.indices.byteOffset),
+				substitutions * static_cast<size_t>(indexSize));
+			const uint8_t* values = getBufferViewBytes(
+				model,
+				accessor.sparse.values.bufferView,
+				static_cast<size_t>(accessor.sparse.values.byteOffset),
+				substitutions * elementSize);
+			if (indices == nullptr || values == nullptr)
+			{
+				return false;
+			}
+			for (size_t i = 0; i < substitutions; ++i)
+			{
+				size_t index;
+				switch (accessor.sparse.indices.componentType)
+				{
+				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+					index = indices[i];
+					break;
+				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+				{
+					uint16_t value;
+					memcpy(&value, indices + i * sizeof(value), sizeof(value));
+					index = value;
+					break;
+				}
+				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+				{
+					uint32_t value;
+					memcpy(&value, indices + i * sizeof(value), sizeof(value));
+					index = value;
+					break;
+				}
+				default:
+					return false;
+				}
+				if (index >= accessor.count)
+				{
+					return false;
+				}
+				memcpy(dense.data() + index * elementSize, values + i * elementSize, elementSize);
+			}
+
+			tinygltf::Buffer buffer;
+			buffer.data = std::move(dense);
+			tinygltf::BufferView bufferView;
+			bufferView.buffer = static_cast<int>(model.buffers.size());
+			bufferView.byteLength = buffer.data.size();
+			model.buffers.push_back(std::move(buffer));
+
+			accessor.bufferView = static_cast<int>(model.bufferViews.size());
+			accessor.byteOffset = 0;
+			accessor.sparse.isSparse = false;
+			model.bufferViews.push_back(std::move(bufferView));
+			return true;
+		}
+
+		float readComponent(const uint8_t* p, int componentType, bool normalized)
+		{
+			switch (componentType)
+			{
+			case TINYGLTF_COMPONENT_TYPE_FLOAT:
+			{
+				float value;
+				memcpy(&value, p, sizeof(value));
+				return value;
+			}
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+				return normalized ? *p / 255.f : static_cast<float>(*p);
+			case TINYGLTF_COMPONENT_TYPE_BYTE:
+			{
+				const int8_t value = static_cast<int8_t>(*p);
+				return normalized ? std::max(value / 127.f, -1.f) : static_cast<float>(value);
+			}
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+			{
+				uint16_t value;
+				memcpy(&value, p, sizeof(value));
+				return normalized ? value / 65535.f : static_cast<float>(value);
+			}
+			case TINYGLTF_COMPONENT_TYPE_SHORT:
+			{
+				int16_t value;
+				memcpy(&value, p, sizeof(value));
+				return normalized ? std::max(value / 32767.f, -1.f) : static_cast<float>(value);
+			}
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+			{
+				uint32_t value;
+				memcpy(&value, p, sizeof(value));
+				return static_cast<float>(value);
+			}
+			default:
+				assert(false);
+				return 0.f;
+			}
+		}
 
-				// process material
-				//mat.diffuseProp.texture = Pool<tinygltf::Image>::alloc(model.images[model.materials[prim.material].pbrMetallicRoughness.baseColorTexture.index]);
-                int diffuseIndex = model.materials[prim.material].pbrMetallicRoughness.baseColorTexture.index;
-                int metallicRoughnessIndex = model.materials[prim.material].pbrMetallicRoughness.metallicRoughnessTexture.index;
-                int normalIndex = model.materials[prim.material].normalTexture.index;
-                if (diffuseIndex > -1) {
-                    mat.diffuseProp.texture = HVK_shared<tinygltf::Image>(new tinygltf::Image(model.images[diffuseIndex]));
-                }
-                if (metallicRoughnessIndex > -1) {
-                    mat.metallicRoughnessProp.texture = HVK_shared<tinygltf::Image>(new tinygltf::Image(model.images[metallicRoughnessIndex]));
-                }
-                if (normalIndex > -1) {
-                    mat.normalProp.texture = HVK_shared<tinygltf::Image>(new tinygltf::Image(model.images[normalIndex]));
-                }
+		// Reads up to N components of element index, zero filling anything missing
+		template <size_t N>
+		void readElement(const AccessorView& view, size_t index, float* out)
+		{
+			const size_t components = view.data != nullptr && index < view.count ? std::min(N, view.getComponentCount()) : 0;
+			const size_t componentSize = components > 0 ? tinygltf::GetComponentSizeInBytes(view.componentType) : 0;
+			const uint8_t* element = view.data + index * view.stride;
+			for (size_t i = 0; i < N; ++i)
+			{
+				out[i] = i < components ? readComponent(element + i * componentSize, view.componentType, view.normalized) : 0.f;
 			}
+		}
 
-			outMeshes.emplace_back(vertices, indices, mat);
+		void interleaveVertex(const GltfPrimitiveView& primitive, size_t index, Vertex* dst)
+		{
+			float values[4];
+			readElement<3>(primitive.positions, index, values);
+			dst->pos = glm::make_vec3(values);
+			readElement<3>(primitive.normals, index, values);
+			dst->normal = glm::make_vec3(values);
+			readElement<2>(primitive.uvs, index, values);
+			dst->texCoord = glm::make_vec2(values);
+			readElement<4>(primitive.tangents, index, values);
+			dst->tangent = glm::make_vec4(values);
 		}
 
-		for (const int& childId : node.children) {
-			tinygltf::Node& childNode = model.nodes[childId];
-			processGltfNode(childNode, model, outMeshes);
+#if HVK_SSE
+		static_assert(sizeof(Vertex) == 12 * sizeof(float), "SIMD interleave assumes a tightly packed 48 byte Vertex");
+
+		// Vertex is [pos.xyz normal.x] [normal.yz uv.xy] [tangent.xyzw], three 16 byte stores.
+		// vec3 loads read 4 bytes past the element, so the final vertex goes through the scalar path
+		template <bool Stream, bool HasTangents>
+		void interleaveSimd(const GltfPrimitiveView& primitive, size_t count, Vertex* dst)
+		{
+			const uint8_t* positions = primitive.positions.data;
+			const uint8_t* normals = primitive.normals.data;
+			const uint8_t* uvs = primitive.uvs.data;
+			const uint8_t* tangents = primitive.tangents.data;
+			float* out = reinterpret_cast<float*>(dst);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const __m128 p = _mm_loadu_ps(reinterpret_cast<const float*>(positions + i * primitive.positions.stride));
+				const __m128 n = _mm_loadu_ps(reinterpret_cast<const float*>(normals + i * primitive.normals.stride));
+				double uvBits;
+				memcpy(&uvBits, uvs + i * primitive.uvs.stride, sizeof(uvBits));
+				const __m128 uv = _mm_castpd_ps(_mm_set_sd(uvBits));
+				const __m128 t = HasTangents ?
+					_mm_loadu_ps(reinterpret_cast<const float*>(tangents + i * primitive.tangents.stride)) :
+					_mm_setzero_ps();
+
+				const __m128 pzNx = _mm_shuffle_ps(p, n, _MM_SHUFFLE(0, 0, 2, 2));
+				const __m128 out0 = _mm_shuffle_ps(p, pzNx, _MM_SHUFFLE(2, 0, 1, 0));
+				const __m128 out1 = _mm_shuffle_ps(n, uv, _MM_SHUFFLE(1, 0, 2, 1));
+
+				if (Stream)
+				{
+					_mm_stream_ps(out, out0);
+					_mm_stream_ps(out + 4, out1);
+					_mm_stream_ps(out + 8, t);
+				}
+				else
+				{
+					_mm_storeu_ps(out, out0);
+					_mm_storeu_ps(out + 4, out1);
+					_mm_storeu_ps(out + 8, t);
+				}
+				out += 12;
+			}
+
+			if (Stream)
+			{
+				_mm_sfence();
+			}
 		}
+#endif
 	}
 
-	std::vector<StaticMesh> createMeshFromGltf(const std::string& filename)
+	size_t AccessorView::getComponentCount() const
 	{
-		std::vector<StaticMesh> meshes;
+		return static_cast<size_t>(tinygltf::GetTypeSizeInBytes(static_cast<uint32_t>(type)));
+	}
 
-		tinygltf::Model model;
+	bool AccessorView::isFloat(size_t components) const
+	{
+		return data != nullptr &&
+			componentType == TINYGLTF_COMPONENT_TYPE_FLOAT &&
+			getComponentCount() == components;
+	}
+
+	bool loadGltfModel(const std::string& filename, tinygltf::Model& outModel, bool deferImages)
+	{
 		std::string err, warn;
 
-		bool modelLoaded = ModelLoader.LoadASCIIFromFile(&model, &err, &warn, filename);
+		// The shared loader keeps tinygltf's decoder; deferred loads get their own
+		// so concurrent imports never see each other's callback
+		tinygltf::TinyGLTF deferredLoader;
+		tinygltf::TinyGLTF& loader = deferImages ? deferredLoader : ModelLoader;
+		if (deferImages)
+		{
+			deferredLoader.SetImageLoader(&deferImageDecode, nullptr);
+		}
+
+		bool modelLoaded = false;
+		if (isBinaryGltf(filename))
+		{
+			modelLoaded = loader.LoadBinaryFromFile(&outModel, &err, &warn, filename);
+		}
+		else
+		{
+			modelLoaded = loader.LoadASCIIFromFile(&outModel, &err, &warn, filename);
+		}
+
 		if (!err.empty()) {
 			std::cout << err << std::endl;
 		}
 		if (!warn.empty()) {
 			std::cout << warn << std::endl;
 		}
+		if (!modelLoaded)
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < outModel.accessors.size(); ++i)
+		{
+			tinygltf::Accessor& accessor = outModel.accessors[i];
+			if (accessor.sparse.isSparse && !densifySparseAccessor(outModel, accessor))
+			{
+				std::cout << "Sparse accessor " << i << " in " << filename << " is invalid" << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	AccessorView getAccessorView(const tinygltf::Model& model, int accessorIndex)
+	{
+		const tinygltf::Accessor& accessor = model.accessors[accessorIndex];
+		// loadGltfModel resolves sparse accessors into dense ones
+		assert(!accessor.sparse.isSparse);
+
+		AccessorView view;
+		view.data = nullptr;
+		view.count = accessor.count;
+		view.stride = 0;
+		view.componentType = accessor.componentType;
+		view.type = accessor.type;
+		view.normalized = accessor.normalized;
+
+		if (accessor.bufferView >= 0)
+		{
+			const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+			const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+			const int stride = accessor.ByteStride(bufferView);
+			assert(stride > 0);
+
+			view.stride = static_cast<size_t>(stride);
+			view.data = buffer.data.data() + bufferView.byteOffset + accessor.byteOffset;
+			assert(accessor.count == 0 ||
+				bufferView.byteOffset + accessor.byteOffset + (accessor.count - 1) * view.stride <= buffer.data.size());
+		}
+
+		return view;
+	}
+
+	GltfPrimitiveView getPrimitiveView(const tinygltf::Model& model, const tinygltf::Primitive& primitive)
+	{
+		const AccessorView missing = { nullptr, 0, 0, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_SCALAR, false };
+		auto findAttribute = [&](const char* name) {
+			const auto found = primitive.attributes.find(name);
+			return found != primitive.attributes.end() ? getAccessorView(model, found->second) : missing;
+		};
+
+		GltfPrimitiveView view;
+		view.positions = findAttribute("POSITION");
+		view.normals = findAttribute("NORMAL");
+		view.uvs = findAttribute("TEXCOORD_0");
+		view.tangents = findAttribute("TANGENT");
+		view.material = primitive.material;
+
+		assert(view.positions.data != nullptr);
+		assert(view.positions.type == TINYGLTF_TYPE_VEC3);
+		assert(view.normals.count == 0 || view.normals.count == view.positions.count);
+		assert(view.uvs.count == 0 || view.uvs.count == view.positions.count);
+		assert(view.tangents.count == 0 || view.tangents.count == view.positions.count);
+
+		if (primitive.indices >= 0)
+		{
+			view.indices = getAccessorView(model, primitive.indices);
+			assert(view.indices.type == TINYGLTF_TYPE_SCALAR);
+		}
+		else
+		{
+			view.indices = { nullptr, view.positions.count, 0, TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT, TINYGLTF_TYPE_SCALAR, false };
+		}
+
+		return view;
+	}
+
+	size_t interleaveVertices(const GltfPrimitiveView& primitive, Vertex* dst)
+	{
+		const size_t count = primitive.positions.count;
+		if (count == 0)
+		{
+			return 0;
+		}
+
+#if HVK_SSE
+		const bool hasTangents = primitive.tangents.count > 0;
+		const bool simd = primitive.positions.isFloat(3) &&
+			primitive.normals.isFloat(3) &&
+			primitive.uvs.isFloat(2) &&
+			(!hasTangents || primitive.tangents.isFloat(4));
+		if (simd)
+		{
+			const bool stream = (reinterpret_cast<uintptr_t>(dst) & 15) == 0 && count * sizeof(Vertex) >= STREAM_THRESHOLD;
+			const size_t simdCount = count - 1;
+			if (stream && hasTangents) interleaveSimd<true, true>(primitive, simdCount, dst);
+			else if (stream) interleaveSimd<true, false>(primitive, simdCount, dst);
+			else if (hasTangents) interleaveSimd<false, true>(primitive, simdCount, dst);
+			else interleaveSimd<false, false>(primitive, simdCount, dst);
+
+			interleaveVertex(primitive, count - 1, dst + count - 1);
+			return count;
+		}
+#endif
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			interleaveVertex(primitive, i, dst + i);
+		}
+		return count;
+	}
+
+	size_t copyIndices(const AccessorView& indices, uint32_t* dst, uint32_t baseVertex)
+	{
+		const size_t count = indices.count;
+		if (indices.data == nullptr)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				dst[i] = static_cast<uint32_t>(baseVertex + i);
+			}
+			return count;
+		}
+
+		if (baseVertex == 0 &&
+			indices.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT &&
+			indices.stride == sizeof(uint32_t))
+		{
+			memcpy(dst, indices.data, count * sizeof(uint32_t));
+			return count;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint8_t* element = indices.data + i * indices.stride;
+			uint32_t index = 0;
+			switch (indices.componentType)
+			{
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+				index = *element;
+				break;
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+			{
+				uint16_t value;
+				memcpy(&value, element, sizeof(value));
+				index = value;
+				break;
+			}
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+				memcpy(&index, element, sizeof(index));
+				break;
+			default:
+				assert(false);
+			}
+			dst[i] = index + baseVertex;
+		}
+		return count;
+	}
+
+	namespace
+	{
+		using ImportClock = std::chrono::steady_clock;
+
+		double elapsedMs(ImportClock::time_point start, ImportClock::time_point end)
+		{
+			return std::chrono::duration<double, std::milli>(end - start).count();
+		}
+
+		// Runs task(i) for every i in [0, count) on the shared workers, tagging what they allocate as assets
+		template <typename Task>
+		size_t parallelFor(size_t count, Task task)
+		{
+			return WorkerPool::parallelFor(count, [&](size_t i) {
+				MemoryTagScope tagScope(MemoryTag::Assets);
+				task(i);
+			});
+		}
+
+		// A mesh whose buffers are sized and whose submesh ranges are assigned,
+		// so every primitive can be extracted independently
+		struct PendingMesh
+		{
+			std::vector<GltfPrimitiveView> primitives;
+			StaticMesh::Vertices vertices;
+			StaticMesh::Indices indices;
+			StaticMesh::Submeshes submeshes;
+		};
+
+		void gatherGltfNode(
+			const tinygltf::Node& node,
+			const tinygltf::Model& model,
+			std::vector<PendingMesh>& outMeshes)
+		{
+			if (node.mesh >= 0) {
+				const tinygltf::Mesh& mesh = model.meshes[node.mesh];
+
+				outMeshes.emplace_back();
+				PendingMesh& pending = outMeshes.back();
+				pending.primitives.reserve(mesh.primitives.size());
+				pending.submeshes.reserve(mesh.primitives.size());
+				uint32_t vertexCount = 0;
+				uint32_t indexCount = 0;
+				for (const auto& prim : mesh.primitives) {
+					pending.primitives.push_back(getPrimitiveView(model, prim));
+					const GltfPrimitiveView& view = pending.primitives.back();
+
+					Submesh submesh;
+					submesh.firstIndex = indexCount;
+					submesh.indexCount = static_cast<uint32_t>(view.indices.count);
+					submesh.vertexOffset = vertexCount;
+					submesh.vertexCount = static_cast<uint32_t>(view.positions.count);
+					submesh.materialIndex = 0;
+					pending.submeshes.push_back(submesh);
+
+					vertexCount += submesh.vertexCount;
+					indexCount += submesh.indexCount;
+				}
+				pending.vertices.resize(vertexCount);
+				pending.indices.resize(indexCount);
+			}
+
+			for (const int& childId : node.children) {
+				gatherGltfNode(model.nodes[childId], model, outMeshes);
+			}
+		}
+	}
+
+	void printGltfImportTimings(const std::string& filename, const GltfImportTimings& timings)
+	{
+		std::cout << "Imported " << filename
+			<< ": parse " << timings.parseMs << "ms"
+			<< ", decode+extract " << timings.parallelMs << "ms on " << timings.workerCount << " threads"
+			<< " (" << timings.imageCount << " images " << timings.decodeMs << "ms"
+			<< ", " << timings.primitiveCount << " primitives " << timings.extractMs << "ms)"
+			<< ", assemble " << timings.assembleMs << "ms"
+			<< ", total " << timings.totalMs << "ms" << std::endl;
+	}
+
+	std::vector<StaticMesh> createMeshFromGltf(const std::string& filename)
+	{
+		MemoryTagScope tagScope(MemoryTag::Assets);
+		GltfImportTimings timings;
+
+		const auto parseStart = ImportClock::now();
+		tinygltf::Model model;
+		bool modelLoaded = loadGltfModel(filename, model, true);
 		assert(modelLoaded);
+		const double parseMs = elapsedMs(parseStart, ImportClock::now());
 
-		const tinygltf::Scene modelScene = model.scenes[model.defaultScene];
+		std::vector<StaticMesh> meshes = createMeshFromGltf(model, &timings);
+		timings.parseMs = parseMs;
+		timings.totalMs += parseMs;
+		printGltfImportTimings(filename, timings);
+
+		return meshes;
+	}
+
+	std::vector<StaticMesh> createMeshFromGltf(tinygltf::Model& model, GltfImportTimings* outTimings)
+	{
+		MemoryTagScope tagScope(MemoryTag::Assets);
+		const auto importStart = ImportClock::now();
+
+		std::vector<PendingMesh> pending;
+		const tinygltf::Scene& modelScene = model.scenes[model.defaultScene >= 0 ? model.defaultScene : 0];
 		for (const int& nodeId : modelScene.nodes) {
-			tinygltf::Node& sceneNode = model.nodes[nodeId];
-			processGltfNode(sceneNode, model, meshes);
+			gatherGltfNode(model.nodes[nodeId], model, pending);
+		}
+
+		// Images still holding encoded bytes from a deferred load, largest first since
+		// they take longest and should start before the cheap primitive tasks
+		std::vector<int> deferredImages;
+		for (size_t i = 0; i < model.images.size(); ++i) {
+			if (model.images[i].as_is) {
+				deferredImages.push_back(static_cast<int>(i));
+			}
+		}
+		std::sort(deferredImages.begin(), deferredImages.end(), [&model](int a, int b) {
+			return model.images[a].image.size() > model.images[b].image.size();
+		});
+
+		std::vector<std::pair<size_t, size_t>> primitiveTasks;
+		for (size_t m = 0; m < pending.size(); ++m) {
+			for (size_t p = 0; p < pending[m].primitives.size(); ++p) {
+				primitiveTasks.push_back({ m, p });
+			}
+		}
+
+		// Decode images and extract primitives concurrently; every task writes to its own range
+		std::vector<std::string> imageErrors(deferredImages.size());
+		std::atomic<int64_t> decodeNs(0);
+		std::atomic<int64_t> extractNs(0);
+		const auto parallelStart = ImportClock::now();
+		const size_t workerCount = parallelFor(deferredImages.size() + primitiveTasks.size(), [&](size_t task) {
+			const auto taskStart = ImportClock::now();
+			if (task < deferredImages.size()) {
+				const int imageIndex = deferredImages[task];
+				decodeDeferredImage(model.images[imageIndex], imageIndex, imageErrors[task]);
+				decodeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(ImportClock::now() - taskStart).count();
+			}
+			else {
+				const auto& primitiveTask = primitiveTasks[task - deferredImages.size()];
+				PendingMesh& mesh = pending[primitiveTask.first];
+				const GltfPrimitiveView& prim = mesh.primitives[primitiveTask.second];
+				const Submesh& submesh = mesh.submeshes[primitiveTask.second];
+				copyIndices(prim.indices, mesh.indices.data() + submesh.firstIndex, 0);
+				interleaveVertices(prim, mesh.vertices.data() + submesh.vertexOffset);
+				extractNs += std::chrono::duration_cast<std::chrono::nanoseconds>(ImportClock::now() - taskStart).count();
+			}
+		});
+		const auto assembleStart = ImportClock::now();
+
+		for (const auto& err : imageErrors) {
+			if (!err.empty()) {
+				std::cout << err << std::endl;
+			}
+		}
+
+		// Materials commonly share images, so each is only moved out of the model once
+		std::unordered_map<int, HVK_shared<tinygltf::Image>> images;
+		auto fetchImage = [&model, &images](int imageIndex) {
+			HVK_shared<tinygltf::Image> image;
+			if (imageIndex > -1) {
+				auto found = images.find(imageIndex);
+				if (found == images.end()) {
+					found = images.insert({ imageIndex, HVK_shared<tinygltf::Image>(new tinygltf::Image(std::move(model.images[imageIndex]))) }).first;
+				}
+				image = found->second;
+			}
+			return image;
+		};
+
+		std::vector<StaticMesh> meshes;
+		meshes.reserve(pending.size());
+		for (auto& mesh : pending) {
+			// glTF material index -> index into materials; primitives without one share a default
+			std::unordered_map<int, uint32_t> materialSlots;
+			StaticMesh::Materials materials;
+			for (size_t j = 0; j < mesh.primitives.size(); ++j) {
+				const int gltfMaterial = mesh.primitives[j].material;
+				auto slot = materialSlots.find(gltfMaterial);
+				if (slot == materialSlots.end()) {
+					Material mat = Material();
+					if (gltfMaterial > -1) {
+						const tinygltf::Material& gltfMat = model.materials[gltfMaterial];
+						mat.diffuseProp.texture = fetchImage(gltfMat.pbrMetallicRoughness.baseColorTexture.index);
+						mat.metallicRoughnessProp.texture = fetchImage(gltfMat.pbrMetallicRoughness.metallicRoughnessTexture.index);
+						mat.normalProp.texture = fetchImage(gltfMat.normalTexture.index);
+					}
+					slot = materialSlots.insert({ gltfMaterial, static_cast<uint32_t>(materials.size()) }).first;
+					materials.push_back(mat);
+				}
+				mesh.submeshes[j].materialIndex = slot->second;
+			}
+
+			if (materials.empty()) {
+				materials.push_back(Material());
+			}
+
+			meshes.emplace_back(std::move(mesh.vertices), std::move(mesh.indices), std::move(mesh.submeshes), std::move(materials));
+		}
+
+		if (outTimings != nullptr) {
+			const auto importEnd = ImportClock::now();
+			outTimings->parseMs = 0.0;
+			outTimings->parallelMs = elapsedMs(parallelStart, assembleStart);
+			outTimings->decodeMs = decodeNs / 1e6;
+			outTimings->extractMs = extractNs / 1e6;
+			outTimings->assembleMs = elapsedMs(assembleStart, importEnd);
+			outTimings->totalMs = elapsedMs(importStart, importEnd);
+			outTimings->workerCount = workerCount;
+			outTimings->imageCount = deferredImages.size();
+			outTimings->primitiveCount = primitiveTasks.size();
 		}
 
 		return meshes;
@@ -6,5 +6,69 @@
 namespace hvk
 {
 	extern tinygltf::TinyGLTF ModelLoader;
+
+	// Strided, non-owning view of a glTF accessor inside its loaded buffer.
+	// data is null for accessors without a buffer view (all zeroes per the spec)
+	struct AccessorView
+	{
+		const uint8_t* data;
+		size_t count;
+		size_t stride;
+		int componentType;
+		int type;
+		bool normalized;
+
+		size_t getComponentCount() const;
+		bool isFloat(size_t components) const;
+	};
+
+	struct GltfPrimitiveView
+	{
+		AccessorView positions;
+		AccessorView normals;
+		AccessorView uvs;
+		AccessorView tangents;
+		AccessorView indices;
+		int material;
+	};
+
+	// Wall time of each import stage. Image decoding and primitive extraction run
+	// concurrently, so decodeMs and extractMs are summed across threads within parallelMs
+	struct GltfImportTimings
+	{
+		double parseMs;
+		double parallelMs;
+		double decodeMs;
+		double extractMs;
+		double assembleMs;
+		double totalMs;
+		size_t workerCount;
+		size_t imageCount;
+		size_t primitiveCount;
+	};
+
+	// Picks the binary loader for .glb files (or anything starting with the glTF magic).
+	// Embedded data: URIs and external buffers are handled by the ASCII loader.
+	// deferImages leaves images encoded (as_is) for createMeshFromGltf to decode in parallel.
+	// Sparse accessors are resolved into dense buffers; fails if one is malformed
+	bool loadGltfModel(const std::string& filename, tinygltf::Model& outModel, bool deferImages = false);
+
+	AccessorView getAccessorView(const tinygltf::Model& model, int accessorIndex);
+	GltfPrimitiveView getPrimitiveView(const tinygltf::Model& model, const tinygltf::Primitive& primitive);
+
+	// Interleaves a primitive's attributes into dst in a single pass. dst may be
+	// write-combined mapped memory; large, 16 byte aligned destinations use non-temporal stores.
+	// Returns the number of vertices written
+	size_t interleaveVertices(const GltfPrimitiveView& primitive, Vertex* dst);
+
+	// Widens indices of any glTF index type (8, 16 or 32 bit) into dst, offset by baseVertex.
+	// Non-indexed primitives have a null view of positions.count and get sequential indices
+	size_t copyIndices(const AccessorView& indices, uint32_t* dst, uint32_t baseVertex);
+
+	// Parses, then decodes images and extracts every primitive on a worker per core,
+	// printing the time spent in each stage
 	std::vector<StaticMesh> createMeshFromGltf(const std::string& filename);
+	// Decodes any deferred images, then moves the pixels of every image a material uses out of the model
+	std::vector<StaticMesh> createMeshFromGltf(tinygltf::Model& model, GltfImportTimings* outTimings = nullptr);
+	void printGltfImportTimings(const std::string& filename, const GltfImportTimings& timings);
 }
@@ -21,6 +21,7 @@
 #include "Light.h"
 #include "CameraController.h"
 #include "gltf.h"
+#include "MeshCache.h"
 #include "vulkan-util.h"
 #include "shapes.h"
 #include "ModelPipeline.h"
@@ -32,6 +33,10 @@
 #include "math-util.h"
 #include "ToolsTypes.h"
 #include "image-util.h"
+#include "FrameAllocator.h"
+#include "MemoryStats.h"
+#include "MemoryPanel.h"
+#include "memory-util.h"
 
 using namespace hvk;
 
@@ -96,6 +101,11 @@ private:
 		}
 	}
 
+	void releasePBRBinding(entt::entity entity)
+	{
+		mPBRMeshRenderer->releasePBRBinding(mRegistry.get<PBRBinding>(entity));
+	}
+
 	void addChild(entt::entity entity)
 	{
 		auto& sceneNode = mRegistry.get<SceneNode>(entity);
@@ -133,25 +143,37 @@ private:
 
 public:
 	TestApp(uint32_t windowWidth, uint32_t windowHeight, const char* windowTitle) :
-		UserApp(windowWidth, windowHeight, windowTitle),
+		UserApp(windowWidth, windowHeight, windowTitle, VertexEncoding::Packed),
         mCameraController(nullptr),
 		mSceneDirty(false)
 	{
+		MemoryTagScope tagScope(MemoryTag::Scene);
 		mRegistry.on_construct<SceneNode>().connect<&TestApp::markSceneDirty>(*this);
 		mRegistry.on_destroy<SceneNode>().connect<&TestApp::markSceneDirty>(*this);
 		mRegistry.on_construct<SceneNode>().connect<&TestApp::addChild>(*this);
 		mRegistry.on_destroy<SceneNode>().connect<&TestApp::removeChild>(*this);
 		mRegistry.on_replace<SceneNode>().connect<&TestApp::markSceneDirty>(*this);
+		mRegistry.on_destroy<PBRBinding>().connect<&TestApp::releasePBRBinding>(*this);
 		mRegistry.on_construct<NodeTransform>().connect<&createWorldTransform>();
 		mRegistry.on_construct<NodeTransform>().connect<&createEditorRotation>();
 		mRegistry.on_construct<NodeTransform>().connect<&entt::registry::assign_or_replace<WorldDirty>>(&mRegistry);
 		mRegistry.on_replace<NodeTransform>().connect<&entt::registry::assign_or_replace<WorldDirty>>(&mRegistry);
 		mRegistry.on_construct<WorldDirty>().connect<&TestApp::dirtyTree>(*this);
 
-        StaticMesh duckMesh(hvk::createMeshFromGltf("resources/bottle/WaterBottle.gltf")[0]);
-		duckMesh.setUsingSRGMat(true);
+        // Cooked on first run, then mapped from the .hvkmesh cache next to the source.
+        // Textures are only block compressed if this device can sample them that way, and
+        // vertices are cooked in the layout the model pipeline draws
+        TextureCookSettings cookSettings;
+        cookSettings.compress = util::image::supportsBlockCompression(GpuManager::getPhysicalDevice());
+        MeshCookSettings meshSettings;
+        meshSettings.vertexEncoding = getModelPipeline().getVertexEncoding();
+        CookedModel duckModel;
+        bool duckLoaded = loadCookedModel("resources/bottle/WaterBottle.gltf", duckModel, cookSettings, meshSettings);
+        assert(duckLoaded);
         glm::mat4 duckTransform = glm::mat4(1.f);
-		StaticMesh staticBoxMesh(hvk::createMeshFromGltf("resources/box/box.gltf")[0]);
+		CookedModel boxModel;
+		bool boxLoaded = loadCookedModel("resources/box/box.gltf", boxModel, cookSettings, meshSettings);
+		assert(boxLoaded);
 
 		mModelEntity = mRegistry.create();
 
@@ -160,14 +182,14 @@ public:
 
 		// Model entity
         PBRMesh duckPbrMesh;
-        PBRMaterial duckPbrMaterial;
+        PBRMaterialSet duckPbrMaterial;
 		entt::entity modelEntity = mModelEntity;
 		mRegistry.assign<SceneNode>(modelEntity, mSceneEntity, "Bottle");
 		//mRegistry.assign<NodeTransform>(modelEntity, duckTransform);
-        getModelPipeline().loadAndFetchModel(duckMesh, "Duck", duckPbrMesh, duckPbrMaterial);
+        getModelPipeline().loadAndFetchModel(duckModel, 0, "Duck", duckPbrMesh, duckPbrMaterial);
         mRegistry.assign<PBRMesh>(modelEntity, duckPbrMesh);
-        mRegistry.assign<PBRMaterial>(modelEntity, duckPbrMaterial);
-		const auto& materialComp = mRegistry.get<PBRMaterial>(modelEntity);
+        mRegistry.assign<PBRMaterialSet>(modelEntity, duckPbrMaterial);
+		const auto& materialComp = mRegistry.get<PBRMaterialSet>(modelEntity);
 		mRegistry.assign<PBRBinding>(modelEntity, mPBRMeshRenderer->createPBRBinding(materialComp));
 		mRegistry.assign<ShadowBinding>(modelEntity, mShadowRenderer->createBinding());
 
@@ -199,14 +221,14 @@ public:
 
 		// Floor
 		PBRMesh boxPbrMesh;
-		PBRMaterial boxPbrMaterial;
+		PBRMaterialSet boxPbrMaterial;
 		entt::entity floorEntity = mRegistry.create();
 		auto floorTransform = glm::translate(glm::scale(glm::mat4(1.f), glm::vec3(10.f, 0.1f, 10.f)), glm::vec3(0.f, -2.5f, 0.f));
 		mRegistry.assign<SceneNode>(floorEntity, mSceneEntity, "Floor");
 		//mRegistry.assign<NodeTransform>(floorEntity, floorTransform);
-		getModelPipeline().loadAndFetchModel(staticBoxMesh, "boxMesh", boxPbrMesh, boxPbrMaterial);
+		getModelPipeline().loadAndFetchModel(boxModel, 0, "boxMesh", boxPbrMesh, boxPbrMaterial);
 		mRegistry.assign<PBRMesh>(floorEntity, boxPbrMesh);
-		const auto& boxMaterialComp = mRegistry.assign<PBRMaterial>(floorEntity, boxPbrMaterial);
+		const auto& boxMaterialComp = mRegistry.assign<PBRMaterialSet>(floorEntity, boxPbrMaterial);
 		mRegistry.assign<PBRBinding>(floorEntity, mPBRMeshRenderer->createPBRBinding(boxMaterialComp));
 
 		// Another box
@@ -214,7 +236,7 @@ public:
 		mRegistry.assign<SceneNode>(shadowBox, mSceneEntity, "ShadowBox");
 		//mRegistry.assign<NodeTransform>(shadowBox, glm::mat4(1.f));
 		mRegistry.assign<PBRMesh>(shadowBox, boxPbrMesh);
-		const auto& shadowboxMaterialComp = mRegistry.assign<PBRMaterial>(shadowBox, boxPbrMaterial);
+		const auto& shadowboxMaterialComp = mRegistry.assign<PBRMaterialSet>(shadowBox, boxPbrMaterial);
 		mRegistry.assign<PBRBinding>(shadowBox, mPBRMeshRenderer->createPBRBinding(shadowboxMaterialComp));
 		mRegistry.assign<ShadowBinding>(shadowBox, mShadowRenderer->createBinding());
 
@@ -310,7 +332,7 @@ protected:
         float mouseDeltY = -static_cast<float>(mouse.y - prevMouse.y);
         float mouseDeltX = static_cast<float>(prevMouse.x - mouse.x);
 
-        std::vector<hvk::Command> cameraCommands;
+        HVK_pmr_vector<hvk::Command> cameraCommands(FrameAllocator::getResource());
         cameraCommands.reserve(6);
 
 		// Don't allow keyboard inputs if the UI is capturing them
@@ -419,6 +441,7 @@ protected:
 		});
 
         // GUI
+        MemoryTagScope uiTagScope(MemoryTag::UI);
         ImGui::NewFrame();
 
         ImGui::Begin("Rendering");
@@ -426,6 +449,7 @@ protected:
 		ImGui::SliderFloat("Metallic", &mPBRWeight.metallic, 0.f, 1.f);
 		ImGui::SliderFloat("Roughness", &mPBRWeight.roughness, 0.f, 1.f);
 		ImGui::SliderFloat("Exposure", &mExposureSettings.exposure, 0.f, 10.f);
+		ImGui::SliderFloat("LOD Error (px)", &mLodSettings.pixelError, 0.f, 16.f);
 		ImGui::Text("Ambient Light");
 		ImGui::ColorEdit3("Color##Ambient", &mAmbientLight.lightColor.r);
 		ImGui::SliderFloat("Intensity##Ambient", &mAmbientLight.lightIntensity, 0.f, 10.f);
@@ -472,7 +496,8 @@ protected:
 		if (activeEntity != entt::null)
 		{
 			auto& sceneNode = mRegistry.get<SceneNode>(activeEntity);
-			std::string windowLabel = sceneNode.name + "###ObjectPanel";
+			std::pmr::string windowLabel(sceneNode.name.c_str(), FrameAllocator::getResource());
+			windowLabel += "###ObjectPanel";
 			ImGui::Begin(windowLabel.c_str());
 
 			if (mRegistry.has<NodeTransform>(activeEntity))
@@ -481,7 +506,8 @@ protected:
 				auto translation = glm::vec3(transform[3]);
 
 				bool changed = false;
-				std::string label = "Position##" + sceneNode.name;
+				std::pmr::string label("Position##", FrameAllocator::getResource());
+				label += sceneNode.name;
 				changed |= ImGui::DragFloat3(label.c_str(), &translation.x, 0.1f);
 
 				glm::quat rotQuat;
@@ -527,8 +553,10 @@ protected:
 				auto& lightColor = mRegistry.get<LightColor>(activeEntity);
 				auto& color = lightColor.color;
 				float intensity = lightColor.intensity;
-				std::string colorLabel = "Color##" + sceneNode.name;
-				std::string intensityLabel = "Intensity##" + sceneNode.name;
+				std::pmr::string colorLabel("Color##", FrameAllocator::getResource());
+				colorLabel += sceneNode.name;
+				std::pmr::string intensityLabel("Intensity##", FrameAllocator::getResource());
+				intensityLabel += sceneNode.name;
 				bool colorChanged = ImGui::ColorEdit3(colorLabel.c_str(), &color.r);
 				bool intensityChanged = ImGui::SliderFloat(intensityLabel.c_str(), &intensity, 0.f, 1.f);
 				if (colorChanged || intensityChanged)
@@ -572,8 +600,21 @@ protected:
 		ImGui::SameLine();
 		ImGui::Checkbox("RB##Prev", &mouse.rightDown);
 		ImGui::PopItemFlag();
+		ImGui::Text("Frame Memory");
+		ImGui::Text("Scratch used: %zu / %zu bytes (peak %zu)",
+			FrameAllocator::getBytesUsed(),
+			FrameAllocator::getFrameSize(),
+			FrameAllocator::getPeakBytesUsed());
+		ImGui::Text("Scratch overflow allocations: %zu", FrameAllocator::getOverflowCount());
+		if (memory::isHeapCountingEnabled())
+		{
+			ImGui::Text("Heap allocations last frame: %zu", memory::getFrameHeapAllocations());
+		}
 		ImGui::End();
 
+        memory::drawMemoryPanel();
+        util::memory::drawGpuMemoryPanel();
+
         ImGui::ShowDemoWindow();
 
         ImGui::EndFrame();
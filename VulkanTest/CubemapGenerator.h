@@ -9,6 +9,7 @@
 #include "shapes.h"
 #include "descriptor-util.h"
 #include "pipeline-util.h"
+#include "memory-util.h"
 
 
 
@@ -101,41 +102,31 @@ namespace hvk
 
 		// Create VBO
 		size_t vertexMemorySize = sizeof(CubeVertex) * mCubeRenderable.numVertices;
-		VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-		bufferInfo.size = vertexMemorySize;
-		bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-
-		VmaAllocationCreateInfo allocCreateInfo = {};
-		allocCreateInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
-		allocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-		vmaCreateBuffer(
+		util::memory::createStaticBuffer(
             allocator,
-			&bufferInfo,
-			&allocCreateInfo,
+			vertices->data(),
+			vertexMemorySize,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
 			&mCubeRenderable.vbo.memoryResource,
 			&mCubeRenderable.vbo.allocation,
-			&mCubeRenderable.vbo.allocationInfo);
-
-		memcpy(mCubeRenderable.vbo.allocationInfo.pMappedData, vertices->data(), vertexMemorySize);
+			&mCubeRenderable.vbo.allocationInfo,
+			util::memory::GpuMemoryCategory::Mesh);
 
 		// Create IBO
         size_t indexMemorySize = sizeof(uint16_t) * mCubeRenderable.numIndices;
-        VkBufferCreateInfo iboInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-        iboInfo.size = indexMemorySize;
-        iboInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-
-        VmaAllocationCreateInfo indexAllocCreateInfo = {};
-        indexAllocCreateInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
-        indexAllocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-        vmaCreateBuffer(
+        util::memory::createStaticBuffer(
             allocator,
-            &iboInfo,
-            &indexAllocCreateInfo,
+            indices->data(),
+            indexMemorySize,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            VK_ACCESS_INDEX_READ_BIT,
             &mCubeRenderable.ibo.memoryResource,
             &mCubeRenderable.ibo.allocation,
-            &mCubeRenderable.ibo.allocationInfo);
-
-        memcpy(mCubeRenderable.ibo.allocationInfo.pMappedData, indices->data(), indexMemorySize);
+            &mCubeRenderable.ibo.allocationInfo,
+            util::memory::GpuMemoryCategory::Mesh);
 
 		// Create UBO
         uint32_t uboMemorySize = sizeof(hvk::UniformBufferObject);
@@ -146,13 +137,14 @@ namespace hvk
 		VmaAllocationCreateInfo uniformAllocCreateInfo = {};
 		uniformAllocCreateInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
 		uniformAllocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-		vmaCreateBuffer(
+		util::memory::createBuffer(
             allocator,
 			&uboInfo,
 			&uniformAllocCreateInfo,
 			&mCubeRenderable.ubo.memoryResource,
 			&mCubeRenderable.ubo.allocation,
-			&mCubeRenderable.ubo.allocationInfo);
+			&mCubeRenderable.ubo.allocationInfo,
+			util::memory::GpuMemoryCategory::Uniform);
 
 		// Create descriptor pool
 		auto poolSizes = util::descriptor::template createPoolSizes<VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER>(1, 1);
@@ -282,9 +274,9 @@ namespace hvk
         const auto& device = GpuManager::getDevice();
         const auto& allocator = GpuManager::getAllocator();
 
-		vmaDestroyBuffer(allocator, mCubeRenderable.vbo.memoryResource, mCubeRenderable.vbo.allocation);
-		vmaDestroyBuffer(allocator, mCubeRenderable.ibo.memoryResource, mCubeRenderable.ibo.allocation);
-		vmaDestroyBuffer(allocator, mCubeRenderable.ubo.memoryResource, mCubeRenderable.ubo.allocation);
+		util::memory::destroyBuffer(allocator, mCubeRenderable.vbo.memoryResource, mCubeRenderable.vbo.allocation);
+		util::memory::destroyBuffer(allocator, mCubeRenderable.ibo.memoryResource, mCubeRenderable.ibo.allocation);
+		util::memory::destroyBuffer(allocator, mCubeRenderable.ubo.memoryResource, mCubeRenderable.ubo.allocation);
 		vkDestroyDescriptorSetLayout(device, mDescriptorSetLayout, nullptr);
 		vkDestroyDescriptorPool(device, mDescriptorPool, nullptr);
 		vkDestroyPipeline(device, mPipeline, nullptr);
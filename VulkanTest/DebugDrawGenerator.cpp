@@ -3,6 +3,7 @@
 
 #include "descriptor-util.h"
 #include "pipeline-util.h"
+#include "UniformRing.h"
 #include "GpuManager.h"
 
 namespace hvk
@@ -15,6 +16,7 @@ namespace hvk
 		DrawlistGenerator(renderPass, commandPool),
 		mDescriptorSetLayout(VK_NULL_HANDLE),
 		mDescriptorPool(VK_NULL_HANDLE),
+		mDescriptorSet(VK_NULL_HANDLE),
 		mPipeline(VK_NULL_HANDLE),
 		mPipelineInfo()
 	{
@@ -25,7 +27,7 @@ namespace hvk
 		***************/
 		VkDescriptorSetLayoutBinding uboLayoutBinding = {};
 		uboLayoutBinding.binding = 0;
-		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		uboLayoutBinding.descriptorCount = 1;
 		uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 		uboLayoutBinding.pImmutableSamplers = nullptr;
@@ -39,8 +41,14 @@ namespace hvk
 
 		//auto poolSizes = util::descriptor::createPoolSizes<VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER>(MAX_UBOS);
 		//util::descriptor::createDescriptorPool(device, poolSizes, MAX_DESCRIPTORS, mDescriptorPool);
-		auto poolSizes = util::descriptor::createPoolSizes<VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER>(10000);
-		util::descriptor::createDescriptorPool(device, poolSizes, 10000, mDescriptorPool);
+		auto poolSizes = util::descriptor::createPoolSizes<VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC>(1);
+		util::descriptor::createDescriptorPool(device, poolSizes, 1, mDescriptorPool);
+
+		// All debug draws share one set into the uniform ring, offset per draw
+		std::vector<VkDescriptorSetLayout> layouts = { mDescriptorSetLayout };
+		util::descriptor::allocateDescriptorSets(device, mDescriptorPool, mDescriptorSet, layouts);
+
+		UniformRing::bindDescriptor(this, mDescriptorSet, 0, sizeof(hvk::UniformBufferObject));
 
 		/**************
 		Set up pipeline
@@ -75,9 +83,9 @@ namespace hvk
 	DebugDrawGenerator::~DebugDrawGenerator()
 	{
         const auto& device = GpuManager::getDevice();
-        const auto& allocator = GpuManager::getAllocator();
 
         vkDestroyDescriptorSetLayout(device, mDescriptorSetLayout, nullptr);
+        UniformRing::releaseDescriptors(this);
         vkDestroyDescriptorPool(device, mDescriptorPool, nullptr);
 
         vkDestroyPipeline(device, mPipeline, nullptr);
@@ -100,46 +108,7 @@ namespace hvk
 	DebugDrawBinding DebugDrawGenerator::createDebugDrawBinding()
 	{
 		DebugDrawBinding newBinding;
-
-		const auto& device = GpuManager::getDevice();
-		const auto& allocator = GpuManager::getAllocator();
-
-		// create UBO
-        uint32_t uboMemorySize = sizeof(hvk::UniformBufferObject);
-        VkBufferCreateInfo uboInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-        uboInfo.size = uboMemorySize;
-        uboInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-
-		VmaAllocationCreateInfo uniformAllocCreateInfo = {};
-		uniformAllocCreateInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
-		uniformAllocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-		vmaCreateBuffer(
-            allocator,
-			&uboInfo,
-			&uniformAllocCreateInfo,
-			&newBinding.ubo.memoryResource,
-			&newBinding.ubo.allocation,
-			nullptr);
-
-		// create descriptor set
-		VkDescriptorSetAllocateInfo dsAlloc = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
-		dsAlloc.descriptorPool = mDescriptorPool;
-		dsAlloc.descriptorSetCount = 1;
-		dsAlloc.pSetLayouts = &mDescriptorSetLayout;
-
-		assert(vkAllocateDescriptorSets(device, &dsAlloc, &newBinding.descriptorSet) == VK_SUCCESS);
-
-		// update descriptor set
-		std::vector<VkWriteDescriptorSet> descriptorWrites;
-		std::vector<VkDescriptorBufferInfo> bufferInfos = {
-			VkDescriptorBufferInfo {
-				newBinding.ubo.memoryResource,
-				0,
-				sizeof(hvk::UniformBufferObject) } };
-		auto bufferDescriptorWrite = util::descriptor::createDescriptorBufferWrite(bufferInfos, newBinding.descriptorSet, 0);
-		descriptorWrites.push_back(bufferDescriptorWrite);
-		vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
-
+		newBinding.descriptorSet = mDescriptorSet;
 		return newBinding;
 	}
 }
@@ -7,6 +7,7 @@
 #include "ResourceManager.h"
 #include "Camera.h"
 #include "DebugDrawTypes.h"
+#include "UniformRing.h"
 
 namespace hvk
 {
@@ -16,6 +17,7 @@ namespace hvk
 	private:
 		VkDescriptorSetLayout mDescriptorSetLayout;
 		VkDescriptorPool mDescriptorPool;
+		VkDescriptorSet mDescriptorSet;
 		VkPipeline mPipeline;
 		RenderPipelineInfo mPipelineInfo;
 
@@ -34,6 +36,7 @@ namespace hvk
 			const VkViewport& viewport,
 			const VkRect2D& scissor,
 			const Camera& camera,
+			const GeometryArena& geometry,
 			DebugDrawGroupType& elements);
 	};
 
@@ -43,6 +46,7 @@ namespace hvk
 		const VkViewport& viewport,
 		const VkRect2D& scissor,
 		const Camera& camera,
+		const GeometryArena& geometry,
 		DebugDrawGroupType& elements)
 	{
 		VkCommandBufferBeginInfo commandBegin = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
@@ -62,18 +66,16 @@ namespace hvk
 			viewProj,
 			camera.getWorldPosition()
 		};
-		VmaAllocationInfo allocInfo;
-		const auto& allocator = GpuManager::getAllocator();
+		//VkBuffer vertexBuffer = geometry.getVertexBuffer();
+		//vkCmdBindVertexBuffers(mCommandBuffer, 0, 1, &vertexBuffer, offsets);
+		//vkCmdBindIndexBuffer(mCommandBuffer, geometry.getIndexBuffer(), 0, VK_INDEX_TYPE_UINT16);
 
 		elements.each([&](auto entity, const auto& mesh, const auto& binding, const auto& transform) {
-			//vmaGetAllocationInfo(allocator, binding.ubo.allocation, &allocInfo);
 			//ubo.model = transform.transform;
 			//ubo.model[1][1] *= -1;
 			//ubo.modelViewProj = viewProj * ubo.model;
-			//memcpy(allocInfo.pMappedData, &ubo, sizeof(ubo));
+			//const uint32_t uboOffset = UniformRing::push(ubo);
 
-			//vkCmdBindVertexBuffers(mCommandBuffer, 0, 1, &mesh.vbo.memoryResource, offsets);
-			//vkCmdBindIndexBuffer(mCommandBuffer, mesh.ibo.memoryResource, 0, VK_INDEX_TYPE_UINT16);
 			//vkCmdBindDescriptorSets(
 			//	mCommandBuffer,
 			//	VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -81,9 +83,10 @@ namespace hvk
 			//	0,
 			//	1,
 			//	&binding.descriptorSet,
-			//	0,
-			//	nullptr);
-			//vkCmdDrawIndexed(mCommandBuffer, mesh.numIndices, 1, 0, 0, 0);
+			//	1,
+			//	&uboOffset);
+			//const GeometryRange& range = geometry.getRange(mesh.geometry);
+			//vkCmdDrawIndexed(mCommandBuffer, range.indexCount, 1, range.firstIndex, range.vertexOffset, 0);
 		});
 
 		assert(vkEndCommandBuffer(mCommandBuffer) == VK_SUCCESS);
@@ -1,19 +1,18 @@
 #pragma once
 
 #include "types.h"
+#include "GeometryArena.h"
 
 namespace hvk
 {
+	// Vertices and indices live in ModelPipeline's debug arena
 	struct DebugDrawMesh
 	{
-		RuntimeResource<VkBuffer> vbo;
-		RuntimeResource<VkBuffer> ibo;
-		uint32_t numIndices;
+		GeometryHandle geometry;
 	};
 
 	struct DebugDrawBinding
 	{
-		RuntimeResource<VkBuffer> ubo;
 		VkDescriptorSet descriptorSet;
 	};
 }
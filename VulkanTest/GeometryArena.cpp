@@ -0,0 +1,723 @@
+#include "pch.h"
+#include "GeometryArena.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "GpuManager.h"
+#include "UploadBatch.h"
+#include "UploadQueue.h"
+#include "command-util.h"
+#include "memory-util.h"
+
+namespace hvk
+{
+	GeometryArena::RangeAllocator::RangeAllocator() :
+		mCapacity(0),
+		mUsed(0),
+		mFreeByOffset(),
+		mFreeBySize()
+	{
+	}
+
+	void GeometryArena::RangeAllocator::insertFree(uint32_t offset, uint32_t size)
+	{
+		mFreeByOffset.insert({ offset, size });
+		mFreeBySize.insert({ size, offset });
+	}
+
+	void GeometryArena::RangeAllocator::eraseFree(std::map<uint32_t, uint32_t>::iterator it)
+	{
+		auto sizeRange = mFreeBySize.equal_range(it->second);
+		for (auto sizeIt = sizeRange.first; sizeIt != sizeRange.second; ++sizeIt)
+		{
+			if (sizeIt->second == it->first)
+			{
+				mFreeBySize.erase(sizeIt);
+				break;
+			}
+		}
+		mFreeByOffset.erase(it);
+	}
+
+	void GeometryArena::RangeAllocator::reset(uint32_t capacity)
+	{
+		mFreeByOffset.clear();
+		mFreeBySize.clear();
+		mCapacity = capacity;
+		mUsed = 0;
+		if (capacity > 0)
+		{
+			insertFree(0, capacity);
+		}
+	}
+
+	void GeometryArena::RangeAllocator::grow(uint32_t capacity)
+	{
+		assert(capacity >= mCapacity);
+		const uint32_t added = capacity - mCapacity;
+		const uint32_t oldCapacity = mCapacity;
+		mCapacity = capacity;
+		if (added > 0)
+		{
+			// release() coalesces the new tail with any free range at the old end
+			mUsed += added;
+			release(oldCapacity, added);
+		}
+	}
+
+	bool GeometryArena::RangeAllocator::allocate(uint32_t size, uint32_t& outOffset)
+	{
+		if (size == 0)
+		{
+			outOffset = 0;
+			return true;
+		}
+
+		auto best = mFreeBySize.lower_bound(size);
+		if (best == mFreeBySize.end())
+		{
+			return false;
+		}
+
+		const uint32_t freeSize = best->first;
+		const uint32_t freeOffset = best->second;
+		mFreeBySize.erase(best);
+		mFreeByOffset.erase(freeOffset);
+		if (freeSize > size)
+		{
+			insertFree(freeOffset + size, freeSize - size);
+		}
+
+		mUsed += size;
+		outOffset = freeOffset;
+		return true;
+	}
+
+	void GeometryArena::RangeAllocator::release(uint32_t offset, uint32_t size)
+	{
+		if (size == 0)
+		{
+			return;
+		}
+
+		assert(mUsed >= size);
+		mUsed -= size;
+
+		// merge with the free range that follows
+		auto next = mFreeByOffset.lower_bound(offset);
+		if (next != mFreeByOffset.end() && next->first == offset + size)
+		{
+			size += next->second;
+			next = std::next(next);
+			eraseFree(std::prev(next));
+		}
+
+		// and the one that precedes
+		if (next != mFreeByOffset.begin())
+		{
+			auto prev = std::prev(next);
+			if (prev->first + prev->second == offset)
+			{
+				offset = prev->first;
+				size += prev->second;
+				eraseFree(prev);
+			}
+		}
+
+		insertFree(offset, size);
+	}
+
+	GeometryArena::GeometryArena() :
+		mVertexStrides(),
+		mDirect(false),
+		mLastUpload(0),
+		mVertexBuffers(),
+		mIndexBuffer(),
+		mVertexRanges(),
+		mIndexRanges(),
+		mRanges(),
+		mLive(),
+		mFreeHandles(),
+		mPendingReleases(),
+		mCompactions(0),
+		mGrowths(0)
+	{
+	}
+
+	GeometryArena::~GeometryArena()
+	{
+	}
+
+	uint32_t GeometryArena::getIndexSize(VkIndexType indexType)
+	{
+		assert(indexType == VK_INDEX_TYPE_UINT16 || indexType == VK_INDEX_TYPE_UINT32);
+		return indexType == VK_INDEX_TYPE_UINT32 ? sizeof(uint32_t) : sizeof(uint16_t);
+	}
+
+	uint32_t GeometryArena::getIndexWords(uint32_t indexCount, VkIndexType indexType)
+	{
+		const size_t bytes = static_cast<size_t>(indexCount) * getIndexSize(indexType);
+		return static_cast<uint32_t>((bytes + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+	}
+
+	VkResult GeometryArena::createBuffers(
+		uint32_t vertexCapacity,
+		uint32_t indexWordCapacity,
+		std::vector<Resource<VkBuffer>>& outVertices,
+		Resource<VkBuffer>& outIndices)
+	{
+		const auto& allocator = GpuManager::getAllocator();
+
+		VmaAllocationCreateInfo allocCreateInfo = {};
+		allocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+		VkBufferUsageFlags transferUsage = 0;
+		uint32_t queueFamilies[2];
+		VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+		if (mDirect)
+		{
+			allocCreateInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			allocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+		}
+		else
+		{
+			// Filled by staged copies and moved by buffer to buffer copies. Meshes are copied in on
+			// the transfer queue while the graphics queue draws the rest, so both may use the buffers
+			transferUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			UploadQueue::setConcurrentSharing(bufferInfo, queueFamilies);
+		}
+
+		// Create a vertex buffer per stream
+		VkResult result = VK_SUCCESS;
+		outVertices.assign(mVertexStrides.size(), Resource<VkBuffer>());
+		for (size_t stream = 0; stream < mVertexStrides.size() && result == VK_SUCCESS; ++stream)
+		{
+			bufferInfo.size = static_cast<VkDeviceSize>(vertexCapacity) * mVertexStrides[stream];
+			bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | transferUsage;
+			result = util::memory::createBuffer(
+				allocator,
+				&bufferInfo,
+				&allocCreateInfo,
+				&outVertices[stream].memoryResource,
+				&outVertices[stream].allocation,
+				&outVertices[stream].allocationInfo,
+				util::memory::GpuMemoryCategory::Mesh);
+		}
+
+		// Create index buffer
+		if (result == VK_SUCCESS)
+		{
+			VkBufferCreateInfo iboInfo = bufferInfo;
+			iboInfo.size = static_cast<VkDeviceSize>(indexWordCapacity) * sizeof(uint32_t);
+			iboInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | transferUsage;
+			result = util::memory::createBuffer(
+				allocator,
+				&iboInfo,
+				&allocCreateInfo,
+				&outIndices.memoryResource,
+				&outIndices.allocation,
+				&outIndices.allocationInfo,
+				util::memory::GpuMemoryCategory::Mesh);
+		}
+		if (result != VK_SUCCESS)
+		{
+			destroyBuffers(outVertices, outIndices);
+		}
+		return result;
+	}
+
+	void GeometryArena::destroyBuffers(std::vector<Resource<VkBuffer>>& vertices, Resource<VkBuffer>& indices)
+	{
+		const auto& allocator = GpuManager::getAllocator();
+		for (auto& buffer : vertices)
+		{
+			if (buffer.allocation != VK_NULL_HANDLE)
+			{
+				util::memory::destroyBuffer(allocator, buffer.memoryResource, buffer.allocation);
+			}
+		}
+		if (indices.allocation != VK_NULL_HANDLE)
+		{
+			util::memory::destroyBuffer(allocator, indices.memoryResource, indices.allocation);
+		}
+		vertices.clear();
+		indices = Resource<VkBuffer>();
+	}
+
+	void GeometryArena::replaceBuffers(
+		uint32_t vertexCapacity,
+		uint32_t indexWordCapacity,
+		const std::vector<VkBufferCopy>& vertexCopies,
+		const std::vector<VkBufferCopy>& indexCopies)
+	{
+		const auto& device = GpuManager::getDevice();
+		const auto& allocator = GpuManager::getAllocator();
+
+		std::vector<Resource<VkBuffer>> vertices;
+		Resource<VkBuffer> indices;
+		assert(createBuffers(vertexCapacity, indexWordCapacity, vertices, indices) == VK_SUCCESS);
+
+		// Scale the vertex ranges to each stream's stride
+		std::vector<std::vector<VkBufferCopy>> streamCopies(mVertexStrides.size(), vertexCopies);
+		for (size_t stream = 0; stream < mVertexStrides.size(); ++stream)
+		{
+			for (auto& copy : streamCopies[stream])
+			{
+				copy.srcOffset *= mVertexStrides[stream];
+				copy.dstOffset *= mVertexStrides[stream];
+				copy.size *= mVertexStrides[stream];
+			}
+		}
+
+		if (mDirect)
+		{
+			auto copyMapped = [allocator](const Resource<VkBuffer>& dst, const Resource<VkBuffer>& src, const std::vector<VkBufferCopy>& copies) {
+				for (const auto& copy : copies)
+				{
+					memcpy(
+						static_cast<char*>(dst.allocationInfo.pMappedData) + copy.dstOffset,
+						static_cast<const char*>(src.allocationInfo.pMappedData) + copy.srcOffset,
+						static_cast<size_t>(copy.size));
+				}
+				vmaFlushAllocation(allocator, dst.allocation, 0, VK_WHOLE_SIZE);
+			};
+			for (size_t stream = 0; stream < mVertexStrides.size(); ++stream)
+			{
+				copyMapped(vertices[stream], mVertexBuffers[stream], streamCopies[stream]);
+			}
+			copyMapped(indices, mIndexBuffer, indexCopies);
+		}
+		else
+		{
+			// Uploads into the old buffers have all landed, and they're shared with the graphics queue
+			const auto& commandPool = GpuManager::getCommandPool();
+			VkCommandBuffer commandBuffer = util::command::beginSingleTimeCommand(device, commandPool);
+			for (size_t stream = 0; stream < mVertexStrides.size() && !vertexCopies.empty(); ++stream)
+			{
+				vkCmdCopyBuffer(
+					commandBuffer,
+					mVertexBuffers[stream].memoryResource,
+					vertices[stream].memoryResource,
+					static_cast<uint32_t>(streamCopies[stream].size()),
+					streamCopies[stream].data());
+			}
+			if (!indexCopies.empty())
+			{
+				vkCmdCopyBuffer(
+					commandBuffer,
+					mIndexBuffer.memoryResource,
+					indices.memoryResource,
+					static_cast<uint32_t>(indexCopies.size()),
+					indexCopies.data());
+			}
+			util::command::endSingleTimeCommand(device, commandPool, commandBuffer, GpuManager::getGraphicsQueue());
+		}
+
+		// the old buffers may still be bound by a frame in flight
+		vkQueueWaitIdle(GpuManager::getGraphicsQueue());
+		destroyBuffers(mVertexBuffers, mIndexBuffer);
+
+		mVertexBuffers = std::move(vertices);
+		mIndexBuffer = indices;
+	}
+
+	void GeometryArena::growBuffers(uint32_t vertexCapacity, uint32_t indexWordCapacity)
+	{
+		const std::vector<VkBufferCopy> vertexCopies = {
+			{ 0, 0, mVertexRanges.getCapacity() } };
+		const std::vector<VkBufferCopy> indexCopies = {
+			{ 0, 0, static_cast<VkDeviceSize>(mIndexRanges.getCapacity()) * sizeof(uint32_t) } };
+		replaceBuffers(vertexCapacity, indexWordCapacity, vertexCopies, indexCopies);
+
+		mVertexRanges.grow(vertexCapacity);
+		mIndexRanges.grow(indexWordCapacity);
+		++mGrowths;
+	}
+
+	void GeometryArena::settleUploads(UploadBatch* batch)
+	{
+		// Copies still waiting in the batch target the current buffers
+		if (batch != nullptr)
+		{
+			batch->submit();
+		}
+		UploadQueue::wait(mLastUpload);
+	}
+
+	void GeometryArena::reclaimReleases()
+	{
+		const uint64_t completedFrame = GpuManager::getCompletedFrame();
+		auto pending = mPendingReleases.begin();
+		for (; pending != mPendingReleases.end() && pending->frame <= completedFrame; ++pending)
+		{
+			mVertexRanges.release(pending->vertexOffset, pending->vertexCount);
+			mIndexRanges.release(pending->indexWordOffset, pending->indexWords);
+		}
+		mPendingReleases.erase(mPendingReleases.begin(), pending);
+	}
+
+	void GeometryArena::init(uint32_t vertexStride, uint32_t vertexCapacity, uint32_t indexWordCapacity)
+	{
+		init(std::vector<uint32_t>{ vertexStride }, vertexCapacity, indexWordCapacity);
+	}
+
+	void GeometryArena::init(const std::vector<uint32_t>& vertexStrides, uint32_t vertexCapacity, uint32_t indexWordCapacity)
+	{
+		assert(!vertexStrides.empty() && vertexStrides.size() <= MAX_VERTEX_STREAMS);
+		mVertexStrides = vertexStrides;
+		mDirect = util::memory::getDirectGeometryWrites();
+		mLastUpload = 0;
+		if (createBuffers(vertexCapacity, indexWordCapacity, mVertexBuffers, mIndexBuffer) != VK_SUCCESS)
+		{
+			// Only direct writes can fail for want of mappable device local memory
+			assert(mDirect);
+			mDirect = false;
+			assert(createBuffers(vertexCapacity, indexWordCapacity, mVertexBuffers, mIndexBuffer) == VK_SUCCESS);
+		}
+		mVertexRanges.reset(vertexCapacity);
+		mIndexRanges.reset(indexWordCapacity);
+	}
+
+	void GeometryArena::destroy()
+	{
+		destroyBuffers(mVertexBuffers, mIndexBuffer);
+		mVertexRanges.reset(0);
+		mIndexRanges.reset(0);
+		mRanges.clear();
+		mLive.clear();
+		mFreeHandles.clear();
+		mPendingReleases.clear();
+	}
+
+	bool GeometryArena::tryAllocate(uint32_t vertexCount, uint32_t indexCount, VkIndexType indexType, GeometryRange& outRange)
+	{
+		uint32_t vertexOffset;
+		if (!mVertexRanges.allocate(vertexCount, vertexOffset))
+		{
+			return false;
+		}
+
+		const uint32_t indexWords = getIndexWords(indexCount, indexType);
+		uint32_t indexWordOffset;
+		if (!mIndexRanges.allocate(indexWords, indexWordOffset))
+		{
+			mVertexRanges.release(vertexOffset, vertexCount);
+			return false;
+		}
+
+		const uint32_t firstIndex = indexWordOffset * sizeof(uint32_t) / getIndexSize(indexType);
+		outRange = { vertexOffset, vertexCount, firstIndex, indexCount, indexType };
+		return true;
+	}
+
+	GeometryRange GeometryArena::reserve(
+		uint32_t vertexCount,
+		uint32_t indexCount,
+		VkIndexType indexType,
+		UploadBatch* batch)
+	{
+		assert(!mVertexStrides.empty());
+
+		reclaimReleases();
+
+		GeometryRange range;
+		if (!tryAllocate(vertexCount, indexCount, indexType, range))
+		{
+			settleUploads(batch);
+
+			// There may be enough space in total, just not contiguous. Compaction waits for the
+			// graphics queue, so space still held for in-flight draws counts too
+			const uint32_t indexWords = getIndexWords(indexCount, indexType);
+			uint32_t pendingVertices = 0;
+			uint32_t pendingIndexWords = 0;
+			for (const auto& pending : mPendingReleases)
+			{
+				pendingVertices += pending.vertexCount;
+				pendingIndexWords += pending.indexWords;
+			}
+			const bool fitsAfterCompaction =
+				mVertexRanges.getFree() + pendingVertices >= vertexCount &&
+				mIndexRanges.getFree() + pendingIndexWords >= indexWords;
+			if (fitsAfterCompaction)
+			{
+				compact();
+			}
+			else
+			{
+				growBuffers(
+					std::max(mVertexRanges.getCapacity() * 2, mVertexRanges.getUsed() + vertexCount),
+					std::max(mIndexRanges.getCapacity() * 2, mIndexRanges.getUsed() + indexWords));
+			}
+
+			const bool allocated = tryAllocate(vertexCount, indexCount, indexType, range);
+			assert(allocated);
+		}
+
+		return range;
+	}
+
+	GeometryHandle GeometryArena::addRange(const GeometryRange& range)
+	{
+		GeometryHandle handle;
+		if (!mFreeHandles.empty())
+		{
+			handle = mFreeHandles.back();
+			mFreeHandles.pop_back();
+			mRanges[handle] = range;
+			mLive[handle] = true;
+		}
+		else
+		{
+			handle = static_cast<GeometryHandle>(mRanges.size());
+			mRanges.push_back(range);
+			mLive.push_back(true);
+		}
+
+		return handle;
+	}
+
+	void GeometryArena::write(
+		const Resource<VkBuffer>& buffer,
+		VkDeviceSize offset,
+		const void* data,
+		VkDeviceSize size,
+		VkAccessFlags dstAccess,
+		UploadBatch* batch)
+	{
+		if (size == 0)
+		{
+			return;
+		}
+
+		if (mDirect)
+		{
+			// Device local memory isn't necessarily coherent even when it's mappable
+			memcpy(static_cast<char*>(buffer.allocationInfo.pMappedData) + offset, data, static_cast<size_t>(size));
+			vmaFlushAllocation(GpuManager::getAllocator(), buffer.allocation, offset, size);
+			return;
+		}
+
+		// Other ranges of the buffer are being drawn from, so it's shared rather than handed over
+		batch->addBuffer(buffer.memoryResource, offset, data, size, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, dstAccess, true);
+		mLastUpload = batch->getTicket();
+	}
+
+	void GeometryArena::writeVertices(const GeometryRange& range, const VertexStreams& vertices, UploadBatch* batch)
+	{
+		for (size_t stream = 0; stream < mVertexStrides.size(); ++stream)
+		{
+			assert(vertices.data[stream] != nullptr || range.vertexCount == 0);
+			write(
+				mVertexBuffers[stream],
+				static_cast<VkDeviceSize>(range.vertexOffset) * mVertexStrides[stream],
+				vertices.data[stream],
+				static_cast<VkDeviceSize>(range.vertexCount) * mVertexStrides[stream],
+				VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+				batch);
+		}
+	}
+
+	void GeometryArena::writeIndices(const GeometryRange& range, const void* indices, UploadBatch* batch)
+	{
+		const VkDeviceSize indexSize = getIndexSize(range.indexType);
+		write(
+			mIndexBuffer,
+			range.firstIndex * indexSize,
+			indices,
+			range.indexCount * indexSize,
+			VK_ACCESS_INDEX_READ_BIT,
+			batch);
+	}
+
+	GeometryHandle GeometryArena::allocate(
+		const VertexStreams& vertices,
+		uint32_t vertexCount,
+		const uint16_t* indices,
+		uint32_t indexCount,
+		UploadBatch* batch)
+	{
+		// Without a batch the copies are a batch of their own, waited on straight away
+		UploadBatch ownBatch;
+		UploadBatch* uploads = batch != nullptr ? batch : &ownBatch;
+
+		const GeometryRange range = reserve(vertexCount, indexCount, VK_INDEX_TYPE_UINT16, uploads);
+		writeVertices(range, vertices, uploads);
+		writeIndices(range, indices, uploads);
+		if (batch == nullptr)
+		{
+			UploadQueue::wait(ownBatch.submit());
+		}
+
+		return addRange(range);
+	}
+
+	GeometryHandle GeometryArena::allocate(
+		const VertexStreams& vertices,
+		uint32_t vertexCount,
+		const uint32_t* indices,
+		uint32_t indexCount,
+		VkIndexType indexType,
+		UploadBatch* batch)
+	{
+		UploadBatch ownBatch;
+		UploadBatch* uploads = batch != nullptr ? batch : &ownBatch;
+
+		const GeometryRange range = reserve(vertexCount, indexCount, indexType, uploads);
+		writeVertices(range, vertices, uploads);
+		if (indexType == VK_INDEX_TYPE_UINT32)
+		{
+			writeIndices(range, indices, uploads);
+		}
+		else
+		{
+			std::vector<uint16_t> narrowed(indexCount);
+			for (uint32_t i = 0; i < indexCount; ++i)
+			{
+				assert(indices[i] < vertexCount && indices[i] <= UINT16_MAX);
+				narrowed[i] = static_cast<uint16_t>(indices[i]);
+			}
+			writeIndices(range, narrowed.data(), uploads);
+		}
+		if (batch == nullptr)
+		{
+			UploadQueue::wait(ownBatch.submit());
+		}
+
+		return addRange(range);
+	}
+
+	void GeometryArena::release(GeometryHandle handle)
+	{
+		assert(handle < mRanges.size() && mLive[handle]);
+
+		const GeometryRange& range = mRanges[handle];
+		mPendingReleases.push_back({
+			GpuManager::getFrame(),
+			range.vertexOffset,
+			range.vertexCount,
+			range.firstIndex * getIndexSize(range.indexType) / static_cast<uint32_t>(sizeof(uint32_t)),
+			getIndexWords(range.indexCount, range.indexType) });
+		mLive[handle] = false;
+		mFreeHandles.push_back(handle);
+	}
+
+	void GeometryArena::compact()
+	{
+		// Ranges are about to move under any command buffers which are still executing
+		settleUploads(nullptr);
+		vkQueueWaitIdle(GpuManager::getGraphicsQueue());
+		// Nothing draws from released space anymore, and packing the live ranges frees it all
+		mPendingReleases.clear();
+
+		std::vector<GeometryHandle> live;
+		live.reserve(mRanges.size());
+		for (GeometryHandle handle = 0; handle < mRanges.size(); ++handle)
+		{
+			if (mLive[handle])
+			{
+				live.push_back(handle);
+			}
+		}
+
+		// Vertices and indices are packed independently, each moving only towards the
+		// start of the buffer so memmove in offset order never overwrites unmoved data.
+		// Staged arenas can't move data in place on the GPU since the copies may overlap,
+		// so every live range is copied into fresh buffers instead
+		std::vector<VkBufferCopy> vertexCopies;
+		std::vector<VkBufferCopy> indexCopies;
+		std::sort(live.begin(), live.end(), [this](GeometryHandle a, GeometryHandle b) {
+			return mRanges[a].vertexOffset < mRanges[b].vertexOffset;
+		});
+		uint32_t vertexCursor = 0;
+		for (GeometryHandle handle : live)
+		{
+			GeometryRange& range = mRanges[handle];
+			if (!mDirect && range.vertexCount > 0)
+			{
+				vertexCopies.push_back({ range.vertexOffset, vertexCursor, range.vertexCount });
+			}
+			else if (range.vertexOffset != vertexCursor)
+			{
+				for (size_t stream = 0; stream < mVertexStrides.size(); ++stream)
+				{
+					auto* vertexData = static_cast<char*>(mVertexBuffers[stream].allocationInfo.pMappedData);
+					const size_t stride = mVertexStrides[stream];
+					memmove(
+						vertexData + vertexCursor * stride,
+						vertexData + range.vertexOffset * stride,
+						range.vertexCount * stride);
+				}
+			}
+			range.vertexOffset = vertexCursor;
+			vertexCursor += range.vertexCount;
+		}
+
+		// Index ranges of either type start on a word boundary, so they are packed in words
+		auto* indexData = static_cast<uint32_t*>(mIndexBuffer.allocationInfo.pMappedData);
+		auto wordOffset = [this](GeometryHandle handle) {
+			const GeometryRange& range = mRanges[handle];
+			return range.firstIndex * getIndexSize(range.indexType) / static_cast<uint32_t>(sizeof(uint32_t));
+		};
+		std::sort(live.begin(), live.end(), [&wordOffset](GeometryHandle a, GeometryHandle b) {
+			return wordOffset(a) < wordOffset(b);
+		});
+		uint32_t indexCursor = 0;
+		for (GeometryHandle handle : live)
+		{
+			GeometryRange& range = mRanges[handle];
+			const uint32_t words = getIndexWords(range.indexCount, range.indexType);
+			const uint32_t offset = wordOffset(handle);
+			if (!mDirect && words > 0)
+			{
+				indexCopies.push_back({
+					static_cast<VkDeviceSize>(offset) * sizeof(uint32_t),
+					static_cast<VkDeviceSize>(indexCursor) * sizeof(uint32_t),
+					static_cast<VkDeviceSize>(words) * sizeof(uint32_t) });
+			}
+			else if (offset != indexCursor)
+			{
+				memmove(
+					indexData + indexCursor,
+					indexData + offset,
+					static_cast<size_t>(words) * sizeof(uint32_t));
+			}
+			range.firstIndex = indexCursor * sizeof(uint32_t) / getIndexSize(range.indexType);
+			indexCursor += words;
+		}
+
+		if (mDirect)
+		{
+			for (const auto& buffer : mVertexBuffers)
+			{
+				vmaFlushAllocation(GpuManager::getAllocator(), buffer.allocation, 0, VK_WHOLE_SIZE);
+			}
+			vmaFlushAllocation(GpuManager::getAllocator(), mIndexBuffer.allocation, 0, VK_WHOLE_SIZE);
+		}
+		else
+		{
+			replaceBuffers(mVertexRanges.getCapacity(), mIndexRanges.getCapacity(), vertexCopies, indexCopies);
+		}
+
+		// Everything live is now one block at the front of each buffer
+		uint32_t offset;
+		mVertexRanges.reset(mVertexRanges.getCapacity());
+		mVertexRanges.allocate(vertexCursor, offset);
+		mIndexRanges.reset(mIndexRanges.getCapacity());
+		mIndexRanges.allocate(indexCursor, offset);
+		++mCompactions;
+	}
+
+	GeometryArena::Stats GeometryArena::getStats() const
+	{
+		Stats stats = {};
+		stats.vertexCapacity = mVertexRanges.getCapacity();
+		stats.vertexUsed = mVertexRanges.getUsed();
+		stats.indexWordCapacity = mIndexRanges.getCapacity();
+		stats.indexWordUsed = mIndexRanges.getUsed();
+		stats.freeRanges = mVertexRanges.getFreeRangeCount() + mIndexRanges.getFreeRangeCount();
+		stats.allocations = static_cast<uint32_t>(mRanges.size() - mFreeHandles.size());
+		stats.compactions = mCompactions;
+		stats.growths = mGrowths;
+		return stats;
+	}
+}
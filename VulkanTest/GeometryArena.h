@@ -0,0 +1,187 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "types.h"
+
+namespace hvk
+{
+	typedef uint32_t GeometryHandle;
+	const GeometryHandle INVALID_GEOMETRY = UINT32_MAX;
+
+	// Element range of a single mesh inside the arena's shared buffers.
+	// firstIndex and vertexOffset are in elements, ready for vkCmdDrawIndexed.
+	// firstIndex counts elements of indexType, so the index buffer must be bound with it
+	struct GeometryRange
+	{
+		uint32_t vertexOffset;
+		uint32_t vertexCount;
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		VkIndexType indexType;
+	};
+
+	class UploadBatch;
+
+	// Suballocates vertices and indices for many meshes out of shared vertex and index
+	// buffers so draws only need to bind them once.
+	// Vertices may be split over several streams, one buffer each, which share vertex offsets
+	// so a pass can bind just the streams it reads.
+	// Index space is managed in 4 byte words so 16 and 32 bit meshes can share the buffer.
+	// Both buffers are device local. Under util::memory::getDirectGeometryWrites() they're
+	// mapped and written in place; otherwise meshes are staged in through the UploadQueue
+	// and the buffers only move on the GPU
+	class GeometryArena
+	{
+	public:
+		static const uint32_t MAX_VERTEX_STREAMS = 2;
+
+		// One pointer per stream, in the order of the strides the arena was initialized with
+		struct VertexStreams
+		{
+			const void* data[MAX_VERTEX_STREAMS];
+
+			VertexStreams(const void* vertices) : data{ vertices, nullptr } {}
+			VertexStreams(const void* positions, const void* attributes) : data{ positions, attributes } {}
+		};
+
+		struct Stats
+		{
+			uint32_t vertexCapacity;
+			uint32_t vertexUsed;
+			uint32_t indexWordCapacity;
+			uint32_t indexWordUsed;
+			uint32_t freeRanges;
+			uint32_t allocations;
+			uint32_t compactions;
+			uint32_t growths;
+		};
+
+	private:
+		// Best fit offset allocator over element units; free ranges are coalesced on release
+		class RangeAllocator
+		{
+		private:
+			uint32_t mCapacity;
+			uint32_t mUsed;
+			std::map<uint32_t, uint32_t> mFreeByOffset;
+			std::multimap<uint32_t, uint32_t> mFreeBySize;
+
+			void insertFree(uint32_t offset, uint32_t size);
+			void eraseFree(std::map<uint32_t, uint32_t>::iterator it);
+
+		public:
+			RangeAllocator();
+			void reset(uint32_t capacity);
+			void grow(uint32_t capacity);
+			bool allocate(uint32_t size, uint32_t& outOffset);
+			void release(uint32_t offset, uint32_t size);
+			uint32_t getCapacity() const { return mCapacity; }
+			uint32_t getUsed() const { return mUsed; }
+			uint32_t getFree() const { return mCapacity - mUsed; }
+			uint32_t getFreeRangeCount() const { return static_cast<uint32_t>(mFreeByOffset.size()); }
+		};
+
+		// Space of a released mesh, held back until draws recorded up to frame have finished
+		struct PendingRelease
+		{
+			uint64_t frame;
+			uint32_t vertexOffset;
+			uint32_t vertexCount;
+			uint32_t indexWordOffset;
+			uint32_t indexWords;
+		};
+
+		std::vector<uint32_t> mVertexStrides;
+		bool mDirect;
+		// Latest staged copy into the current buffers; they can't be replaced before it lands
+		UploadTicket mLastUpload;
+		std::vector<Resource<VkBuffer>> mVertexBuffers;
+		Resource<VkBuffer> mIndexBuffer;
+		RangeAllocator mVertexRanges;
+		RangeAllocator mIndexRanges;
+		std::vector<GeometryRange> mRanges;
+		std::vector<bool> mLive;
+		std::vector<GeometryHandle> mFreeHandles;
+		// In release order, so frames never decrease
+		std::vector<PendingRelease> mPendingReleases;
+		uint32_t mCompactions;
+		uint32_t mGrowths;
+
+		VkResult createBuffers(
+			uint32_t vertexCapacity,
+			uint32_t indexWordCapacity,
+			std::vector<Resource<VkBuffer>>& outVertices,
+			Resource<VkBuffer>& outIndices);
+		void destroyBuffers(std::vector<Resource<VkBuffer>>& vertices, Resource<VkBuffer>& indices);
+		// Moves into new buffers of the given capacity, copying the given ranges across.
+		// Vertex ranges are counted in vertices and copied in every stream; index ranges are in bytes
+		void replaceBuffers(
+			uint32_t vertexCapacity,
+			uint32_t indexWordCapacity,
+			const std::vector<VkBufferCopy>& vertexCopies,
+			const std::vector<VkBufferCopy>& indexCopies);
+		void growBuffers(uint32_t vertexCapacity, uint32_t indexWordCapacity);
+		void settleUploads(UploadBatch* batch);
+		// Frees the space of released meshes whose last draws have finished
+		void reclaimReleases();
+		bool tryAllocate(uint32_t vertexCount, uint32_t indexCount, VkIndexType indexType, GeometryRange& outRange);
+		GeometryRange reserve(uint32_t vertexCount, uint32_t indexCount, VkIndexType indexType, UploadBatch* batch);
+		GeometryHandle addRange(const GeometryRange& range);
+		void write(
+			const Resource<VkBuffer>& buffer,
+			VkDeviceSize offset,
+			const void* data,
+			VkDeviceSize size,
+			VkAccessFlags dstAccess,
+			UploadBatch* batch);
+		void writeVertices(const GeometryRange& range, const VertexStreams& vertices, UploadBatch* batch);
+		void writeIndices(const GeometryRange& range, const void* indices, UploadBatch* batch);
+
+	public:
+		GeometryArena();
+		~GeometryArena();
+
+		static uint32_t getIndexSize(VkIndexType indexType);
+		static uint32_t getIndexWords(uint32_t indexCount, VkIndexType indexType);
+
+		void init(uint32_t vertexStride, uint32_t vertexCapacity, uint32_t indexWordCapacity);
+		void init(const std::vector<uint32_t>& vertexStrides, uint32_t vertexCapacity, uint32_t indexWordCapacity);
+		void destroy();
+
+		// Copies the mesh into the arena, compacting or growing the buffers if it doesn't fit.
+		// Staged copies join batch when one is given and the range can't be drawn until
+		// batch->getTicket() completes; the batch is submitted early if the buffers have to move.
+		// Without a batch the copy is waited on before returning
+		GeometryHandle allocate(
+			const VertexStreams& vertices,
+			uint32_t vertexCount,
+			const uint16_t* indices,
+			uint32_t indexCount,
+			UploadBatch* batch = nullptr);
+		// 32 bit indices are stored as indexType, narrowing to 16 bits while copying.
+		// Every index must fit in indexType
+		GeometryHandle allocate(
+			const VertexStreams& vertices,
+			uint32_t vertexCount,
+			const uint32_t* indices,
+			uint32_t indexCount,
+			VkIndexType indexType,
+			UploadBatch* batch = nullptr);
+		// The handle may be reused straight away, but the mesh's space isn't until the graphics
+		// queue has finished the current frame, since draws already recorded still read it
+		void release(GeometryHandle handle);
+
+		// Slides every live mesh down to the start of the buffers, removing all gaps.
+		// Waits for the graphics queue since in-flight draws reference the old offsets, and for
+		// staged copies, so no batch holding copies into the arena may still be open
+		void compact();
+
+		const GeometryRange& getRange(GeometryHandle handle) const { return mRanges[handle]; }
+		uint32_t getVertexStreamCount() const { return static_cast<uint32_t>(mVertexBuffers.size()); }
+		VkBuffer getVertexBuffer(uint32_t stream = 0) const { return mVertexBuffers[stream].memoryResource; }
+		VkBuffer getIndexBuffer() const { return mIndexBuffer.memoryResource; }
+		Stats getStats() const;
+	};
+}
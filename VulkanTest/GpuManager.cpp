@@ -9,6 +9,8 @@ namespace hvk
     VkCommandPool GpuManager::sCommandPool = VK_NULL_HANDLE;
     VkQueue GpuManager::sGraphicsQueue = VK_NULL_HANDLE;
     VmaAllocator GpuManager::sAllocator = VK_NULL_HANDLE;
+    uint64_t GpuManager::sFrame = 1;
+    uint64_t GpuManager::sCompletedFrame = 0;
 
     GpuManager::GpuManager()
     {
@@ -32,4 +34,10 @@ namespace hvk
         sGraphicsQueue = graphicsQueue;
         sAllocator = allocator;
     }
+
+    void GpuManager::beginFrame()
+    {
+        sCompletedFrame = sFrame;
+        ++sFrame;
+    }
 }
@@ -14,6 +14,8 @@ namespace hvk
         static VkCommandPool sCommandPool;
         static VkQueue sGraphicsQueue;
         static VmaAllocator sAllocator;
+        static uint64_t sFrame;
+        static uint64_t sCompletedFrame;
         GpuManager();
         ~GpuManager();
 
@@ -29,5 +31,13 @@ namespace hvk
         static VkCommandPool getCommandPool() { return sCommandPool; }
         static VkQueue getGraphicsQueue() { return sGraphicsQueue; }
         static VmaAllocator getAllocator() { return sAllocator; }
+
+        // Called from VulkanApp::renderPrepare once the previous frame's fence has signalled,
+        // so every frame before the new one is done on the graphics queue
+        static void beginFrame();
+        // Work recorded for the graphics queue is tagged with getFrame() and free to reuse
+        // once getCompletedFrame() reaches it. Loading before the first frame counts as frame 1
+        static uint64_t getFrame() { return sFrame; }
+        static uint64_t getCompletedFrame() { return sCompletedFrame; }
     };
 }
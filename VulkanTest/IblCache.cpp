@@ -0,0 +1,121 @@
+#include "pch.h"
+#include "IblCache.h"
+
+#include <vector>
+
+#include "GpuManager.h"
+#include "Hash.h"
+#include "Ktx2.h"
+#include "MappedFile.h"
+#include "TextureCooker.h"
+#include "image-util.h"
+
+namespace hvk
+{
+	namespace
+	{
+		const char IBL_CACHE_EXTENSION[] = ".ktx2";
+
+		// Bytes per texel of the formats maps are baked to, 0 for anything else
+		int getTexelSize(VkFormat format)
+		{
+			switch (format)
+			{
+			case VK_FORMAT_R16G16B16A16_SFLOAT:
+				return 8;
+			case VK_FORMAT_R32G32B32A32_SFLOAT:
+				return 16;
+			default:
+				return 0;
+			}
+		}
+	}
+
+	std::string getIblCachePath(const std::string& sourcePath, const std::string& mapName)
+	{
+		return sourcePath + "." + mapName + IBL_CACHE_EXTENSION;
+	}
+
+	bool computeIblKey(
+		uint64_t sourceKey,
+		const std::array<std::string, 2>& shaderFiles,
+		uint32_t resolution,
+		VkFormat format,
+		uint32_t mipLevels,
+		const void* settings,
+		size_t settingsSize,
+		uint64_t& outKey)
+	{
+		uint64_t key = hash::combine(IBL_CACHE_VERSION, sourceKey);
+		for (const auto& shaderFile : shaderFiles)
+		{
+			uint64_t shaderHash;
+			if (!hash::hashFile(shaderFile, shaderHash))
+			{
+				return false;
+			}
+			key = hash::combine(key, shaderHash);
+		}
+		key = hash::combine(key, resolution);
+		key = hash::combine(key, static_cast<uint64_t>(format));
+		key = hash::combine(key, mipLevels);
+		outKey = hash::hashBytes(settings, settingsSize, key);
+		return true;
+	}
+
+	bool loadIblMap(const std::string& cachePath, uint64_t key, TextureMap& outMap)
+	{
+		MappedFile file;
+		Ktx2Texture texture;
+		if (!file.open(cachePath) ||
+			!parseKtx2(file.getData(), file.getSize(), texture) ||
+			texture.sourceKey != key)
+		{
+			return false;
+		}
+
+		return util::image::createTextureMapFromKtx2(
+			GpuManager::getPhysicalDevice(),
+			GpuManager::getDevice(),
+			GpuManager::getAllocator(),
+			GpuManager::getCommandPool(),
+			GpuManager::getGraphicsQueue(),
+			texture,
+			outMap,
+			util::memory::GpuMemoryCategory::IBL);
+	}
+
+	bool saveIblMap(
+		const std::string& cachePath,
+		uint64_t key,
+		const TextureMap& map,
+		VkFormat format,
+		uint32_t resolution,
+		uint32_t faceCount,
+		uint32_t mipLevels)
+	{
+		const int texelSize = getTexelSize(format);
+		if (texelSize == 0)
+		{
+			return false;
+		}
+
+		std::vector<std::vector<uint8_t>> levels;
+		util::image::readImageLevels(
+			GpuManager::getDevice(),
+			GpuManager::getAllocator(),
+			GpuManager::getCommandPool(),
+			GpuManager::getGraphicsQueue(),
+			map.texture.memoryResource,
+			resolution,
+			resolution,
+			faceCount,
+			mipLevels,
+			texelSize,
+			levels);
+
+		std::vector<uint8_t> file;
+		return writeKtx2(format, resolution, resolution, faceCount, levels, false, key, file) &&
+			writeCookedFile(cachePath, file);
+	}
+}
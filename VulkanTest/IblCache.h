@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "types.h"
+
+namespace hvk
+{
+	// Bumped when baking changes in a way its shaders and settings don't show
+	const uint32_t IBL_CACHE_VERSION = 1;
+
+	// The BRDF LUT doesn't depend on the environment, so one copy serves every HDR
+	const char BRDF_LUT_CACHE_PATH[] = "resources/brdfLUT.ktx2";
+
+	// Where a map baked from sourcePath is kept, such as the HDR's ".irradiance.ktx2"
+	std::string getIblCachePath(const std::string& sourcePath, const std::string& mapName);
+
+	// Key of a map baked from an input with sourceKey (0 for none) by shaderFiles, given settings
+	// as push constants. The compiled shaders are hashed, so rebuilding them bakes again.
+	// False if a shader can't be read
+	bool computeIblKey(
+		uint64_t sourceKey,
+		const std::array<std::string, 2>& shaderFiles,
+		uint32_t resolution,
+		VkFormat format,
+		uint32_t mipLevels,
+		const void* settings,
+		size_t settingsSize,
+		uint64_t& outKey);
+
+	// Loads a map saveIblMap wrote with the same key. False if it's missing or stale
+	bool loadIblMap(const std::string& cachePath, uint64_t key, TextureMap& outMap);
+
+	// Reads a baked map back from the GPU and writes every face and level of it to cachePath.
+	// The map must be in SHADER_READ_ONLY_OPTIMAL and a transfer source
+	bool saveIblMap(
+		const std::string& cachePath,
+		uint64_t key,
+		const TextureMap& map,
+		VkFormat format,
+		uint32_t resolution,
+		uint32_t faceCount,
+		uint32_t mipLevels);
+}
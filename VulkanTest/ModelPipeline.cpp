@@ -4,34 +4,53 @@
 #include "image-util.h"
 #include "PBRTypes.h"
 #include "DebugDrawTypes.h"
+#include "MemoryStats.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "Hash.h"
+#include "UploadBatch.h"
 
 
 namespace hvk
 {
-    TextureMap createTextureMapFromImageData(
-        VkDevice device,
-        VmaAllocator allocator,
-        VkCommandPool commandPool,
-        VkQueue graphicsQueue,
-        const tinygltf::Image& texture)
+    const uint32_t INITIAL_MESH_VERTICES = 1 << 16;
+    const uint32_t INITIAL_MESH_INDEX_WORDS = 1 << 17;
+    const uint32_t INITIAL_DEBUG_VERTICES = 1 << 12;
+    const uint32_t INITIAL_DEBUG_INDEX_WORDS = 1 << 13;
+
+    // meshletRanges is parallel to submeshes, or null when there are no meshlets
+    void appendSubmeshes(
+        const Submesh* submeshes,
+        const MeshletRange* meshletRanges,
+        size_t submeshCount,
+        std::vector<PBRSubmesh>& outSubmeshes)
     {
-        return util::image::createTextureMap(
-            device,
-            allocator,
-            commandPool,
-            graphicsQueue,
-            texture.image.data(),
-            texture.width,
-            texture.height,
-            texture.component * (texture.bits / 8));
+        outSubmeshes.reserve(outSubmeshes.size() + submeshCount);
+        for (size_t i = 0; i < submeshCount; ++i)
+        {
+            const Submesh& submesh = submeshes[i];
+            const MeshletRange meshlets = meshletRanges ? meshletRanges[i] : MeshletRange{ 0, 0 };
+            outSubmeshes.push_back({
+                submesh.firstIndex,
+                submesh.indexCount,
+                static_cast<int32_t>(submesh.vertexOffset),
+                submesh.materialIndex,
+                meshlets.firstMeshlet,
+                meshlets.meshletCount });
+        }
     }
 
     ModelPipeline::ModelPipeline() :
         mMeshStore(),
         mMaterialStore(),
+        mTextureStore(),
+        mRetiredTextures(),
         mDummyAlbedoMap(),
         mDummyNormalMap(),
         mDummyMetallicRoughnessMap(),
+        mMeshArena(),
+        mDebugArena(),
+        mVertexEncoding(VertexEncoding::Full),
         mInitialized(false)
     {
     }
@@ -41,136 +60,309 @@ namespace hvk
     {
     }
 
-    void ModelPipeline::init()
+    void ModelPipeline::init(VertexEncoding vertexEncoding)
     {
         mMeshStore.reserve(50);
         mMaterialStore.reserve(50);
         mDebugMeshStore.reserve(50);
-        mDummyAlbedoMap = util::image::createTextureMapFromFile(
+        mVertexEncoding = vertexEncoding;
+        mMeshArena.init(
+            { sizeof(PositionVertex), getVertexAttributeStride(vertexEncoding) },
+            INITIAL_MESH_VERTICES,
+            INITIAL_MESH_INDEX_WORDS);
+        mDebugArena.init(sizeof(ColorVertex), INITIAL_DEBUG_VERTICES, INITIAL_DEBUG_INDEX_WORDS);
+        mDummyAlbedoMap = std::make_shared<TextureMap>(util::image::createTextureMapFromFile(
+            GpuManager::getPhysicalDevice(),
             GpuManager::getDevice(),
             GpuManager::getAllocator(),
             GpuManager::getCommandPool(),
             GpuManager::getGraphicsQueue(),
-            std::string("resources/dummy-white.png"));
-        mDummyNormalMap = util::image::createTextureMapFromFile(
+            std::string("resources/dummy-white.png")));
+        mDummyNormalMap = std::make_shared<TextureMap>(util::image::createTextureMapFromFile(
+            GpuManager::getPhysicalDevice(),
             GpuManager::getDevice(),
             GpuManager::getAllocator(),
             GpuManager::getCommandPool(),
             GpuManager::getGraphicsQueue(),
-            std::string("resources/dummy-normal.png"));
-        mDummyMetallicRoughnessMap = util::image::createTextureMapFromFile(
+            std::string("resources/dummy-normal.png")));
+        mDummyMetallicRoughnessMap = std::make_shared<TextureMap>(util::image::createTextureMapFromFile(
+            GpuManager::getPhysicalDevice(),
             GpuManager::getDevice(),
             GpuManager::getAllocator(),
             GpuManager::getCommandPool(),
             GpuManager::getGraphicsQueue(),
-            std::string("resources/dummy-occlusionmetallicroughness.png"));
+            std::string("resources/dummy-occlusionmetallicroughness.png")));
         mInitialized = true;
     }
 
-    void ModelPipeline::processGltfModel(const StaticMesh& model, const std::string& name)
+    void ModelPipeline::destroy()
     {
-        assert(mInitialized);
+        const auto& device = GpuManager::getDevice();
+        const auto& allocator = GpuManager::getAllocator();
 
-        PBRMesh mesh;
-        PBRMaterial material;
+        mMeshStore.clear();
+        mMaterialStore.clear();
+        mDebugMeshStore.clear();
+        mMeshArena.destroy();
+        mDebugArena.destroy();
 
-        const auto& allocator = GpuManager::getAllocator();
-        const auto& device = GpuManager::getDevice();
-        const auto& commandPool = GpuManager::getCommandPool();
-        const auto& graphicsQueue = GpuManager::getGraphicsQueue();
+        // The device is idle by now, so every map goes whether or not something still references it
+        for (auto& entry : mTextureStore)
+        {
+            util::image::destroyMap(device, allocator, *entry.second);
+        }
+        mTextureStore.clear();
+        for (auto& retired : mRetiredTextures)
+        {
+            util::image::destroyMap(device, allocator, *retired.map);
+        }
+        mRetiredTextures.clear();
+        util::image::destroyMap(device, allocator, *mDummyAlbedoMap);
+        util::image::destroyMap(device, allocator, *mDummyNormalMap);
+        util::image::destroyMap(device, allocator, *mDummyMetallicRoughnessMap);
+    }
 
-		const StaticMesh::Vertices vertices = model.getVertices();
-		const StaticMesh::Indices indices = model.getIndices();
+    HVK_shared<TextureMap> ModelPipeline::fetchTexture(
+        const void* pixels,
+        int width,
+        int height,
+        int bytesPerPixel,
+        bool srgb,
+        UploadBatch& uploads)
+    {
+        // Keyed on the decoded texels rather than a source path, so one image shared by
+        // several materials, files or cooked models is uploaded once.
+        // Every map is created with the same format and sampler, so only the mip filtering joins the key
+        const size_t size = static_cast<size_t>(width) * height * bytesPerPixel;
+        const uint64_t shape = hash::combine(
+            (static_cast<uint64_t>(width) << 32) | static_cast<uint32_t>(height),
+            (static_cast<uint64_t>(bytesPerPixel) << 1) | (srgb ? 1 : 0));
+        const uint64_t key = hash::hashBytes(pixels, size, shape);
+
+        auto found = mTextureStore.find(key);
+        if (found == mTextureStore.end())
+        {
+            found = mTextureStore.insert({ key, std::make_shared<TextureMap>(util::image::createTextureMap(
+                GpuManager::getPhysicalDevice(),
+                GpuManager::getDevice(),
+                GpuManager::getAllocator(),
+                GpuManager::getCommandPool(),
+                GpuManager::getGraphicsQueue(),
+                pixels,
+                width,
+                height,
+                bytesPerPixel,
+                VK_IMAGE_TYPE_2D,
+                0,
+                VK_FORMAT_R8G8B8A8_UNORM,
+                util::memory::GpuMemoryCategory::Texture,
+                &uploads,
+                srgb)) }).first;
+        }
 
-		mesh.numIndices = indices.size();
+        return found->second;
+    }
 
-        // Create vertex buffer
-        size_t vertexMemorySize = sizeof(Vertex) * vertices.size();
-        VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-        bufferInfo.size = vertexMemorySize;
-        bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    HVK_shared<TextureMap> ModelPipeline::fetchTexture(const Ktx2Texture& texture, bool srgb, UploadBatch& uploads)
+    {
+        // The cooker is deterministic, so the base level and format stand in for the whole chain
+        const uint64_t shape = hash::combine(
+            hash::combine((static_cast<uint64_t>(texture.width) << 32) | texture.height, texture.levels.size()),
+            (static_cast<uint64_t>(texture.format) << 1) | (srgb ? 1 : 0));
+        const uint64_t key = hash::hashBytes(texture.levels[0].data, static_cast<size_t>(texture.levels[0].size), shape);
+
+        auto found = mTextureStore.find(key);
+        if (found == mTextureStore.end())
+        {
+            TextureMap map;
+            if (!util::image::createTextureMapFromKtx2(
+                GpuManager::getPhysicalDevice(),
+                GpuManager::getDevice(),
+                GpuManager::getAllocator(),
+                GpuManager::getCommandPool(),
+                GpuManager::getGraphicsQueue(),
+                texture,
+                map,
+                util::memory::GpuMemoryCategory::Texture,
+                &uploads,
+                srgb))
+            {
+                return nullptr;
+            }
+            found = mTextureStore.insert({ key, std::make_shared<TextureMap>(map) }).first;
+        }
 
-        VmaAllocationCreateInfo allocCreateInfo = {};
-        allocCreateInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
-        allocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-        VmaAllocationInfo vboAllocInfo;
-        vmaCreateBuffer(
-            GpuManager::getAllocator(),
-            &bufferInfo,
-            &allocCreateInfo,
-            &mesh.vbo.memoryResource,
-            &mesh.vbo.allocation,
-            &vboAllocInfo);
-
-        memcpy(vboAllocInfo.pMappedData, vertices.data(), vertexMemorySize);
-
-        // Create index buffer
-        size_t indexMemorySize = sizeof(uint16_t) * indices.size();
-        VkBufferCreateInfo iboInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-        iboInfo.size = indexMemorySize;
-        iboInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-
-        VmaAllocationCreateInfo indexAllocCreateInfo = {};
-        indexAllocCreateInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
-        indexAllocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-        VmaAllocationInfo iboAllocInfo;
-        vmaCreateBuffer(
-            allocator,
-            &iboInfo,
-            &indexAllocCreateInfo,
-            &mesh.ibo.memoryResource,
-            &mesh.ibo.allocation,
-            &iboAllocInfo);
-
-        memcpy(iboAllocInfo.pMappedData, indices.data(), indexMemorySize);
+        return found->second;
+    }
 
-        // Create texture maps
-        const auto& mat = model.getMaterial();
+    PBRMaterial ModelPipeline::createPBRMaterial(const Material& mat, UploadBatch& uploads)
+    {
+        auto fetchImageTexture = [this, &uploads](const MaterialProperty& prop, bool srgb, const HVK_shared<TextureMap>& fallback) {
+            if (prop.texture == nullptr)
+            {
+                return fallback;
+            }
+            const tinygltf::Image& image = *prop.texture;
+            return fetchTexture(
+                image.image.data(),
+                image.width,
+                image.height,
+                image.component * (image.bits / 8),
+                srgb,
+                uploads);
+        };
+
+        PBRMaterial material;
+        material.albedo = fetchImageTexture(mat.diffuseProp, true, mDummyAlbedoMap);
+        material.metallicRoughness = fetchImageTexture(mat.metallicRoughnessProp, false, mDummyMetallicRoughnessMap);
+        material.normal = fetchImageTexture(mat.normalProp, false, mDummyNormalMap);
 
-        if (mat.diffuseProp.texture != nullptr)
+        return material;
+    }
+
+    void ModelPipeline::processGltfModel(const StaticMesh& source, const std::string& name)
+    {
+        assert(mInitialized);
+        MemoryTagScope tagScope(MemoryTag::Assets);
+
+        // Same settings the cook defaults to; materials come through untouched
+        const StaticMesh model = optimizeMesh(source, MeshOptimizeSettings());
+
+        PBRMesh mesh;
+        PBRMaterialSet material;
+
+		const StaticMesh::Vertices& vertices = model.getVertices();
+		const StaticMesh::Indices& indices = model.getIndices();
+
+        std::vector<PositionVertex> positions;
+        std::vector<uint8_t> attributes;
+        encodeVertices(vertices.data(), vertices.size(), mVertexEncoding, positions, attributes);
+
+        // Geometry and every new texture go up in one submission
+        UploadBatch uploads;
+
+        // Every submesh goes into the same arena range so drawing them never rebinds buffers
+        mesh.geometry = mMeshArena.allocate(
+            { positions.data(), attributes.data() },
+            static_cast<uint32_t>(vertices.size()),
+            indices.data(),
+            static_cast<uint32_t>(indices.size()),
+            model.getIndexType(),
+            &uploads);
+        mesh.indexType = mMeshArena.getRange(mesh.geometry).indexType;
+
+        appendSubmeshes(model.getSubmeshes().data(), nullptr, model.getSubmeshes().size(), mesh.submeshes);
+
+        // Levels of detail and meshlets are only generated by the cook, so this mesh just has lod0
+        // and its submeshes are drawn whole
+        mesh.boundsMin = glm::vec3(0.f);
+        mesh.boundsMax = glm::vec3(0.f);
+        if (!vertices.empty())
         {
-			const auto& diffuseTex = *mat.diffuseProp.texture;
-			material.albedo = createTextureMapFromImageData(
-				device,
-				allocator,
-				commandPool,
-				graphicsQueue,
-				diffuseTex);
+            mesh.boundsMin = mesh.boundsMax = vertices.front().pos;
+            for (const auto& vertex : vertices)
+            {
+                mesh.boundsMin = glm::min(mesh.boundsMin, vertex.pos);
+                mesh.boundsMax = glm::max(mesh.boundsMax, vertex.pos);
+            }
         }
-        else
+
+        // Create texture maps
+        const auto& materials = model.getMaterials();
+        material.materials.reserve(materials.size());
+        for (const auto& mat : materials)
         {
-            material.albedo = mDummyAlbedoMap;
+            material.materials.push_back(createPBRMaterial(mat, uploads));
         }
+        mesh.upload = uploads.submit();
 
-        if (mat.metallicRoughnessProp.texture != nullptr)
+        // register mesh and material in the store
+        mMeshStore.insert({ name + "_lod0", mesh });
+        mMaterialStore.insert({ name + "_material_lod0", material });
+    }
+
+    void ModelPipeline::processCookedModel(const CookedModel& model, size_t meshIndex, const std::string& name)
+    {
+        assert(mInitialized);
+        assert(meshIndex < model.getMeshes().size());
+        MemoryTagScope tagScope(MemoryTag::Assets);
+
+        // The arena only holds one attribute layout
+        assert(model.getVertexEncoding() == mVertexEncoding);
+
+        const CookedMesh& cooked = model.getMeshes()[meshIndex];
+        PBRMesh mesh;
+        PBRMaterialSet material;
+
+        // The cooked payload is already in its final layout, so it's staged straight
+        // from the mapped file, along with every new texture, in one submission
+        UploadBatch uploads;
+        if (cooked.indexType == VK_INDEX_TYPE_UINT16)
         {
-            const auto& mtlRoughTex = *mat.metallicRoughnessProp.texture;
-            material.metallicRoughness = createTextureMapFromImageData(
-                device,
-                allocator,
-                commandPool,
-                graphicsQueue,
-                mtlRoughTex);
+            mesh.geometry = mMeshArena.allocate(
+                { cooked.positions, cooked.attributes },
+                cooked.vertexCount,
+                static_cast<const uint16_t*>(cooked.indices),
+                cooked.indexCount,
+                &uploads);
         }
         else
         {
-            material.metallicRoughness = mDummyMetallicRoughnessMap;
+            mesh.geometry = mMeshArena.allocate(
+                { cooked.positions, cooked.attributes },
+                cooked.vertexCount,
+                static_cast<const uint32_t*>(cooked.indices),
+                cooked.indexCount,
+                VK_INDEX_TYPE_UINT32,
+                &uploads);
         }
-
-        if (mat.normalProp.texture != nullptr)
+        mesh.indexType = mMeshArena.getRange(mesh.geometry).indexType;
+        const MeshletRange* meshletRanges = cooked.meshletCount > 0 ? cooked.meshletRanges : nullptr;
+        appendSubmeshes(cooked.submeshes, meshletRanges, cooked.submeshCount, mesh.submeshes);
+        mesh.lods.resize(cooked.lodCount - 1);
+        for (uint32_t lod = 1; lod < cooked.lodCount; ++lod)
         {
-            const auto& normalTex = *mat.normalProp.texture;
-            material.normal = createTextureMapFromImageData(
-                device,
-                allocator,
-                commandPool,
-                graphicsQueue,
-                normalTex);
+            const size_t first = lod * cooked.submeshCount;
+            mesh.lods[lod - 1].error = cooked.lodErrors[lod];
+            appendSubmeshes(
+                cooked.submeshes + first,
+                meshletRanges ? meshletRanges + first : nullptr,
+                cooked.submeshCount,
+                mesh.lods[lod - 1].submeshes);
         }
-        else
+        mesh.meshlets.assign(cooked.meshlets, cooked.meshlets + cooked.meshletCount);
+        mesh.boundsMin = cooked.boundsMin;
+        mesh.boundsMax = cooked.boundsMax;
+
+        // Each image is hashed once however many materials use it; the store then shares
+        // its upload with any other model holding the same cooked texture. A texture whose
+        // format the device can't sample falls back to the material's dummy
+        std::unordered_map<int32_t, HVK_shared<TextureMap>> textures;
+        auto fetchCookedTexture = [&](int32_t image, bool srgb, const HVK_shared<TextureMap>& fallback) {
+            if (image < 0)
+            {
+                return fallback;
+            }
+            const int32_t key = (image << 1) | (srgb ? 1 : 0);
+            auto found = textures.find(key);
+            if (found == textures.end())
+            {
+                found = textures.insert({ key, fetchTexture(model.getImages()[image], srgb, uploads) }).first;
+            }
+            return found->second != nullptr ? found->second : fallback;
+        };
+
+        material.materials.reserve(cooked.materialCount);
+        for (uint32_t i = 0; i < cooked.materialCount; ++i)
         {
-            material.normal = mDummyNormalMap;
+            const CookedMaterial& mat = cooked.materials[i];
+            PBRMaterial pbrMaterial;
+            pbrMaterial.albedo = fetchCookedTexture(mat.albedo, true, mDummyAlbedoMap);
+            pbrMaterial.metallicRoughness = fetchCookedTexture(mat.metallicRoughness, false, mDummyMetallicRoughnessMap);
+            pbrMaterial.normal = fetchCookedTexture(mat.normal, false, mDummyNormalMap);
+            material.materials.push_back(pbrMaterial);
         }
+        mesh.upload = uploads.submit();
 
         // register mesh and material in the store
         mMeshStore.insert({ name + "_lod0", mesh });
@@ -180,56 +372,19 @@ namespace hvk
     void ModelPipeline::processDebugModel(const DebugMesh& model, const std::string& modelName)
     {
         assert(mInitialized);
+        MemoryTagScope tagScope(MemoryTag::Assets);
 
         DebugDrawMesh mesh;
 
-        const auto& allocator = GpuManager::getAllocator();
-        const auto& device = GpuManager::getDevice();
-
         const auto vertices = model.getVertices();
         const auto indices = model.getIndices();
 
-        mesh.numIndices = indices->size();
-
-        // create vertex buffer
-        size_t vertexMemorySize = sizeof(ColorVertex) * vertices->size();
-        VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-        bufferInfo.size = vertexMemorySize;
-        bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-
-        VmaAllocationCreateInfo allocCreateInfo = {};
-        allocCreateInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
-        allocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-        VmaAllocationInfo vboAllocInfo;
-        vmaCreateBuffer(
-            allocator,
-            &bufferInfo,
-            &allocCreateInfo,
-            &mesh.vbo.memoryResource,
-            &mesh.vbo.allocation,
-            &vboAllocInfo);
-
-        memcpy(vboAllocInfo.pMappedData, vertices->data(), vertexMemorySize);
-
-        // create index buffer
-        uint32_t indexMemorySize = sizeof(uint16_t) * mesh.numIndices;
-        VkBufferCreateInfo iboInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-        iboInfo.size = indexMemorySize;
-        iboInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-
-        VmaAllocationCreateInfo indexAllocCreateInfo = {};
-        indexAllocCreateInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
-        indexAllocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-        VmaAllocationInfo iboAllocInfo;
-        vmaCreateBuffer(
-            allocator,
-            &iboInfo,
-            &indexAllocCreateInfo,
-            &mesh.ibo.memoryResource,
-            &mesh.ibo.allocation,
-            &iboAllocInfo);
-
-        memcpy(iboAllocInfo.pMappedData, indices->data(), (size_t)indexMemorySize);
+        // Copy vertices and indices into the debug arena
+        mesh.geometry = mDebugArena.allocate(
+            vertices->data(),
+            static_cast<uint32_t>(vertices->size()),
+            indices->data(),
+            static_cast<uint32_t>(indices->size()));
 
         // register mesh in the store
         mDebugMeshStore.insert({ modelName, mesh });
@@ -242,7 +397,7 @@ namespace hvk
         return found->second;
     }
 
-    PBRMaterial ModelPipeline::fetchMaterial(std::string&& name)
+    PBRMaterialSet ModelPipeline::fetchMaterial(std::string&& name)
     {
         auto found = mMaterialStore.find(name);
         assert(found != mMaterialStore.end());
@@ -256,18 +411,13 @@ namespace hvk
         return found->second;
     }
 
-    bool ModelPipeline::loadAndFetchModel(
-        const StaticMesh& model, 
-        const std::string& name, 
-        PBRMesh& outMesh, 
-        PBRMaterial& outMaterial)
+    bool ModelPipeline::fetchStoredModel(
+        const std::string& name,
+        PBRMesh& outMesh,
+        PBRMaterialSet& outMaterial)
     {
-        bool newLoad = false;
-        auto meshName = name + "_lod0";
-        auto materialName = name + "_material_lod0";
-
-        auto meshAt = mMeshStore.find(meshName);
-        auto materialAt = mMaterialStore.find(materialName);
+        auto meshAt = mMeshStore.find(name + "_lod0");
+        auto materialAt = mMaterialStore.find(name + "_material_lod0");
         bool meshFound = meshAt != mMeshStore.end();
         bool materialFound = materialAt != mMaterialStore.end();
 
@@ -279,15 +429,41 @@ namespace hvk
             outMesh = meshAt->second;
             outMaterial = materialAt->second;
         }
-        else
+
+        return meshFound;
+    }
+
+    bool ModelPipeline::loadAndFetchModel(
+        const StaticMesh& model, 
+        const std::string& name, 
+        PBRMesh& outMesh, 
+        PBRMaterialSet& outMaterial)
+    {
+        if (fetchStoredModel(name, outMesh, outMaterial))
         {
-            newLoad = true;
-            processGltfModel(model, name);
-            outMesh = mMeshStore.at(meshName);
-            outMaterial = mMaterialStore.at(materialName);
+            return false;
         }
 
-        return newLoad;
+        processGltfModel(model, name);
+        fetchStoredModel(name, outMesh, outMaterial);
+        return true;
+    }
+
+    bool ModelPipeline::loadAndFetchModel(
+        const CookedModel& model,
+        size_t meshIndex,
+        const std::string& name,
+        PBRMesh& outMesh,
+        PBRMaterialSet& outMaterial)
+    {
+        if (fetchStoredModel(name, outMesh, outMaterial))
+        {
+            return false;
+        }
+
+        processCookedModel(model, meshIndex, name);
+        fetchStoredModel(name, outMesh, outMaterial);
+        return true;
     }
 
     bool ModelPipeline::loadAndFetchDebugModel(
@@ -313,4 +489,57 @@ namespace hvk
 
         return newLoad;
     }
+
+    void ModelPipeline::releaseMesh(const std::string& name)
+    {
+        auto found = mMeshStore.find(name + "_lod0");
+        assert(found != mMeshStore.end());
+        mMeshArena.release(found->second.geometry);
+        mMeshStore.erase(found);
+
+        auto materialAt = mMaterialStore.find(name + "_material_lod0");
+        assert(materialAt != mMaterialStore.end());
+        mMaterialStore.erase(materialAt);
+        releaseUnusedTextures();
+    }
+
+    void ModelPipeline::releaseDebugMesh(const std::string& name)
+    {
+        auto found = mDebugMeshStore.find(name);
+        assert(found != mDebugMeshStore.end());
+        mDebugArena.release(found->second.geometry);
+        mDebugMeshStore.erase(found);
+    }
+
+    void ModelPipeline::releaseUnusedTextures()
+    {
+        const uint64_t frame = GpuManager::getFrame();
+        for (auto it = mTextureStore.begin(); it != mTextureStore.end();)
+        {
+            // The store's own reference is the only one left
+            if (it->second.use_count() == 1)
+            {
+                mRetiredTextures.push_back({ frame, std::move(it->second) });
+                it = mTextureStore.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    void ModelPipeline::update()
+    {
+        const auto& device = GpuManager::getDevice();
+        const auto& allocator = GpuManager::getAllocator();
+        const uint64_t completedFrame = GpuManager::getCompletedFrame();
+
+        auto retired = mRetiredTextures.begin();
+        for (; retired != mRetiredTextures.end() && retired->frame <= completedFrame; ++retired)
+        {
+            util::image::destroyMap(device, allocator, *retired->map);
+        }
+        mRetiredTextures.erase(mRetiredTextures.begin(), retired);
+    }
 }
@@ -4,45 +4,99 @@
 
 #include "HvkUtil.h"
 #include "StaticMesh.h"
+#include "VertexEncoding.h"
 #include "DebugMesh.h"
 #include "types.h"
+#include "GeometryArena.h"
 
 namespace hvk
 {
     struct PBRMesh;
     struct PBRMaterial;
+    struct PBRMaterialSet;
     struct DebugDrawMesh;
+    class CookedModel;
+    class UploadBatch;
+    struct Ktx2Texture;
 
     class ModelPipeline
     {
     private:
+        // A map nothing references anymore, kept until draws recorded up to frame have finished
+        struct RetiredTexture
+        {
+            uint64_t frame;
+            HVK_shared<TextureMap> map;
+        };
+
         std::unordered_map<std::string, PBRMesh> mMeshStore;
-        std::unordered_map<std::string, PBRMaterial> mMaterialStore;
+        std::unordered_map<std::string, PBRMaterialSet> mMaterialStore;
         std::unordered_map<std::string, DebugDrawMesh> mDebugMeshStore;
-        TextureMap mDummyAlbedoMap;
-        TextureMap mDummyNormalMap;
-        TextureMap mDummyMetallicRoughnessMap;
+        // Positions in stream 0 and mVertexEncoding's attributes in stream 1
+        GeometryArena mMeshArena;
+        GeometryArena mDebugArena;
+        VertexEncoding mVertexEncoding;
+        // Keyed by a hash of the texels, their dimensions and, for cooked textures, their format
+        std::unordered_map<uint64_t, HVK_shared<TextureMap>> mTextureStore;
+        // In retirement order, so frames never decrease
+        std::vector<RetiredTexture> mRetiredTextures;
+        HVK_shared<TextureMap> mDummyAlbedoMap;
+        HVK_shared<TextureMap> mDummyNormalMap;
+        HVK_shared<TextureMap> mDummyMetallicRoughnessMap;
         bool mInitialized;
 
-        void processGltfModel(const StaticMesh& model, const std::string& modelName);
+        // New maps join uploads and can't be sampled until TextureMap::upload completes.
+        // srgb marks colour textures, whose mips are filtered in linear space
+        HVK_shared<TextureMap> fetchTexture(const void* pixels, int width, int height, int bytesPerPixel, bool srgb, UploadBatch& uploads);
+        // Null if the device can't sample the texture's format
+        HVK_shared<TextureMap> fetchTexture(const Ktx2Texture& texture, bool srgb, UploadBatch& uploads);
+        PBRMaterial createPBRMaterial(const Material& mat, UploadBatch& uploads);
+        // Runs the cook's vertex cache optimization first, so uncooked models draw as fast as cooked ones
+        void processGltfModel(const StaticMesh& source, const std::string& modelName);
+        void processCookedModel(const CookedModel& model, size_t meshIndex, const std::string& modelName);
         void processDebugModel(const DebugMesh& model, const std::string& modelName);
+        bool fetchStoredModel(const std::string& name, PBRMesh& outMesh, PBRMaterialSet& outMaterial);
 
     public:
         ModelPipeline();
         ~ModelPipeline();
-        void init();
+        // Every mesh is stored in vertexEncoding; cooked models must have been cooked with it
+        void init(VertexEncoding vertexEncoding = VertexEncoding::Full);
+        void destroy();
 
         PBRMesh fetchMesh(std::string&& name);
-        PBRMaterial fetchMaterial(std::string&& name);
+        PBRMaterialSet fetchMaterial(std::string&& name);
         DebugDrawMesh fetchDebugMesh(const std::string& name);
         bool loadAndFetchModel(
             const StaticMesh& model, 
             const std::string& name, 
             PBRMesh& outMesh, 
-            PBRMaterial& outMaterial);
+            PBRMaterialSet& outMaterial);
+        // Uploads one mesh of a cooked model straight from its mapping
+        bool loadAndFetchModel(
+            const CookedModel& model,
+            size_t meshIndex,
+            const std::string& name,
+            PBRMesh& outMesh,
+            PBRMaterialSet& outMaterial);
         bool loadAndFetchDebugModel(
             const DebugMesh& model,
             const std::string& name,
             DebugDrawMesh& outMesh);
+
+        // Return a mesh's space to its arena and drop its materials; entities still using it must be removed first
+        void releaseMesh(const std::string& name);
+        void releaseDebugMesh(const std::string& name);
+        // Retire textures no stored material or outside copy references anymore. Command buffers
+        // still in flight may sample them, so they're destroyed by update() once their frame is done
+        void releaseUnusedTextures();
+        // Destroys retired textures whose last draws have finished. Called from
+        // VulkanApp::renderPrepare once the previous frame's fence has signalled
+        void update();
+
+        const GeometryArena& getMeshArena() const { return mMeshArena; }
+        const GeometryArena& getDebugArena() const { return mDebugArena; }
+        VertexEncoding getVertexEncoding() const { return mVertexEncoding; }
+        size_t getTextureCount() const { return mTextureStore.size(); }
     };
 }
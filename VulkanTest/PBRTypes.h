@@ -2,26 +2,79 @@
 
 #include "HvkUtil.h"
 #include "types.h"
+#include "GeometryArena.h"
+#include "MeshletBuilder.h"
 
 namespace hvk
 {
+    // Offsets are relative to the mesh's arena range
+    struct PBRSubmesh
+    {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        int32_t vertexOffset;
+        uint32_t materialIndex;
+        // The submesh's meshlets in PBRMesh::meshlets; with none it's drawn whole
+        uint32_t firstMeshlet;
+        uint32_t meshletCount;
+    };
+
+    // A coarser level of detail, drawn from the same arena range as lod0
+    struct PBRMeshLod
+    {
+        // How far the surface may be from lod0's, in object space
+        float error;
+        std::vector<PBRSubmesh> submeshes;
+    };
+
+    // Vertices and indices live in ModelPipeline's mesh arena
     struct PBRMesh
     {
-        RuntimeResource<VkBuffer> vbo;
-        RuntimeResource<VkBuffer> ibo;
-		uint32_t numIndices;
+        GeometryHandle geometry;
+        // Matches the arena range; draws rebind the index buffer when it changes
+        VkIndexType indexType;
+        // lod0
+        std::vector<PBRSubmesh> submeshes;
+        // Coarser levels, finest first; empty when the mesh only has lod0
+        std::vector<PBRMeshLod> lods;
+        // Every level's meshlets, with index offsets relative to the arena range like submeshes'
+        std::vector<Meshlet> meshlets;
+        // Object space bounds, used to measure how far away the mesh is
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        // The level this entity draws, 0 for lod0 and n for lods[n - 1]. Picked each frame
+        // from the previous one, so it's kept per entity
+        uint32_t lod = 0;
+        // Staged geometry can't be drawn until this completes
+        UploadTicket upload = 0;
     };
 
+    inline const std::vector<PBRSubmesh>& getLodSubmeshes(const PBRMesh& mesh)
+    {
+        return mesh.lod == 0 ? mesh.submeshes : mesh.lods[mesh.lod - 1].submeshes;
+    }
+
+    // Maps are shared through ModelPipeline's texture store, so materials using
+    // the same image hold the same upload
     struct PBRMaterial
     {
-        TextureMap albedo;
-        TextureMap metallicRoughness;
-        TextureMap normal;
+        HVK_shared<TextureMap> albedo;
+        HVK_shared<TextureMap> metallicRoughness;
+        HVK_shared<TextureMap> normal;
+    };
+
+    // Every material of a mesh, indexed by PBRSubmesh::materialIndex
+    struct PBRMaterialSet
+    {
+        std::vector<PBRMaterial> materials;
     };
 
 	struct PBRBinding
 	{
-		RuntimeResource<VkBuffer> ubo; // should we make this a Resource<T> and store the allocation info?  Adds at least 24 bytes to the field.
-		VkDescriptorSet descriptorSet;
+		// One set per material, indexed like PBRMaterialSet.
+		// Per-draw uniforms come from the UniformRing through a dynamic offset
+		std::vector<VkDescriptorSet> descriptorSets;
+		// The latest upload among the bound maps; the mesh isn't drawn until it completes
+		UploadTicket upload = 0;
 	};
 }
@@ -3,6 +3,7 @@
 
 #include "descriptor-util.h"
 #include "pipeline-util.h"
+#include "memory-util.h"
 
 namespace hvk
 {
@@ -26,39 +27,31 @@ namespace hvk
 
 		// Create VBO
 		size_t vertexMemorySize = sizeof(QuadVertex) * numVertices;
-		VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-		bufferInfo.size = vertexMemorySize;
-		bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-
-		VmaAllocationCreateInfo allocCreateInfo = {};
-		allocCreateInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
-		allocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-		vmaCreateBuffer(
+		util::memory::createStaticBuffer(
             allocator,
-			&bufferInfo,
-			&allocCreateInfo,
+			quadVertices.data(),
+			vertexMemorySize,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
 			&mRenderable.vbo.memoryResource,
 			&mRenderable.vbo.allocation,
-			&mRenderable.vbo.allocationInfo);
-		memcpy(mRenderable.vbo.allocationInfo.pMappedData, quadVertices.data(), vertexMemorySize);
+			&mRenderable.vbo.allocationInfo,
+			util::memory::GpuMemoryCategory::Mesh);
 
 		// Create IBO
 		size_t indexMemorySize = sizeof(uint16_t) * numIndices;
-		VkBufferCreateInfo iboInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-		iboInfo.size = indexMemorySize;
-		iboInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-
-		VmaAllocationCreateInfo indexCreateInfo = {};
-		indexCreateInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
-		indexCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-		vmaCreateBuffer(
+		util::memory::createStaticBuffer(
             allocator,
-			&iboInfo,
-			&indexCreateInfo,
+			quadIndices.data(),
+			indexMemorySize,
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			VK_ACCESS_INDEX_READ_BIT,
 			&mRenderable.ibo.memoryResource,
 			&mRenderable.ibo.allocation,
-			&mRenderable.ibo.allocationInfo);
-		memcpy(mRenderable.ibo.allocationInfo.pMappedData, quadIndices.data(), indexMemorySize);
+			&mRenderable.ibo.allocationInfo,
+			util::memory::GpuMemoryCategory::Mesh);
 
 		std::vector<VkDescriptorSetLayout> layouts;
 		if (mOffscreenMap != nullptr)
@@ -122,8 +115,8 @@ namespace hvk
 
 	QuadGenerator::~QuadGenerator()
 	{
-        vmaDestroyBuffer(GpuManager::getAllocator(), mRenderable.vbo.memoryResource, mRenderable.vbo.allocation);
-        vmaDestroyBuffer(GpuManager::getAllocator(), mRenderable.ibo.memoryResource, mRenderable.ibo.allocation);
+        util::memory::destroyBuffer(GpuManager::getAllocator(), mRenderable.vbo.memoryResource, mRenderable.vbo.allocation);
+        util::memory::destroyBuffer(GpuManager::getAllocator(), mRenderable.ibo.memoryResource, mRenderable.ibo.allocation);
 	}
 
 	void QuadGenerator::invalidate()
@@ -2,6 +2,7 @@
 
 #include "descriptor-util.h"
 #include "pipeline-util.h"
+#include "UniformRing.h"
 
 namespace hvk
 {
@@ -9,21 +10,31 @@ namespace hvk
 		DrawlistGenerator(renderPass, commandPool),
 		mDescriptorSetLayout(VK_NULL_HANDLE),
 		mDescriptorPool(VK_NULL_HANDLE),
+		mDescriptorSet(VK_NULL_HANDLE),
 		mPipeline(VK_NULL_HANDLE),
 		mPipelineInfo()
 	{
 		const VkDevice& device = GpuManager::getDevice();
-		const VmaAllocator& allocator = GpuManager::getAllocator();
 
 		// create descriptor set layout and descriptor pool
-		auto poolSizes = util::descriptor::createPoolSizes<VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER>(MAX_UBOS);
-		util::descriptor::createDescriptorPool(device, poolSizes, MAX_DESCRIPTORS, mDescriptorPool);
+		auto poolSizes = util::descriptor::createPoolSizes<VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC>(1);
+		util::descriptor::createDescriptorPool(device, poolSizes, 1, mDescriptorPool);
 
 		std::vector<VkDescriptorSetLayoutBinding> bindings = {
-			util::descriptor::generateUboLayoutBinding(0, 1)
+			util::descriptor::generateUboLayoutBinding(
+				0,
+				1,
+				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
 		};
 		util::descriptor::createDescriptorSetLayout(device, bindings, mDescriptorSetLayout);
 
+		// create the shared descriptor set pointing at the uniform ring
+		std::vector<VkDescriptorSetLayout> layouts = { mDescriptorSetLayout };
+		util::descriptor::allocateDescriptorSets(device, mDescriptorPool, mDescriptorSet, layouts);
+
+		UniformRing::bindDescriptor(this, mDescriptorSet, 0, sizeof(hvk::UniformBufferObject));
+
 		// prepare pipeline
 		preparePipelineInfo();
 
@@ -34,9 +45,9 @@ namespace hvk
 	ShadowGenerator::~ShadowGenerator()
 	{
 		const VkDevice& device = GpuManager::getDevice();
-		const VmaAllocator& allocator = GpuManager::getAllocator();
 
 		vkDestroyDescriptorSetLayout(device, mDescriptorSetLayout, nullptr);
+		UniformRing::releaseDescriptors(this);
 		vkDestroyDescriptorPool(device, mDescriptorPool, nullptr);
 
 		vkDestroyPipeline(device, mPipeline, nullptr);
@@ -58,8 +69,8 @@ namespace hvk
 		};
 		assert(vkCreatePipelineLayout(device, &layoutCreate, nullptr, &mPipelineInfo.pipelineLayout) == VK_SUCCESS);
 
-		// TODO: only need vertex position attribute; should we define a new vertex type for shadows?
-		util::pipeline::fillVertexInfo<Vertex>(mPipelineInfo.vertexInfo);
+		// Depth only, so just the arena's position stream is read
+		util::pipeline::fillVertexInfo<PositionVertex>(mPipelineInfo.vertexInfo);
 
 		VkPipelineColorBlendAttachmentState blendAttachment = {};
 		blendAttachment.blendEnable = VK_FALSE;
@@ -91,46 +102,7 @@ namespace hvk
 	ShadowBinding ShadowGenerator::createBinding()
 	{
 		ShadowBinding newBinding;
-
-		const auto& device = GpuManager::getDevice();
-		const auto& allocator = GpuManager::getAllocator();
-
-		// create UBO
-        uint32_t uboMemorySize = sizeof(hvk::UniformBufferObject);
-        VkBufferCreateInfo uboInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-        uboInfo.size = uboMemorySize;
-        uboInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-
-		VmaAllocationCreateInfo uniformAllocCreateInfo = {};
-		uniformAllocCreateInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
-		uniformAllocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-		vmaCreateBuffer(
-            allocator,
-			&uboInfo,
-			&uniformAllocCreateInfo,
-			&newBinding.ubo.memoryResource,
-			&newBinding.ubo.allocation,
-			nullptr);
-
-		// create descriptor set
-		VkDescriptorSetAllocateInfo dsAlloc = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
-		dsAlloc.descriptorPool = mDescriptorPool;
-		dsAlloc.descriptorSetCount = 1;
-		dsAlloc.pSetLayouts = &mDescriptorSetLayout;
-
-		assert(vkAllocateDescriptorSets(device, &dsAlloc, &newBinding.descriptorSet) == VK_SUCCESS);
-
-		// update descriptor set
-		std::vector<VkWriteDescriptorSet> descriptorWrites;
-		std::vector<VkDescriptorBufferInfo> bufferInfos = {
-			VkDescriptorBufferInfo {
-				newBinding.ubo.memoryResource,
-				0,
-				sizeof(hvk::UniformBufferObject) } };
-		auto bufferDescriptorWrite = util::descriptor::createDescriptorBufferWrite(bufferInfos, newBinding.descriptorSet, 0);
-		descriptorWrites.push_back(bufferDescriptorWrite);
-		vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
-
+		newBinding.descriptorSet = mDescriptorSet;
 		return newBinding;
 	}
-}
\ No newline at end of file
+}
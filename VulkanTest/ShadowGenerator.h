@@ -1,11 +1,15 @@
 #pragma once
 #include "DrawlistGenerator.h"
+#include "GeometryArena.h"
+#include "UniformRing.h"
+#include "UploadQueue.h"
+#include "FrameAllocator.h"
+#include "cull-util.h"
 
 namespace hvk
 {
 	struct ShadowBinding
 	{
-		RuntimeResource<VkBuffer> ubo;
 		VkDescriptorSet descriptorSet;
 	};
 
@@ -14,6 +18,8 @@ namespace hvk
 	private:
 		VkDescriptorSetLayout mDescriptorSetLayout;
 		VkDescriptorPool mDescriptorPool;
+		// Every shadow caster shares this set, only the dynamic UBO offset differs per draw
+		VkDescriptorSet mDescriptorSet;
 		VkPipeline mPipeline;
 		RenderPipelineInfo mPipelineInfo;
 
@@ -34,6 +40,7 @@ namespace hvk
 			const VkViewport& viewport,
 			const VkRect2D& scissor,
 			const LightType& light,
+			const GeometryArena& geometry,
 			const ShadowGroupType& shadowables);
 	};
 
@@ -43,11 +50,9 @@ namespace hvk
 		const VkViewport& viewport,
 		const VkRect2D& scissor,
 		const LightType& light,
+		const GeometryArena& geometry,
 		const ShadowGroupType& shadowables)
 	{
-		const auto& device = GpuManager::getDevice();
-		const auto& allocator = GpuManager::getAllocator();
-
 		VkCommandBufferBeginInfo commandBegin = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
 		commandBegin.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
 		commandBegin.pInheritanceInfo = &inheritance;
@@ -70,16 +75,38 @@ namespace hvk
 			worldTransform[3]
 		};
 
-		VmaAllocationInfo allocInfo;
+		VkBuffer vertexBuffer = geometry.getVertexBuffer(0);
+		vkCmdBindVertexBuffers(mCommandBuffer, 0, 1, &vertexBuffer, offsets);
+		VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+		const util::math::Frustum frustum = util::math::getFrustum(viewProj);
+		HVK_pmr_vector<util::cull::IndexRange> visibleRanges(FrameAllocator::getResource());
+
 		shadowables.each([&](auto entity, const auto& mesh, const auto& binding, const auto& transform) {
+			// Geometry still being staged in casts no shadow yet
+			if (!UploadQueue::isComplete(mesh.upload))
+			{
+				return;
+			}
+
+			// Only the light's frustum culls casters; a directional light has no position
+			// for meshlets to face away from
+			const util::cull::ObjectView objectView = util::cull::getObjectView(
+				frustum,
+				transform.transform,
+				glm::vec3(worldTransform[3]),
+				false);
+			const glm::vec3 boundsCenter = (mesh.boundsMin + mesh.boundsMax) * 0.5f;
+			if (!util::math::sphereInFrustum(objectView.frustum, boundsCenter, glm::length(mesh.boundsMax - boundsCenter)))
+			{
+				return;
+			}
+
 			// update UBO
-			vmaGetAllocationInfo(allocator, binding.ubo.allocation, &allocInfo);
 			ubo.model = transform.transform;
 			ubo.modelViewProj = viewProj * ubo.model;
-			memcpy(allocInfo.pMappedData, &ubo, sizeof(ubo));
+			const uint32_t uboOffset = UniformRing::push(ubo);
 
-			vkCmdBindVertexBuffers(mCommandBuffer, 0, 1, &mesh.vbo.memoryResource, offsets);
-			vkCmdBindIndexBuffer(mCommandBuffer, mesh.ibo.memoryResource, 0, VK_INDEX_TYPE_UINT16);
 			vkCmdBindDescriptorSets(
 				mCommandBuffer,
 				VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -87,10 +114,44 @@ namespace hvk
 				0,
 				1,
 				&binding.descriptorSet,
-				0,
-				nullptr);
+				1,
+				&uboOffset);
+
+			if (mesh.indexType != boundIndexType)
+			{
+				// firstIndex is in units of the mesh's index type, so the buffer offset stays 0
+				vkCmdBindIndexBuffer(mCommandBuffer, geometry.getIndexBuffer(), 0, mesh.indexType);
+				boundIndexType = mesh.indexType;
+			}
+
+			const GeometryRange& range = geometry.getRange(mesh.geometry);
+			for (const auto& submesh : getLodSubmeshes(mesh))
+			{
+				visibleRanges.clear();
+				if (submesh.meshletCount > 0)
+				{
+					util::cull::appendVisibleRanges(
+						objectView,
+						mesh.meshlets.data() + submesh.firstMeshlet,
+						submesh.meshletCount,
+						visibleRanges);
+				}
+				else
+				{
+					visibleRanges.push_back({ submesh.firstIndex, submesh.indexCount });
+				}
 
-			vkCmdDrawIndexed(mCommandBuffer, mesh.numIndices, 1, 0, 0, 0);
+				for (const auto& indexRange : visibleRanges)
+				{
+					vkCmdDrawIndexed(
+						mCommandBuffer,
+						indexRange.indexCount,
+						1,
+						range.firstIndex + indexRange.firstIndex,
+						static_cast<int32_t>(range.vertexOffset) + submesh.vertexOffset,
+						0);
+				}
+			}
 		});
 
 		assert(vkEndCommandBuffer(mCommandBuffer) == VK_SUCCESS);
@@ -0,0 +1,112 @@
+#include "pch.h"
+#include "StagingRing.h"
+
+#include <algorithm>
+
+#include "GpuManager.h"
+#include "UploadQueue.h"
+#include "memory-util.h"
+
+namespace hvk
+{
+	Resource<VkBuffer> StagingRing::sBuffer = {};
+	VkDeviceSize StagingRing::sSize = 0;
+	uint64_t StagingRing::sHead = 0;
+	uint64_t StagingRing::sTail = 0;
+	uint64_t StagingRing::sFenced = 0;
+	VkDeviceSize StagingRing::sPeak = 0;
+	std::deque<StagingRing::Fence> StagingRing::sFences;
+
+	void StagingRing::initialize(VkDeviceSize size)
+	{
+		sSize = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+		sHead = 0;
+		sTail = 0;
+		sFenced = 0;
+		sPeak = 0;
+		sFences.clear();
+
+		VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+		bufferInfo.size = sSize;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+		VmaAllocationCreateInfo allocCreateInfo = {};
+		allocCreateInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+		allocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+		assert(util::memory::createBuffer(
+			GpuManager::getAllocator(),
+			&bufferInfo,
+			&allocCreateInfo,
+			&sBuffer.memoryResource,
+			&sBuffer.allocation,
+			&sBuffer.allocationInfo,
+			util::memory::GpuMemoryCategory::Staging) == VK_SUCCESS);
+	}
+
+	void StagingRing::destroy()
+	{
+		if (sBuffer.allocation != VK_NULL_HANDLE)
+		{
+			util::memory::destroyBuffer(GpuManager::getAllocator(), sBuffer.memoryResource, sBuffer.allocation);
+		}
+		sBuffer = {};
+		sFences.clear();
+	}
+
+	void StagingRing::reclaim()
+	{
+		while (!sFences.empty() && UploadQueue::isComplete(sFences.front().ticket))
+		{
+			sTail = sFences.front().end;
+			sFences.pop_front();
+		}
+	}
+
+	bool StagingRing::allocate(VkDeviceSize size, StagingAllocation& outAllocation)
+	{
+		if (size > sSize)
+		{
+			return false;
+		}
+
+		// An allocation never straddles the end of the buffer; the rest of the lap is skipped
+		uint64_t start = (sHead + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+		if (start % sSize + size > sSize)
+		{
+			start = (start / sSize + 1) * sSize;
+		}
+
+		reclaim();
+		while (start + size - sTail > sSize)
+		{
+			if (sFences.empty())
+			{
+				return false;
+			}
+			UploadQueue::wait(sFences.front().ticket);
+			reclaim();
+		}
+
+		sHead = start + size;
+		sPeak = std::max<VkDeviceSize>(sPeak, sHead - sTail);
+
+		outAllocation.buffer = sBuffer.memoryResource;
+		outAllocation.offset = start % sSize;
+		outAllocation.data = static_cast<char*>(sBuffer.allocationInfo.pMappedData) + outAllocation.offset;
+		return true;
+	}
+
+	void StagingRing::fence(UploadTicket ticket)
+	{
+		if (sHead != sFenced)
+		{
+			sFences.push_back({ ticket, sHead });
+			sFenced = sHead;
+		}
+	}
+
+	void StagingRing::flush(const StagingAllocation& allocation, VkDeviceSize size)
+	{
+		vmaFlushAllocation(GpuManager::getAllocator(), sBuffer.allocation, allocation.offset, size);
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <deque>
+
+#include "types.h"
+
+namespace hvk
+{
+	struct StagingAllocation
+	{
+		VkBuffer buffer;
+		// Offset from the start of the ring buffer, used as the copy's source offset
+		VkDeviceSize offset;
+		void* data;
+	};
+
+	// One persistently mapped staging buffer that upload batches sub-allocate from instead
+	// of creating a buffer per copy. Allocations are handed out in order and given back in
+	// the same order once the upload they were submitted with completes, so the free space
+	// is always the stretch between the newest allocation and the oldest unfinished one.
+	// Positions are kept as running byte counts and only wrapped when turned into offsets
+	class StagingRing
+	{
+	public:
+		static constexpr VkDeviceSize DEFAULT_SIZE = 64 * 1024 * 1024;
+		// Covers the texel block size of every format the renderer uploads
+		static constexpr VkDeviceSize ALIGNMENT = 16;
+
+	private:
+		struct Fence
+		{
+			UploadTicket ticket;
+			uint64_t end;
+		};
+
+		static Resource<VkBuffer> sBuffer;
+		static VkDeviceSize sSize;
+		static uint64_t sHead;
+		static uint64_t sTail;
+		static uint64_t sFenced;
+		static VkDeviceSize sPeak;
+		static std::deque<Fence> sFences;
+
+		static void reclaim();
+
+	public:
+		static void initialize(VkDeviceSize size);
+		static void destroy();
+
+		// False when size doesn't fit even after waiting on every fenced upload, meaning
+		// the unfenced allocations fill the ring and must be submitted first
+		static bool allocate(VkDeviceSize size, StagingAllocation& outAllocation);
+		// Everything allocated since the last fence is released once ticket completes
+		static void fence(UploadTicket ticket);
+		// Makes the CPU writes to an allocation visible to the device
+		static void flush(const StagingAllocation& allocation, VkDeviceSize size);
+
+		static VkDeviceSize getSize() { return sSize; }
+		static VkDeviceSize getBytesUsed() { return sHead - sTail; }
+		static VkDeviceSize getPeakBytesUsed() { return sPeak; }
+	};
+}
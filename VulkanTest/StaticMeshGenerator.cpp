@@ -1,11 +1,15 @@
 #include "pch.h"
 #include "StaticMeshGenerator.h"
 
+#include <algorithm>
+
 #include "descriptor-util.h"
 #include "pipeline-util.h"
 #include "image-util.h"
+#include "UniformRing.h"
 
 const uint32_t MAX_SHADOWMAPS = 10;
+const uint32_t PBR_SETS_PER_POOL = 64;
 
 namespace hvk
 {
@@ -14,27 +18,32 @@ namespace hvk
 		VkCommandPool commandPool,
         HVK_shared<TextureMap> environmentMap,
 		HVK_shared<TextureMap> irradianceMap,
-		HVK_shared<TextureMap> brdfLutMap) :
+		HVK_shared<TextureMap> brdfLutMap,
+		VertexEncoding vertexEncoding) :
 
 		DrawlistGenerator(renderPass, commandPool),
 		mDescriptorSetLayout(VK_NULL_HANDLE),
 		mLightsDescriptorSetLayout(VK_NULL_HANDLE),
 		mDescriptorPool(VK_NULL_HANDLE),
+		mDescriptorAllocator(),
 		mLightsDescriptorSet(VK_NULL_HANDLE),
 		mPipeline(VK_NULL_HANDLE),
 		mPipelineInfo(),
-		mLightsUbo(),
         mEnvironmentMap(environmentMap),
 		mIrradianceMap(irradianceMap),
-		mBrdfLutMap(brdfLutMap)
+		mBrdfLutMap(brdfLutMap),
+		mVertexEncoding(vertexEncoding)
 	{
         const VkDevice& device = GpuManager::getDevice();
-        const VmaAllocator& allocator = GpuManager::getAllocator();
 
 		/***************
 		 Create descriptor set layout and descriptor pool
 		***************/
-		VkDescriptorSetLayoutBinding uboLayoutBinding = util::descriptor::generateUboLayoutBinding(0, 1);
+		VkDescriptorSetLayoutBinding uboLayoutBinding = util::descriptor::generateUboLayoutBinding(
+			0,
+			1,
+			VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+			VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
 		VkDescriptorSetLayoutBinding diffuseSamplerBinding = util::descriptor::generateSamplerLayoutBinding(1, 1);
 		VkDescriptorSetLayoutBinding metalRoughSamplerBinding = util::descriptor::generateSamplerLayoutBinding(2, 1);
 		VkDescriptorSetLayoutBinding normalSamplerBinding = util::descriptor::generateSamplerLayoutBinding(3, 1);
@@ -53,32 +62,20 @@ namespace hvk
         };
 		util::descriptor::createDescriptorSetLayout(device, bindings, mDescriptorSetLayout);
 
-        auto poolSizes = util::descriptor::createPoolSizes<VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER>(MAX_UBOS, MAX_SAMPLERS);
-		util::descriptor::createDescriptorPool(device, poolSizes, MAX_DESCRIPTORS, mDescriptorPool);
-
-		/*************
-		 Create Lights UBO
-		 *************/
-		uint32_t uboMemorySize = sizeof(hvk::UniformLightObject<NUM_INITIAL_LIGHTS>);
-        VkBufferCreateInfo uboInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-        uboInfo.size = uboMemorySize;
-        uboInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-
-		VmaAllocationCreateInfo uniformAllocCreateInfo = {};
-		uniformAllocCreateInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
-		uniformAllocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-		vmaCreateBuffer(
-            allocator,
-			&uboInfo,
-			&uniformAllocCreateInfo,
-			&mLightsUbo.memoryResource,
-			&mLightsUbo.allocation,
-			&mLightsUbo.allocationInfo);
+		mDescriptorAllocator.init(device, mDescriptorSetLayout, bindings, PBR_SETS_PER_POOL);
+
+		// The lights set is the only one allocated from the fixed pool
+        auto poolSizes = util::descriptor::createPoolSizes<VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER>(1, MAX_SHADOWMAPS);
+		util::descriptor::createDescriptorPool(device, poolSizes, 1, mDescriptorPool);
 
 		/*****************
 		 Create Lights descriptor set
 		******************/
-		VkDescriptorSetLayoutBinding lightLayoutBinding = util::descriptor::generateUboLayoutBinding(0, 1, VK_SHADER_STAGE_FRAGMENT_BIT);
+		VkDescriptorSetLayoutBinding lightLayoutBinding = util::descriptor::generateUboLayoutBinding(
+			0,
+			1,
+			VK_SHADER_STAGE_FRAGMENT_BIT,
+			VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
 		VkDescriptorSetLayoutBinding shadowMapsBinding = util::descriptor::generateSamplerLayoutBinding(2, MAX_SHADOWMAPS);
 		std::vector<decltype(lightLayoutBinding)> lightBindings = {
 			lightLayoutBinding,
@@ -89,20 +86,8 @@ namespace hvk
 		std::vector<VkDescriptorSetLayout> lightLayouts = { mLightsDescriptorSetLayout };
 		util::descriptor::allocateDescriptorSets(device, mDescriptorPool, mLightsDescriptorSet, lightLayouts);
 
-		VkDescriptorBufferInfo lightsBufferInfo = {};
-		lightsBufferInfo.buffer = mLightsUbo.memoryResource;
-		lightsBufferInfo.offset = 0;
-		lightsBufferInfo.range = NUM_INITIAL_LIGHTS * sizeof(hvk::UniformLight);
-
-		VkWriteDescriptorSet lightsDescriptorWrite = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
-		lightsDescriptorWrite.dstSet = mLightsDescriptorSet;
-		lightsDescriptorWrite.dstBinding = 0;
-		lightsDescriptorWrite.dstArrayElement = 0;
-		lightsDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		lightsDescriptorWrite.descriptorCount = 1;
-		lightsDescriptorWrite.pBufferInfo = &lightsBufferInfo;
-
-		vkUpdateDescriptorSets(device, 1, &lightsDescriptorWrite, 0, nullptr);
+		// Lights are written to the uniform ring each frame and addressed with a dynamic offset
+		UniformRing::bindDescriptor(this, mLightsDescriptorSet, 0, sizeof(hvk::UniformLightObject<NUM_INITIAL_LIGHTS>));
 
 		/*
 		 prepare graphics pipeline info	
@@ -116,13 +101,13 @@ namespace hvk
     StaticMeshGenerator::~StaticMeshGenerator()
     {
         const auto& device = GpuManager::getDevice();
-        const auto& allocator = GpuManager::getAllocator();
 
 		// TODO: need to make sure environment map and irradiance map are being cleaned up
 
-        vmaDestroyBuffer(allocator, mLightsUbo.memoryResource, mLightsUbo.allocation);
         vkDestroyDescriptorSetLayout(device, mLightsDescriptorSetLayout, nullptr);
 
+        UniformRing::releaseDescriptors(this);
+        mDescriptorAllocator.destroy();
         vkDestroyDescriptorSetLayout(device, mDescriptorSetLayout, nullptr);
         vkDestroyDescriptorPool(device, mDescriptorPool, nullptr);
 
@@ -148,7 +133,17 @@ namespace hvk
 
 		assert(vkCreatePipelineLayout(device, &layoutCreate, nullptr, &mPipelineInfo.pipelineLayout) == VK_SUCCESS);
 
-		util::pipeline::fillVertexInfo<Vertex>(mPipelineInfo.vertexInfo);
+		// Both layouts feed the same fragment shader; the packed one is unpacked in its vertex shader
+		if (mVertexEncoding == VertexEncoding::Packed)
+		{
+			util::pipeline::fillVertexInfo<PositionVertex, PackedVertexAttributes>(mPipelineInfo.vertexInfo);
+			mPipelineInfo.vertShaderFile = "shaders/compiled/vert_packed.spv";
+		}
+		else
+		{
+			util::pipeline::fillVertexInfo<PositionVertex, VertexAttributes>(mPipelineInfo.vertexInfo);
+			mPipelineInfo.vertShaderFile = "shaders/compiled/vert.spv";
+		}
 
 		VkPipelineColorBlendAttachmentState blendAttachment = {};
 		blendAttachment.blendEnable = VK_FALSE;
@@ -156,7 +151,6 @@ namespace hvk
 
 		mPipelineInfo.blendAttachments = { blendAttachment };
 		mPipelineInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-		mPipelineInfo.vertShaderFile = "shaders/compiled/vert.spv";
 		mPipelineInfo.fragShaderFile = "shaders/compiled/frag.spv";
 		mPipelineInfo.rasterizationState = util::pipeline::createRasterizationState();
 
@@ -178,78 +172,73 @@ namespace hvk
 		vkDestroyPipeline(GpuManager::getDevice(), mPipeline, nullptr);
 	}
 
-	PBRBinding StaticMeshGenerator::createPBRBinding(const PBRMaterial& material)
+	PBRBinding StaticMeshGenerator::createPBRBinding(const PBRMaterialSet& materials)
 	{
 		PBRBinding newBinding;
+		newBinding.descriptorSets.reserve(materials.materials.size());
+		for (const auto& material : materials.materials)
+		{
+			newBinding.descriptorSets.push_back(createMaterialDescriptorSet(material));
+			for (const auto* map : { &material.albedo, &material.metallicRoughness, &material.normal })
+			{
+				newBinding.upload = std::max(newBinding.upload, (*map)->upload);
+			}
+		}
+
+		return newBinding;
+	}
 
+	void StaticMeshGenerator::releasePBRBinding(PBRBinding& binding)
+	{
+		for (auto descriptorSet : binding.descriptorSets)
+		{
+			UniformRing::releaseDescriptor(descriptorSet);
+			mDescriptorAllocator.free(descriptorSet, GpuManager::getFrame());
+		}
+		binding.descriptorSets.clear();
+	}
+
+	VkDescriptorSet StaticMeshGenerator::createMaterialDescriptorSet(const PBRMaterial& material)
+	{
         const auto& device = GpuManager::getDevice();
-        const auto& allocator = GpuManager::getAllocator();
-		//const auto& comp = registry.get<PBRMaterial>(pbrEntity);
-
-		// Create UBO
-        uint32_t uboMemorySize = sizeof(hvk::UniformBufferObject);
-        VkBufferCreateInfo uboInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-        uboInfo.size = uboMemorySize;
-        uboInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-
-		VmaAllocationCreateInfo uniformAllocCreateInfo = {};
-		uniformAllocCreateInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
-		uniformAllocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-		vmaCreateBuffer(
-            allocator,
-			&uboInfo,
-			&uniformAllocCreateInfo,
-			&newBinding.ubo.memoryResource,
-			&newBinding.ubo.allocation,
-			nullptr);
-
-		VkDescriptorSetAllocateInfo dsAlloc = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
-		dsAlloc.descriptorPool = mDescriptorPool;
-		dsAlloc.descriptorSetCount = 1;
-		dsAlloc.pSetLayouts = &mDescriptorSetLayout;
-
-		assert(vkAllocateDescriptorSets(device, &dsAlloc, &newBinding.descriptorSet) == VK_SUCCESS);
+
+		mDescriptorAllocator.recycle(GpuManager::getCompletedFrame());
+		VkDescriptorSet descriptorSet = mDescriptorAllocator.allocate();
 
 		// Update descriptor set
 		{
 			std::vector<VkWriteDescriptorSet> descriptorWrites;
-			descriptorWrites.reserve(7);
+			descriptorWrites.reserve(6);
 
-			std::vector<VkDescriptorBufferInfo> bufferInfos = {
-				VkDescriptorBufferInfo {
-					newBinding.ubo.memoryResource,
-					0,
-					sizeof(hvk::UniformBufferObject) } };
-
-			auto bufferDescriptorWrite = util::descriptor::createDescriptorBufferWrite(bufferInfos, newBinding.descriptorSet, 0);
-			descriptorWrites.push_back(bufferDescriptorWrite);
+			// Per-draw UBO lives in the uniform ring, the offset is supplied at bind time
+			UniformRing::bindDescriptor(this, descriptorSet, 0, sizeof(hvk::UniformBufferObject));
 
 			std::vector<VkDescriptorImageInfo> albedoImageInfos = {
 				VkDescriptorImageInfo{
-					material.albedo.sampler,
-					material.albedo.view,
+					material.albedo->sampler,
+					material.albedo->view,
 					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL } };
 
 			auto albedoDescriptorWrite = util::descriptor::createDescriptorImageWrite(
 				albedoImageInfos,
-				newBinding.descriptorSet,
+				descriptorSet,
 				1);
 			descriptorWrites.push_back(albedoDescriptorWrite);
 
 			std::vector<VkDescriptorImageInfo> mtlRoughImageInfos = {
 				VkDescriptorImageInfo{
-				material.metallicRoughness.sampler,
-				material.metallicRoughness.view,
+				material.metallicRoughness->sampler,
+				material.metallicRoughness->view,
 				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL } };
-			auto mtlRoughDescriptorWrite = util::descriptor::createDescriptorImageWrite(mtlRoughImageInfos, newBinding.descriptorSet, 2);
+			auto mtlRoughDescriptorWrite = util::descriptor::createDescriptorImageWrite(mtlRoughImageInfos, descriptorSet, 2);
 			descriptorWrites.push_back(mtlRoughDescriptorWrite);
 
 			std::vector<VkDescriptorImageInfo> normalImageInfos = {
 				VkDescriptorImageInfo{
-				material.normal.sampler,
-				material.normal.view,
+				material.normal->sampler,
+				material.normal->view,
 				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL } };
-			auto normalDescriptorWrite = util::descriptor::createDescriptorImageWrite(normalImageInfos, newBinding.descriptorSet, 3);
+			auto normalDescriptorWrite = util::descriptor::createDescriptorImageWrite(normalImageInfos, descriptorSet, 3);
 			descriptorWrites.push_back(normalDescriptorWrite);
 
             std::vector<VkDescriptorImageInfo> environmentImageInfos = {
@@ -259,7 +248,7 @@ namespace hvk
                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL} };
             auto environmentDescriptorWrite = util::descriptor::createDescriptorImageWrite(
                 environmentImageInfos, 
-                newBinding.descriptorSet, 
+                descriptorSet, 
                 4);
 			descriptorWrites.push_back(environmentDescriptorWrite);
 
@@ -270,7 +259,7 @@ namespace hvk
 					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }};
 			auto irradianceDescriptorWrite = util::descriptor::createDescriptorImageWrite(
 				irradianceImageInfos,
-				newBinding.descriptorSet,
+				descriptorSet,
 				5);
 			descriptorWrites.push_back(irradianceDescriptorWrite);
 
@@ -281,13 +270,13 @@ namespace hvk
 					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }};
 			auto brdfDescriptorWrite = util::descriptor::createDescriptorImageWrite(
 				brdfImageInfos,
-				newBinding.descriptorSet,
+				descriptorSet,
 				6);
 			descriptorWrites.push_back(brdfDescriptorWrite);
 
 			vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
 		}
 
-		return newBinding;
+		return descriptorSet;
 	}
 }
\ No newline at end of file
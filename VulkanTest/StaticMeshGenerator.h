@@ -9,8 +9,15 @@
 #include "Light.h"
 #include "Camera.h"
 #include "PBRTypes.h"
+#include "GeometryArena.h"
 #include "SceneTypes.h"
 #include "LightTypes.h"
+#include "FrameAllocator.h"
+#include "UploadQueue.h"
+#include "UniformRing.h"
+#include "descriptor-util.h"
+#include "cull-util.h"
+#include "VertexEncoding.h"
 
 namespace hvk
 {
@@ -21,19 +28,21 @@ namespace hvk
 		VkDescriptorSetLayout mDescriptorSetLayout;
 		VkDescriptorSetLayout mLightsDescriptorSetLayout;
 		VkDescriptorPool mDescriptorPool;
+		util::descriptor::DescriptorAllocator mDescriptorAllocator;
 		VkDescriptorSet mLightsDescriptorSet;
 		VkPipeline mPipeline;
 		RenderPipelineInfo mPipelineInfo;
-		Resource<VkBuffer> mLightsUbo;
 
         HVK_shared<TextureMap> mEnvironmentMap;
 		HVK_shared<TextureMap> mIrradianceMap;
 		HVK_shared<TextureMap> mBrdfLutMap;
+		VertexEncoding mVertexEncoding;
 
         float mGammaCorrection;
         bool mUseSRGBTex;
 
 		void preparePipelineInfo();
+		VkDescriptorSet createMaterialDescriptorSet(const PBRMaterial& material);
 
 	public:
         StaticMeshGenerator(
@@ -41,11 +50,14 @@ namespace hvk
 			VkCommandPool commandPool,
             HVK_shared<TextureMap> environmentMap,
 			HVK_shared<TextureMap> irradianceMap,
-			HVK_shared<TextureMap> brdfLutMap);
+			HVK_shared<TextureMap> brdfLutMap,
+			VertexEncoding vertexEncoding = VertexEncoding::Full);
 		virtual ~StaticMeshGenerator();
 		virtual void invalidate() override;
 		void updateRenderPass(VkRenderPass renderPass);
-		PBRBinding createPBRBinding(const PBRMaterial& material);
+		PBRBinding createPBRBinding(const PBRMaterialSet& materials);
+		// Hands the binding's sets back once the frames that may still draw with them complete
+		void releasePBRBinding(PBRBinding& binding);
 
 		template <typename PBRGroupType, 
 				  typename LightGroupType, 
@@ -60,6 +72,7 @@ namespace hvk
 			const AmbientLight& ambientLight,
 			const GammaSettings& gammaSettings,
 			const PBRWeight& pbrWeight,
+			const GeometryArena& geometry,
 			PBRGroupType& elements,
 			LightGroupType& lights,
 			SpotlightGroupType& spotlights,
@@ -81,6 +94,7 @@ namespace hvk
 		const AmbientLight& ambientLight,
 		const GammaSettings& gammaSettings,
 		const PBRWeight& pbrWeight,
+		const GeometryArena& geometry,
 		PBRGroupType& elements,
 		LightGroupType& lights,
 		SpotlightGroupType& spotlights,
@@ -88,8 +102,6 @@ namespace hvk
 		ShadowViewType& shadowMaps)
 	{
 		 // update lights
-		int memOffset = 0;
-		auto* copyaddr = reinterpret_cast<UniformLightObject<NUM_INITIAL_LIGHTS>*>(mLightsUbo.allocationInfo.pMappedData);
 		auto uboLights = UniformLightObject<NUM_INITIAL_LIGHTS>();
         uboLights.ambient = ambientLight;
 		UniformLight lightUbo = {};
@@ -128,10 +140,10 @@ namespace hvk
 		uboLights.directional.lightIntensity = directionalColor.intensity;
 		uboLights.directional.direction = directionalDirection.direction;
 
-		memcpy(copyaddr, &uboLights, sizeof(uboLights));
+		const uint32_t lightsOffset = UniformRing::push(uboLights);
 
 		// update shadow maps
-		std::vector<VkDescriptorImageInfo> shadowmapWrites;
+		HVK_pmr_vector<VkDescriptorImageInfo> shadowmapWrites(FrameAllocator::getResource());
 		shadowmapWrites.reserve(uboLights.numShadowMaps);
 		shadowMaps.each([&](auto entity, const auto& shadowMap) {
 			shadowmapWrites.push_back(VkDescriptorImageInfo{
@@ -153,7 +165,7 @@ namespace hvk
 		vkCmdSetViewport(mCommandBuffer, 0, 1, &viewport);
 		vkCmdSetScissor(mCommandBuffer, 0, 1, &scissor);
 
-		VkDeviceSize offsets[] = { 0 };
+		VkDeviceSize offsets[] = { 0, 0 };
 
 		// bind lights descriptor set to set 0
 		vkCmdBindDescriptorSets(
@@ -163,8 +175,8 @@ namespace hvk
 			0,
 			1,
 			&mLightsDescriptorSet,
-			0,
-			nullptr);
+			1,
+			&lightsOffset);
 
 		auto viewProj = camera.getProjection() * camera.getViewTransform();
 		UniformBufferObject ubo = {
@@ -174,29 +186,39 @@ namespace hvk
 			camera.getWorldPosition()
 		};
 
+		// All meshes share the arena's buffers; the index buffer is rebound only when the index type changes
+		const VkBuffer vertexBuffers[] = { geometry.getVertexBuffer(0), geometry.getVertexBuffer(1) };
+		vkCmdBindVertexBuffers(mCommandBuffer, 0, 2, vertexBuffers, offsets);
+		VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+		const util::math::Frustum frustum = util::math::getFrustum(viewProj);
+		HVK_pmr_vector<util::cull::IndexRange> visibleRanges(FrameAllocator::getResource());
+
 		// Prepare and draw PBR elements
 		PushConstant push = {};
-		VmaAllocationInfo allocInfo;
-        const auto& allocator = GpuManager::getAllocator();
 		elements.each([&](auto entity, const auto& mesh, const auto& binding, const auto& transform) {
+			// Meshes whose geometry or textures are still streaming in pop in once they arrive
+			if (!UploadQueue::isComplete(mesh.upload) || !UploadQueue::isComplete(binding.upload))
+			{
+				return;
+			}
+
+			const util::cull::ObjectView objectView = util::cull::getObjectView(
+				frustum,
+				transform.transform,
+				camera.getWorldPosition(),
+				true);
+			const glm::vec3 boundsCenter = (mesh.boundsMin + mesh.boundsMax) * 0.5f;
+			if (!util::math::sphereInFrustum(objectView.frustum, boundsCenter, glm::length(mesh.boundsMax - boundsCenter)))
+			{
+				return;
+			}
+
 			// update UBO
-			vmaGetAllocationInfo(allocator, binding.ubo.allocation, &allocInfo);
 			ubo.model = transform.transform;
 			//ubo.modelViewProj = camera.getProjection() * camera.getViewTransform() * ubo.model;
 			ubo.modelViewProj = viewProj * ubo.model;
-			memcpy(allocInfo.pMappedData, &ubo, sizeof(ubo));
-
-			vkCmdBindVertexBuffers(mCommandBuffer, 0, 1, &mesh.vbo.memoryResource, offsets);
-			vkCmdBindIndexBuffer(mCommandBuffer, mesh.ibo.memoryResource, 0, VK_INDEX_TYPE_UINT16);
-			vkCmdBindDescriptorSets(
-				mCommandBuffer,
-				VK_PIPELINE_BIND_POINT_GRAPHICS,
-				mPipelineInfo.pipelineLayout,
-				1,
-				1,
-				&binding.descriptorSet,
-				0,
-				nullptr);
+			const uint32_t uboOffset = UniformRing::push(ubo);
 
 			push.gamma = gammaSettings.gamma;
 			push.sRGBTextures = true;
@@ -208,7 +230,63 @@ namespace hvk
 				0, 
 				sizeof(PushConstant), 
 				&push);
-			vkCmdDrawIndexed(mCommandBuffer, mesh.numIndices, 1, 0, 0, 0);
+			if (mesh.indexType != boundIndexType)
+			{
+				// firstIndex is in units of the mesh's index type, so the buffer offset stays 0
+				vkCmdBindIndexBuffer(mCommandBuffer, geometry.getIndexBuffer(), 0, mesh.indexType);
+				boundIndexType = mesh.indexType;
+			}
+
+			// Submeshes only differ by material, so consecutive ones sharing a set skip the rebind
+			const GeometryRange& range = geometry.getRange(mesh.geometry);
+			uint32_t boundMaterial = UINT32_MAX;
+			for (const auto& submesh : getLodSubmeshes(mesh))
+			{
+				// Meshlets outside the frustum or facing away are dropped, and the ones left that
+				// follow each other in the index buffer are drawn together
+				visibleRanges.clear();
+				if (submesh.meshletCount > 0)
+				{
+					util::cull::appendVisibleRanges(
+						objectView,
+						mesh.meshlets.data() + submesh.firstMeshlet,
+						submesh.meshletCount,
+						visibleRanges);
+					if (visibleRanges.empty())
+					{
+						continue;
+					}
+				}
+				else
+				{
+					visibleRanges.push_back({ submesh.firstIndex, submesh.indexCount });
+				}
+
+				if (submesh.materialIndex != boundMaterial)
+				{
+					vkCmdBindDescriptorSets(
+						mCommandBuffer,
+						VK_PIPELINE_BIND_POINT_GRAPHICS,
+						mPipelineInfo.pipelineLayout,
+						1,
+						1,
+						&binding.descriptorSets[submesh.materialIndex],
+						1,
+						&uboOffset);
+					boundMaterial = submesh.materialIndex;
+				}
+
+				for (const auto& indexRange : visibleRanges)
+				{
+					vkCmdDrawIndexed(
+						mCommandBuffer,
+						indexRange.indexCount,
+						1,
+						range.firstIndex + indexRange.firstIndex,
+						static_cast<int32_t>(range.vertexOffset) + submesh.vertexOffset,
+						0);
+				}
+			}
 		});
 
 		assert(vkEndCommandBuffer(mCommandBuffer) == VK_SUCCESS);
@@ -5,6 +5,7 @@
 
 #include "descriptor-util.h"
 #include "pipeline-util.h"
+#include "memory-util.h"
 #include "image-util.h"
 
 namespace hvk
@@ -61,7 +62,11 @@ namespace hvk
 			1,
 			fontTextWidth,
 			fontTextHeight,
-			bytesPerPixel);
+			bytesPerPixel,
+			VK_IMAGE_TYPE_2D,
+			0,
+			VK_FORMAT_R8G8B8A8_UNORM,
+			util::memory::GpuMemoryCategory::UI);
 
 		/***************
 		 Create descriptor set layout and descriptor pool
@@ -122,10 +127,10 @@ namespace hvk
 		assert(vkCreatePipelineLayout(device, &uiLayoutCreate, nullptr, &mPipelineInfo.pipelineLayout) == VK_SUCCESS);
 
 		mPipelineInfo.vertexInfo = {};
-		mPipelineInfo.vertexInfo.bindingDescription = {};
-		mPipelineInfo.vertexInfo.bindingDescription.binding = 0;
-		mPipelineInfo.vertexInfo.bindingDescription.stride = sizeof(ImDrawVert);
-		mPipelineInfo.vertexInfo.bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		mPipelineInfo.vertexInfo.bindingDescriptions.resize(1);
+		mPipelineInfo.vertexInfo.bindingDescriptions[0].binding = 0;
+		mPipelineInfo.vertexInfo.bindingDescriptions[0].stride = sizeof(ImDrawVert);
+		mPipelineInfo.vertexInfo.bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
 		mPipelineInfo.vertexInfo.attributeDescriptions.resize(3);
 		mPipelineInfo.vertexInfo.attributeDescriptions[0] = {
@@ -153,8 +158,8 @@ namespace hvk
 			VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
 			nullptr,
 			0,
-			1,
-			&mPipelineInfo.vertexInfo.bindingDescription,
+			static_cast<uint32_t>(mPipelineInfo.vertexInfo.bindingDescriptions.size()),
+			mPipelineInfo.vertexInfo.bindingDescriptions.data(),
 			static_cast<uint32_t>(mPipelineInfo.vertexInfo.attributeDescriptions.size()),
 			mPipelineInfo.vertexInfo.attributeDescriptions.data()
 		};
@@ -190,10 +195,10 @@ namespace hvk
 
         vkDestroySampler(device, mFontSampler, nullptr);
         vkDestroyImageView(device, mFontView, nullptr);
-        vmaDestroyImage(allocator, mFontImage.memoryResource, mFontImage.allocation);
+        util::memory::destroyImage(allocator, mFontImage.memoryResource, mFontImage.allocation);
 
-        vmaDestroyBuffer(allocator, mVbo.memoryResource, mVbo.allocation);
-        vmaDestroyBuffer(allocator, mIbo.memoryResource, mIbo.allocation);
+        util::memory::destroyBuffer(allocator, mVbo.memoryResource, mVbo.allocation);
+        util::memory::destroyBuffer(allocator, mIbo.memoryResource, mIbo.allocation);
 
         vkDestroyDescriptorSetLayout(device, mDescriptorSetLayout, nullptr);
         vkDestroyDescriptorPool(device, mDescriptorPool, nullptr);
@@ -236,7 +241,7 @@ namespace hvk
 		uint32_t indexMemorySize = sizeof(ImDrawIdx) * imDrawData->TotalIdxCount;
 		if (vertexMemorySize && indexMemorySize) {
 			if (mVbo.allocationInfo.size < vertexMemorySize) {
-                vmaDestroyBuffer(allocator, mVbo.memoryResource, mVbo.allocation);
+                util::memory::destroyBuffer(allocator, mVbo.memoryResource, mVbo.allocation);
 				VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
 				bufferInfo.size = vertexMemorySize;
 				bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
@@ -244,18 +249,19 @@ namespace hvk
 				VmaAllocationCreateInfo allocCreateInfo = {};
 				allocCreateInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
 				allocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-				vmaCreateBuffer(
+				util::memory::createBuffer(
                     allocator,
 					&bufferInfo,
 					&allocCreateInfo,
 					&mVbo.memoryResource,
 					&mVbo.allocation,
-					&mVbo.allocationInfo);
+					&mVbo.allocationInfo,
+					util::memory::GpuMemoryCategory::UI);
 
 			}
 
 			if (mIbo.allocationInfo.size < indexMemorySize) {
-                vmaDestroyBuffer(allocator, mIbo.memoryResource, mIbo.allocation);
+                util::memory::destroyBuffer(allocator, mIbo.memoryResource, mIbo.allocation);
 				VkBufferCreateInfo iboInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
 				iboInfo.size = indexMemorySize;
 				iboInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
@@ -263,13 +269,14 @@ namespace hvk
 				VmaAllocationCreateInfo indexAllocCreateInfo = {};
 				indexAllocCreateInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
 				indexAllocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-				vmaCreateBuffer(
+				util::memory::createBuffer(
                     allocator,
 					&iboInfo,
 					&indexAllocCreateInfo,
 					&mIbo.memoryResource,
 					&mIbo.allocation,
-					&mIbo.allocationInfo);
+					&mIbo.allocationInfo,
+					util::memory::GpuMemoryCategory::UI);
 
 			}
 
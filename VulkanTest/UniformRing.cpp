@@ -0,0 +1,173 @@
+#include "pch.h"
+#include "UniformRing.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "GpuManager.h"
+#include "memory-util.h"
+#include "descriptor-util.h"
+
+namespace hvk
+{
+	Resource<VkBuffer> UniformRing::sBuffer = {};
+	VkDeviceSize UniformRing::sFrameSize = 0;
+	VkDeviceSize UniformRing::sAlignment = 1;
+	VkDeviceSize UniformRing::sOffset = 0;
+	VkDeviceSize UniformRing::sPeak = 0;
+	uint32_t UniformRing::sFrameIndex = 0;
+	std::vector<UniformRing::BoundDescriptor> UniformRing::sDescriptors;
+	std::vector<char> UniformRing::sOverflow;
+
+	void UniformRing::initialize(VkDeviceSize bytesPerFrame)
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(GpuManager::getPhysicalDevice(), &properties);
+		sAlignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 1);
+
+		createBuffer(bytesPerFrame);
+		sPeak = 0;
+	}
+
+	void UniformRing::createBuffer(VkDeviceSize bytesPerFrame)
+	{
+		// Each region starts on an aligned offset too
+		sFrameSize = (bytesPerFrame + sAlignment - 1) & ~(sAlignment - 1);
+		sOffset = 0;
+		sFrameIndex = 0;
+
+		VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+		bufferInfo.size = sFrameSize * FRAMES_IN_FLIGHT;
+		bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+
+		VmaAllocationCreateInfo allocCreateInfo = {};
+		allocCreateInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+		allocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+		assert(util::memory::createBuffer(
+			GpuManager::getAllocator(),
+			&bufferInfo,
+			&allocCreateInfo,
+			&sBuffer.memoryResource,
+			&sBuffer.allocation,
+			&sBuffer.allocationInfo,
+			util::memory::GpuMemoryCategory::Uniform) == VK_SUCCESS);
+	}
+
+	void UniformRing::destroy()
+	{
+		if (sBuffer.allocation != VK_NULL_HANDLE)
+		{
+			util::memory::destroyBuffer(GpuManager::getAllocator(), sBuffer.memoryResource, sBuffer.allocation);
+		}
+		sBuffer = {};
+		sDescriptors.clear();
+		sOverflow.clear();
+		sOverflow.shrink_to_fit();
+	}
+
+	void UniformRing::beginFrame()
+	{
+		if (sPeak <= sFrameSize)
+		{
+			return;
+		}
+
+		// Leave headroom so a scene that keeps growing doesn't reallocate every frame.
+		// The render fence has been waited on, so the old buffer can go right away
+		const VkDeviceSize newFrameSize = sPeak + sPeak / 2;
+		std::cerr << "Uniform ring overflowed (" << sPeak << " of " << sFrameSize
+			<< " bytes per frame), growing to " << newFrameSize << std::endl;
+
+		util::memory::destroyBuffer(GpuManager::getAllocator(), sBuffer.memoryResource, sBuffer.allocation);
+		sBuffer = {};
+		createBuffer(newFrameSize);
+
+		for (const auto& descriptor : sDescriptors)
+		{
+			writeDescriptor(descriptor);
+		}
+	}
+
+	void UniformRing::nextFrame()
+	{
+		// Memory may not be host coherent, make this frame's writes visible before submit
+		const VkDeviceSize written = std::min(sOffset, sFrameSize);
+		if (written > 0)
+		{
+			vmaFlushAllocation(
+				GpuManager::getAllocator(),
+				sBuffer.allocation,
+				sFrameSize * sFrameIndex,
+				written);
+		}
+
+		sFrameIndex = (sFrameIndex + 1) % FRAMES_IN_FLIGHT;
+		sOffset = 0;
+	}
+
+	void UniformRing::writeDescriptor(const BoundDescriptor& descriptor)
+	{
+		VkDescriptorSet set = descriptor.set;
+		std::vector<VkDescriptorBufferInfo> bufferInfos = { getDescriptorInfo(descriptor.range) };
+		std::vector<VkWriteDescriptorSet> descriptorWrites = {
+			util::descriptor::createDescriptorBufferWrite(
+				bufferInfos,
+				set,
+				descriptor.binding,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) };
+		util::descriptor::writeDescriptorSets(GpuManager::getDevice(), descriptorWrites);
+	}
+
+	void UniformRing::bindDescriptor(const void* owner, VkDescriptorSet set, uint32_t binding, VkDeviceSize range)
+	{
+		sDescriptors.push_back({ owner, set, binding, range });
+		writeDescriptor(sDescriptors.back());
+	}
+
+	void UniformRing::releaseDescriptor(VkDescriptorSet set)
+	{
+		sDescriptors.erase(
+			std::remove_if(sDescriptors.begin(), sDescriptors.end(), [set](const BoundDescriptor& descriptor) {
+				return descriptor.set == set;
+			}),
+			sDescriptors.end());
+	}
+
+	void UniformRing::releaseDescriptors(const void* owner)
+	{
+		sDescriptors.erase(
+			std::remove_if(sDescriptors.begin(), sDescriptors.end(), [owner](const BoundDescriptor& descriptor) {
+				return descriptor.owner == owner;
+			}),
+			sDescriptors.end());
+	}
+
+	UniformAllocation UniformRing::allocate(VkDeviceSize size)
+	{
+		const VkDeviceSize aligned = (size + sAlignment - 1) & ~(sAlignment - 1);
+		const VkDeviceSize regionStart = sFrameSize * sFrameIndex;
+
+		UniformAllocation allocation;
+		if (sOffset + aligned <= sFrameSize)
+		{
+			allocation.offset = static_cast<uint32_t>(regionStart + sOffset);
+			allocation.data = static_cast<char*>(sBuffer.allocationInfo.pMappedData) + regionStart + sOffset;
+		}
+		else
+		{
+			// Writing past the region would clobber a frame the GPU may be reading. The draw
+			// reads stale data from the start of the region for this frame instead, and
+			// the demand recorded in sPeak grows the ring at the next beginFrame()
+			if (sOverflow.size() < aligned)
+			{
+				sOverflow.resize(aligned);
+			}
+			allocation.offset = static_cast<uint32_t>(regionStart);
+			allocation.data = sOverflow.data();
+		}
+
+		sOffset += aligned;
+		sPeak = std::max(sPeak, sOffset);
+		return allocation;
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstring>
+#include <vector>
+
+#include "types.h"
+#include "FrameAllocator.h"
+
+namespace hvk
+{
+	struct UniformAllocation
+	{
+		// Offset from the start of the ring buffer, used as the dynamic descriptor offset
+		uint32_t offset;
+		void* data;
+	};
+
+	// One persistently mapped uniform buffer split into a region per frame in flight.
+	// Per-draw uniforms are bump allocated out of the current frame's region at
+	// minUniformBufferOffsetAlignment and bound through UNIFORM_BUFFER_DYNAMIC
+	// descriptors, so a single descriptor can address any draw's data.
+	// nextFrame() (called from VulkanApp::renderFinish) flushes the region and moves
+	// on, so the CPU never writes into data a frame in flight is still reading.
+	// A frame that asks for more than its region gets scratch memory for the overflow
+	// and the ring is reallocated to fit the scene's demand in beginFrame(), which
+	// rewrites every descriptor registered through bindDescriptor().
+	class UniformRing
+	{
+	public:
+		static constexpr VkDeviceSize DEFAULT_FRAME_SIZE = 1024 * 1024;
+
+	private:
+		static Resource<VkBuffer> sBuffer;
+		static VkDeviceSize sFrameSize;
+		static VkDeviceSize sAlignment;
+		static VkDeviceSize sOffset;
+		static VkDeviceSize sPeak;
+		static uint32_t sFrameIndex;
+
+		struct BoundDescriptor
+		{
+			const void* owner;
+			VkDescriptorSet set;
+			uint32_t binding;
+			VkDeviceSize range;
+		};
+		static std::vector<BoundDescriptor> sDescriptors;
+		// Overflowing allocations are written here so the GPU visible regions stay intact
+		static std::vector<char> sOverflow;
+
+		static void createBuffer(VkDeviceSize bytesPerFrame);
+		static void writeDescriptor(const BoundDescriptor& descriptor);
+
+	public:
+		static void initialize(VkDeviceSize bytesPerFrame);
+		static void destroy();
+		// Called once the render fence has been waited on, so no recorded command
+		// buffer still references the ring or the descriptors pointing into it
+		static void beginFrame();
+		static void nextFrame();
+
+		// Writes a UNIFORM_BUFFER_DYNAMIC descriptor for the ring and keeps it current when the ring grows
+		static void bindDescriptor(const void* owner, VkDescriptorSet set, uint32_t binding, VkDeviceSize range);
+		static void releaseDescriptor(VkDescriptorSet set);
+		static void releaseDescriptors(const void* owner);
+
+		static UniformAllocation allocate(VkDeviceSize size);
+
+		template <typename T>
+		static uint32_t push(const T& data)
+		{
+			UniformAllocation allocation = allocate(sizeof(T));
+			memcpy(allocation.data, &data, sizeof(T));
+			return allocation.offset;
+		}
+
+		static VkBuffer getBuffer() { return sBuffer.memoryResource; }
+		static VkDescriptorBufferInfo getDescriptorInfo(VkDeviceSize range) { return { sBuffer.memoryResource, 0, range }; }
+
+		// May exceed the frame size for a frame that overflowed
+		static VkDeviceSize getBytesUsed() { return sOffset; }
+		static VkDeviceSize getPeakBytesUsed() { return sPeak; }
+		static VkDeviceSize getFrameSize() { return sFrameSize; }
+	};
+}
@@ -0,0 +1,255 @@
+#include "pch.h"
+#include "UploadBatch.h"
+
+#include <cstring>
+
+#include "GpuManager.h"
+#include "StagingRing.h"
+#include "image-util.h"
+#include "memory-util.h"
+
+namespace hvk
+{
+	UploadBatch::UploadBatch() :
+		mOpen(false),
+		mSubmitted(0),
+		mRecording(),
+		mImages(),
+		mBuffers(),
+		mDedicatedStaging()
+	{
+	}
+
+	UploadBatch::~UploadBatch()
+	{
+		assert(!mOpen);
+	}
+
+	void UploadBatch::open()
+	{
+		if (!mOpen)
+		{
+			mRecording = UploadQueue::begin();
+			mOpen = true;
+		}
+	}
+
+	void UploadBatch::stage(const void* data, VkDeviceSize size, VkBuffer& outBuffer, VkDeviceSize& outOffset)
+	{
+		const bool fitsRing = size <= StagingRing::getSize();
+		StagingAllocation allocation;
+		bool staged = fitsRing && StagingRing::allocate(size, allocation);
+		if (fitsRing && !staged)
+		{
+			// This batch's own copies fill the ring; once they're submitted it can wait on them
+			submit();
+			staged = StagingRing::allocate(size, allocation);
+			assert(staged);
+		}
+		open();
+
+		if (staged)
+		{
+			memcpy(allocation.data, data, static_cast<size_t>(size));
+			StagingRing::flush(allocation, size);
+			outBuffer = allocation.buffer;
+			outOffset = allocation.offset;
+			return;
+		}
+
+		RuntimeResource<VkBuffer> staging;
+		VkBufferCreateInfo stagingCreateInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+		stagingCreateInfo.size = size;
+		stagingCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+		VmaAllocationCreateInfo stagingAllocCreateInfo = {};
+		stagingAllocCreateInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+		stagingAllocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+		VmaAllocationInfo stagingAllocationInfo;
+		util::memory::createBuffer(
+			GpuManager::getAllocator(),
+			&stagingCreateInfo,
+			&stagingAllocCreateInfo,
+			&staging.memoryResource,
+			&staging.allocation,
+			&stagingAllocationInfo,
+			util::memory::GpuMemoryCategory::Staging);
+		memcpy(stagingAllocationInfo.pMappedData, data, static_cast<size_t>(size));
+		vmaFlushAllocation(GpuManager::getAllocator(), staging.allocation, 0, size);
+
+		mDedicatedStaging.push_back(staging);
+		outBuffer = staging.memoryResource;
+		outOffset = 0;
+	}
+
+	void UploadBatch::addImage(
+		VkImage image,
+		const void* data,
+		VkDeviceSize size,
+		const std::vector<VkBufferImageCopy>& regions,
+		uint32_t width,
+		uint32_t height,
+		uint32_t numLayers,
+		uint32_t mipLevels,
+		bool blitMips)
+	{
+		VkBuffer source;
+		VkDeviceSize sourceOffset;
+		stage(data, size, source, sourceOffset);
+
+		ImageCopy copy = { image, source, regions, width, height, numLayers, mipLevels, blitMips };
+		for (auto& region : copy.regions)
+		{
+			region.bufferOffset += sourceOffset;
+		}
+		mImages.push_back(std::move(copy));
+	}
+
+	void UploadBatch::addBuffer(
+		VkBuffer buffer,
+		VkDeviceSize offset,
+		const void* data,
+		VkDeviceSize size,
+		VkPipelineStageFlags dstStage,
+		VkAccessFlags dstAccess,
+		bool concurrent)
+	{
+		VkBuffer source;
+		VkDeviceSize sourceOffset;
+		stage(data, size, source, sourceOffset);
+
+		mBuffers.push_back({ buffer, source, { sourceOffset, offset, size }, dstStage, dstAccess, concurrent });
+	}
+
+	void UploadBatch::record()
+	{
+		const VkCommandBuffer transfer = mRecording.transfer;
+
+		std::vector<VkImageMemoryBarrier> toTransfer;
+		toTransfer.reserve(mImages.size());
+		for (const auto& image : mImages)
+		{
+			VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = image.image;
+			barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, image.mipLevels, 0, image.numLayers };
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			toTransfer.push_back(barrier);
+		}
+		if (!toTransfer.empty())
+		{
+			vkCmdPipelineBarrier(
+				transfer,
+				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0,
+				0,
+				nullptr,
+				0,
+				nullptr,
+				static_cast<uint32_t>(toTransfer.size()),
+				toTransfer.data());
+		}
+
+		// Whole levels are copied, which always satisfies the transfer queue's minImageTransferGranularity
+		for (const auto& image : mImages)
+		{
+			vkCmdCopyBufferToImage(
+				transfer,
+				image.source,
+				image.image,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				static_cast<uint32_t>(image.regions.size()),
+				image.regions.data());
+		}
+		for (const auto& buffer : mBuffers)
+		{
+			vkCmdCopyBuffer(transfer, buffer.source, buffer.destination, 1, &buffer.region);
+		}
+
+		// Blits need a graphics queue, so those images are handed over still being written
+		std::vector<UploadQueue::ImageHandoff> imageHandoffs;
+		imageHandoffs.reserve(mImages.size());
+		for (const auto& image : mImages)
+		{
+			if (image.blitMips)
+			{
+				imageHandoffs.push_back({
+					image.image,
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					VK_PIPELINE_STAGE_TRANSFER_BIT,
+					VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+					image.numLayers,
+					image.mipLevels });
+			}
+			else
+			{
+				imageHandoffs.push_back({
+					image.image,
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+					VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+					VK_ACCESS_SHADER_READ_BIT,
+					image.numLayers,
+					image.mipLevels });
+			}
+		}
+
+		std::vector<UploadQueue::BufferHandoff> bufferHandoffs;
+		bufferHandoffs.reserve(mBuffers.size());
+		for (const auto& buffer : mBuffers)
+		{
+			bufferHandoffs.push_back({
+				buffer.destination,
+				buffer.region.dstOffset,
+				buffer.region.size,
+				buffer.dstStage,
+				buffer.dstAccess,
+				buffer.concurrent });
+		}
+		UploadQueue::recordHandoffs(mRecording, imageHandoffs, bufferHandoffs);
+
+		for (const auto& image : mImages)
+		{
+			if (image.blitMips)
+			{
+				util::image::recordMipBlits(
+					mRecording.graphics,
+					image.image,
+					image.width,
+					image.height,
+					image.numLayers,
+					image.mipLevels);
+			}
+		}
+	}
+
+	UploadTicket UploadBatch::getTicket() const
+	{
+		return mOpen ? UploadQueue::getNextTicket() : mSubmitted;
+	}
+
+	UploadTicket UploadBatch::submit()
+	{
+		if (!mOpen)
+		{
+			return mSubmitted;
+		}
+
+		record();
+		mSubmitted = UploadQueue::submit(mRecording, mDedicatedStaging);
+		StagingRing::fence(mSubmitted);
+
+		mImages.clear();
+		mBuffers.clear();
+		mDedicatedStaging.clear();
+		mOpen = false;
+		return mSubmitted;
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <vector>
+
+#include "types.h"
+#include "UploadQueue.h"
+
+namespace hvk
+{
+	// Collects the copies for any number of images and buffers and records them into one
+	// UploadQueue submission: a single barrier moves every image into TRANSFER_DST, the copies
+	// follow, and a single handoff barrier passes everything to the graphics queue.
+	// Source data is copied into the StagingRing as it's added, so the caller's memory can go
+	// straight away; data too large for the ring gets a staging buffer of its own. If the ring
+	// fills up the batch submits what it has and carries on in a new submission.
+	// The batch holds the UploadQueue's recording from the first add until submit(), so
+	// nothing else may upload in between, and it must be submitted before it's destroyed
+	class UploadBatch
+	{
+	private:
+		struct ImageCopy
+		{
+			VkImage image;
+			VkBuffer source;
+			std::vector<VkBufferImageCopy> regions;
+			uint32_t width;
+			uint32_t height;
+			uint32_t numLayers;
+			uint32_t mipLevels;
+			bool blitMips;
+		};
+
+		struct BufferCopy
+		{
+			VkBuffer destination;
+			VkBuffer source;
+			VkBufferCopy region;
+			VkPipelineStageFlags dstStage;
+			VkAccessFlags dstAccess;
+			bool concurrent;
+		};
+
+		bool mOpen;
+		UploadTicket mSubmitted;
+		UploadQueue::Recording mRecording;
+		std::vector<ImageCopy> mImages;
+		std::vector<BufferCopy> mBuffers;
+		std::vector<RuntimeResource<VkBuffer>> mDedicatedStaging;
+
+		void open();
+		void stage(const void* data, VkDeviceSize size, VkBuffer& outBuffer, VkDeviceSize& outOffset);
+		void record();
+
+	public:
+		UploadBatch();
+		~UploadBatch();
+		UploadBatch(const UploadBatch&) = delete;
+		UploadBatch& operator=(const UploadBatch&) = delete;
+
+		// regions' buffer offsets are relative to data. The image must be in UNDEFINED layout and is
+		// left in SHADER_READ_ONLY_OPTIMAL; with blitMips every level below the base is filled from it
+		void addImage(
+			VkImage image,
+			const void* data,
+			VkDeviceSize size,
+			const std::vector<VkBufferImageCopy>& regions,
+			uint32_t width,
+			uint32_t height,
+			uint32_t numLayers,
+			uint32_t mipLevels,
+			bool blitMips);
+		// dstStage and dstAccess are how the buffer is used once the upload completes. An exclusive
+		// buffer changes queue ownership as a whole, so writing part of one that's in use needs it
+		// created with UploadQueue::setConcurrentSharing and concurrent set
+		void addBuffer(
+			VkBuffer buffer,
+			VkDeviceSize offset,
+			const void* data,
+			VkDeviceSize size,
+			VkPipelineStageFlags dstStage,
+			VkAccessFlags dstAccess,
+			bool concurrent);
+
+		// The ticket that covers everything added so far
+		UploadTicket getTicket() const;
+		bool isEmpty() const { return !mOpen; }
+		// Returns the last submission's ticket, or 0 if nothing was added
+		UploadTicket submit();
+	};
+}
@@ -0,0 +1,420 @@
+#include "pch.h"
+#include "UploadQueue.h"
+
+#include <limits>
+#include <stdexcept>
+
+#include "GpuManager.h"
+#include "command-util.h"
+#include "memory-util.h"
+#include "signal-util.h"
+
+namespace hvk
+{
+	uint32_t UploadQueue::sGraphicsFamily = 0;
+	uint32_t UploadQueue::sTransferFamily = 0;
+	VkQueue UploadQueue::sGraphicsQueue = VK_NULL_HANDLE;
+	VkQueue UploadQueue::sTransferQueue = VK_NULL_HANDLE;
+	VkCommandPool UploadQueue::sGraphicsPool = VK_NULL_HANDLE;
+	VkCommandPool UploadQueue::sTransferPool = VK_NULL_HANDLE;
+	std::vector<VkCommandBuffer> UploadQueue::sFreeGraphicsBuffers;
+	std::vector<VkCommandBuffer> UploadQueue::sFreeTransferBuffers;
+	std::vector<VkFence> UploadQueue::sFreeFences;
+	std::vector<VkSemaphore> UploadQueue::sFreeSemaphores;
+	std::deque<UploadQueue::Submission> UploadQueue::sInFlight;
+	bool UploadQueue::sRecording = false;
+	UploadTicket UploadQueue::sLastTicket = 0;
+	UploadTicket UploadQueue::sCompletedTicket = 0;
+
+	void UploadQueue::initialize(
+		uint32_t graphicsFamily,
+		VkQueue graphicsQueue,
+		uint32_t transferFamily,
+		VkQueue transferQueue)
+	{
+		const auto& device = GpuManager::getDevice();
+
+		sGraphicsFamily = graphicsFamily;
+		sGraphicsQueue = graphicsQueue;
+		sTransferFamily = transferFamily;
+		sTransferQueue = transferQueue;
+		sLastTicket = 0;
+		sCompletedTicket = 0;
+
+		// Command buffers are reset one at a time as their uploads retire
+		sGraphicsPool = util::command::createCommandPool(
+			device,
+			graphicsFamily,
+			VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+		if (hasTransferQueue())
+		{
+			sTransferPool = util::command::createCommandPool(
+				device,
+				transferFamily,
+				VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+		}
+	}
+
+	void UploadQueue::destroy()
+	{
+		const auto& device = GpuManager::getDevice();
+
+		// The device is idle by now, so every upload has finished
+		while (!sInFlight.empty())
+		{
+			retire(sInFlight.front());
+			sInFlight.pop_front();
+		}
+
+		for (VkFence fence : sFreeFences)
+		{
+			vkDestroyFence(device, fence, nullptr);
+		}
+		for (VkSemaphore semaphore : sFreeSemaphores)
+		{
+			vkDestroySemaphore(device, semaphore, nullptr);
+		}
+		sFreeFences.clear();
+		sFreeSemaphores.clear();
+		sFreeGraphicsBuffers.clear();
+		sFreeTransferBuffers.clear();
+
+		if (sTransferPool != VK_NULL_HANDLE)
+		{
+			vkDestroyCommandPool(device, sTransferPool, nullptr);
+		}
+		if (sGraphicsPool != VK_NULL_HANDLE)
+		{
+			vkDestroyCommandPool(device, sGraphicsPool, nullptr);
+		}
+		sTransferPool = VK_NULL_HANDLE;
+		sGraphicsPool = VK_NULL_HANDLE;
+	}
+
+	void UploadQueue::setConcurrentSharing(VkBufferCreateInfo& createInfo, uint32_t (&families)[2])
+	{
+		if (!hasTransferQueue())
+		{
+			createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			return;
+		}
+
+		families[0] = sGraphicsFamily;
+		families[1] = sTransferFamily;
+		createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		createInfo.queueFamilyIndexCount = 2;
+		createInfo.pQueueFamilyIndices = families;
+	}
+
+	VkCommandBuffer UploadQueue::acquireCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& freeBuffers)
+	{
+		VkCommandBuffer commandBuffer;
+		if (!freeBuffers.empty())
+		{
+			commandBuffer = freeBuffers.back();
+			freeBuffers.pop_back();
+		}
+		else
+		{
+			VkCommandBufferAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandPool = pool;
+			allocInfo.commandBufferCount = 1;
+			assert(vkAllocateCommandBuffers(GpuManager::getDevice(), &allocInfo, &commandBuffer) == VK_SUCCESS);
+		}
+
+		VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		assert(vkBeginCommandBuffer(commandBuffer, &beginInfo) == VK_SUCCESS);
+		return commandBuffer;
+	}
+
+	VkFence UploadQueue::acquireFence()
+	{
+		if (!sFreeFences.empty())
+		{
+			VkFence fence = sFreeFences.back();
+			sFreeFences.pop_back();
+			return fence;
+		}
+		return util::signal::createFence(GpuManager::getDevice(), static_cast<VkFenceCreateFlagBits>(0));
+	}
+
+	VkSemaphore UploadQueue::acquireSemaphore()
+	{
+		if (!sFreeSemaphores.empty())
+		{
+			VkSemaphore semaphore = sFreeSemaphores.back();
+			sFreeSemaphores.pop_back();
+			return semaphore;
+		}
+		return util::signal::createSemaphore(GpuManager::getDevice());
+	}
+
+	UploadQueue::Recording UploadQueue::begin()
+	{
+		assert(!sRecording);
+		sRecording = true;
+
+		Recording recording;
+		recording.graphics = acquireCommandBuffer(sGraphicsPool, sFreeGraphicsBuffers);
+		recording.transfer = hasTransferQueue() ?
+			acquireCommandBuffer(sTransferPool, sFreeTransferBuffers) :
+			recording.graphics;
+		return recording;
+	}
+
+	UploadTicket UploadQueue::submit(
+		const Recording& recording,
+		const std::vector<RuntimeResource<VkBuffer>>& stagingBuffers)
+	{
+		assert(sRecording);
+		sRecording = false;
+
+		Submission submission = {};
+		submission.ticket = ++sLastTicket;
+		submission.recording = recording;
+		submission.stagingBuffers = stagingBuffers;
+
+		VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+		submitInfo.commandBufferCount = 1;
+		if (hasTransferQueue())
+		{
+			assert(vkEndCommandBuffer(recording.transfer) == VK_SUCCESS);
+			assert(vkEndCommandBuffer(recording.graphics) == VK_SUCCESS);
+
+			// The acquire half waits in update() until this fence says the copy is done
+			submission.transferFence = acquireFence();
+			submission.transferDone = acquireSemaphore();
+			submitInfo.pCommandBuffers = &recording.transfer;
+			submitInfo.signalSemaphoreCount = 1;
+			submitInfo.pSignalSemaphores = &submission.transferDone;
+			assert(vkQueueSubmit(sTransferQueue, 1, &submitInfo, submission.transferFence) == VK_SUCCESS);
+		}
+		else
+		{
+			assert(vkEndCommandBuffer(recording.graphics) == VK_SUCCESS);
+
+			submission.graphicsFence = acquireFence();
+			submitInfo.pCommandBuffers = &recording.graphics;
+			assert(vkQueueSubmit(sGraphicsQueue, 1, &submitInfo, submission.graphicsFence) == VK_SUCCESS);
+			submission.acquireSubmitted = true;
+		}
+
+		sInFlight.push_back(std::move(submission));
+		return sLastTicket;
+	}
+
+	void UploadQueue::submitAcquire(Submission& submission)
+	{
+		// The semaphore has already signalled, it's only waited on for the memory dependency
+		const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		submission.graphicsFence = acquireFence();
+
+		VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores = &submission.transferDone;
+		submitInfo.pWaitDstStageMask = &waitStage;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &submission.recording.graphics;
+		assert(vkQueueSubmit(sGraphicsQueue, 1, &submitInfo, submission.graphicsFence) == VK_SUCCESS);
+		submission.acquireSubmitted = true;
+	}
+
+	void UploadQueue::retire(Submission& submission)
+	{
+		const auto& device = GpuManager::getDevice();
+		const auto& allocator = GpuManager::getAllocator();
+
+		for (const auto& staging : submission.stagingBuffers)
+		{
+			util::memory::destroyBuffer(allocator, staging.memoryResource, staging.allocation);
+		}
+
+		vkResetCommandBuffer(submission.recording.graphics, 0);
+		sFreeGraphicsBuffers.push_back(submission.recording.graphics);
+		for (VkFence fence : { submission.transferFence, submission.graphicsFence })
+		{
+			if (fence != VK_NULL_HANDLE)
+			{
+				vkResetFences(device, 1, &fence);
+				sFreeFences.push_back(fence);
+			}
+		}
+		if (hasTransferQueue())
+		{
+			vkResetCommandBuffer(submission.recording.transfer, 0);
+			sFreeTransferBuffers.push_back(submission.recording.transfer);
+			// Waited on by the acquire, so it's unsignalled again
+			sFreeSemaphores.push_back(submission.transferDone);
+		}
+
+		sCompletedTicket = submission.ticket;
+	}
+
+	void UploadQueue::recordHandoffs(
+		const Recording& recording,
+		const std::vector<ImageHandoff>& images,
+		const std::vector<BufferHandoff>& buffers)
+	{
+		if (images.empty() && buffers.empty())
+		{
+			return;
+		}
+
+		// Without a transfer queue these are plain barriers; otherwise the same barriers are
+		// recorded twice, as the release on the transfer queue and the acquire on the graphics
+		// queue, and must match apart from their access masks. The layout changes once, between them
+		const bool handoff = hasTransferQueue();
+		const uint32_t srcFamily = handoff ? sTransferFamily : VK_QUEUE_FAMILY_IGNORED;
+		const uint32_t dstFamily = handoff ? sGraphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+
+		VkPipelineStageFlags dstStages = 0;
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+		imageBarriers.reserve(images.size());
+		for (const auto& image : images)
+		{
+			VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+			barrier.oldLayout = image.oldLayout;
+			barrier.newLayout = image.newLayout;
+			barrier.srcQueueFamilyIndex = srcFamily;
+			barrier.dstQueueFamilyIndex = dstFamily;
+			barrier.image = image.image;
+			barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, image.mipLevels, 0, image.numLayers };
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = handoff ? 0 : image.dstAccess;
+			imageBarriers.push_back(barrier);
+			dstStages |= image.dstStage;
+		}
+
+		// Concurrent buffers aren't released; the semaphore the acquire waits on already makes the
+		// copies available, and their barrier on the graphics queue makes them visible
+		std::vector<VkBufferMemoryBarrier> bufferBarriers;
+		std::vector<VkAccessFlags> bufferDstAccess;
+		std::vector<VkBufferMemoryBarrier> concurrentBarriers;
+		bufferBarriers.reserve(buffers.size());
+		bufferDstAccess.reserve(buffers.size());
+		for (const auto& buffer : buffers)
+		{
+			VkBufferMemoryBarrier barrier = { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+			barrier.srcQueueFamilyIndex = srcFamily;
+			barrier.dstQueueFamilyIndex = dstFamily;
+			barrier.buffer = buffer.buffer;
+			barrier.offset = buffer.offset;
+			barrier.size = buffer.size;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = handoff ? 0 : buffer.dstAccess;
+			dstStages |= buffer.dstStage;
+			if (handoff && buffer.concurrent)
+			{
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = buffer.dstAccess;
+				concurrentBarriers.push_back(barrier);
+			}
+			else
+			{
+				bufferBarriers.push_back(barrier);
+				bufferDstAccess.push_back(buffer.dstAccess);
+			}
+		}
+
+		if (!bufferBarriers.empty() || !imageBarriers.empty())
+		{
+			vkCmdPipelineBarrier(
+				recording.transfer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				handoff ? static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT) : dstStages,
+				0,
+				0,
+				nullptr,
+				static_cast<uint32_t>(bufferBarriers.size()),
+				bufferBarriers.data(),
+				static_cast<uint32_t>(imageBarriers.size()),
+				imageBarriers.data());
+		}
+		if (!handoff)
+		{
+			return;
+		}
+
+		for (size_t i = 0; i < images.size(); ++i)
+		{
+			imageBarriers[i].srcAccessMask = 0;
+			imageBarriers[i].dstAccessMask = images[i].dstAccess;
+		}
+		for (size_t i = 0; i < bufferBarriers.size(); ++i)
+		{
+			bufferBarriers[i].srcAccessMask = 0;
+			bufferBarriers[i].dstAccessMask = bufferDstAccess[i];
+		}
+		bufferBarriers.insert(bufferBarriers.end(), concurrentBarriers.begin(), concurrentBarriers.end());
+		vkCmdPipelineBarrier(
+			recording.graphics,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			dstStages,
+			0,
+			0,
+			nullptr,
+			static_cast<uint32_t>(bufferBarriers.size()),
+			bufferBarriers.data(),
+			static_cast<uint32_t>(imageBarriers.size()),
+			imageBarriers.data());
+	}
+
+	void UploadQueue::update()
+	{
+		const auto& device = GpuManager::getDevice();
+
+		// Transfers finish in submission order, so the first unfinished one ends the scan
+		for (auto& submission : sInFlight)
+		{
+			if (submission.acquireSubmitted)
+			{
+				continue;
+			}
+			if (vkGetFenceStatus(device, submission.transferFence) != VK_SUCCESS)
+			{
+				break;
+			}
+			submitAcquire(submission);
+		}
+
+		while (!sInFlight.empty() &&
+			sInFlight.front().acquireSubmitted &&
+			vkGetFenceStatus(device, sInFlight.front().graphicsFence) == VK_SUCCESS)
+		{
+			retire(sInFlight.front());
+			sInFlight.pop_front();
+		}
+	}
+
+	void UploadQueue::wait(UploadTicket ticket)
+	{
+		// An open batch's ticket would never complete, so waiting on it can only hang
+		if (ticket > sLastTicket)
+		{
+			throw std::runtime_error("Waited on an upload that hasn't been submitted");
+		}
+		const auto& device = GpuManager::getDevice();
+		const uint64_t forever = std::numeric_limits<uint64_t>::max();
+
+		while (!isComplete(ticket))
+		{
+			if (sInFlight.empty())
+			{
+				throw std::runtime_error("Waited on an upload that isn't in flight");
+			}
+			Submission& submission = sInFlight.front();
+			if (!submission.acquireSubmitted)
+			{
+				vkWaitForFences(device, 1, &submission.transferFence, VK_TRUE, forever);
+				submitAcquire(submission);
+			}
+			vkWaitForFences(device, 1, &submission.graphicsFence, VK_TRUE, forever);
+			retire(submission);
+			sInFlight.pop_front();
+		}
+	}
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "types.h"
+
+namespace hvk
+{
+	// Records copies into device local resources and submits them without waiting.
+	// When the device has a queue family with transfer but no graphics support, the copies
+	// run there and exclusive resources are released to the graphics family; the matching
+	// acquire is only submitted once the copy's fence has signalled, so the graphics queue
+	// never waits on a transfer. Without one, both halves go into one graphics submission.
+	// Recording, submission and update() are main thread only
+	class UploadQueue
+	{
+	public:
+		struct Recording
+		{
+			// Copies out of staging memory; on the transfer queue when there is one
+			VkCommandBuffer transfer;
+			// Ownership acquires and anything that needs a graphics queue, like mip blits.
+			// The same command buffer as transfer when there is no separate queue
+			VkCommandBuffer graphics;
+		};
+
+		// Hands an exclusive image written by the transfer commands over to the graphics
+		// queue, moving it from oldLayout to newLayout. dstStage and dstAccess are how it's used next
+		struct ImageHandoff
+		{
+			VkImage image;
+			VkImageLayout oldLayout;
+			VkImageLayout newLayout;
+			VkPipelineStageFlags dstStage;
+			VkAccessFlags dstAccess;
+			uint32_t numLayers;
+			uint32_t mipLevels;
+		};
+
+		// A concurrent buffer is shared by both families, so it only gets a barrier on the graphics
+		// queue; ownership of an exclusive one covers the whole buffer, so the range must be all of it
+		// or the graphics queue must not be using the rest
+		struct BufferHandoff
+		{
+			VkBuffer buffer;
+			VkDeviceSize offset;
+			VkDeviceSize size;
+			VkPipelineStageFlags dstStage;
+			VkAccessFlags dstAccess;
+			bool concurrent;
+		};
+
+	private:
+		struct Submission
+		{
+			UploadTicket ticket;
+			Recording recording;
+			VkFence transferFence;
+			VkFence graphicsFence;
+			VkSemaphore transferDone;
+			bool acquireSubmitted;
+			std::vector<RuntimeResource<VkBuffer>> stagingBuffers;
+		};
+
+		static uint32_t sGraphicsFamily;
+		static uint32_t sTransferFamily;
+		static VkQueue sGraphicsQueue;
+		static VkQueue sTransferQueue;
+		static VkCommandPool sGraphicsPool;
+		static VkCommandPool sTransferPool;
+		static std::vector<VkCommandBuffer> sFreeGraphicsBuffers;
+		static std::vector<VkCommandBuffer> sFreeTransferBuffers;
+		static std::vector<VkFence> sFreeFences;
+		static std::vector<VkSemaphore> sFreeSemaphores;
+		// In submission order, which is also completion order
+		static std::deque<Submission> sInFlight;
+		static bool sRecording;
+		static UploadTicket sLastTicket;
+		static UploadTicket sCompletedTicket;
+
+		static VkCommandBuffer acquireCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& freeBuffers);
+		static VkFence acquireFence();
+		static VkSemaphore acquireSemaphore();
+		static void submitAcquire(Submission& submission);
+		static void retire(Submission& submission);
+
+	public:
+		static void initialize(
+			uint32_t graphicsFamily,
+			VkQueue graphicsQueue,
+			uint32_t transferFamily,
+			VkQueue transferQueue);
+		static void destroy();
+
+		static bool hasTransferQueue() { return sTransferFamily != sGraphicsFamily; }
+		static uint32_t getGraphicsFamily() { return sGraphicsFamily; }
+		static uint32_t getTransferFamily() { return sTransferFamily; }
+		// Fills a create info's sharing mode so both families may use the buffer at once without
+		// ownership transfers. Exclusive when there's only one family. families must outlive the create
+		static void setConcurrentSharing(VkBufferCreateInfo& createInfo, uint32_t (&families)[2]);
+
+		// Only one recording may be open at a time
+		static Recording begin();
+		// The ticket the open recording will be submitted as
+		static UploadTicket getNextTicket() { return sLastTicket + 1; }
+		// Staging buffers are destroyed once the upload has completed
+		static UploadTicket submit(
+			const Recording& recording,
+			const std::vector<RuntimeResource<VkBuffer>>& stagingBuffers);
+
+		// Records every handoff as one barrier per queue, waiting on the union of their stages
+		static void recordHandoffs(
+			const Recording& recording,
+			const std::vector<ImageHandoff>& images,
+			const std::vector<BufferHandoff>& buffers);
+
+		// Submits acquires for finished transfers and retires finished uploads. Called once per
+		// frame before drawing, so anything reported complete can be used by that frame
+		static void update();
+		static bool isComplete(UploadTicket ticket) { return ticket <= sCompletedTicket; }
+		// Blocks until ticket completes, waiting on its own fences rather than idling the queues.
+		// Throws for a ticket that hasn't been submitted yet
+		static void wait(UploadTicket ticket);
+
+		static size_t getInFlightCount() { return sInFlight.size(); }
+	};
+}
@@ -11,12 +11,15 @@
 #include "HvkUtil.h"
 #include "renderpass-util.h"
 #include "image-util.h"
+#include "memory-util.h"
 #include "command-util.h"
 #include "framebuffer-util.h"
 #include "Camera.h"
 #include "LightTypes.h"
 #include "ShadowGenerator.h"
 #include "math-util.h"
+#include "FrameAllocator.h"
+#include "MemoryStats.h"
 
 const uint32_t HEIGHT = 1024;
 const uint32_t WIDTH = 1024;
@@ -50,7 +53,11 @@ std::vector<const char*> getRequiredExtensions() {
 namespace hvk
 {
 
-    UserApp::UserApp(uint32_t windowWidth, uint32_t windowHeight, const char* windowTitle) :
+    UserApp::UserApp(
+        uint32_t windowWidth,
+        uint32_t windowHeight,
+        const char* windowTitle,
+        VertexEncoding meshEncoding) :
         mWindowWidth(windowWidth),
         mWindowHeight(windowHeight),
         mWindowTitle(windowTitle),
@@ -88,6 +95,7 @@ namespace hvk
         mPBRWeight(),
         mExposureSettings(),
         mSkySettings(),
+        mLodSettings(),
         mCamera(nullptr),
         mAmbientLight{glm::vec3(1.f), 0.3f},
         mSceneEntity(mRegistry.create()),
@@ -129,7 +137,7 @@ namespace hvk
         // must init InputManager after we've created an ImGui context
         hvk::InputManager::init(mWindow);
 
-        mApp->init(mVulkanInstance, mWindowSurface);
+        mApp->init(mVulkanInstance, mWindowSurface, meshEncoding);
 
         // Create swapchain
         assert(createSwapchain(
@@ -159,6 +167,8 @@ namespace hvk
 		mExposureSettings = { 1.0 };
 		// Initialize sky settings
 		mSkySettings = { 2.2f, 2.f };
+		// Initialize level of detail settings
+		mLodSettings = { 1.f, 0.25f };
 
         //// Create cubemap for skybox and environmental mapping
         //std::array<std::string, 6> skyboxFiles = {
@@ -203,7 +213,8 @@ namespace hvk
             GpuManager::getCommandPool(),
 			mPrefilteredMap,
 			mIrradianceMap,
-			mBrdfLutMap);
+			mBrdfLutMap,
+			mApp->getModelPipeline().getVertexEncoding());
 
 		mUiRenderer = std::make_shared<UiDrawGenerator>(
             mFinalRenderPass, 
@@ -386,13 +397,14 @@ namespace hvk
         VmaAllocationCreateInfo depthImageAllocationCreate = {};
         depthImageAllocationCreate.usage = VMA_MEMORY_USAGE_GPU_ONLY;
 
-        vmaCreateImage(
+        util::memory::createImage(
             GpuManager::getAllocator(),
             &depthImageCreate,
             &depthImageAllocationCreate,
             &mPBRDepthImage.memoryResource,
             &mPBRDepthImage.allocation,
-            nullptr);
+            nullptr,
+            util::memory::GpuMemoryCategory::RenderTarget);
 
 		mPBRDepthView = util::image::createImageView(
             GpuManager::getDevice(),
@@ -669,7 +681,7 @@ namespace hvk
 		const auto& allocator = GpuManager::getAllocator();
 
 		vkDestroyImageView(device, mPBRDepthView, nullptr);
-		vmaDestroyImage(allocator, mPBRDepthImage.memoryResource, mPBRDepthImage.allocation);
+		util::memory::destroyImage(allocator, mPBRDepthImage.memoryResource, mPBRDepthImage.allocation);
 
         // destroy final framebuffers and renderpass
 		for (auto& imageView : mSwapchainViews)
@@ -690,10 +702,56 @@ namespace hvk
 		vkDestroySwapchainKHR(device, mSwapchain.swapchain, nullptr);
 	}
 
+    void UserApp::selectMeshLods()
+    {
+        // Pixels one object space unit covers at a distance of one, from the vertical field of view
+        const float pixelsPerUnit = mSwapchain.swapchainExtent.height * mCamera->getProjection()[1][1] * 0.5f;
+        const glm::vec3 cameraPosition = mCamera->getWorldPosition();
+        const float refineAbove = mLodSettings.pixelError * (1.f + mLodSettings.hysteresis);
+        const float coarsenBelow = mLodSettings.pixelError * (1.f - mLodSettings.hysteresis);
+
+        auto lodView = mRegistry.view<PBRMesh, WorldTransform>();
+        lodView.each([&](auto entity, auto& mesh, const auto& transform) {
+            if (mesh.lods.empty())
+            {
+                return;
+            }
+
+            // Distance to the nearest point of the mesh's bounding sphere, using its largest scale
+            // so neither the distance nor the error are ever underestimated
+            const glm::mat4& world = transform.transform;
+            const float scale = std::max(
+                glm::length(glm::vec3(world[0])),
+                std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+            const glm::vec3 center = glm::vec3(world * glm::vec4((mesh.boundsMin + mesh.boundsMax) * 0.5f, 1.f));
+            const float radius = glm::length(mesh.boundsMax - mesh.boundsMin) * 0.5f * scale;
+            const float distance = std::max(glm::distance(center, cameraPosition) - radius, mCamera->getNear());
+            const float pixelsPerError = scale * pixelsPerUnit / distance;
+
+            // Levels only change once their projected error is clear of the threshold, so a mesh
+            // sitting at a switching distance doesn't flip between two levels every frame
+            const uint32_t lodCount = static_cast<uint32_t>(mesh.lods.size());
+            uint32_t lod = std::min(mesh.lod, lodCount);
+            while (lod > 0 && mesh.lods[lod - 1].error * pixelsPerError > refineAbove)
+            {
+                --lod;
+            }
+            while (lod < lodCount && mesh.lods[lod].error * pixelsPerError <= coarsenBelow)
+            {
+                ++lod;
+            }
+            mesh.lod = lod;
+        });
+    }
+
     void UserApp::drawFrame(double frametime)
     {
+        MemoryTagScope tagScope(MemoryTag::Render);
         uint32_t swapIndex = mApp->renderPrepare(mSwapchain.swapchain);
 
+        // Shadow maps draw the same levels as the camera
+        selectMeshLods();
+
         // prepare shadow render pass
         VkRect2D shadowScissor = {
             {0, 0},
@@ -722,7 +780,6 @@ namespace hvk
             &shadowClear
         };
 
-        std::vector<VkCommandBuffer> shadowCommandBuffers;
         auto shadowableGroup = mRegistry.group<>(entt::get<PBRMesh, ShadowBinding, WorldTransform>);
         auto lightCameraGroup = mRegistry.group<>(entt::get<WorldTransform, Projection, ShadowCaster>);
         //shadowCommandBuffers.reserve(lightCameraGroup.size());
@@ -736,14 +793,13 @@ namespace hvk
             const auto& lightCamera = mRegistry.get<WorldTransform, Projection>(entity);
             auto& shadowMap = mRegistry.get<ShadowCaster>(entity);
             mApp->renderpassExecuteAndClose(
-                {
-					mShadowRenderer->drawElements(
-						shadowInheritanceInfo,
-						shadowViewport,
-						shadowScissor,
-						lightCamera,
-						shadowableGroup)
-				}
+				mShadowRenderer->drawElements(
+					shadowInheritanceInfo,
+					shadowViewport,
+					shadowScissor,
+					lightCamera,
+					mApp->getModelPipeline().getMeshArena(),
+					shadowableGroup)
             );
             // copy shadow map from framebuffer to texture image
             util::image::framebufferImageToTexture(
@@ -793,7 +849,7 @@ namespace hvk
         };
 
         auto pbrInheritanceInfo = mApp->renderpassBegin(pbrRenderBegin);
-        std::vector<VkCommandBuffer> pbrCommandBuffers;
+        HVK_pmr_vector<VkCommandBuffer> pbrCommandBuffers(FrameAllocator::getResource());
         //pbrCommandBuffers.push_back(mPBRMeshRenderer->drawEl)
         auto pbrGroup = mRegistry.group<>(entt::get<PBRMesh, PBRBinding, WorldTransform>);
         auto lightGroup = mRegistry.group<>(entt::get<LightColor, LightAttenuation, WorldTransform>, entt::exclude<SpotLight>);
@@ -808,6 +864,7 @@ namespace hvk
             mAmbientLight,
             mGammaSettings,
             mPBRWeight,
+            mApp->getModelPipeline().getMeshArena(),
             pbrGroup,
             lightGroup,
             spotlightGroup,
@@ -820,6 +877,7 @@ namespace hvk
             viewport,
             scissor,
             *mCamera,
+            mApp->getModelPipeline().getDebugArena(),
             debugGroup));
 
         if (pbrCommandBuffers.size())
@@ -838,7 +896,7 @@ namespace hvk
             clearValues.data()
         };
         auto finalInheritanceInfo = mApp->renderpassBegin(finalRenderBegin);
-        std::vector<VkCommandBuffer> finalCommandBuffers;
+        HVK_pmr_vector<VkCommandBuffer> finalCommandBuffers(FrameAllocator::getResource());
         finalCommandBuffers.push_back(mQuadRenderer->drawFrame(
             finalInheritanceInfo,
             mSwapFramebuffers[swapIndex],
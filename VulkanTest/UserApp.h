@@ -9,6 +9,7 @@
 
 #include "Clock.h"
 #include "HvkUtil.h"
+#include "VertexEncoding.h"
 #include "CubemapGenerator.h"
 #include "entt/entt.hpp"
 #include "math-util.h"
@@ -36,6 +37,7 @@ namespace hvk
 	struct PBRWeight;
 	struct ExposureSettings;
 	struct SkySettings;
+	struct LodSettings;
 	struct Swapchain;
 	class Camera;
 }
@@ -85,6 +87,7 @@ namespace hvk
 		PBRWeight mPBRWeight;
 		ExposureSettings mExposureSettings;
 		SkySettings mSkySettings;
+		LodSettings mLodSettings;
 		std::shared_ptr<Camera> mCamera;
 		AmbientLight mAmbientLight;
 		entt::entity mSceneEntity;
@@ -98,6 +101,7 @@ namespace hvk
 		void createSwapFramebuffers();
         void createShadowRenderPass();
 		void createShadowFramebuffer();
+        void selectMeshLods();
         void drawFrame(double frametime);
 		void cleanupSwapchain();
 		void recreateSwapchain();
@@ -110,7 +114,12 @@ namespace hvk
 		virtual void close() = 0;
 
 	public:
-		UserApp(uint32_t windowWidth, uint32_t windowHeight, const char* windowTitle);
+		// meshEncoding is the vertex layout every mesh is imported in
+		UserApp(
+			uint32_t windowWidth,
+			uint32_t windowHeight,
+			const char* windowTitle,
+			VertexEncoding meshEncoding = VertexEncoding::Full);
 		virtual ~UserApp();
 
 		void runApp();
@@ -1,4 +1,5 @@
 C:/VulkanSDK/1.1.126.0/Bin/glslangValidator.exe -o shaders/compiled/vert.spv -V shaders/shader.vert
+C:/VulkanSDK/1.1.126.0/Bin/glslangValidator.exe -o shaders/compiled/vert_packed.spv -V shaders/shader_packed.vert
 C:/VulkanSDK/1.1.126.0/Bin/glslangValidator.exe -o shaders/compiled/frag.spv -V shaders/shader.frag
 C:/VulkanSDK/1.1.126.0/Bin/glslangValidator.exe -o shaders/compiled/normal_v.spv -V shaders/normal.vert
 C:/VulkanSDK/1.1.126.0/Bin/glslangValidator.exe -o shaders/compiled/normal_f.spv -V shaders/normal.frag
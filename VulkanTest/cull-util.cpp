@@ -0,0 +1,70 @@
+#include "pch.h"
+#include "cull-util.h"
+
+namespace hvk
+{
+	namespace util
+	{
+		namespace cull
+		{
+			ObjectView getObjectView(
+				const math::Frustum& worldFrustum,
+				const glm::mat4& worldTransform,
+				const glm::vec3& worldViewPosition,
+				bool cullBackfaces)
+			{
+				// Testing in object space keeps both tests exact under non-uniform scale
+				ObjectView view;
+				view.frustum = math::transformFrustum(worldFrustum, worldTransform);
+				view.viewPosition = glm::vec3(glm::inverse(worldTransform) * glm::vec4(worldViewPosition, 1.f));
+				view.cullBackfaces = cullBackfaces && glm::determinant(glm::mat3(worldTransform)) > 0.f;
+				return view;
+			}
+
+			bool isMeshletVisible(const ObjectView& view, const Meshlet& meshlet)
+			{
+				if (!math::sphereInFrustum(view.frustum, meshlet.center, meshlet.radius))
+				{
+					return false;
+				}
+				if (view.cullBackfaces && meshlet.coneCutoff < 1.f)
+				{
+					const glm::vec3 toApex = meshlet.coneApex - view.viewPosition;
+					const float distance = glm::length(toApex);
+					if (distance > 0.f && glm::dot(toApex, meshlet.coneAxis) > meshlet.coneCutoff * distance)
+					{
+						return false;
+					}
+				}
+				return true;
+			}
+
+			void appendVisibleRanges(
+				const ObjectView& view,
+				const Meshlet* meshlets,
+				uint32_t meshletCount,
+				HVK_pmr_vector<IndexRange>& outRanges)
+			{
+				const size_t firstRange = outRanges.size();
+				for (uint32_t i = 0; i < meshletCount; ++i)
+				{
+					const Meshlet& meshlet = meshlets[i];
+					if (!isMeshletVisible(view, meshlet))
+					{
+						continue;
+					}
+					if (outRanges.size() > firstRange)
+					{
+						IndexRange& last = outRanges.back();
+						if (last.firstIndex + last.indexCount == meshlet.firstIndex)
+						{
+							last.indexCount += meshlet.indexCount;
+							continue;
+						}
+					}
+					outRanges.push_back({ meshlet.firstIndex, meshlet.indexCount });
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "HvkUtil.h"
+#include "MeshletBuilder.h"
+#include "math-util.h"
+
+namespace hvk
+{
+	namespace util
+	{
+		namespace cull
+		{
+			// A view moved into one object's space, where its meshlet bounds are
+			struct ObjectView
+			{
+				math::Frustum frustum;
+				glm::vec3 viewPosition;
+				bool cullBackfaces;
+			};
+
+			// A run of indices to draw, relative to the mesh's arena range
+			struct IndexRange
+			{
+				uint32_t firstIndex;
+				uint32_t indexCount;
+			};
+
+			// Meshlets only face away from the view by their winding, so backfaces aren't culled for
+			// a view without a position to face from (pass false) or a transform that mirrors the mesh
+			ObjectView getObjectView(
+				const math::Frustum& worldFrustum,
+				const glm::mat4& worldTransform,
+				const glm::vec3& worldViewPosition,
+				bool cullBackfaces);
+
+			bool isMeshletVisible(const ObjectView& view, const Meshlet& meshlet);
+
+			// Appends the index ranges of a submesh's visible meshlets, merging neighbours into one draw
+			void appendVisibleRanges(
+				const ObjectView& view,
+				const Meshlet* meshlets,
+				uint32_t meshletCount,
+				HVK_pmr_vector<IndexRange>& outRanges);
+		}
+	}
+}
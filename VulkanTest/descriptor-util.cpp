@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "descriptor-util.h"
 
+#include <algorithm>
+
 
 namespace hvk
 {
@@ -39,11 +41,12 @@ namespace hvk
 			VkDescriptorSetLayoutBinding generateUboLayoutBinding(
 				uint32_t binding,
 				uint32_t descriptorCount,
-				VkShaderStageFlags flags)
+				VkShaderStageFlags flags,
+				VkDescriptorType type)
 			{
 				return VkDescriptorSetLayoutBinding {
 					binding,
-					VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+					type,
 					descriptorCount,
 					flags,
 					nullptr
@@ -84,7 +87,8 @@ namespace hvk
 			VkWriteDescriptorSet createDescriptorBufferWrite(
 				std::vector<VkDescriptorBufferInfo>& bufferInfos,
 				VkDescriptorSet& descriptorSet,
-				uint32_t binding)
+				uint32_t binding,
+				VkDescriptorType type)
 			{
 				return VkWriteDescriptorSet{
 					VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
@@ -93,7 +97,7 @@ namespace hvk
 					binding,
 					0,
 					static_cast<uint32_t>(bufferInfos.size()),
-					VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+					type,
 					nullptr,
 					bufferInfos.data(),
 					nullptr
@@ -133,6 +137,161 @@ namespace hvk
 					nullptr
 				);
 			}
+
+
+			DescriptorAllocator::DescriptorAllocator() :
+				mDevice(VK_NULL_HANDLE),
+				mLayout(VK_NULL_HANDLE),
+				mPoolSizes(),
+				mSetsPerPool(0),
+				mUsedPools(),
+				mFreePools(),
+				mCurrentPool(VK_NULL_HANDLE),
+				mAllocatedSets(0),
+				mRetiredSets(),
+				mFreeSets()
+			{
+
+			}
+
+
+			DescriptorAllocator::~DescriptorAllocator()
+			{
+				assert(mUsedPools.empty() && mFreePools.empty());
+			}
+
+
+			void DescriptorAllocator::init(
+				VkDevice device,
+				VkDescriptorSetLayout layout,
+				const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+				uint32_t setsPerPool)
+			{
+				assert(setsPerPool > 0);
+				mDevice = device;
+				mLayout = layout;
+				mSetsPerPool = setsPerPool;
+
+				mPoolSizes.clear();
+				for (const auto& binding : bindings)
+				{
+					auto it = std::find_if(mPoolSizes.begin(), mPoolSizes.end(), [&](const VkDescriptorPoolSize& size) {
+						return size.type == binding.descriptorType;
+					});
+					if (it == mPoolSizes.end())
+					{
+						mPoolSizes.push_back({ binding.descriptorType, 0 });
+						it = mPoolSizes.end() - 1;
+					}
+					it->descriptorCount += binding.descriptorCount * setsPerPool;
+				}
+			}
+
+
+			void DescriptorAllocator::destroy()
+			{
+				for (auto pool : mUsedPools)
+				{
+					vkDestroyDescriptorPool(mDevice, pool, nullptr);
+				}
+				for (auto pool : mFreePools)
+				{
+					vkDestroyDescriptorPool(mDevice, pool, nullptr);
+				}
+				mUsedPools.clear();
+				mFreePools.clear();
+				mCurrentPool = VK_NULL_HANDLE;
+				mAllocatedSets = 0;
+				mRetiredSets.clear();
+				mFreeSets.clear();
+			}
+
+
+			VkDescriptorPool DescriptorAllocator::grabPool()
+			{
+				VkDescriptorPool pool = VK_NULL_HANDLE;
+				if (!mFreePools.empty())
+				{
+					pool = mFreePools.back();
+					mFreePools.pop_back();
+				}
+				else
+				{
+					createDescriptorPool(mDevice, mPoolSizes, mSetsPerPool, pool);
+				}
+				mUsedPools.push_back(pool);
+				return pool;
+			}
+
+
+			VkDescriptorSet DescriptorAllocator::allocate()
+			{
+				if (!mFreeSets.empty())
+				{
+					VkDescriptorSet descriptorSet = mFreeSets.back();
+					mFreeSets.pop_back();
+					++mAllocatedSets;
+					return descriptorSet;
+				}
+
+				if (mCurrentPool == VK_NULL_HANDLE)
+				{
+					mCurrentPool = grabPool();
+				}
+
+				VkDescriptorSetAllocateInfo alloc = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+				alloc.descriptorPool = mCurrentPool;
+				alloc.descriptorSetCount = 1;
+				alloc.pSetLayouts = &mLayout;
+
+				VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+				VkResult result = vkAllocateDescriptorSets(mDevice, &alloc, &descriptorSet);
+				if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+				{
+					// current pool is exhausted, move on to a fresh one
+					mCurrentPool = grabPool();
+					alloc.descriptorPool = mCurrentPool;
+					result = vkAllocateDescriptorSets(mDevice, &alloc, &descriptorSet);
+				}
+				assert(result == VK_SUCCESS);
+
+				++mAllocatedSets;
+				return descriptorSet;
+			}
+
+
+			void DescriptorAllocator::free(VkDescriptorSet set, uint64_t frame)
+			{
+				assert(mAllocatedSets > 0);
+				mRetiredSets.push_back({ frame, set });
+				--mAllocatedSets;
+			}
+
+
+			void DescriptorAllocator::recycle(uint64_t completedFrame)
+			{
+				auto end = mRetiredSets.begin();
+				for (; end != mRetiredSets.end() && end->first <= completedFrame; ++end)
+				{
+					mFreeSets.push_back(end->second);
+				}
+				mRetiredSets.erase(mRetiredSets.begin(), end);
+			}
+
+
+			void DescriptorAllocator::reset()
+			{
+				for (auto pool : mUsedPools)
+				{
+					vkResetDescriptorPool(mDevice, pool, 0);
+					mFreePools.push_back(pool);
+				}
+				mUsedPools.clear();
+				mCurrentPool = VK_NULL_HANDLE;
+				mAllocatedSets = 0;
+				mRetiredSets.clear();
+				mFreeSets.clear();
+			}
 		}
 	}
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <utility>
 #include <vector>
 
 #ifndef GLFW_INCLUDE_VULKAN
@@ -33,7 +34,8 @@ namespace hvk
 			VkDescriptorSetLayoutBinding generateUboLayoutBinding(
 				uint32_t binding,
 				uint32_t descriptorCount,
-				VkShaderStageFlags flags=VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+				VkShaderStageFlags flags=VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+				VkDescriptorType type=VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
 
 			VkDescriptorSetLayoutBinding generateSamplerLayoutBinding(
 				uint32_t binding,
@@ -43,7 +45,8 @@ namespace hvk
 			VkWriteDescriptorSet createDescriptorBufferWrite(
 				std::vector<VkDescriptorBufferInfo>& bufferInfos,
 				VkDescriptorSet& descriptorSet,
-				uint32_t binding);
+				uint32_t binding,
+				VkDescriptorType type=VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
 
 			VkWriteDescriptorSet createDescriptorImageWrite(
 				std::vector<VkDescriptorImageInfo>& imageInfos,
@@ -55,6 +58,54 @@ namespace hvk
 				std::vector<VkWriteDescriptorSet>& descriptorWrites);
 
 
+			// Hands out descriptor sets for a single layout from a growing list of pools.
+			// When the current pool runs out (OUT_OF_POOL_MEMORY / FRAGMENTED_POOL) another
+			// pool sized for setsPerPool more sets is added, so the number of sets is only
+			// bounded by memory. reset() returns every set at once with vkResetDescriptorPool,
+			// which lets an allocator per frame in flight serve transient per-frame sets.
+			// Long-lived sets are handed back one at a time with free(), tagged with the last
+			// frame that may still read them; recycle() makes them available to allocate() again
+			// once that frame has completed. Every set shares the layout, so a recycled set only
+			// needs its bindings rewritten and the pools don't need FREE_DESCRIPTOR_SET_BIT.
+			class DescriptorAllocator
+			{
+			private:
+				VkDevice mDevice;
+				VkDescriptorSetLayout mLayout;
+				std::vector<VkDescriptorPoolSize> mPoolSizes;
+				uint32_t mSetsPerPool;
+				std::vector<VkDescriptorPool> mUsedPools;
+				std::vector<VkDescriptorPool> mFreePools;
+				VkDescriptorPool mCurrentPool;
+				uint32_t mAllocatedSets;
+				// Freed sets in the order they were freed, waiting on their frame
+				std::vector<std::pair<uint64_t, VkDescriptorSet>> mRetiredSets;
+				std::vector<VkDescriptorSet> mFreeSets;
+
+				VkDescriptorPool grabPool();
+
+			public:
+				DescriptorAllocator();
+				~DescriptorAllocator();
+
+				// Pool sizes are derived from the layout's bindings
+				void init(
+					VkDevice device,
+					VkDescriptorSetLayout layout,
+					const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+					uint32_t setsPerPool);
+				void destroy();
+
+				VkDescriptorSet allocate();
+				void free(VkDescriptorSet set, uint64_t frame);
+				void recycle(uint64_t completedFrame);
+				void reset();
+
+				uint32_t getPoolCount() const { return static_cast<uint32_t>(mUsedPools.size() + mFreePools.size()); }
+				uint32_t getAllocatedSetCount() const { return mAllocatedSets; }
+			};
+
+
 			template <VkDescriptorType T>
 			void _buildPoolSizes(std::vector<VkDescriptorPoolSize>& poolSizes, uint32_t count)
 			{
@@ -2,13 +2,21 @@
 #include "image-util.h"
 
 #include <assert.h>
+#include <algorithm>
+#include <cmath>
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
 #endif
+// glTF images are decoded on worker threads
+#define STBI_THREAD_LOCAL thread_local
 #include "stb_image.h"
 
 #include "command-util.h"
+#include "BlockCompression.h"
+#include "MappedFile.h"
+#include "MipChain.h"
+#include "UploadBatch.h"
 
 namespace hvk
 {
@@ -69,9 +77,156 @@ namespace hvk
 
 			void destroyMap(VkDevice device, VmaAllocator allocator, TextureMap& map)
 			{
+                UploadQueue::wait(map.upload);
                 vkDestroySampler(device, map.sampler, nullptr);
                 vkDestroyImageView(device, map.view, nullptr);
-                vmaDestroyImage(allocator, map.texture.memoryResource, map.texture.allocation);
+                memory::destroyImage(allocator, map.texture.memoryResource, map.texture.allocation);
+			}
+
+
+			bool supportsLinearBlit(VkPhysicalDevice physicalDevice, VkFormat format)
+			{
+				const VkFormatFeatureFlags required =
+					VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+					VK_FORMAT_FEATURE_BLIT_DST_BIT |
+					VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+				VkFormatProperties properties;
+				vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+				return (properties.optimalTilingFeatures & required) == required;
+			}
+
+
+			bool supportsSampledFormat(VkPhysicalDevice physicalDevice, VkFormat format)
+			{
+				const VkFormatFeatureFlags required =
+					VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+					VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+				VkFormatProperties properties;
+				vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+				return (properties.optimalTilingFeatures & required) == required;
+			}
+
+
+			bool supportsBlockCompression(VkPhysicalDevice physicalDevice)
+			{
+				VkPhysicalDeviceFeatures features;
+				vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+				return features.textureCompressionBC == VK_TRUE;
+			}
+
+
+			// Block compressed levels are sized by the format, everything else by bitDepth bytes per texel
+			VkDeviceSize getLevelSize(VkFormat format, uint32_t width, uint32_t height, int bitDepth)
+			{
+				if (bc::getBlockSize(format) != 0)
+				{
+					return bc::getLevelSize(format, width, height);
+				}
+				return static_cast<VkDeviceSize>(width) * height * bitDepth;
+			}
+
+
+			bool isSrgbFormat(VkFormat format)
+			{
+				switch (format)
+				{
+				case VK_FORMAT_R8_SRGB:
+				case VK_FORMAT_R8G8_SRGB:
+				case VK_FORMAT_R8G8B8_SRGB:
+				case VK_FORMAT_B8G8R8_SRGB:
+				case VK_FORMAT_R8G8B8A8_SRGB:
+				case VK_FORMAT_B8G8R8A8_SRGB:
+					return true;
+				default:
+					return false;
+				}
+			}
+
+
+			// The sRGB format with the same layout, so an image can be aliased to filter in linear space
+			VkFormat getSrgbFormat(VkFormat format)
+			{
+				switch (format)
+				{
+				case VK_FORMAT_R8_UNORM: return VK_FORMAT_R8_SRGB;
+				case VK_FORMAT_R8G8_UNORM: return VK_FORMAT_R8G8_SRGB;
+				case VK_FORMAT_R8G8B8_UNORM: return VK_FORMAT_R8G8B8_SRGB;
+				case VK_FORMAT_B8G8R8_UNORM: return VK_FORMAT_B8G8R8_SRGB;
+				case VK_FORMAT_R8G8B8A8_UNORM: return VK_FORMAT_R8G8B8A8_SRGB;
+				case VK_FORMAT_B8G8R8A8_UNORM: return VK_FORMAT_B8G8R8A8_SRGB;
+				default:
+					return isSrgbFormat(format) ? format : VK_FORMAT_UNDEFINED;
+				}
+			}
+
+
+			void recordMipBlits(
+				VkCommandBuffer commandBuffer,
+				VkImage image,
+				uint32_t imageWidth,
+				uint32_t imageHeight,
+				uint32_t numLayers,
+				uint32_t mipLevels)
+			{
+				// Each level is read once it's complete, then handed to the shader, so
+				// every level ends up in SHADER_READ_ONLY_OPTIMAL
+				int32_t srcWidth = static_cast<int32_t>(imageWidth);
+				int32_t srcHeight = static_cast<int32_t>(imageHeight);
+				for (uint32_t level = 1; level < mipLevels; ++level)
+				{
+					int32_t dstWidth = std::max(srcWidth / 2, 1);
+					int32_t dstHeight = std::max(srcHeight / 2, 1);
+
+					transitionImageLayout(
+						commandBuffer,
+						image,
+						VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+						numLayers,
+						0,
+						1,
+						level - 1);
+
+					VkImageBlit blit = {};
+					blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, numLayers };
+					blit.srcOffsets[1] = { srcWidth, srcHeight, 1 };
+					blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, numLayers };
+					blit.dstOffsets[1] = { dstWidth, dstHeight, 1 };
+					vkCmdBlitImage(
+						commandBuffer,
+						image,
+						VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+						image,
+						VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						1,
+						&blit,
+						VK_FILTER_LINEAR);
+
+					transitionImageLayout(
+						commandBuffer,
+						image,
+						VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+						VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+						numLayers,
+						0,
+						1,
+						level - 1);
+
+					srcWidth = dstWidth;
+					srcHeight = dstHeight;
+				}
+
+				transitionImageLayout(
+					commandBuffer,
+					image,
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+					numLayers,
+					0,
+					1,
+					mipLevels - 1);
 			}
 
 
@@ -87,51 +242,43 @@ namespace hvk
 				int bitDepth,
 				VkImageType imageType,
 				VkImageCreateFlags flags,
-				VkFormat imageFormat) {
+				VkFormat imageFormat,
+				memory::GpuMemoryCategory category,
+				uint32_t mipLevels,
+				bool mipsIncluded,
+				UploadBatch* batch) {
 
 				hvk::RuntimeResource<VkImage> textureResource;
 
-				//VkDeviceSize imageSize = imageWidth * imageHeight * components * bitDepth;
-				VkDeviceSize singleImageSize = imageWidth * imageHeight * bitDepth;
+				// Every uploaded level of one layer, tightly packed
+				const uint32_t uploadedLevels = mipsIncluded ? mipLevels : 1;
+				const bool blitMips = mipLevels > 1 && !mipsIncluded;
+				VkDeviceSize singleImageSize = 0;
+				for (uint32_t level = 0; level < uploadedLevels; ++level)
+				{
+					singleImageSize += getLevelSize(
+						imageFormat,
+						std::max(static_cast<uint32_t>(imageWidth) >> level, 1u),
+						std::max(static_cast<uint32_t>(imageHeight) >> level, 1u),
+						bitDepth);
+				}
 				VkDeviceSize imageSize = singleImageSize * numLayers;
 
-				// copy image data into a staging buffer which will then be used
-				// to transfer to a Vulkan image
-				VkBuffer imageStagingBuffer;
-				VkBufferCreateInfo stagingCreateInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-				stagingCreateInfo.size = imageSize;
-				stagingCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-
-				VmaAllocation stagingAllocation;
-				VmaAllocationInfo stagingAllocationInfo;
-				VmaAllocationCreateInfo stagingAllocCreateInfo = {};
-				stagingAllocCreateInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
-
-				vmaCreateBuffer(
-					allocator,
-					&stagingCreateInfo,
-					&stagingAllocCreateInfo,
-					&imageStagingBuffer,
-					&stagingAllocation,
-					&stagingAllocationInfo);
-
-				void* stagingData;
-				int offset = 0;
-				vmaMapMemory(allocator, stagingAllocation, &stagingData);
-				memcpy(stagingData, imageDataLayers, imageSize);
-				vmaUnmapMemory(allocator, stagingAllocation);
-
 				VkImageCreateInfo imageInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
 				imageInfo.imageType = imageType;
 				imageInfo.extent.width = static_cast<uint32_t>(imageWidth);
 				imageInfo.extent.height = static_cast<uint32_t>(imageHeight);
 				imageInfo.extent.depth = 1;
-				imageInfo.mipLevels = 1;
+				imageInfo.mipLevels = mipLevels;
 				imageInfo.arrayLayers = numLayers;
 				imageInfo.format = imageFormat;
 				imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
 				imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 				imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+				if (blitMips)
+				{
+					imageInfo.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+				}
 				imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 				imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 				imageInfo.flags = flags;
@@ -139,51 +286,61 @@ namespace hvk
 				VmaAllocationCreateInfo imageAllocationCreateInfo = {};
 				imageAllocationCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
 
-				auto createResult = vmaCreateImage(
+				auto createResult = memory::createImage(
 					allocator,
 					&imageInfo,
 					&imageAllocationCreateInfo,
 					&textureResource.memoryResource,
 					&textureResource.allocation,
-                    nullptr);
-
-				auto commandBuffer = command::beginSingleTimeCommand(device, commandPool);
-				transitionImageLayout(
-					commandBuffer,
-					textureResource.memoryResource,
-					VK_IMAGE_LAYOUT_UNDEFINED,
-					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					numLayers);
-				command::endSingleTimeCommand(device, commandPool, commandBuffer, graphicsQueue);
+                    nullptr,
+					category);
 
-				copyBufferToImage(
-					device,
-					commandPool,
-					graphicsQueue,
-					imageStagingBuffer,
-					textureResource.memoryResource,
-					imageWidth,
-					imageHeight,
-					numLayers,
-					singleImageSize);
+				std::vector<VkBufferImageCopy> regions;
+				regions.reserve(numLayers * uploadedLevels);
+				VkDeviceSize regionOffset = 0;
+				for (uint32_t layer = 0; layer < numLayers; ++layer)
+				{
+					for (uint32_t level = 0; level < uploadedLevels; ++level)
+					{
+						uint32_t levelWidth = std::max(static_cast<uint32_t>(imageWidth) >> level, 1u);
+						uint32_t levelHeight = std::max(static_cast<uint32_t>(imageHeight) >> level, 1u);
+
+						VkBufferImageCopy region = {};
+						region.bufferOffset = regionOffset;
+						region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+						region.imageSubresource.mipLevel = level;
+						region.imageSubresource.baseArrayLayer = layer;
+						region.imageSubresource.layerCount = 1;
+						region.imageExtent = { levelWidth, levelHeight, 1 };
+						regions.push_back(region);
+
+						regionOffset += getLevelSize(imageFormat, levelWidth, levelHeight, bitDepth);
+					}
+				}
 
-				commandBuffer = command::beginSingleTimeCommand(device, commandPool);
-				transitionImageLayout(
-					commandBuffer,
+				// Without a batch the upload is a batch of one that's waited on straight away
+				UploadBatch ownBatch;
+				UploadBatch& uploads = batch != nullptr ? *batch : ownBatch;
+				uploads.addImage(
 					textureResource.memoryResource,
-					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-					//1);
-					numLayers);
-				command::endSingleTimeCommand(device, commandPool, commandBuffer, graphicsQueue);
-
-
-				vmaDestroyBuffer(allocator, imageStagingBuffer, stagingAllocation);
+					imageDataLayers,
+					imageSize,
+					regions,
+					static_cast<uint32_t>(imageWidth),
+					static_cast<uint32_t>(imageHeight),
+					static_cast<uint32_t>(numLayers),
+					mipLevels,
+					blitMips);
+				if (batch == nullptr)
+				{
+					UploadQueue::wait(ownBatch.submit());
+				}
 
 				return textureResource;
 			}
 
 			TextureMap createTextureMap(
+				VkPhysicalDevice physicalDevice,
 				VkDevice device,
 				VmaAllocator allocator,
 				VkCommandPool commandPool,
@@ -194,33 +351,211 @@ namespace hvk
 				int bitDepth,
 				VkImageType imageType,
 				VkImageCreateFlags flags,
-				VkFormat imageFormat)
+				VkFormat imageFormat,
+				memory::GpuMemoryCategory category,
+				UploadBatch* batch,
+				bool srgbTexels)
 			{
 				TextureMap map;
 
+				uint32_t mipLevels = getMipLevelCount(
+					static_cast<uint32_t>(imageWidth),
+					static_cast<uint32_t>(imageHeight));
+				const void* uploadData = imageData;
+				std::vector<uint8_t> mipChain;
+				bool mipsIncluded = false;
+
+				// Blits filter in the image's own format, so sRGB texels in a UNORM format are blitted
+				// through an sRGB image and sampled through a UNORM view of it
+				const bool srgbFilter = srgbTexels || isSrgbFormat(imageFormat);
+				const VkFormat blitFormat = srgbFilter ? getSrgbFormat(imageFormat) : imageFormat;
+				if (mipLevels > 1 && (blitFormat == VK_FORMAT_UNDEFINED || !supportsLinearBlit(physicalDevice, blitFormat)))
+				{
+					// The CPU filter only understands 8 bit channels; anything wider goes without mips
+					if (bitDepth <= 4)
+					{
+						mipChain = generateMipChain(
+							imageData,
+							static_cast<uint32_t>(imageWidth),
+							static_cast<uint32_t>(imageHeight),
+							static_cast<uint32_t>(bitDepth),
+							mipLevels,
+							srgbFilter);
+						uploadData = mipChain.data();
+						mipsIncluded = true;
+					}
+					else
+					{
+						mipLevels = 1;
+					}
+				}
+
+				const bool aliased = mipLevels > 1 && !mipsIncluded && blitFormat != imageFormat;
 				map.texture = createTextureImage(
 					device,
 					allocator,
 					commandPool,
 					graphicsQueue,
-					imageData,
+					uploadData,
 					1,
 					imageWidth,
 					imageHeight,
-					bitDepth);
+					bitDepth,
+					imageType,
+					aliased ? flags | VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT : flags,
+					aliased ? blitFormat : imageFormat,
+					category,
+					mipLevels,
+					mipsIncluded,
+					batch);
+				map.upload = batch != nullptr ? batch->getTicket() : 0;
 				map.view = createImageView(
 					device,
 					map.texture.memoryResource,
-					VK_FORMAT_R8G8B8A8_UNORM,
+					imageFormat,
 					VK_IMAGE_ASPECT_COLOR_BIT,
-					1);
-				map.sampler = createImageSampler(device);
+					1,
+					VK_IMAGE_VIEW_TYPE_2D,
+					mipLevels);
+				map.sampler = createImageSampler(device, static_cast<float>(mipLevels));
 
 				return map;
 			}
 
 
+			bool createTextureMapFromKtx2(
+				VkPhysicalDevice physicalDevice,
+				VkDevice device,
+				VmaAllocator allocator,
+				VkCommandPool commandPool,
+				VkQueue graphicsQueue,
+				const Ktx2Texture& texture,
+				TextureMap& outMap,
+				memory::GpuMemoryCategory category,
+				UploadBatch* batch,
+				bool srgbTexels)
+			{
+				const bool isCube = texture.faceCount == 6;
+				if (!supportsSampledFormat(physicalDevice, texture.format) || (isCube && texture.generateMips))
+				{
+					return false;
+				}
+
+				if (texture.generateMips)
+				{
+					// Uncompressed texels; the chain is built the same way as for a decoded image
+					const uint64_t texelCount = static_cast<uint64_t>(texture.width) * texture.height;
+					outMap = createTextureMap(
+						physicalDevice,
+						device,
+						allocator,
+						commandPool,
+						graphicsQueue,
+						texture.levels[0].data,
+						static_cast<int>(texture.width),
+						static_cast<int>(texture.height),
+						static_cast<int>(texture.levels[0].size / texelCount),
+						VK_IMAGE_TYPE_2D,
+						0,
+						texture.format,
+						category,
+						batch,
+						srgbTexels);
+					return true;
+				}
+
+				// KTX2 stores the smallest level first with each level's faces together; the upload
+				// wants each face's chain packed base first
+				std::vector<uint8_t> chain;
+				size_t chainSize = 0;
+				for (const auto& level : texture.levels)
+				{
+					chainSize += static_cast<size_t>(level.size);
+				}
+				chain.reserve(chainSize);
+				for (uint32_t face = 0; face < texture.faceCount; ++face)
+				{
+					for (const auto& level : texture.levels)
+					{
+						const size_t faceSize = static_cast<size_t>(level.size / texture.faceCount);
+						const uint8_t* faceData = level.data + face * faceSize;
+						chain.insert(chain.end(), faceData, faceData + faceSize);
+					}
+				}
+
+				// Block compressed levels are sized by the format, the rest by their texel size
+				const uint64_t baseTexels = static_cast<uint64_t>(texture.width) * texture.height * texture.faceCount;
+				const int bitDepth = bc::getBlockSize(texture.format) != 0 ?
+					0 :
+					static_cast<int>(texture.levels[0].size / baseTexels);
+				const uint32_t mipLevels = static_cast<uint32_t>(texture.levels.size());
+				outMap.texture = createTextureImage(
+					device,
+					allocator,
+					commandPool,
+					graphicsQueue,
+					chain.data(),
+					texture.faceCount,
+					static_cast<int>(texture.width),
+					static_cast<int>(texture.height),
+					bitDepth,
+					VK_IMAGE_TYPE_2D,
+					isCube ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0,
+					texture.format,
+					category,
+					mipLevels,
+					true,
+					batch);
+				outMap.upload = batch != nullptr ? batch->getTicket() : 0;
+				outMap.view = createImageView(
+					device,
+					outMap.texture.memoryResource,
+					texture.format,
+					VK_IMAGE_ASPECT_COLOR_BIT,
+					texture.faceCount,
+					isCube ? VK_IMAGE_VIEW_TYPE_CUBE : VK_IMAGE_VIEW_TYPE_2D,
+					mipLevels);
+				outMap.sampler = createImageSampler(device, static_cast<float>(mipLevels));
+				return true;
+			}
+
+
+			bool createTextureMapFromCookedFile(
+				VkPhysicalDevice physicalDevice,
+				VkDevice device,
+				VmaAllocator allocator,
+				VkCommandPool commandPool,
+				VkQueue graphicsQueue,
+				const std::string& sourcePath,
+				const TextureCookSettings& settings,
+				TextureMap& outMap,
+				memory::GpuMemoryCategory category)
+			{
+				MappedFile file;
+				Ktx2Texture texture;
+				uint64_t sourceKey;
+				if (!file.open(getCookedTexturePath(sourcePath)) ||
+					!parseKtx2(file.getData(), file.getSize(), texture) ||
+					!computeTextureSourceKey(sourcePath, settings, sourceKey) ||
+					texture.sourceKey != sourceKey)
+				{
+					return false;
+				}
+
+				return createTextureMapFromKtx2(
+					physicalDevice,
+					device,
+					allocator,
+					commandPool,
+					graphicsQueue,
+					texture,
+					outMap,
+					category);
+			}
+
+
 			TextureMap createTextureMapFromFile(
+				VkPhysicalDevice physicalDevice,
 				VkDevice device,
 				VmaAllocator allocator,
 				VkCommandPool commandPool,
@@ -229,12 +564,27 @@ namespace hvk
 			{
 				TextureMap map;
 
+				if (createTextureMapFromCookedFile(
+					physicalDevice,
+					device,
+					allocator,
+					commandPool,
+					graphicsQueue,
+					filename,
+					TextureCookSettings(),
+					map))
+				{
+					return map;
+				}
+
+				// Expanded to RGBA to match the texture format whatever the file stores
 				int width, height, numChannels;
-				unsigned char* data = stbi_load(filename.c_str(), &width, &height, &numChannels, 0);
+				unsigned char* data = stbi_load(filename.c_str(), &width, &height, &numChannels, STBI_rgb_alpha);
 
                 assert(data != nullptr);
 
 				map = createTextureMap(
+					physicalDevice,
 					device,
 					allocator,
 					commandPool,
@@ -242,7 +592,7 @@ namespace hvk
 					data,
 					width,
 					height,
-					numChannels);
+					STBI_rgb_alpha);
 
 				stbi_image_free(data);
 				return map;
@@ -370,6 +720,114 @@ namespace hvk
 			}
 
 
+			void readImageLevels(
+				VkDevice device,
+				VmaAllocator allocator,
+				VkCommandPool commandPool,
+				VkQueue graphicsQueue,
+				VkImage image,
+				uint32_t width,
+				uint32_t height,
+				uint32_t numLayers,
+				uint32_t mipLevels,
+				int bitDepth,
+				std::vector<std::vector<uint8_t>>& outLevels)
+			{
+				std::vector<VkBufferImageCopy> regions;
+				regions.reserve(mipLevels);
+				VkDeviceSize readbackSize = 0;
+				for (uint32_t level = 0; level < mipLevels; ++level)
+				{
+					const uint32_t levelWidth = std::max(width >> level, 1u);
+					const uint32_t levelHeight = std::max(height >> level, 1u);
+
+					VkBufferImageCopy region = {};
+					region.bufferOffset = readbackSize;
+					region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+					region.imageSubresource.mipLevel = level;
+					region.imageSubresource.baseArrayLayer = 0;
+					region.imageSubresource.layerCount = numLayers;
+					region.imageExtent = { levelWidth, levelHeight, 1 };
+					regions.push_back(region);
+
+					readbackSize += static_cast<VkDeviceSize>(levelWidth) * levelHeight * bitDepth * numLayers;
+				}
+
+				RuntimeResource<VkBuffer> readback;
+				VkBufferCreateInfo readbackCreateInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+				readbackCreateInfo.size = readbackSize;
+				readbackCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+				VmaAllocationCreateInfo readbackAllocCreateInfo = {};
+				readbackAllocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_TO_CPU;
+				readbackAllocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+				VmaAllocationInfo readbackAllocationInfo;
+				memory::createBuffer(
+					allocator,
+					&readbackCreateInfo,
+					&readbackAllocCreateInfo,
+					&readback.memoryResource,
+					&readback.allocation,
+					&readbackAllocationInfo,
+					memory::GpuMemoryCategory::Staging);
+
+				VkCommandBuffer commandBuffer = command::beginSingleTimeCommand(device, commandPool);
+				transitionImageLayout(
+					commandBuffer,
+					image,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+					VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+					numLayers,
+					0,
+					mipLevels);
+				vkCmdCopyImageToBuffer(
+					commandBuffer,
+					image,
+					VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+					readback.memoryResource,
+					static_cast<uint32_t>(regions.size()),
+					regions.data());
+				// The copy only becomes visible to the host through a barrier, even once the queue is idle
+				VkMemoryBarrier hostRead = { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+				hostRead.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				hostRead.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+				vkCmdPipelineBarrier(
+					commandBuffer,
+					VK_PIPELINE_STAGE_TRANSFER_BIT,
+					VK_PIPELINE_STAGE_HOST_BIT,
+					0,
+					1,
+					&hostRead,
+					0,
+					nullptr,
+					0,
+					nullptr);
+				transitionImageLayout(
+					commandBuffer,
+					image,
+					VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+					numLayers,
+					0,
+					mipLevels);
+				command::endSingleTimeCommand(device, commandPool, commandBuffer, graphicsQueue);
+
+				vmaInvalidateAllocation(allocator, readback.allocation, 0, readbackSize);
+				const uint8_t* readbackData = static_cast<const uint8_t*>(readbackAllocationInfo.pMappedData);
+				outLevels.resize(mipLevels);
+				for (uint32_t level = 0; level < mipLevels; ++level)
+				{
+					const VkDeviceSize levelEnd = level + 1 < mipLevels ? regions[level + 1].bufferOffset : readbackSize;
+					outLevels[level].assign(
+						readbackData + regions[level].bufferOffset,
+						readbackData + levelEnd);
+				}
+
+				memory::destroyBuffer(allocator, readback.memoryResource, readback.allocation);
+			}
+
+
 			TextureMap createImageMap(
 				VkDevice device,
 				VmaAllocator allocator,
@@ -384,7 +842,8 @@ namespace hvk
 				VkImageLayout initialLayout,
 				VkImageViewType viewType,
 				uint32_t mipLevels,
-				VkImageAspectFlags aspectFlags)
+				VkImageAspectFlags aspectFlags,
+				memory::GpuMemoryCategory category)
 			{
 				TextureMap imageMap;
 				uint32_t bitDepth = 4;
@@ -409,13 +868,14 @@ namespace hvk
 				VmaAllocationCreateInfo imageAllocationCreateInfo = {};
 				imageAllocationCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
 
-				vmaCreateImage(
+				memory::createImage(
 					allocator,
 					&image,
 					&imageAllocationCreateInfo,
 					&imageMap.texture.memoryResource,
 					&imageMap.texture.allocation,
-                    nullptr);
+                    nullptr,
+					category);
 
 				imageMap.view = createImageView(
 					device,
@@ -6,9 +6,14 @@
 #endif
 
 #include "types.h"
+#include "memory-util.h"
+#include "Ktx2.h"
+#include "TextureCooker.h"
 
 namespace hvk
 {
+	class UploadBatch;
+
 	namespace util
 	{
 		namespace image
@@ -26,6 +31,15 @@ namespace hvk
 				VkDevice device,
 				float maxLod=0.f);
 
+			// Whether the format can be the source and destination of a linearly filtered vkCmdBlitImage
+			bool supportsLinearBlit(VkPhysicalDevice physicalDevice, VkFormat format);
+
+			// Whether optimally tiled images of the format can be sampled with linear filtering
+			bool supportsSampledFormat(VkPhysicalDevice physicalDevice, VkFormat format);
+
+			// Whether the device has the BC formats textures are cooked to; decides the cook settings
+			bool supportsBlockCompression(VkPhysicalDevice physicalDevice);
+
 			void transitionImageLayout(
 				VkCommandBuffer commandBuffer,
 				VkImage image,
@@ -51,8 +65,15 @@ namespace hvk
 				VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
 				VkImageViewType viewType=VK_IMAGE_VIEW_TYPE_2D,
 				uint32_t mipLevels = 1,
-				VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT);
+				VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT,
+				memory::GpuMemoryCategory category = memory::GpuMemoryCategory::RenderTarget);
 
+			// Uploads, fills and transitions the image. With mipLevels > 1 the levels below the base
+			// are blitted on the GPU unless mipsIncluded, in which case each layer of
+			// imageDataLayers holds its whole chain as laid out by generateMipChain.
+			// Block compressed formats size their levels by the format and ignore bitDepth.
+			// Given a batch the copy joins it and completes with batch->getTicket(); otherwise it's
+			// submitted and waited on. imageDataLayers can be freed as soon as this returns
 			RuntimeResource<VkImage> createTextureImage(
 				VkDevice device,
 				VmaAllocator allocator,
@@ -65,7 +86,21 @@ namespace hvk
 				int bitDepth,
 				VkImageType imageType=VK_IMAGE_TYPE_2D,
 				VkImageCreateFlags flags=0,
-				VkFormat imageFormat=VK_FORMAT_R8G8B8A8_UNORM);
+				VkFormat imageFormat=VK_FORMAT_R8G8B8A8_UNORM,
+				memory::GpuMemoryCategory category=memory::GpuMemoryCategory::Texture,
+				uint32_t mipLevels=1,
+				bool mipsIncluded=false,
+				UploadBatch* batch=nullptr);
+
+			// Fills every level below the base of an image in TRANSFER_DST_OPTIMAL from the one above,
+			// leaving the whole chain in SHADER_READ_ONLY_OPTIMAL
+			void recordMipBlits(
+				VkCommandBuffer commandBuffer,
+				VkImage image,
+				uint32_t imageWidth,
+				uint32_t imageHeight,
+				uint32_t numLayers,
+				uint32_t mipLevels);
 
 			TextureMap createCubeMap(
 				VkDevice device,
@@ -74,7 +109,11 @@ namespace hvk
 				VkQueue graphicsQueue,
 				std::array<std::string, 6>& fileNames);
 
+			// Sampled with a full mip chain, blitted when the format allows it and box filtered on the CPU otherwise.
+			// srgbTexels marks colour data stored sRGB encoded in a UNORM format: the shader still reads it as
+			// stored, but its mips are averaged in linear space. Given a batch, sample it once map.upload completes
 			TextureMap createTextureMap(
+				VkPhysicalDevice physicalDevice,
 				VkDevice device,
 				VmaAllocator allocator,
 				VkCommandPool commandPool,
@@ -85,15 +124,49 @@ namespace hvk
 				int bitDepth,
 				VkImageType imageType = VK_IMAGE_TYPE_2D,
 				VkImageCreateFlags flags = 0,
-				VkFormat imageFormat = VK_FORMAT_R8G8B8A8_UNORM);
+				VkFormat imageFormat = VK_FORMAT_R8G8B8A8_UNORM,
+				memory::GpuMemoryCategory category = memory::GpuMemoryCategory::Texture,
+				UploadBatch* batch = nullptr,
+				bool srgbTexels = false);
+
+			// Uploads a cooked texture's levels as they are, or builds the chain for one that asks
+			// for it, treating srgbTexels as createTextureMap does. False if the device can't sample
+			// the format, so the caller can fall back
+			bool createTextureMapFromKtx2(
+				VkPhysicalDevice physicalDevice,
+				VkDevice device,
+				VmaAllocator allocator,
+				VkCommandPool commandPool,
+				VkQueue graphicsQueue,
+				const Ktx2Texture& texture,
+				TextureMap& outMap,
+				memory::GpuMemoryCategory category = memory::GpuMemoryCategory::Texture,
+				UploadBatch* batch = nullptr,
+				bool srgbTexels = false);
 
+			// Loads sourcePath's .ktx2 when it was cooked from the current source with settings.
+			// False if it's missing, stale or unsupported
+			bool createTextureMapFromCookedFile(
+				VkPhysicalDevice physicalDevice,
+				VkDevice device,
+				VmaAllocator allocator,
+				VkCommandPool commandPool,
+				VkQueue graphicsQueue,
+				const std::string& sourcePath,
+				const TextureCookSettings& settings,
+				TextureMap& outMap,
+				memory::GpuMemoryCategory category = memory::GpuMemoryCategory::Texture);
+
+			// Prefers the file's cooked .ktx2 and decodes the image itself otherwise
 			TextureMap createTextureMapFromFile(
+				VkPhysicalDevice physicalDevice,
 				VkDevice device,
 				VmaAllocator allocator,
 				VkCommandPool commandPool,
 				VkQueue graphicsQueue,
 				std::string&& filename);
 
+			// Waits for the map's upload first, if it's still in flight
 			// TODO: Maybe move to a memory util instead?
 			void destroyMap(VkDevice device, VmaAllocator allocator, TextureMap& map);
 
@@ -108,6 +181,22 @@ namespace hvk
 				size_t numFaces = 1,
 				size_t faceSize = 0);
 
+			// Copies every level of an image in SHADER_READ_ONLY_OPTIMAL back into outLevels, base first,
+			// each holding its layers in order, and leaves the image as it was. The image needs
+			// VK_IMAGE_USAGE_TRANSFER_SRC_BIT and bitDepth is bytes per texel. Waits for the copy
+			void readImageLevels(
+				VkDevice device,
+				VmaAllocator allocator,
+				VkCommandPool commandPool,
+				VkQueue graphicsQueue,
+				VkImage image,
+				uint32_t width,
+				uint32_t height,
+				uint32_t numLayers,
+				uint32_t mipLevels,
+				int bitDepth,
+				std::vector<std::vector<uint8_t>>& outLevels);
+
 			void framebufferImageToTexture(
 				VkCommandBuffer commandBuffer,
 				const TextureMap& framebufferImage,
@@ -85,6 +85,50 @@ namespace hvk
 				auto clip = screenToClip(screenCoord, screenDimensions);
 				return clipToView(clip, inverseProjection);
 			}
+
+			glm::vec4 normalizePlane(const glm::vec4& plane)
+			{
+				const float length = glm::length(glm::vec3(plane));
+				return length > 0.f ? plane / length : plane;
+			}
+
+			Frustum getFrustum(const glm::mat4& viewProj)
+			{
+				// Gribb and Hartmann: each plane is the w row plus or minus another row. The near
+				// plane assumes a -w..w depth range, which is only looser for a 0..w projection
+				const glm::mat4 rows = glm::transpose(viewProj);
+				Frustum frustum;
+				frustum.planes[0] = normalizePlane(rows[3] + rows[0]);
+				frustum.planes[1] = normalizePlane(rows[3] - rows[0]);
+				frustum.planes[2] = normalizePlane(rows[3] + rows[1]);
+				frustum.planes[3] = normalizePlane(rows[3] - rows[1]);
+				frustum.planes[4] = normalizePlane(rows[3] + rows[2]);
+				frustum.planes[5] = normalizePlane(rows[3] - rows[2]);
+				return frustum;
+			}
+
+			Frustum transformFrustum(const Frustum& frustum, const glm::mat4& transform)
+			{
+				const glm::mat4 planeTransform = glm::transpose(transform);
+				Frustum transformed;
+				for (size_t i = 0; i < 6; ++i)
+				{
+					transformed.planes[i] = normalizePlane(planeTransform * frustum.planes[i]);
+				}
+				return transformed;
+			}
+
+			bool sphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius)
+			{
+				for (const auto& plane : frustum.planes)
+				{
+					if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+					{
+						return false;
+					}
+				}
+				return true;
+			}
         }
     }
 }
\ No newline at end of file
@@ -31,6 +31,12 @@ namespace hvk
                 glm::vec3 max;
             };
 
+            // Normalized planes facing inwards: p is inside when dot(xyz, p) + w >= 0 for all six
+            struct Frustum
+            {
+                glm::vec4 planes[6];
+            };
+
 			template <typename T>
 			bool almost_equal(T lhs, T rhs)
 			{
@@ -52,6 +58,14 @@ namespace hvk
             glm::vec4 clipToView(const glm::vec4& clipCoord, const glm::mat4& inverseProjection);
 
             glm::vec4 screenToView(const glm::vec2& screenCoord, const glm::vec2& screenDimensions, const glm::mat4& inverseProjection);
+
+            // The frustum's planes in the space viewProj transforms from
+            Frustum getFrustum(const glm::mat4& viewProj);
+
+            // Moves a frustum into the space transform maps into the frustum's space, such as an object's
+            Frustum transformFrustum(const Frustum& frustum, const glm::mat4& transform);
+
+            bool sphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius);
 		}
 	}
 }
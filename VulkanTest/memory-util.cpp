@@ -0,0 +1,461 @@
+#include "pch.h"
+#include "memory-util.h"
+
+#include <assert.h>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "imgui/imgui.h"
+#include "UploadBatch.h"
+
+namespace {
+	const size_t CATEGORY_COUNT = static_cast<size_t>(hvk::util::memory::GpuMemoryCategory::Count);
+
+	const char* CATEGORY_NAMES[CATEGORY_COUNT] = {
+		"General",
+		"Mesh",
+		"Texture",
+		"RenderTarget",
+		"Uniform",
+		"IBL",
+		"Staging",
+		"UI"
+	};
+
+	struct Counters
+	{
+		std::atomic<VkDeviceSize> bytes;
+		std::atomic<VkDeviceSize> peakBytes;
+		std::atomic<uint32_t> allocations;
+	};
+
+	Counters sCategories[CATEGORY_COUNT];
+	std::atomic<VkDeviceSize> sHeapBytes[VK_MAX_MEMORY_HEAPS];
+
+	VkPhysicalDevice sPhysicalDevice = VK_NULL_HANDLE;
+	VmaAllocator sAllocator = VK_NULL_HANDLE;
+	const VkPhysicalDeviceMemoryProperties* sMemoryProperties = nullptr;
+	bool sBudgetExtension = false;
+	bool sUnifiedMemory = false;
+	bool sDirectGeometryWrites = false;
+	float sWarningThreshold = 0.9f;
+	uint32_t sOverBudgetMask = 0;
+	FILE* sFrameLog = nullptr;
+	uint64_t sFrameNumber = 0;
+
+	// Category is stored offset by one so allocations made without a category
+	// (null user data) are never counted
+	void* encodeCategory(hvk::util::memory::GpuMemoryCategory category)
+	{
+		return reinterpret_cast<void*>(static_cast<uintptr_t>(category) + 1);
+	}
+
+	void recordAllocation(VmaAllocator allocator, VmaAllocation allocation, bool allocated)
+	{
+		VmaAllocationInfo info;
+		vmaGetAllocationInfo(allocator, allocation, &info);
+		const uintptr_t encoded = reinterpret_cast<uintptr_t>(info.pUserData);
+		if (encoded == 0 || encoded > CATEGORY_COUNT) {
+			return;
+		}
+
+		Counters& counters = sCategories[encoded - 1];
+		const uint32_t heapIndex = sMemoryProperties->memoryTypes[info.memoryType].heapIndex;
+		if (allocated) {
+			const VkDeviceSize live = counters.bytes.fetch_add(info.size, std::memory_order_relaxed) + info.size;
+			VkDeviceSize peak = counters.peakBytes.load(std::memory_order_relaxed);
+			while (live > peak && !counters.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+			}
+			counters.allocations.fetch_add(1, std::memory_order_relaxed);
+			sHeapBytes[heapIndex].fetch_add(info.size, std::memory_order_relaxed);
+		}
+		else {
+			counters.bytes.fetch_sub(info.size, std::memory_order_relaxed);
+			counters.allocations.fetch_sub(1, std::memory_order_relaxed);
+			sHeapBytes[heapIndex].fetch_sub(info.size, std::memory_order_relaxed);
+		}
+	}
+
+	// Fills in size, budget and usage for every heap
+	void queryHeapBudgets(hvk::util::memory::GpuMemoryStats& stats)
+	{
+		stats.heapCount = sMemoryProperties->memoryHeapCount;
+		stats.budgetExtension = sBudgetExtension;
+
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT };
+		if (sBudgetExtension) {
+			VkPhysicalDeviceMemoryProperties2 memoryProperties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2 };
+			memoryProperties.pNext = &budgetProperties;
+			vkGetPhysicalDeviceMemoryProperties2(sPhysicalDevice, &memoryProperties);
+		}
+
+		for (uint32_t i = 0; i < stats.heapCount; ++i) {
+			auto& heap = stats.heaps[i];
+			const VkMemoryHeap& memoryHeap = sMemoryProperties->memoryHeaps[i];
+			heap.size = memoryHeap.size;
+			heap.deviceLocal = (memoryHeap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+			if (sBudgetExtension) {
+				heap.budget = budgetProperties.heapBudget[i];
+				heap.usage = budgetProperties.heapUsage[i];
+			}
+			else {
+				heap.budget = memoryHeap.size * 8 / 10;
+				heap.usage = sHeapBytes[i].load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	void checkBudgets(const hvk::util::memory::GpuMemoryStats& stats)
+	{
+		uint32_t overMask = 0;
+		for (uint32_t i = 0; i < stats.heapCount; ++i) {
+			const auto& heap = stats.heaps[i];
+			if (heap.budget > 0 && static_cast<float>(heap.usage) > static_cast<float>(heap.budget) * sWarningThreshold) {
+				overMask |= 1u << i;
+			}
+		}
+
+		// Only warn when a heap first goes over, not every frame it stays there
+		const uint32_t newlyOver = overMask & ~sOverBudgetMask;
+		for (uint32_t i = 0; i < stats.heapCount; ++i) {
+			if (newlyOver & (1u << i)) {
+				std::cerr << "GPU memory heap " << i << " over budget: "
+					<< stats.heaps[i].usage << " / " << stats.heaps[i].budget << " bytes" << std::endl;
+			}
+		}
+		sOverBudgetMask = overMask;
+	}
+
+	void writeFrameLogHeader()
+	{
+		fprintf(sFrameLog, "frame");
+		for (size_t c = 0; c < CATEGORY_COUNT; ++c) {
+			fprintf(sFrameLog, ",%s", CATEGORY_NAMES[c]);
+		}
+		for (uint32_t i = 0; i < sMemoryProperties->memoryHeapCount; ++i) {
+			fprintf(sFrameLog, ",heap%uUsage,heap%uBudget", i, i);
+		}
+		fprintf(sFrameLog, "\n");
+	}
+
+	void writeFrameLog(const hvk::util::memory::GpuMemoryStats& stats)
+	{
+		fprintf(sFrameLog, "%llu", static_cast<unsigned long long>(sFrameNumber));
+		for (const auto& category : stats.categories) {
+			fprintf(sFrameLog, ",%llu", static_cast<unsigned long long>(category.bytes));
+		}
+		for (uint32_t i = 0; i < stats.heapCount; ++i) {
+			fprintf(sFrameLog, ",%llu,%llu",
+				static_cast<unsigned long long>(stats.heaps[i].usage),
+				static_cast<unsigned long long>(stats.heaps[i].budget));
+		}
+		fprintf(sFrameLog, "\n");
+	}
+}
+
+namespace hvk
+{
+	namespace util
+	{
+		namespace memory
+		{
+			void initialize(VkPhysicalDevice physicalDevice, VmaAllocator allocator, bool budgetExtension)
+			{
+				sPhysicalDevice = physicalDevice;
+				sAllocator = allocator;
+				sBudgetExtension = budgetExtension;
+				vmaGetMemoryProperties(allocator, &sMemoryProperties);
+
+				// A discrete GPU may expose a small mappable window of its memory, but never all of it
+				const VkMemoryPropertyFlags mappableDeviceLocal =
+					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+				sUnifiedMemory = true;
+				for (uint32_t heap = 0; heap < sMemoryProperties->memoryHeapCount; ++heap) {
+					if (!(sMemoryProperties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) {
+						continue;
+					}
+					bool mappable = false;
+					for (uint32_t type = 0; type < sMemoryProperties->memoryTypeCount; ++type) {
+						const VkMemoryType& memoryType = sMemoryProperties->memoryTypes[type];
+						if (memoryType.heapIndex == heap && (memoryType.propertyFlags & mappableDeviceLocal) == mappableDeviceLocal) {
+							mappable = true;
+							break;
+						}
+					}
+					sUnifiedMemory = sUnifiedMemory && mappable;
+				}
+				sDirectGeometryWrites = sUnifiedMemory;
+			}
+
+			const char* getCategoryName(GpuMemoryCategory category)
+			{
+				return CATEGORY_NAMES[static_cast<size_t>(category)];
+			}
+
+			VkResult createBuffer(
+				VmaAllocator allocator,
+				const VkBufferCreateInfo* bufferCreateInfo,
+				const VmaAllocationCreateInfo* allocationCreateInfo,
+				VkBuffer* buffer,
+				VmaAllocation* allocation,
+				VmaAllocationInfo* allocationInfo,
+				GpuMemoryCategory category)
+			{
+				VmaAllocationCreateInfo categorizedInfo = *allocationCreateInfo;
+				categorizedInfo.pUserData = encodeCategory(category);
+
+				VkResult result = vmaCreateBuffer(
+					allocator,
+					bufferCreateInfo,
+					&categorizedInfo,
+					buffer,
+					allocation,
+					allocationInfo);
+				if (result == VK_SUCCESS) {
+					recordAllocation(allocator, *allocation, true);
+				}
+				return result;
+			}
+
+			VkResult createImage(
+				VmaAllocator allocator,
+				const VkImageCreateInfo* imageCreateInfo,
+				const VmaAllocationCreateInfo* allocationCreateInfo,
+				VkImage* image,
+				VmaAllocation* allocation,
+				VmaAllocationInfo* allocationInfo,
+				GpuMemoryCategory category)
+			{
+				VmaAllocationCreateInfo categorizedInfo = *allocationCreateInfo;
+				categorizedInfo.pUserData = encodeCategory(category);
+
+				VkResult result = vmaCreateImage(
+					allocator,
+					imageCreateInfo,
+					&categorizedInfo,
+					image,
+					allocation,
+					allocationInfo);
+				if (result == VK_SUCCESS) {
+					recordAllocation(allocator, *allocation, true);
+				}
+				return result;
+			}
+
+			void destroyBuffer(VmaAllocator allocator, VkBuffer buffer, VmaAllocation allocation)
+			{
+				if (allocation != VK_NULL_HANDLE) {
+					recordAllocation(allocator, allocation, false);
+				}
+				vmaDestroyBuffer(allocator, buffer, allocation);
+			}
+
+			void destroyImage(VmaAllocator allocator, VkImage image, VmaAllocation allocation)
+			{
+				if (allocation != VK_NULL_HANDLE) {
+					recordAllocation(allocator, allocation, false);
+				}
+				vmaDestroyImage(allocator, image, allocation);
+			}
+
+			bool isUnifiedMemory()
+			{
+				return sUnifiedMemory;
+			}
+
+			void setDirectGeometryWrites(bool enabled)
+			{
+				sDirectGeometryWrites = enabled;
+			}
+
+			bool getDirectGeometryWrites()
+			{
+				return sDirectGeometryWrites;
+			}
+
+			VkResult createStaticBuffer(
+				VmaAllocator allocator,
+				const void* data,
+				VkDeviceSize size,
+				VkBufferUsageFlags usage,
+				VkPipelineStageFlags dstStage,
+				VkAccessFlags dstAccess,
+				VkBuffer* buffer,
+				VmaAllocation* allocation,
+				VmaAllocationInfo* allocationInfo,
+				GpuMemoryCategory category)
+			{
+				VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+				bufferInfo.size = size;
+				bufferInfo.usage = usage;
+
+				VmaAllocationCreateInfo allocCreateInfo = {};
+				allocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+				if (sDirectGeometryWrites) {
+					allocCreateInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+					allocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+					if (createBuffer(allocator, &bufferInfo, &allocCreateInfo, buffer, allocation, allocationInfo, category) == VK_SUCCESS) {
+						memcpy(allocationInfo->pMappedData, data, static_cast<size_t>(size));
+						vmaFlushAllocation(allocator, *allocation, 0, size);
+						return VK_SUCCESS;
+					}
+					// The mappable heap is full, fall back to staging
+					allocCreateInfo.requiredFlags = 0;
+					allocCreateInfo.flags = 0;
+				}
+
+				bufferInfo.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+				VkResult result = createBuffer(allocator, &bufferInfo, &allocCreateInfo, buffer, allocation, allocationInfo, category);
+				if (result != VK_SUCCESS) {
+					return result;
+				}
+
+				UploadBatch batch;
+				batch.addBuffer(*buffer, 0, data, size, dstStage, dstAccess, false);
+				UploadQueue::wait(batch.submit());
+				return VK_SUCCESS;
+			}
+
+			GpuMemoryStats getGpuMemoryStats()
+			{
+				assert(sAllocator != VK_NULL_HANDLE);
+
+				GpuMemoryStats stats = {};
+				for (size_t c = 0; c < CATEGORY_COUNT; ++c) {
+					stats.categories[c].bytes = sCategories[c].bytes.load(std::memory_order_relaxed);
+					stats.categories[c].peakBytes = sCategories[c].peakBytes.load(std::memory_order_relaxed);
+					stats.categories[c].allocations = sCategories[c].allocations.load(std::memory_order_relaxed);
+				}
+
+				queryHeapBudgets(stats);
+
+				VmaStats vmaStats;
+				vmaCalculateStats(sAllocator, &vmaStats);
+				for (uint32_t i = 0; i < stats.heapCount; ++i) {
+					stats.heaps[i].allocatedBytes = vmaStats.memoryHeap[i].usedBytes;
+					stats.heaps[i].blockBytes = vmaStats.memoryHeap[i].usedBytes + vmaStats.memoryHeap[i].unusedBytes;
+				}
+
+				return stats;
+			}
+
+			void setBudgetWarningThreshold(float threshold)
+			{
+				sWarningThreshold = threshold;
+			}
+
+			bool startFrameLog(const char* filename)
+			{
+				stopFrameLog();
+				sFrameLog = fopen(filename, "w");
+				if (sFrameLog == nullptr) {
+					return false;
+				}
+				writeFrameLogHeader();
+				return true;
+			}
+
+			void stopFrameLog()
+			{
+				if (sFrameLog != nullptr) {
+					fclose(sFrameLog);
+					sFrameLog = nullptr;
+				}
+			}
+
+			bool isFrameLogging()
+			{
+				return sFrameLog != nullptr;
+			}
+
+			void endFrame()
+			{
+				if (sAllocator == VK_NULL_HANDLE) {
+					return;
+				}
+
+				if (sFrameLog != nullptr) {
+					const GpuMemoryStats stats = getGpuMemoryStats();
+					checkBudgets(stats);
+					writeFrameLog(stats);
+				}
+				else {
+					// Budget check alone only needs the heap query, skip walking the allocator
+					GpuMemoryStats stats = {};
+					queryHeapBudgets(stats);
+					checkBudgets(stats);
+				}
+				++sFrameNumber;
+			}
+
+			uint32_t getOverBudgetHeapMask()
+			{
+				return sOverBudgetMask;
+			}
+
+			void drawGpuMemoryPanel(bool* open)
+			{
+				ImGui::Begin("GPU Memory", open);
+
+				const GpuMemoryStats stats = getGpuMemoryStats();
+
+				ImGui::Columns(4, "GpuMemoryCategories");
+				ImGui::Text("Category"); ImGui::NextColumn();
+				ImGui::Text("Live (KB)"); ImGui::NextColumn();
+				ImGui::Text("Peak (KB)"); ImGui::NextColumn();
+				ImGui::Text("Allocs"); ImGui::NextColumn();
+				ImGui::Separator();
+				for (size_t c = 0; c < CATEGORY_COUNT; ++c) {
+					const CategoryUsage& usage = stats.categories[c];
+					ImGui::Text("%s", CATEGORY_NAMES[c]); ImGui::NextColumn();
+					ImGui::Text("%llu", static_cast<unsigned long long>(usage.bytes / 1024)); ImGui::NextColumn();
+					ImGui::Text("%llu", static_cast<unsigned long long>(usage.peakBytes / 1024)); ImGui::NextColumn();
+					ImGui::Text("%u", usage.allocations); ImGui::NextColumn();
+				}
+				ImGui::Columns(1);
+
+				ImGui::Separator();
+				ImGui::Text(stats.budgetExtension ?
+					"Heap budgets from VK_EXT_memory_budget" :
+					"VK_EXT_memory_budget unavailable, budget is 80%% of heap size");
+				for (uint32_t i = 0; i < stats.heapCount; ++i) {
+					const HeapUsage& heap = stats.heaps[i];
+					const float fraction = heap.budget > 0 ?
+						static_cast<float>(heap.usage) / static_cast<float>(heap.budget) :
+						0.f;
+					char overlay[64];
+					snprintf(overlay, sizeof(overlay), "%llu / %llu MB",
+						static_cast<unsigned long long>(heap.usage >> 20),
+						static_cast<unsigned long long>(heap.budget >> 20));
+					ImGui::Text("Heap %u%s", i, heap.deviceLocal ? " (device local)" : "");
+					const bool over = (sOverBudgetMask & (1u << i)) != 0;
+					if (over) {
+						ImGui::PushStyleColor(ImGuiCol_PlotHistogram, ImVec4(0.9f, 0.2f, 0.2f, 1.f));
+					}
+					ImGui::ProgressBar(fraction, ImVec2(-1.f, 0.f), overlay);
+					if (over) {
+						ImGui::PopStyleColor();
+					}
+					ImGui::Text("Allocator blocks: %llu KB, allocated: %llu KB",
+						static_cast<unsigned long long>(heap.blockBytes / 1024),
+						static_cast<unsigned long long>(heap.allocatedBytes / 1024));
+				}
+
+				ImGui::Separator();
+				bool logging = isFrameLogging();
+				if (ImGui::Checkbox("Log every frame to gpu_memory.csv", &logging)) {
+					if (logging) {
+						startFrameLog("gpu_memory.csv");
+					}
+					else {
+						stopFrameLog();
+					}
+				}
+
+				ImGui::End();
+			}
+		}
+	}
+}
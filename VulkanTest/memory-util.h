@@ -0,0 +1,132 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#endif
+#include "vk_mem_alloc.h"
+
+#include <array>
+
+namespace hvk
+{
+	namespace util
+	{
+		namespace memory
+		{
+			enum class GpuMemoryCategory : uint8_t
+			{
+				General,
+				Mesh,
+				Texture,
+				RenderTarget,
+				Uniform,
+				IBL,
+				Staging,
+				UI,
+				Count
+			};
+
+			struct CategoryUsage
+			{
+				VkDeviceSize bytes;
+				VkDeviceSize peakBytes;
+				uint32_t allocations;
+			};
+
+			struct HeapUsage
+			{
+				VkDeviceSize size;
+				// Budget and usage come from VK_EXT_memory_budget when it is available,
+				// otherwise budget is 80% of the heap size and usage is what this process allocated
+				VkDeviceSize budget;
+				VkDeviceSize usage;
+				// Bytes in VkDeviceMemory blocks owned by the allocator and bytes handed out of them
+				VkDeviceSize blockBytes;
+				VkDeviceSize allocatedBytes;
+				bool deviceLocal;
+			};
+
+			struct GpuMemoryStats
+			{
+				std::array<CategoryUsage, static_cast<size_t>(GpuMemoryCategory::Count)> categories;
+				std::array<HeapUsage, VK_MAX_MEMORY_HEAPS> heaps;
+				uint32_t heapCount;
+				bool budgetExtension;
+			};
+
+			// Must be called once the allocator exists, before any of the below
+			void initialize(VkPhysicalDevice physicalDevice, VmaAllocator allocator, bool budgetExtension);
+
+			const char* getCategoryName(GpuMemoryCategory category);
+
+			// vmaCreateBuffer / vmaCreateImage which attribute the allocation to a category.
+			// The category is kept in the allocation's user data so the destroy calls
+			// don't need to be told it again
+			VkResult createBuffer(
+				VmaAllocator allocator,
+				const VkBufferCreateInfo* bufferCreateInfo,
+				const VmaAllocationCreateInfo* allocationCreateInfo,
+				VkBuffer* buffer,
+				VmaAllocation* allocation,
+				VmaAllocationInfo* allocationInfo,
+				GpuMemoryCategory category);
+
+			VkResult createImage(
+				VmaAllocator allocator,
+				const VkImageCreateInfo* imageCreateInfo,
+				const VmaAllocationCreateInfo* allocationCreateInfo,
+				VkImage* image,
+				VmaAllocation* allocation,
+				VmaAllocationInfo* allocationInfo,
+				GpuMemoryCategory category);
+
+			void destroyBuffer(VmaAllocator allocator, VkBuffer buffer, VmaAllocation allocation);
+			void destroyImage(VmaAllocator allocator, VkImage image, VmaAllocation allocation);
+
+			// True when every device local heap can also be mapped, as on integrated GPUs
+			bool isUnifiedMemory();
+
+			// Static geometry lives in device local memory. With direct writes on it's mapped and
+			// written in place, otherwise it's filled with a staged copy. Defaults to isUnifiedMemory(),
+			// since on a discrete GPU mappable device local memory is scarce or missing. Arenas read
+			// it when they are initialized
+			void setDirectGeometryWrites(bool enabled);
+			bool getDirectGeometryWrites();
+
+			// A device local buffer holding size bytes of data which never change. Written in place
+			// under direct geometry writes, otherwise uploaded through the UploadQueue and waited on.
+			// dstStage and dstAccess are how the buffer is read
+			VkResult createStaticBuffer(
+				VmaAllocator allocator,
+				const void* data,
+				VkDeviceSize size,
+				VkBufferUsageFlags usage,
+				VkPipelineStageFlags dstStage,
+				VkAccessFlags dstAccess,
+				VkBuffer* buffer,
+				VmaAllocation* allocation,
+				VmaAllocationInfo* allocationInfo,
+				GpuMemoryCategory category);
+
+			// Walks every allocator block, so not free; fine for an overlay or a log
+			GpuMemoryStats getGpuMemoryStats();
+
+			// Fraction of a heap's budget which triggers a warning, defaults to 0.9
+			void setBudgetWarningThreshold(float threshold);
+
+			// Start or stop writing a CSV row of category and heap usage every frame
+			bool startFrameLog(const char* filename);
+			void stopFrameLog();
+			bool isFrameLogging();
+
+			// Mark a frame boundary; checks heap budgets and writes the frame log if open
+			void endFrame();
+
+			// Heaps which went over the warning threshold during the last endFrame
+			uint32_t getOverBudgetHeapMask();
+
+			void drawGpuMemoryPanel(bool* open = nullptr);
+		}
+	}
+}
@@ -37,17 +37,25 @@ namespace hvk
 				const VkPipelineRasterizationStateCreateInfo& rasterizationInfo,
 				const std::vector<VkPipelineColorBlendAttachmentState>& blendAttachments);
 
-			template <typename T>
+			// Each type describes one vertex stream and names its own binding
+			template <typename... Streams>
 			void fillVertexInfo(VertexInfo& vertexInfo) 
 			{
-				vertexInfo.bindingDescription = T::getBindingDescription();
-				vertexInfo.attributeDescriptions = T::getAttributeDescriptions();
+				vertexInfo.bindingDescriptions = { Streams::getBindingDescription()... };
+				vertexInfo.attributeDescriptions.clear();
+				for (const auto& attributes : { Streams::getAttributeDescriptions()... })
+				{
+					vertexInfo.attributeDescriptions.insert(
+						vertexInfo.attributeDescriptions.end(),
+						attributes.begin(),
+						attributes.end());
+				}
 				vertexInfo.vertexInputInfo = {
 					VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
 					nullptr,
 					0,
-					1,
-					&vertexInfo.bindingDescription,
+					static_cast<uint32_t>(vertexInfo.bindingDescriptions.size()),
+					vertexInfo.bindingDescriptions.data(),
 					static_cast<uint32_t>(vertexInfo.attributeDescriptions.size()),
 					vertexInfo.attributeDescriptions.data()
 				};
@@ -37,7 +37,13 @@ namespace hvk
 					outResolution,
 					outResolution,
 					0,
-					VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT));
+					VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+					1,
+					VK_IMAGE_LAYOUT_UNDEFINED,
+					VK_IMAGE_VIEW_TYPE_2D,
+					1,
+					VK_IMAGE_ASPECT_COLOR_BIT,
+					memory::GpuMemoryCategory::IBL));
 				auto fbColorAttachment = renderpass::createColorAttachment(
 					outFormat,
 					VK_IMAGE_LAYOUT_UNDEFINED,
@@ -69,6 +75,7 @@ namespace hvk
 					shaderFiles);
 
 				// Create cubemap which we will iteratively copy environmentFramebuffer onto
+				// It's a transfer source as well so the result can be read back into the IBL cache
 				*outMap = image::createImageMap(
 					device,
 					allocator,
@@ -78,7 +85,13 @@ namespace hvk
 					outResolution,
 					outResolution,
 					0,
-					VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+					VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+					1,
+					VK_IMAGE_LAYOUT_UNDEFINED,
+					VK_IMAGE_VIEW_TYPE_2D,
+					1,
+					VK_IMAGE_ASPECT_COLOR_BIT,
+					memory::GpuMemoryCategory::IBL);
 
 				// map needs to be transitioned to a transfer destination
 				auto onetime = command::beginSingleTimeCommand(device, commandPool);
@@ -237,7 +250,13 @@ namespace hvk
 					outResolution,
 					outResolution,
 					0,
-					VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT));
+					VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+					1,
+					VK_IMAGE_LAYOUT_UNDEFINED,
+					VK_IMAGE_VIEW_TYPE_2D,
+					1,
+					VK_IMAGE_ASPECT_COLOR_BIT,
+					memory::GpuMemoryCategory::IBL));
 				auto cubeColorAttachment = renderpass::createColorAttachment(
 					outFormat,
 					VK_IMAGE_LAYOUT_UNDEFINED,
@@ -269,6 +288,7 @@ namespace hvk
 					shaderFiles);
 
 				// Create cubemap which we will iteratively copy environmentFramebuffer onto
+				// It's a transfer source as well so the result can be read back into the IBL cache
 				*outMap = image::createImageMap(
 					device,
 					allocator,
@@ -278,11 +298,13 @@ namespace hvk
 					outResolution,
 					outResolution,
 					VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT,
-					VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+					VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 					6,
 					VK_IMAGE_LAYOUT_UNDEFINED,
 					VK_IMAGE_VIEW_TYPE_CUBE,
-					mipLevels);
+					mipLevels,
+					VK_IMAGE_ASPECT_COLOR_BIT,
+					memory::GpuMemoryCategory::IBL);
 
 				// map needs to be transitioned to a transfer destination
 				auto onetime = command::beginSingleTimeCommand(device, commandPool);
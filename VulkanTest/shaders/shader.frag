@@ -205,8 +205,9 @@ void main() {
 
     vec4 albedo = texture(diffuseSampler, fragTexCoord);
 	vec3 metallicRoughness = texture(metallicRoughnessSampler, fragTexCoord).rgb;
-	vec3 surfaceNormal = texture(normalSampler, fragTexCoord).rgb;
-    surfaceNormal = normalize(surfaceNormal * 2.0 - 1.0);
+	// Only x and y are read so two channel (BC5) normal maps work; z is rebuilt on the hemisphere
+	vec2 normalXY = texture(normalSampler, fragTexCoord).rg * 2.0 - 1.0;
+	vec3 surfaceNormal = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
     surfaceNormal = normalize(inTBN * surfaceNormal);
 
 	float occlusion = metallicRoughness.r;
@@ -0,0 +1,43 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(set = 1, binding = 0) uniform UniformBufferObject {
+	mat4 model;
+	mat4 view;
+	mat4 modelViewProj;
+	vec3 cameraPos;
+} ubo;
+
+// PackedVertexAttributes: octahedral normal in xy and tangent in zw,
+// with the tangent's handedness in the lowest bit of w
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec4 inNormalTangent;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 2) out vec3 fragPos;
+layout(location = 3) out mat3 outTBN;
+
+vec3 decodeOctahedral(vec2 e) {
+	vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-v.z, 0.0);
+	v.x += v.x >= 0.0 ? -t : t;
+	v.y += v.y >= 0.0 ? -t : t;
+	return normalize(v);
+}
+
+void main() {
+    gl_Position = ubo.modelViewProj * vec4(inPosition, 1.0);
+	fragTexCoord = inTexCoord;
+	fragPos = vec3(ubo.model * vec4(inPosition, 1.0));
+
+	vec3 normal = decodeOctahedral(inNormalTangent.xy);
+	vec3 tangent = decodeOctahedral(inNormalTangent.zw);
+	float handedness = (int(round(inNormalTangent.w * 32767.0)) & 1) != 0 ? -1.0 : 1.0;
+
+    // calculate TBN
+    vec3 T = normalize(vec3(ubo.model * vec4(tangent, 0.0)));
+    vec3 N = normalize(vec3(ubo.model * vec4(normal, 0.0)));
+    vec3 B = cross(N, T) * -handedness;
+    outTBN = mat3(T, B, N);
+}
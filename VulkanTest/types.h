@@ -24,7 +24,11 @@ namespace hvk {
 	typedef std::vector<VkDescriptorSet> DescriptorSets;
 	//typedef std::shared_ptr<GLFWwindow, void(*)(GLFWwindow*)> window_ptr;
 	typedef std::shared_ptr<GLFWwindow> window_ptr;
+	// Matches hvk::VertIndex, see HvkUtil.h for why it stays 16 bit. Only the old
+	// Renderer, which is no longer built, still uses this one
 	typedef uint16_t VertIndex;
+	// Issued by UploadQueue in submission order; 0 is always complete
+	typedef uint64_t UploadTicket;
 
 
 	template <class T>
@@ -46,6 +50,8 @@ namespace hvk {
 		RuntimeResource<VkImage> texture;
 		VkImageView view = VK_NULL_HANDLE;
 		VkSampler sampler = VK_NULL_HANDLE;
+		// Not safe to sample until this upload completes
+		UploadTicket upload = 0;
 	};
 
 	struct QueueFamilies {
@@ -141,6 +147,13 @@ namespace hvk {
 		float roughness;
 	};
 
+	// A mesh draws the coarsest level whose error covers no more than pixelError pixels.
+	// hysteresis is the fraction either side of that a level has to cross before it switches
+	struct LodSettings {
+		float pixelError;
+		float hysteresis;
+	};
+
 	struct SkySettings {
 		float gamma;
 		float lod;
@@ -148,7 +161,7 @@ namespace hvk {
 
 	struct VertexInfo 
 	{
-		VkVertexInputBindingDescription bindingDescription;
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions;
 		std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo;
 	};
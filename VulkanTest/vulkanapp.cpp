@@ -2,6 +2,7 @@
 #include <vector>
 #include <iostream>
 #include <limits>
+#include <cstring>
 
 #include "stb_image.h"
 #include "stb_image_write.h"
@@ -17,10 +18,18 @@
 #include "framebuffer-util.h"
 #include "signal-util.h"
 #include "command-util.h"
+#include "UploadQueue.h"
+#include "StagingRing.h"
 #include "render-util.h"
 #include "GpuManager.h"
+#include "IblCache.h"
+#include "Hash.h"
+#include "memory-util.h"
 
 #include "HvkUtil.h"
+#include "FrameAllocator.h"
+#include "UniformRing.h"
+#include "MemoryStats.h"
 
 #include <renderdoc_app.h>
 
@@ -38,6 +47,8 @@ namespace hvk {
         mPhysicalDevice(VK_NULL_HANDLE),
         mGraphicsIndex(),
 		mGraphicsQueue(VK_NULL_HANDLE),
+		mTransferIndex(),
+		mTransferQueue(VK_NULL_HANDLE),
         mCommandPool(VK_NULL_HANDLE),
         mPrimaryCommandBuffer(VK_NULL_HANDLE),
         mModelPipeline(),
@@ -45,6 +56,7 @@ namespace hvk {
         mRenderFinished(VK_NULL_HANDLE),
 		mFinalRenderFinished(VK_NULL_HANDLE),
         mAllocator(),
+        mMemoryBudgetSupported(false),
         mRenderFence(VK_NULL_HANDLE)
     {
 
@@ -58,6 +70,10 @@ namespace hvk {
         vkDestroySemaphore(mDevice, mRenderFinished, nullptr);
         vkDestroyFence(mDevice, mRenderFence, nullptr);
 
+        mModelPipeline.destroy();
+        UniformRing::destroy();
+        UploadQueue::destroy();
+        StagingRing::destroy();
         vmaDestroyAllocator(mAllocator);
 
         vkDestroyDevice(mDevice, nullptr);
@@ -96,6 +112,8 @@ namespace hvk {
         if (!supportedFeatures.samplerAnisotropy) {
             throw std::runtime_error("Physical Device does not support Anisotropic Filtering");
         }
+        // Cooked textures are block compressed where the device allows it
+        deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
 
         uint32_t queueFamilyCount = 0;
         mGraphicsIndex = 0;
@@ -108,20 +126,56 @@ namespace hvk {
             }
         }
 
+        // Uploads go to a family without graphics when there is one, preferring a
+        // transfer-only family since that's usually a dedicated copy engine
+        mTransferIndex = mGraphicsIndex;
+        int transferScore = 0;
+        for (uint32_t i = 0; i < queueFamilyCount; ++i) {
+            const VkQueueFlags flags = queueFamilies[i].queueFlags;
+            if (!(flags & VK_QUEUE_TRANSFER_BIT) || (flags & VK_QUEUE_GRAPHICS_BIT)) {
+                continue;
+            }
+            const int score = (flags & VK_QUEUE_COMPUTE_BIT) ? 1 : 2;
+            if (score > transferScore) {
+                mTransferIndex = i;
+                transferScore = score;
+            }
+        }
+
+        // Heap budgets are optional, fall back to heap sizes without them
+        uint32_t extensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(mPhysicalDevice, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(mPhysicalDevice, nullptr, &extensionCount, availableExtensions.data());
+        std::vector<const char*> enabledExtensions = deviceExtensions;
+        for (const auto& extension : availableExtensions) {
+            if (strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0) {
+                enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+                mMemoryBudgetSupported = true;
+                break;
+            }
+        }
+
         float queuePriority = 1.0f;
+        std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
         VkDeviceQueueCreateInfo queueCreateInfo = {};
         queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
         queueCreateInfo.queueFamilyIndex = mGraphicsIndex;
         queueCreateInfo.queueCount = 1;
         queueCreateInfo.pQueuePriorities = &queuePriority;
+        queueCreateInfos.push_back(queueCreateInfo);
+        if (mTransferIndex != mGraphicsIndex) {
+            queueCreateInfo.queueFamilyIndex = mTransferIndex;
+            queueCreateInfos.push_back(queueCreateInfo);
+        }
 
         VkDeviceCreateInfo deviceInfo = {};
         deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-        deviceInfo.pQueueCreateInfos = &queueCreateInfo;
-        deviceInfo.queueCreateInfoCount = 1;
+        deviceInfo.pQueueCreateInfos = queueCreateInfos.data();
+        deviceInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         deviceInfo.pEnabledFeatures = &deviceFeatures;
-        deviceInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        deviceInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        deviceInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        deviceInfo.ppEnabledExtensionNames = enabledExtensions.data();
         //deviceInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
         //deviceInfo.ppEnabledLayerNames = validationLayers.data();
 
@@ -137,8 +191,10 @@ namespace hvk {
 		allocatorCreate.physicalDevice = mPhysicalDevice;
 		allocatorCreate.device = mDevice;
 		vmaCreateAllocator(&allocatorCreate, &mAllocator);
+		util::memory::initialize(mPhysicalDevice, mAllocator, mMemoryBudgetSupported);
 
         vkGetDeviceQueue(mDevice, mGraphicsIndex, 0, &mGraphicsQueue);
+        vkGetDeviceQueue(mDevice, mTransferIndex, 0, &mTransferQueue);
         mCommandPool = util::command::createCommandPool(
 			mDevice, 
 			mGraphicsIndex, 
@@ -165,7 +221,8 @@ namespace hvk {
 
     void VulkanApp::init(
             VkInstance vulkanInstance,
-            VkSurfaceKHR surface)
+            VkSurfaceKHR surface,
+            VertexEncoding meshEncoding)
     {
         mInstance = vulkanInstance;
 
@@ -197,7 +254,11 @@ namespace hvk {
         }
 
 		GpuManager::init(mPhysicalDevice, mDevice, mCommandPool, mGraphicsQueue, mAllocator);
-        mModelPipeline.init();
+		UploadQueue::initialize(mGraphicsIndex, mGraphicsQueue, mTransferIndex, mTransferQueue);
+		StagingRing::initialize(StagingRing::DEFAULT_SIZE);
+		FrameAllocator::initialize(FrameAllocator::DEFAULT_FRAME_SIZE);
+		UniformRing::initialize(UniformRing::DEFAULT_FRAME_SIZE);
+        mModelPipeline.init(meshEncoding);
     }
 
 
@@ -216,6 +277,12 @@ namespace hvk {
 		// Wait for render fence to free
 		assert(vkWaitForFences(mDevice, 1, &mRenderFence, VK_TRUE, UINT64_MAX) == VK_SUCCESS);
 		assert(vkResetFences(mDevice, 1, &mRenderFence) == VK_SUCCESS);
+		GpuManager::beginFrame();
+		UniformRing::beginFrame();
+		mModelPipeline.update();
+
+		// Textures whose uploads finish here are drawn this frame
+		UploadQueue::update();
 
 		VkCommandBufferBeginInfo commandBegin = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
         commandBegin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
@@ -242,13 +309,19 @@ namespace hvk {
 		return inheritanceInfo;
 	}
 
-	void VulkanApp::renderpassExecuteAndClose(const std::vector<VkCommandBuffer>& secondaryBuffers)
+	void VulkanApp::renderpassExecuteAndClose(const HVK_pmr_vector<VkCommandBuffer>& secondaryBuffers)
 	{
 		vkCmdExecuteCommands(mPrimaryCommandBuffer, static_cast<uint32_t>(secondaryBuffers.size()), secondaryBuffers.data());
 		vkCmdEndRenderPass(mPrimaryCommandBuffer);
 	}
 
-	void VulkanApp::renderpassExecute(const std::vector<VkCommandBuffer>& secondaryBuffers)
+	void VulkanApp::renderpassExecuteAndClose(VkCommandBuffer secondaryBuffer)
+	{
+		vkCmdExecuteCommands(mPrimaryCommandBuffer, 1, &secondaryBuffer);
+		vkCmdEndRenderPass(mPrimaryCommandBuffer);
+	}
+
+	void VulkanApp::renderpassExecute(const HVK_pmr_vector<VkCommandBuffer>& secondaryBuffers)
 	{
 		vkCmdExecuteCommands(mPrimaryCommandBuffer, static_cast<uint32_t>(secondaryBuffers.size()), secondaryBuffers.data());
 	}
@@ -261,6 +334,12 @@ namespace hvk {
 	void VulkanApp::renderFinish()
 	{
 		assert(vkEndCommandBuffer(mPrimaryCommandBuffer) == VK_SUCCESS);
+
+		// Scratch memory from this frame stays valid until its buffer comes around again
+		FrameAllocator::nextFrame();
+		UniformRing::nextFrame();
+		memory::endFrame();
+		util::memory::endFrame();
 	}
 
 	void VulkanApp::renderSubmit()
@@ -309,118 +388,228 @@ namespace hvk {
         const auto& commandPool = GpuManager::getCommandPool();
         const auto& graphicsQueue = GpuManager::getGraphicsQueue();
 
-		// Convert HDR equirectangular map to cubemap
-		int hdrWidth, hdrHeight, hdrBitDepth;
-		float* hdrData = stbi_loadf("resources/Alexs_Apartment/Alexs_Apt_2k.hdr", &hdrWidth, &hdrHeight, &hdrBitDepth, 4);
-		//float* hdrData = stbi_loadf("resources/MonValley_Lookout/MonValley_A_LookoutPoint_2k.hdr", &hdrWidth, &hdrHeight, &hdrBitDepth, 4);
-		auto hdrImage = util::image::createTextureImage(
-            device,
-            allocator,
-            commandPool,
-            graphicsQueue,
-			hdrData, 
-			1, 
-			hdrWidth, 
-			hdrHeight, 
-			4 * 4,  // hdrBitDepth might be 3, but we are telling stb_image to fake the Alpha channel and floats are 2 bytes
-			VK_IMAGE_TYPE_2D, 
-			0, 
-			VK_FORMAT_R32G32B32A32_SFLOAT);
-		auto hdrMap = std::make_shared<TextureMap>(TextureMap{
-			hdrImage,
-			util::image::createImageView(mDevice, hdrImage.memoryResource, VK_FORMAT_R32G32B32A32_SFLOAT),
-			util::image::createImageSampler(mDevice)});
+		// Each baked map is cached next to its source under a key of everything that went into it.
+		// The irradiance and prefiltered maps chain the environment's key, so a new HDR or
+		// environment bake invalidates them too
+		const std::string hdrPath = "resources/Alexs_Apartment/Alexs_Apt_2k.hdr";
+		//const std::string hdrPath = "resources/MonValley_Lookout/MonValley_A_LookoutPoint_2k.hdr";
+		const VkFormat iblFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+		const uint32_t environmentResolution = 1024;
+		const uint32_t irradianceResolution = 32;
+		const uint32_t prefilteredResolution = 256;
+		const uint32_t brdfLutResolution = 512;
 
 		std::vector<GammaSettings> vgammaSettings = { gammaSettings };
 
 		std::array<std::string, 2> hdrMapShaders = {
 			"shaders/compiled/hdr_to_cubemap_vert.spv",
 			"shaders/compiled/hdr_to_cubemap_frag.spv"};
-		util::render::renderCubeMap<GammaSettings>(
-			device,
-            allocator,
-            commandPool,
-            graphicsQueue,
-			mPrimaryCommandBuffer,
-			hdrMap,
-			1024,
-			VK_FORMAT_R16G16B16A16_SFLOAT,
-			environmentMap,
-			hdrMapShaders,
-			vgammaSettings);
-
-        // clean up
-        vmaDestroyImage(mAllocator, hdrImage.memoryResource, hdrImage.allocation);
-
-		// Finally, update the skybox
-		//mSkyboxRenderer->setCubemap(cubemap);
-
 		std::array<std::string, 2> irradianceMapShaders = {
 			"shaders/compiled/convolution_vert.spv",
 			"shaders/compiled/convolution_frag.spv"
 		};
-		util::render::renderCubeMap<GammaSettings>(
-			device,
-            allocator,
-            commandPool,
-            graphicsQueue,
-			mPrimaryCommandBuffer,
-			environmentMap,
-			32,
-			VK_FORMAT_R16G16B16A16_SFLOAT,
-			irradianceMap,
-			irradianceMapShaders,
-			vgammaSettings);
+		std::array<std::string, 2> prefilterMapShaders = {
+			"shaders/compiled/prefiltered-environment_vert.spv",
+			"shaders/compiled/prefiltered-environment_frag.spv"
+		};
+		std::array<std::string, 2> brdfLutShaders = {
+			"shaders/compiled/quad_vert.spv",
+			"shaders/compiled/brdfLUT_frag.spv" };
 
-		//mSkyboxRenderer->setCubemap(irradianceMap);
-		
-		uint32_t numMips = static_cast<uint32_t>(std::floor(std::log2(256.f))) + 1;
+		uint32_t numMips = static_cast<uint32_t>(std::floor(std::log2(static_cast<float>(prefilteredResolution)))) + 1;
 		std::vector<RoughnessSettings> roughnessSettings;
 		roughnessSettings.reserve(numMips);
 		for (uint32_t i = 0; i < numMips; ++i)
 		{
 			roughnessSettings.push_back(RoughnessSettings{ static_cast<float>(i) / numMips });
 		}
-		std::array<std::string, 2> prefilterMapShaders = {
-			"shaders/compiled/prefiltered-environment_vert.spv",
-			"shaders/compiled/prefiltered-environment_frag.spv"
-		};
-		util::render::renderCubeMap<RoughnessSettings>(
-			device,
-            allocator,
-            commandPool,
-            graphicsQueue,
-			mPrimaryCommandBuffer,
-			environmentMap,
-			256,
-			VK_FORMAT_R16G16B16A16_SFLOAT,
-			prefilteredMap,
-			prefilterMapShaders,
-			roughnessSettings,
-			numMips);
-
-		if (rdoc_api)
+
+		// Without a key, such as when a shader is missing, everything is baked and nothing cached
+		uint64_t hdrHash = 0;
+		uint64_t environmentKey = 0;
+		uint64_t irradianceKey = 0;
+		uint64_t prefilteredKey = 0;
+		uint64_t brdfLutKey = 0;
+		const bool environmentCacheable =
+			hash::hashFile(hdrPath, hdrHash) &&
+			computeIblKey(
+				hdrHash,
+				hdrMapShaders,
+				environmentResolution,
+				iblFormat,
+				1,
+				vgammaSettings.data(),
+				vgammaSettings.size() * sizeof(GammaSettings),
+				environmentKey) &&
+			computeIblKey(
+				environmentKey,
+				irradianceMapShaders,
+				irradianceResolution,
+				iblFormat,
+				1,
+				vgammaSettings.data(),
+				vgammaSettings.size() * sizeof(GammaSettings),
+				irradianceKey) &&
+			computeIblKey(
+				environmentKey,
+				prefilterMapShaders,
+				prefilteredResolution,
+				iblFormat,
+				numMips,
+				roughnessSettings.data(),
+				roughnessSettings.size() * sizeof(RoughnessSettings),
+				prefilteredKey);
+		const bool brdfLutCacheable = computeIblKey(
+			0,
+			brdfLutShaders,
+			brdfLutResolution,
+			iblFormat,
+			1,
+			nullptr,
+			0,
+			brdfLutKey);
+
+		const std::string environmentCachePath = getIblCachePath(hdrPath, "environment");
+		const std::string irradianceCachePath = getIblCachePath(hdrPath, "irradiance");
+		const std::string prefilteredCachePath = getIblCachePath(hdrPath, "prefiltered");
+
+		// The environment is one of the outputs, so it's loaded even when the other two are cached
+		if (!environmentCacheable || !loadIblMap(environmentCachePath, environmentKey, *environmentMap))
 		{
-			rdoc_api->StartFrameCapture(nullptr, nullptr);
+			// Convert HDR equirectangular map to cubemap
+			// The cooked BC6H copy is an eighth of the float texels; the source is decoded when it's missing
+			auto hdrMap = std::make_shared<TextureMap>();
+			if (!util::image::createTextureMapFromCookedFile(
+				GpuManager::getPhysicalDevice(),
+				device,
+				allocator,
+				commandPool,
+				graphicsQueue,
+				hdrPath,
+				TextureCookSettings(),
+				*hdrMap,
+				util::memory::GpuMemoryCategory::IBL))
+			{
+				int hdrWidth, hdrHeight, hdrBitDepth;
+				float* hdrData = stbi_loadf(hdrPath.c_str(), &hdrWidth, &hdrHeight, &hdrBitDepth, 4);
+				auto hdrImage = util::image::createTextureImage(
+					device,
+					allocator,
+					commandPool,
+					graphicsQueue,
+					hdrData, 
+					1, 
+					hdrWidth, 
+					hdrHeight, 
+					4 * 4,  // hdrBitDepth might be 3, but we are telling stb_image to fake the Alpha channel and floats are 2 bytes
+					VK_IMAGE_TYPE_2D, 
+					0, 
+					VK_FORMAT_R32G32B32A32_SFLOAT,
+					util::memory::GpuMemoryCategory::IBL);
+				stbi_image_free(hdrData);
+				*hdrMap = TextureMap{
+					hdrImage,
+					util::image::createImageView(mDevice, hdrImage.memoryResource, VK_FORMAT_R32G32B32A32_SFLOAT),
+					util::image::createImageSampler(mDevice)};
+			}
+
+			util::render::renderCubeMap<GammaSettings>(
+				device,
+				allocator,
+				commandPool,
+				graphicsQueue,
+				mPrimaryCommandBuffer,
+				hdrMap,
+				environmentResolution,
+				iblFormat,
+				environmentMap,
+				hdrMapShaders,
+				vgammaSettings);
+
+			// clean up
+			util::image::destroyMap(device, allocator, *hdrMap);
+
+			if (environmentCacheable)
+			{
+				saveIblMap(environmentCachePath, environmentKey, *environmentMap, iblFormat, environmentResolution, 6, 1);
+			}
 		}
-		std::array<std::string, 2> brdfLutShaders = {
-			"shaders/compiled/quad_vert.spv",
-			"shaders/compiled/brdfLUT_frag.spv" };
-		auto brdfFence = util::render::renderImageMap(
-            device,
-            allocator,
-            commandPool,
-            graphicsQueue,
-			mPrimaryCommandBuffer,
-			512,
-			VK_FORMAT_R16G16B16A16_SFLOAT,
-			brdfLutMap,
-			brdfLutShaders);
-		assert(vkWaitForFences(mDevice, 1, &brdfFence, VK_TRUE, UINT64_MAX) == VK_SUCCESS);
-
-		if (rdoc_api)
+
+		// Finally, update the skybox
+		//mSkyboxRenderer->setCubemap(cubemap);
+
+		if (!environmentCacheable || !loadIblMap(irradianceCachePath, irradianceKey, *irradianceMap))
 		{
-			rdoc_api->EndFrameCapture(nullptr, nullptr);
+			util::render::renderCubeMap<GammaSettings>(
+				device,
+				allocator,
+				commandPool,
+				graphicsQueue,
+				mPrimaryCommandBuffer,
+				environmentMap,
+				irradianceResolution,
+				iblFormat,
+				irradianceMap,
+				irradianceMapShaders,
+				vgammaSettings);
+
+			if (environmentCacheable)
+			{
+				saveIblMap(irradianceCachePath, irradianceKey, *irradianceMap, iblFormat, irradianceResolution, 6, 1);
+			}
+		}
+
+		//mSkyboxRenderer->setCubemap(irradianceMap);
+
+		if (!environmentCacheable || !loadIblMap(prefilteredCachePath, prefilteredKey, *prefilteredMap))
+		{
+			util::render::renderCubeMap<RoughnessSettings>(
+				device,
+				allocator,
+				commandPool,
+				graphicsQueue,
+				mPrimaryCommandBuffer,
+				environmentMap,
+				prefilteredResolution,
+				iblFormat,
+				prefilteredMap,
+				prefilterMapShaders,
+				roughnessSettings,
+				numMips);
+
+			if (environmentCacheable)
+			{
+				saveIblMap(prefilteredCachePath, prefilteredKey, *prefilteredMap, iblFormat, prefilteredResolution, 6, numMips);
+			}
+		}
+
+		if (!brdfLutCacheable || !loadIblMap(BRDF_LUT_CACHE_PATH, brdfLutKey, *brdfLutMap))
+		{
+			if (rdoc_api)
+			{
+				rdoc_api->StartFrameCapture(nullptr, nullptr);
+			}
+			auto brdfFence = util::render::renderImageMap(
+				device,
+				allocator,
+				commandPool,
+				graphicsQueue,
+				mPrimaryCommandBuffer,
+				brdfLutResolution,
+				iblFormat,
+				brdfLutMap,
+				brdfLutShaders);
+			assert(vkWaitForFences(mDevice, 1, &brdfFence, VK_TRUE, UINT64_MAX) == VK_SUCCESS);
+
+			if (rdoc_api)
+			{
+				rdoc_api->EndFrameCapture(nullptr, nullptr);
+			}
+
+			if (brdfLutCacheable)
+			{
+				saveIblMap(BRDF_LUT_CACHE_PATH, brdfLutKey, *brdfLutMap, iblFormat, brdfLutResolution, 1, 1);
+			}
 		}
 	}
 }
\ No newline at end of file
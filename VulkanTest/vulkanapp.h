@@ -33,6 +33,9 @@ namespace hvk {
 
 		uint32_t mGraphicsIndex;
 		VkQueue mGraphicsQueue;
+		// Same as the graphics family when the device has no separate transfer family
+		uint32_t mTransferIndex;
+		VkQueue mTransferQueue;
 		VkCommandPool mCommandPool;
 		VkCommandBuffer mPrimaryCommandBuffer;
 
@@ -43,6 +46,7 @@ namespace hvk {
 		VkSemaphore mFinalRenderFinished;
 
 		VmaAllocator mAllocator;
+		bool mMemoryBudgetSupported;
 
 		VkFence mRenderFence;
 
@@ -58,7 +62,8 @@ namespace hvk {
 
 		void init(
             VkInstance vulkanInstance,
-            VkSurfaceKHR surface);
+            VkSurfaceKHR surface,
+            VertexEncoding meshEncoding = VertexEncoding::Full);
         bool update(double frameTime);
 
         ModelPipeline& getModelPipeline() { return mModelPipeline; }
@@ -73,8 +78,9 @@ namespace hvk {
 		// new render paradigm
 		uint32_t renderPrepare(VkSwapchainKHR& swapchain);
 		VkCommandBufferInheritanceInfo renderpassBegin(const VkRenderPassBeginInfo& renderBegin);
-		void renderpassExecuteAndClose(const std::vector<VkCommandBuffer>& secondaryBuffers);
-		void renderpassExecute(const std::vector<VkCommandBuffer>& secondaryBuffers);
+		void renderpassExecuteAndClose(const HVK_pmr_vector<VkCommandBuffer>& secondaryBuffers);
+		void renderpassExecuteAndClose(VkCommandBuffer secondaryBuffer);
+		void renderpassExecute(const HVK_pmr_vector<VkCommandBuffer>& secondaryBuffers);
 		void renderpassClose();
 		void renderFinish();
 		void renderSubmit();